@@ -28,6 +28,7 @@
 #include "linklist.h"
 #include "queue.h"
 #include "pullwr.h"
+#include "segbuf.h"
 #include "memory.h"
 #include "network.h"
 #include "filter.h"
@@ -476,16 +477,19 @@ static int bmp_send_peerup(struct bmp *bmp)
 	return 0;
 }
 
-/* XXX: kludge - filling the pullwr's buffer */
+/* XXX: kludge - filling the pullwr's buffer
+ * (the message itself is shared between all sessions, not copied)
+ */
 static void bmp_send_all(struct bmp_bgp *bmpbgp, struct stream *s)
 {
 	struct bmp_targets *bt;
 	struct bmp *bmp;
+	struct segbuf *sb = segbuf_from_stream(s);
 
 	frr_each(bmp_targets, &bmpbgp->targets, bt)
 		frr_each(bmp_session, &bt->sessions, bmp)
-			pullwr_write_stream(bmp->pullwr, s);
-	stream_free(s);
+			pullwr_write_segbuf(bmp->pullwr, sb);
+	segbuf_free(sb);
 }
 
 /*
@@ -899,6 +903,7 @@ static void bmp_monitor(struct bmp *bmp, struct peer *peer, uint8_t flags,
 			time_t uptime)
 {
 	struct stream *hdr, *msg;
+	struct segbuf *sb;
 	struct timeval tv = { .tv_sec = uptime, .tv_usec = 0 };
 	struct timeval uptime_real;
 
@@ -917,9 +922,12 @@ static void bmp_monitor(struct bmp *bmp, struct peer *peer, uint8_t flags,
 
 	bmp->cnt_update++;
 	pullwr_write_stream(bmp->pullwr, hdr);
-	pullwr_write_stream(bmp->pullwr, msg);
 	stream_free(hdr);
-	stream_free(msg);
+
+	/* hand the UPDATE over without copying it */
+	sb = segbuf_from_stream(msg);
+	pullwr_write_segbuf(bmp->pullwr, sb);
+	segbuf_free(sb);
 }
 
 static bool bmp_wrsync(struct bmp *bmp, struct pullwr *pullwr)
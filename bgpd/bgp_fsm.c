@@ -199,7 +199,7 @@ static struct peer *peer_xfer_conn(struct peer *from_peer)
 		from_peer->fd = fd;
 
 		stream_fifo_clean(peer->ibuf);
-		stream_fifo_clean(peer->obuf);
+		segbuf_fifo_clean(peer->obuf);
 
 		/*
 		 * this should never happen, since bgp_process_packet() is the
@@ -222,8 +222,8 @@ static struct peer *peer_xfer_conn(struct peer *from_peer)
 
 		// copy each packet from old peer's output queue to new peer
 		while (from_peer->obuf->head)
-			stream_fifo_push(peer->obuf,
-					 stream_fifo_pop(from_peer->obuf));
+			segbuf_fifo_push(peer->obuf,
+					 segbuf_fifo_pop(from_peer->obuf));
 
 		// copy each packet from old peer's input queue to new peer
 		while (from_peer->ibuf->head)
@@ -1359,7 +1359,7 @@ int bgp_stop(struct peer *peer)
 		if (peer->ibuf)
 			stream_fifo_clean(peer->ibuf);
 		if (peer->obuf)
-			stream_fifo_clean(peer->obuf);
+			segbuf_fifo_clean(peer->obuf);
 
 		if (peer->ibuf_work)
 			ringbuf_wipe(peer->ibuf_work);
@@ -30,6 +30,7 @@
 #include "memory.h"		// for MTYPE_TMP, XCALLOC, XFREE
 #include "network.h"		// for ERRNO_IO_RETRY
 #include "stream.h"		// for stream_get_endp, stream_getw_from, str...
+#include "segbuf.h"		// for segbuf_iovec, segbuf_fifo_pop, segbuf...
 #include "ringbuf.h"		// for ringbuf_remain, ringbuf_peek, ringbuf_...
 #include "thread.h"		// for THREAD_OFF, THREAD_ARG, thread...
 
@@ -136,7 +137,7 @@ static int bgp_process_writes(struct thread *thread)
 
 	frr_with_mutex(&peer->io_mtx) {
 		status = bgp_write(peer);
-		reschedule = (stream_fifo_head(peer->obuf) != NULL);
+		reschedule = (segbuf_fifo_head(peer->obuf) != NULL);
 	}
 
 	/* no problem */
@@ -275,6 +276,25 @@ static int bgp_process_reads(struct thread *thread)
 	return 0;
 }
 
+/*
+ * Fill iov with the unwritten data of up to pkts packets, starting at sb.
+ * Returns the number of iovec entries used, the byte count goes to *bytes.
+ */
+static unsigned int bgp_write_iov(struct segbuf *sb, unsigned int pkts,
+				  struct iovec *iov, unsigned int iovcnt,
+				  size_t *bytes)
+{
+	unsigned int iovsz = 0, n;
+
+	*bytes = 0;
+	for (; sb && pkts && iovsz < iovcnt; sb = sb->next, pkts--) {
+		n = segbuf_iovec(sb, &iov[iovsz], iovcnt - iovsz);
+		while (n--)
+			*bytes += iov[iovsz++].iov_len;
+	}
+	return iovsz;
+}
+
 /*
  * Flush peer output buffer.
  *
@@ -282,6 +302,9 @@ static int bgp_process_reads(struct thread *thread)
  * The amount of packets written is equal to the minimum of peer->wpkt_quanta
  * and the number of packets on the output buffer, unless an error occurs.
  *
+ * Packets on peer->obuf may share their data with other peers' queues, so
+ * they are never modified here;  partial writes only advance their getp.
+ *
  * If write() returns an error, the appropriate FSM event is generated.
  *
  * The return value is equal to the number of packets written
@@ -290,42 +313,30 @@ static int bgp_process_reads(struct thread *thread)
 static uint16_t bgp_write(struct peer *peer)
 {
 	uint8_t type;
-	struct stream *s;
+	struct segbuf *sb;
 	int update_last_write = 0;
 	unsigned int count;
 	uint32_t uo = 0;
 	uint16_t status = 0;
 	uint32_t wpkt_quanta_old;
 
-	int writenum = 0;
-	int num;
+	size_t writenum;
+	ssize_t num;
 	unsigned int iovsz;
-	unsigned int strmsz;
 	unsigned int total_written;
 
 	wpkt_quanta_old = atomic_load_explicit(&peer->bgp->wpkt_quanta,
 					       memory_order_relaxed);
-	struct stream *ostreams[wpkt_quanta_old];
-	struct stream **streams = ostreams;
 	struct iovec iov[wpkt_quanta_old];
 
-	s = stream_fifo_head(peer->obuf);
+	sb = segbuf_fifo_head(peer->obuf);
 
-	if (!s)
+	if (!sb)
 		goto done;
 
-	count = iovsz = 0;
-	while (count < wpkt_quanta_old && iovsz < array_size(iov) && s) {
-		ostreams[iovsz] = s;
-		iov[iovsz].iov_base = stream_pnt(s);
-		iov[iovsz].iov_len = STREAM_READABLE(s);
-		writenum += STREAM_READABLE(s);
-		s = s->next;
-		++iovsz;
-		++count;
-	}
+	count = MIN(wpkt_quanta_old, segbuf_fifo_count(peer->obuf));
+	iovsz = bgp_write_iov(sb, count, iov, array_size(iov), &writenum);
 
-	strmsz = iovsz;
 	total_written = 0;
 
 	do {
@@ -340,51 +351,38 @@ static uint16_t bgp_write(struct peer *peer)
 			}
 
 			break;
-		} else if (num != writenum) {
-			unsigned int msg_written = 0;
-			unsigned int ic = iovsz;
+		}
 
-			for (unsigned int i = 0; i < ic; i++) {
-				size_t ss = iov[i].iov_len;
+		writenum -= num;
 
-				if (ss > (unsigned int) num)
-					break;
+		/* skip over completely written packets, advance into the
+		 * partially written one
+		 */
+		while (num > 0) {
+			size_t len = SEGBUF_READABLE(sb);
 
-				msg_written++;
-				iovsz--;
-				writenum -= ss;
-				num -= ss;
+			if ((size_t)num < len) {
+				segbuf_forward_getp(sb, num);
+				break;
 			}
-
-			total_written += msg_written;
-
-			assert(total_written < count);
-
-			memmove(&iov, &iov[msg_written],
-				sizeof(iov[0]) * iovsz);
-			streams = &streams[msg_written];
-			stream_forward_getp(streams[0], num);
-			iov[0].iov_base = stream_pnt(streams[0]);
-			iov[0].iov_len = STREAM_READABLE(streams[0]);
-
-			writenum -= num;
-			num = 0;
-			assert(writenum > 0);
-		} else {
-			total_written = strmsz;
+			segbuf_forward_getp(sb, len);
+			num -= len;
+			sb = sb->next;
+			total_written++;
 		}
 
-	} while (num != writenum);
+		if (writenum)
+			iovsz = bgp_write_iov(sb, count - total_written, iov,
+					      array_size(iov), &writenum);
+	} while (writenum);
 
 	/* Handle statistics */
 	for (unsigned int i = 0; i < total_written; i++) {
-		s = stream_fifo_pop(peer->obuf);
-
-		assert(s == ostreams[i]);
+		sb = segbuf_fifo_pop(peer->obuf);
 
 		/* Retrieve BGP packet type. */
-		stream_set_getp(s, BGP_MARKER_SIZE + 2);
-		type = stream_getc(s);
+		type = segbuf_getc_from(sb, BGP_MARKER_SIZE + 2);
+		segbuf_free(sb);
 
 		switch (type) {
 		case BGP_MSG_OPEN:
@@ -428,8 +426,6 @@ static uint16_t bgp_write(struct peer *peer)
 			break;
 		}
 
-		stream_free(s);
-		ostreams[i] = NULL;
 		update_last_write = 1;
 	}
 
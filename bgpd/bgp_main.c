@@ -495,6 +495,15 @@ int main(int argc, char **argv)
 	if (skip_runas)
 		memset(&bgpd_privs, 0, sizeof(bgpd_privs));
 
+	/* Recycle the most frequently allocated fixed-size objects.  BGP's
+	 * route nodes are BGP_NODE;  plain route_nodes are already carved out
+	 * of per-table chunks by route_node_create().
+	 */
+	mtype_pool_enable(MTYPE_BGP_NODE, sizeof(struct bgp_node));
+	mtype_pool_enable(MTYPE_BGP_ROUTE, sizeof(struct bgp_path_info));
+	mtype_pool_enable(MTYPE_ATTR, sizeof(struct attr));
+	nexthop_pool_enable();
+
 	/* BGP master init. */
 	bgp_master_init(frr_init(), buffer_size, addresses);
 	bm->port = bgp_port;
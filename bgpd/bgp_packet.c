@@ -25,6 +25,7 @@
 
 #include "thread.h"
 #include "stream.h"
+#include "segbuf.h"
 #include "network.h"
 #include "prefix.h"
 #include "command.h"
@@ -123,13 +124,19 @@ int bgp_packet_set_size(struct stream *s)
  * Push a packet onto the beginning of the peer's output queue.
  * This function acquires the peer's write mutex before proceeding.
  */
-static void bgp_packet_add(struct peer *peer, struct stream *s)
+static void bgp_packet_add_segbuf(struct peer *peer, struct segbuf *sb)
 {
 	frr_with_mutex(&peer->io_mtx) {
-		stream_fifo_push(peer->obuf, s);
+		segbuf_fifo_push(peer->obuf, sb);
 	}
 }
 
+/* Same, for a packet built in a stream;  the stream is consumed. */
+static void bgp_packet_add(struct peer *peer, struct stream *s)
+{
+	bgp_packet_add_segbuf(peer, segbuf_from_stream(s));
+}
+
 static struct stream *bgp_update_packet_eor(struct peer *peer, afi_t afi,
 					    safi_t safi)
 {
@@ -394,6 +401,7 @@ int bgp_generate_updgrp_packets(struct thread *thread)
 	struct peer *peer = THREAD_ARG(thread);
 
 	struct stream *s;
+	struct segbuf *sb;
 	struct peer_af *paf;
 	struct bpacket *next_pkt;
 	uint32_t wpq;
@@ -423,6 +431,7 @@ int bgp_generate_updgrp_packets(struct thread *thread)
 		enum bgp_af_index index;
 
 		s = NULL;
+		sb = NULL;
 		for (index = BGP_AF_START; index < BGP_AF_MAX; index++) {
 			paf = peer->peer_af_array[index];
 			if (!paf || !PAF_SUBGRP(paf))
@@ -534,11 +543,12 @@ int bgp_generate_updgrp_packets(struct thread *thread)
 			/* Found a packet template to send, overwrite
 			 * packet with appropriate attributes from peer
 			 * and advance peer */
-			s = bpacket_reformat_for_peer(next_pkt, paf);
-			bgp_packet_add(peer, s);
+			sb = bpacket_reformat_for_peer(next_pkt, paf);
+			if (sb)
+				bgp_packet_add_segbuf(peer, sb);
 			bpacket_queue_advance_peer(paf);
 		}
-	} while (s && (++generated < wpq));
+	} while ((s || sb) && (++generated < wpq));
 
 	if (generated)
 		bgp_writes_on(peer);
@@ -646,15 +656,17 @@ static void bgp_write_notify(struct peer *peer)
 {
 	int ret, val;
 	uint8_t type;
-	struct stream *s;
+	struct segbuf *sb;
+	struct iovec iov[4];
+	unsigned int niov;
 
 	/* There should be at least one packet. */
-	s = stream_fifo_pop(peer->obuf);
+	sb = segbuf_fifo_pop(peer->obuf);
 
-	if (!s)
+	if (!sb)
 		return;
 
-	assert(stream_get_endp(s) >= BGP_HEADER_SIZE);
+	assert(SEGBUF_READABLE(sb) >= BGP_HEADER_SIZE);
 
 	/* Stop collecting data within the socket */
 	sockopt_cork(peer->fd, 0);
@@ -663,14 +675,15 @@ static void bgp_write_notify(struct peer *peer)
 	 * socket is in nonblocking mode, if we can't deliver the NOTIFY, well,
 	 * we only care about getting a clean shutdown at this point.
 	 */
-	ret = write(peer->fd, STREAM_DATA(s), stream_get_endp(s));
+	niov = segbuf_iovec(sb, iov, array_size(iov));
+	ret = writev(peer->fd, iov, niov);
 
 	/*
 	 * only connection reset/close gets counted as TCP_fatal_error, failure
 	 * to write the entire NOTIFY doesn't get different FSM treatment
 	 */
 	if (ret <= 0) {
-		stream_free(s);
+		segbuf_free(sb);
 		BGP_EVENT_ADD(peer, TCP_fatal_error);
 		return;
 	}
@@ -681,8 +694,7 @@ static void bgp_write_notify(struct peer *peer)
 			 sizeof(val));
 
 	/* Retrieve BGP packet type. */
-	stream_set_getp(s, BGP_MARKER_SIZE + 2);
-	type = stream_getc(s);
+	type = segbuf_getc_from(sb, BGP_MARKER_SIZE + 2);
 
 	assert(type == BGP_MSG_NOTIFY);
 
@@ -703,7 +715,7 @@ static void bgp_write_notify(struct peer *peer)
 	 */
 	BGP_EVENT_ADD(peer, BGP_Stop);
 
-	stream_free(s);
+	segbuf_free(sb);
 }
 
 /*
@@ -753,7 +765,7 @@ void bgp_notify_send_with_data(struct peer *peer, uint8_t code,
 	bgp_packet_set_size(s);
 
 	/* wipe output buffer */
-	stream_fifo_clean(peer->obuf);
+	segbuf_fifo_clean(peer->obuf);
 
 	/*
 	 * If possible, store last packet for debugging purposes. This check is
@@ -822,7 +834,7 @@ void bgp_notify_send_with_data(struct peer *peer, uint8_t code,
 		peer->last_reset = PEER_DOWN_NOTIFY_SEND;
 
 	/* Add packet to peer's output queue */
-	stream_fifo_push(peer->obuf, s);
+	segbuf_fifo_push(peer->obuf, segbuf_from_stream(s));
 
 	bgp_peer_gr_flags_update(peer);
 	BGP_GR_ROUTER_DETECT_AND_SEND_CAPABILITY_TO_ZEBRA(peer->bgp,
@@ -93,6 +93,8 @@
 #include "bgpd/bgp_route_clippy.c"
 #endif
 
+DEFINE_MTYPE_STATIC(BGPD, BGP_SHOW_WALK, "BGP show walk");
+
 DEFINE_HOOK(bgp_snmp_update_stats,
 	    (struct bgp_node *rn, struct bgp_path_info *pi, bool added),
 	    (rn, pi, added));
@@ -10710,29 +10712,43 @@ static int bgp_show_community(struct vty *vty, struct bgp *bgp,
 			      const char *comstr, int exact, afi_t afi,
 			      safi_t safi, uint16_t show_flags);
 
-static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
-			  struct bgp_table *table, enum bgp_show_type type,
-			  void *output_arg, char *rd, int is_last,
-			  unsigned long *output_cum, unsigned long *total_cum,
-			  unsigned long *json_header_depth, uint16_t show_flags,
-			  enum rpki_states rpki_target_state)
+/* State of a bgp_show_table() walk.  A deferred "show bgp" keeps it across
+ * vty_defer() slices, resuming at (afi, safi, cursor); the instance and table
+ * are looked up again each time since either may have gone away meanwhile.
+ */
+struct bgp_show_walk {
+	/* filter */
+	enum bgp_show_type type;
+	void *output_arg;
+	char *output_str;
+	uint16_t show_flags;
+	enum rpki_states rpki_target_state;
+
+	/* where to continue */
+	char *bgp_name;
+	afi_t afi;
+	safi_t safi;
+	struct prefix cursor;
+	bool yield;
+	bool in_table;
+	bool first_afi_safi;
+
+	/* progress within the table */
+	int header;
+	int first;
+	unsigned long output_count;
+	unsigned long total_count;
+	unsigned long json_header_depth;
+};
+
+static void bgp_show_table_start(struct vty *vty, struct bgp *bgp,
+				 struct bgp_table *table, char *rd,
+				 unsigned long *json_header_depth,
+				 uint16_t show_flags)
 {
-	struct bgp_path_info *pi;
-	struct bgp_dest *dest;
-	int header = 1;
-	int display;
-	unsigned long output_count = 0;
-	unsigned long total_count = 0;
-	struct prefix *p;
-	json_object *json_paths = NULL;
-	int first = 1;
 	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
-	bool wide = CHECK_FLAG(show_flags, BGP_SHOW_OPT_WIDE);
 	bool all = CHECK_FLAG(show_flags, BGP_SHOW_OPT_AFI_ALL);
 
-	if (output_cum && *output_cum != 0)
-		header = 0;
-
 	if (use_json && !*json_header_depth) {
 		if (all)
 			*json_header_depth = 1;
@@ -10760,12 +10776,41 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 	if (use_json && rd) {
 		vty_out(vty, " \"%s\" : { ", rd);
 	}
+}
+
+/*
+ * Show the routes of table starting at (locked) dest.  If w->yield is set,
+ * returns CMD_SUSPEND with w->cursor set to the next prefix to show when the
+ * vty asks us to yield.
+ */
+static int bgp_show_table_walk(struct vty *vty, struct bgp *bgp, safi_t safi,
+			       struct bgp_table *table, struct bgp_dest *dest,
+			       char *rd, struct bgp_show_walk *w)
+{
+	struct bgp_path_info *pi;
+	int display;
+	struct prefix *p;
+	json_object *json_paths = NULL;
+	enum bgp_show_type type = w->type;
+	void *output_arg = w->output_arg;
+	uint16_t show_flags = w->show_flags;
+	enum rpki_states rpki_target_state = w->rpki_target_state;
+	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
+	bool wide = CHECK_FLAG(show_flags, BGP_SHOW_OPT_WIDE);
 
 	/* Start processing of routes. */
-	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
+	for (; dest; dest = bgp_route_next(dest)) {
 		const struct prefix *dest_p = bgp_dest_get_prefix(dest);
 		enum rpki_states rpki_curr_state = RPKI_NOT_BEING_USED;
 
+		/* flowspec prefixes point to their NLRI, don't keep them */
+		if (w->yield && dest_p->family != AF_FLOWSPEC
+		    && vty_defer_yield(vty)) {
+			prefix_copy(&w->cursor, dest_p);
+			bgp_dest_unlock_node(dest);
+			return CMD_SUSPEND;
+		}
+
 		pi = bgp_dest_get_bgp_path_info(dest);
 		if (pi == NULL)
 			continue;
@@ -10777,7 +10822,7 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 			json_paths = NULL;
 
 		for (; pi; pi = pi->next) {
-			total_count++;
+			w->total_count++;
 
 			if (type == bgp_show_type_prefix_version) {
 				uint32_t version =
@@ -10990,7 +11035,7 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 					continue;
 			}
 
-			if (!use_json && header) {
+			if (!use_json && w->header) {
 				vty_out(vty,
 					"BGP table version is %" PRIu64
 					", local router ID is %pI4, vrf id ",
@@ -11016,9 +11061,9 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 				else
 					vty_out(vty, (wide ? BGP_SHOW_HEADER_WIDE
 							   : BGP_SHOW_HEADER));
-				header = 0;
+				w->header = 0;
 			}
-			if (rd != NULL && !display && !output_count) {
+			if (rd != NULL && !display && !w->output_count) {
 				if (!use_json)
 					vty_out(vty,
 						"Route Distinguisher: %s\n",
@@ -11049,7 +11094,7 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 		}
 
 		if (display) {
-			output_count++;
+			w->output_count++;
 			if (!use_json)
 				continue;
 
@@ -11065,7 +11110,7 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 					retstr, NLRI_STRING_FORMAT_MIN, NULL,
 					family2afi(dest_p->u
 						   .prefix_flowspec.family));
-				if (first)
+				if (w->first)
 					vty_out(vty, "\"%s/%d\": ", retstr,
 						dest_p->u.prefix_flowspec
 							.prefixlen);
@@ -11074,7 +11119,7 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 						dest_p->u.prefix_flowspec
 							.prefixlen);
 			} else {
-				if (first)
+				if (w->first)
 					vty_out(vty, "\"%pFX\": ", dest_p);
 				else
 					vty_out(vty, ",\"%pFX\": ", dest_p);
@@ -11084,11 +11129,25 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 					json_paths, JSON_C_TO_STRING_PRETTY));
 			json_object_free(json_paths);
 			json_paths = NULL;
-			first = 0;
+			w->first = 0;
 		} else
 			json_object_free(json_paths);
 	}
 
+	return CMD_SUCCESS;
+}
+
+static int bgp_show_table_end(struct vty *vty, struct bgp_show_walk *w,
+			      char *rd, int is_last, unsigned long *output_cum,
+			      unsigned long *total_cum,
+			      unsigned long *json_header_depth)
+{
+	unsigned long output_count = w->output_count;
+	unsigned long total_count = w->total_count;
+	enum bgp_show_type type = w->type;
+	bool use_json = CHECK_FLAG(w->show_flags, BGP_SHOW_OPT_JSON);
+	bool all = CHECK_FLAG(w->show_flags, BGP_SHOW_OPT_AFI_ALL);
+
 	if (output_cum) {
 		output_count += *output_cum;
 		*output_cum = output_count;
@@ -11126,6 +11185,30 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 	return CMD_SUCCESS;
 }
 
+static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
+			  struct bgp_table *table, enum bgp_show_type type,
+			  void *output_arg, char *rd, int is_last,
+			  unsigned long *output_cum, unsigned long *total_cum,
+			  unsigned long *json_header_depth, uint16_t show_flags,
+			  enum rpki_states rpki_target_state)
+{
+	struct bgp_show_walk w = {
+		.type = type,
+		.output_arg = output_arg,
+		.show_flags = show_flags,
+		.rpki_target_state = rpki_target_state,
+		.header = !(output_cum && *output_cum),
+		.first = 1,
+	};
+
+	bgp_show_table_start(vty, bgp, table, rd, json_header_depth,
+			     show_flags);
+	bgp_show_table_walk(vty, bgp, safi, table, bgp_table_top(table), rd,
+			    &w);
+	return bgp_show_table_end(vty, &w, rd, is_last, output_cum, total_cum,
+				  json_header_depth);
+}
+
 int bgp_show_table_rd(struct vty *vty, struct bgp *bgp, safi_t safi,
 		      struct bgp_table *table, struct prefix_rd *prd_match,
 		      enum bgp_show_type type, void *output_arg, bool use_json)
@@ -11218,6 +11301,191 @@ static int bgp_show(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
 			      rpki_target_state);
 }
 
+/* Show (the rest of) the table of w->afi/w->safi */
+static int bgp_show_resume_table(struct vty *vty, struct bgp *bgp,
+				 struct bgp_show_walk *w)
+{
+	safi_t safi = w->safi;
+	struct bgp_table *table;
+	struct bgp_dest *dest;
+	bool use_json = CHECK_FLAG(w->show_flags, BGP_SHOW_OPT_JSON);
+
+	/* Labeled-unicast routes live in the unicast table. */
+	if (safi == SAFI_LABELED_UNICAST)
+		safi = SAFI_UNICAST;
+
+	table = bgp->rib[w->afi][safi];
+
+	if (!w->in_table) {
+		/* use MPLS and ENCAP specific shows until they are merged */
+		if (safi == SAFI_MPLS_VPN)
+			return bgp_show_table_rd(vty, bgp, safi, table, NULL,
+						 w->type, w->output_arg,
+						 use_json);
+
+		if (safi == SAFI_FLOWSPEC && w->type == bgp_show_type_detail)
+			return bgp_show_table_flowspec(vty, bgp, w->afi, table,
+						       w->type, w->output_arg,
+						       use_json, 1, NULL,
+						       NULL);
+
+		w->in_table = true;
+		w->header = 1;
+		w->first = 1;
+		w->output_count = 0;
+		w->total_count = 0;
+		w->json_header_depth = 0;
+		bgp_show_table_start(vty, bgp, table, NULL,
+				     &w->json_header_depth, w->show_flags);
+		dest = bgp_table_top(table);
+	} else {
+		dest = bgp_node_lookup(table, &w->cursor);
+		if (!dest)
+			dest = bgp_table_get_next(table, &w->cursor);
+	}
+
+	if (bgp_show_table_walk(vty, bgp, safi, table, dest, NULL, w)
+	    == CMD_SUSPEND)
+		return CMD_SUSPEND;
+
+	w->in_table = false;
+	return bgp_show_table_end(vty, w, NULL, 1, NULL, NULL,
+				  &w->json_header_depth);
+}
+
+/* vty_defer() continuation of bgp_show_deferred() */
+static int bgp_show_resume(struct vty *vty, void *arg)
+{
+	struct bgp_show_walk *w = arg;
+	struct bgp *bgp;
+	bool use_json = CHECK_FLAG(w->show_flags, BGP_SHOW_OPT_JSON);
+	bool all = CHECK_FLAG(w->show_flags, BGP_SHOW_OPT_AFI_ALL);
+	int ret;
+
+	bgp = bgp_lookup_by_name(w->bgp_name);
+	if (!bgp) {
+		/* instance went away, just close what we opened */
+		if (w->in_table) {
+			w->in_table = false;
+			bgp_show_table_end(vty, w, NULL, 1, NULL, NULL,
+					   &w->json_header_depth);
+			if (all && use_json)
+				vty_out(vty, "}\n");
+		}
+		if (all && use_json)
+			vty_out(vty, "}\n");
+		return CMD_SUCCESS;
+	}
+
+	if (!all)
+		return bgp_show_resume_table(vty, bgp, w);
+
+	/* show <ip> bgp [<ipv4|ipv6>] all: each AFI/SAFI with peers */
+	for (; w->afi < AFI_MAX; w->afi++, w->safi = SAFI_UNICAST) {
+		if ((CHECK_FLAG(w->show_flags, BGP_SHOW_OPT_AFI_IP)
+		     && w->afi != AFI_IP)
+		    || (CHECK_FLAG(w->show_flags, BGP_SHOW_OPT_AFI_IP6)
+			&& w->afi != AFI_IP6))
+			continue;
+
+		for (; w->safi < SAFI_MAX; w->safi++) {
+			if (!w->in_table) {
+				if (!bgp_afi_safi_peer_exists(bgp, w->afi,
+							      w->safi))
+					continue;
+
+				if (use_json) {
+					if (w->first_afi_safi)
+						w->first_afi_safi = false;
+					else
+						vty_out(vty, ",\n");
+					vty_out(vty, "\"%s\":{\n",
+						get_afi_safi_str(w->afi,
+								 w->safi,
+								 true));
+				} else
+					vty_out(vty,
+						"\nFor address family: %s\n",
+						get_afi_safi_str(w->afi,
+								 w->safi,
+								 false));
+			}
+
+			ret = bgp_show_resume_table(vty, bgp, w);
+			if (ret == CMD_SUSPEND)
+				return ret;
+
+			if (use_json)
+				vty_out(vty, "}\n");
+		}
+	}
+
+	if (use_json)
+		vty_out(vty, "}\n");
+	return CMD_SUCCESS;
+}
+
+static void bgp_show_walk_free(void *arg)
+{
+	struct bgp_show_walk *w = arg;
+
+	XFREE(MTYPE_BGP_SHOW_WALK, w->output_str);
+	XFREE(MTYPE_BGP_SHOW_WALK, w->bgp_name);
+	XFREE(MTYPE_BGP_SHOW_WALK, w);
+}
+
+/*
+ * Like bgp_show(), but lets the event loop run while the table is walked, so
+ * callers must return its result right away.  Only for filters without an
+ * argument or with a string one, which is copied.  With BGP_SHOW_OPT_AFI_ALL
+ * all address families (of the given AFI with BGP_SHOW_OPT_AFI_IP/IP6) which
+ * have peers are shown.
+ */
+static int bgp_show_deferred(struct vty *vty, struct bgp *bgp, afi_t afi,
+			     safi_t safi, enum bgp_show_type type,
+			     const char *output_str, uint16_t show_flags,
+			     enum rpki_states rpki_target_state)
+{
+	struct bgp_show_walk *w;
+	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
+
+	if (bgp == NULL) {
+		bgp = bgp_get_default();
+	}
+
+	if (bgp == NULL) {
+		if (!use_json)
+			vty_out(vty, "No BGP process is configured\n");
+		else
+			vty_out(vty, "{}\n");
+		return CMD_WARNING;
+	}
+
+	w = XCALLOC(MTYPE_BGP_SHOW_WALK, sizeof(*w));
+	w->type = type;
+	if (output_str) {
+		w->output_str = XSTRDUP(MTYPE_BGP_SHOW_WALK, output_str);
+		w->output_arg = w->output_str;
+	}
+	w->show_flags = show_flags;
+	w->rpki_target_state = rpki_target_state;
+	if (bgp->name)
+		w->bgp_name = XSTRDUP(MTYPE_BGP_SHOW_WALK, bgp->name);
+	w->afi = afi;
+	w->safi = safi;
+	w->yield = true;
+
+	if (CHECK_FLAG(show_flags, BGP_SHOW_OPT_AFI_ALL)) {
+		w->afi = AFI_IP;
+		w->safi = SAFI_UNICAST;
+		w->first_afi_safi = true;
+		if (use_json)
+			vty_out(vty, "{\n");
+	}
+
+	return vty_defer(vty, bgp_show_resume, w, bgp_show_walk_free);
+}
+
 static void bgp_show_all_instances_routes_vty(struct vty *vty, afi_t afi,
 					      safi_t safi, uint16_t show_flags)
 {
@@ -11868,9 +12136,9 @@ DEFUN (show_ip_bgp_large_community,
 		return bgp_show_lcommunity(vty, bgp, argc, argv,
 					exact_match, afi, safi, uj);
 	} else
-		return bgp_show(vty, bgp, afi, safi,
-				bgp_show_type_lcommunity_all, NULL, show_flags,
-				RPKI_NOT_BEING_USED);
+		return bgp_show_deferred(vty, bgp, afi, safi,
+					 bgp_show_type_lcommunity_all, NULL,
+					 show_flags, RPKI_NOT_BEING_USED);
 }
 
 static int bgp_table_stats_single(struct vty *vty, struct bgp *bgp, afi_t afi,
@@ -12255,16 +12523,21 @@ DEFPY(show_ip_bgp_json, show_ip_bgp_json_cmd,
 						  exact_match, afi, safi,
 						  show_flags);
 		else if (prefix_version)
-			return bgp_show(vty, bgp, afi, safi, sh_type,
-					prefix_version, show_flags,
-					rpki_target_state);
+			return bgp_show_deferred(vty, bgp, afi, safi, sh_type,
+						 prefix_version, show_flags,
+						 rpki_target_state);
 		else if (bgp_community_alias)
-			return bgp_show(vty, bgp, afi, safi, sh_type,
-					bgp_community_alias, show_flags,
-					rpki_target_state);
+			return bgp_show_deferred(vty, bgp, afi, safi, sh_type,
+						 bgp_community_alias,
+						 show_flags,
+						 rpki_target_state);
 		else
-			return bgp_show(vty, bgp, afi, safi, sh_type, NULL,
-					show_flags, rpki_target_state);
+			return bgp_show_deferred(vty, bgp, afi, safi, sh_type,
+						 NULL, show_flags,
+						 rpki_target_state);
+	} else if (!community && !prefix_version && !bgp_community_alias) {
+		return bgp_show_deferred(vty, bgp, afi, safi, sh_type, NULL,
+					 show_flags, rpki_target_state);
 	} else {
 		/* show <ip> bgp ipv4 all: AFI_IP, show <ip> bgp ipv6 all:
 		 * AFI_IP6 */
@@ -14103,8 +14376,8 @@ DEFUN (show_ip_bgp_flowspec_routes_detailed,
 	if (!idx)
 		return CMD_WARNING;
 
-	return bgp_show(vty, bgp, afi, safi, bgp_show_type_detail, NULL,
-			show_flags, RPKI_NOT_BEING_USED);
+	return bgp_show_deferred(vty, bgp, afi, safi, bgp_show_type_detail,
+				 NULL, show_flags, RPKI_NOT_BEING_USED);
 }
 
 DEFUN (show_ip_bgp_neighbor_routes,
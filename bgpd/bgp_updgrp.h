@@ -101,6 +101,10 @@ struct bpacket {
 	LIST_HEAD(pkt_peer_list, peer_af) peers;
 
 	struct stream *buffer;
+	/* buffer wrapped for sharing it with peers' output queues, created
+	 * on first use;  owns buffer once set
+	 */
+	struct segbuf *seg;
 	bpacket_attr_vec_arr arr;
 
 	unsigned int ver;
@@ -401,7 +405,7 @@ extern void bpacket_queue_show_vty(struct bpacket_queue *q, struct vty *vty);
 bool subgroup_packets_to_build(struct update_subgroup *subgrp);
 extern struct bpacket *subgroup_update_packet(struct update_subgroup *s);
 extern struct bpacket *subgroup_withdraw_packet(struct update_subgroup *s);
-extern struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
+extern struct segbuf *bpacket_reformat_for_peer(struct bpacket *pkt,
 						struct peer_af *paf);
 extern void bpacket_attr_vec_arr_reset(struct bpacket_attr_vec_arr *vecarr);
 extern void bpacket_attr_vec_arr_set_vec(struct bpacket_attr_vec_arr *vecarr,
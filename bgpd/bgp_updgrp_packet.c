@@ -30,6 +30,7 @@
 #include "thread.h"
 #include "buffer.h"
 #include "stream.h"
+#include "segbuf.h"
 #include "command.h"
 #include "sockunion.h"
 #include "network.h"
@@ -76,8 +77,12 @@ struct bpacket *bpacket_alloc(void)
 
 void bpacket_free(struct bpacket *pkt)
 {
-	if (pkt->buffer)
+	/* peers may still hold references to the packet data */
+	if (pkt->seg)
+		segbuf_free(pkt->seg);
+	else if (pkt->buffer)
 		stream_free(pkt->buffer);
+	pkt->seg = NULL;
 	pkt->buffer = NULL;
 	XFREE(MTYPE_BGP_PACKET, pkt);
 }
@@ -344,7 +349,11 @@ void bpacket_queue_show_vty(struct bpacket_queue *q, struct vty *vty)
 	return;
 }
 
-struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
+/*
+ * Returns the packet to queue for the peer.  Unless the nexthop needs to be
+ * rewritten, this references the update group's packet instead of copying.
+ */
+struct segbuf *bpacket_reformat_for_peer(struct bpacket *pkt,
 					 struct peer_af *paf)
 {
 	struct stream *s = NULL;
@@ -352,13 +361,16 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 	struct peer *peer;
 	struct bgp_filter *filter;
 
-	s = stream_dup(pkt->buffer);
-	peer = PAF_PEER(paf);
-
 	vec = &pkt->arr.entries[BGP_ATTR_VEC_NH];
 
-	if (!CHECK_FLAG(vec->flags, BPKT_ATTRVEC_FLAGS_UPDATED))
-		return s;
+	if (!CHECK_FLAG(vec->flags, BPKT_ATTRVEC_FLAGS_UPDATED)) {
+		if (!pkt->seg)
+			pkt->seg = segbuf_from_stream(pkt->buffer);
+		return segbuf_clone(pkt->seg);
+	}
+
+	s = stream_dup(pkt->buffer);
+	peer = PAF_PEER(paf);
 
 	uint8_t nhlen;
 	afi_t nhafi;
@@ -608,7 +620,7 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 				   PAF_SUBGRP(paf)->id, peer->host, mod_v4nh);
 	}
 
-	return s;
+	return segbuf_from_stream(s);
 }
 
 /*
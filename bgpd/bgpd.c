@@ -1398,7 +1398,7 @@ struct peer *peer_new(struct bgp *bgp)
 
 	/* Create buffers.  */
 	peer->ibuf = stream_fifo_new();
-	peer->obuf = stream_fifo_new();
+	peer->obuf = segbuf_fifo_new();
 	pthread_mutex_init(&peer->io_mtx, NULL);
 
 	/* We use a larger buffer for peer->obuf_work in the event that:
@@ -2473,7 +2473,7 @@ int peer_delete(struct peer *peer)
 	}
 
 	if (peer->obuf) {
-		stream_fifo_free(peer->obuf);
+		segbuf_fifo_free(peer->obuf);
 		peer->obuf = NULL;
 	}
 
@@ -35,6 +35,7 @@
 /* For union sockunion.  */
 #include "queue.h"
 #include "sockunion.h"
+#include "segbuf.h"
 #include "routemap.h"
 #include "linklist.h"
 #include "defaults.h"
@@ -1100,7 +1101,7 @@ struct peer {
 	/* Packet receive and send buffer. */
 	pthread_mutex_t io_mtx;   // guards ibuf, obuf
 	struct stream_fifo *ibuf; // packets waiting to be processed
-	struct stream_fifo *obuf; // packets waiting to be written
+	struct segbuf_fifo *obuf; // packets waiting to be written
 
 	/* used as a block to deposit raw wire data to */
 	uint8_t ibuf_scratch[BGP_EXTENDED_MESSAGE_MAX_PACKET_SIZE
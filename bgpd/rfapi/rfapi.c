@@ -1264,7 +1264,7 @@ static int rfapi_open_inner(struct rfapi_descriptor *rfd, struct bgp *bgp,
 		if (rfd->peer->ibuf)
 			stream_fifo_free(rfd->peer->ibuf);
 		if (rfd->peer->obuf)
-			stream_fifo_free(rfd->peer->obuf);
+			segbuf_fifo_free(rfd->peer->obuf);
 
 		if (rfd->peer->ibuf_work)
 			ringbuf_del(rfd->peer->ibuf_work);
@@ -1117,6 +1117,172 @@ struct isis_spftree *isis_spf_reverse_run(const struct isis_spftree *spftree)
 	return spftree_reverse;
 }
 
+/**
+ * Detach the cached neighbor SPTs from the list of adjacent nodes, so that
+ * they survive the next SPF run.
+ *
+ * @param spftree	IS-IS SPF tree
+ */
+void isis_spf_lfa_cache_detach(struct isis_spftree *spftree)
+{
+	struct isis_spf_node *adj_node;
+
+	if (RB_EMPTY(isis_spf_nodes, &spftree->lfa.cache.nodes))
+		return;
+
+	RB_FOREACH (adj_node, isis_spf_nodes, &spftree->adj_nodes) {
+		adj_node->lfa.spftree = NULL;
+		adj_node->lfa.spftree_reverse = NULL;
+	}
+}
+
+/*
+ * Remove a neighbor and its SPTs from the cache.
+ */
+static void isis_spf_lfa_cache_node_del(struct isis_spftree *spftree,
+					struct isis_spf_node *cache_node)
+{
+	RB_REMOVE(isis_spf_nodes, &spftree->lfa.cache.nodes, cache_node);
+	if (cache_node->adjacencies)
+		list_delete(&cache_node->adjacencies);
+	isis_spftree_del(cache_node->lfa.spftree);
+	if (cache_node->lfa.spftree_reverse)
+		isis_spftree_del(cache_node->lfa.spftree_reverse);
+	isis_spf_node_list_clear(&cache_node->lfa.p_space);
+	XFREE(MTYPE_ISIS_SPF_NODE, cache_node);
+}
+
+/**
+ * Release all SPTs cached on behalf of the given SPF tree.
+ *
+ * @param spftree	IS-IS SPF tree
+ */
+void isis_spf_lfa_cache_clear(struct isis_spftree *spftree)
+{
+	isis_spf_lfa_cache_detach(spftree);
+	isis_spf_node_list_clear(&spftree->lfa.cache.nodes);
+	isis_spf_node_list_clear(&spftree->lfa.cache.changed);
+	if (spftree->lfa.cache.spftree_reverse) {
+		isis_spftree_del(spftree->lfa.cache.spftree_reverse);
+		spftree->lfa.cache.spftree_reverse = NULL;
+	}
+}
+
+static void isis_spf_lfa_cache_note(struct isis_spftree *spftree,
+				    const uint8_t *sysid)
+{
+	if (!isis_spf_node_find(&spftree->lfa.cache.changed, sysid))
+		isis_spf_node_new(&spftree->lfa.cache.changed, sysid);
+}
+
+/**
+ * Record an LSP change for the SPTs cached on behalf of the given SPF tree:
+ * the System ID of the LSP's originator and those of the neighbors it
+ * advertises. Nothing is recorded while the cache is empty.
+ *
+ * @param spftree	IS-IS SPF tree
+ * @param lsp		The LSP that changed, was purged or is being deleted
+ */
+void isis_spf_lfa_cache_lsp_changed(struct isis_spftree *spftree,
+				    const struct isis_lsp *lsp)
+{
+	struct isis_oldstyle_reach *r;
+	struct isis_extended_reach *er;
+	struct isis_item_list *te_neighs;
+
+	if (RB_EMPTY(isis_spf_nodes, &spftree->lfa.cache.nodes)
+	    && !spftree->lfa.cache.spftree_reverse)
+		return;
+
+	isis_spf_lfa_cache_note(spftree, lsp->hdr.lsp_id);
+	if (!lsp->tlvs)
+		return;
+
+	for (r = (struct isis_oldstyle_reach *)lsp->tlvs->oldstyle_reach.head;
+	     r; r = r->next)
+		isis_spf_lfa_cache_note(spftree, r->id);
+
+	for (er = (struct isis_extended_reach *)lsp->tlvs->extended_reach.head;
+	     er; er = er->next)
+		isis_spf_lfa_cache_note(spftree, er->id);
+
+	te_neighs = isis_lookup_mt_items(&lsp->tlvs->mt_reach, spftree->mtid);
+	for (er = te_neighs ? (struct isis_extended_reach *)te_neighs->head
+			    : NULL;
+	     er; er = er->next)
+		isis_spf_lfa_cache_note(spftree, er->id);
+}
+
+/*
+ * Check whether a cached SPT contains any of the routers whose LSPs, or
+ * whose neighbors' LSPs, changed. The pseudonode LSPs of a LAN list all
+ * routers on it, so looking up the non-pseudonode vertices is enough.
+ */
+static bool isis_spf_lfa_cache_affected(struct isis_spftree *tree,
+					const struct isis_spf_nodes *changed)
+{
+	struct isis_spf_node *node;
+	uint8_t id[ISIS_SYS_ID_LEN + 1] = {};
+
+	RB_FOREACH (node, isis_spf_nodes, changed) {
+		memcpy(id, node->sysid, ISIS_SYS_ID_LEN);
+		if (isis_find_vertex(&tree->paths, id, VTYPE_NONPSEUDO_IS)
+		    || isis_find_vertex(&tree->paths, id,
+					VTYPE_NONPSEUDO_TE_IS))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Invalidate the cached SPTs that the LSP changes recorded since the last
+ * check may affect.
+ */
+static void isis_spf_lfa_cache_check(struct isis_spftree *spftree)
+{
+	struct isis_spf_nodes *changed = &spftree->lfa.cache.changed;
+	struct isis_spf_node *cache_node, *safe;
+
+	if (RB_EMPTY(isis_spf_nodes, changed))
+		return;
+
+	if (spftree->lfa.cache.spftree_reverse
+	    && isis_spf_lfa_cache_affected(spftree->lfa.cache.spftree_reverse,
+					   changed)) {
+		if (IS_DEBUG_LFA)
+			zlog_debug("ISIS-LFA: flushing cached reverse SPT");
+		isis_spftree_del(spftree->lfa.cache.spftree_reverse);
+		spftree->lfa.cache.spftree_reverse = NULL;
+	}
+
+	RB_FOREACH_SAFE (cache_node, isis_spf_nodes, &spftree->lfa.cache.nodes,
+			 safe) {
+		if (isis_spf_lfa_cache_affected(cache_node->lfa.spftree,
+						changed)) {
+			if (IS_DEBUG_LFA)
+				zlog_debug(
+					"ISIS-LFA: flushing cached SPTs of neighbor %s",
+					print_sys_hostname(cache_node->sysid));
+			isis_spf_lfa_cache_node_del(spftree, cache_node);
+			continue;
+		}
+
+		if (cache_node->lfa.spftree_reverse
+		    && isis_spf_lfa_cache_affected(
+			    cache_node->lfa.spftree_reverse, changed)) {
+			if (IS_DEBUG_LFA)
+				zlog_debug(
+					"ISIS-LFA: flushing cached reverse SPT of neighbor %s",
+					print_sys_hostname(cache_node->sysid));
+			isis_spftree_del(cache_node->lfa.spftree_reverse);
+			cache_node->lfa.spftree_reverse = NULL;
+		}
+	}
+
+	isis_spf_node_list_clear(changed);
+}
+
 /*
  * Calculate the Extended P-space and Q-space associated to a given link
  * failure.
@@ -1151,11 +1317,22 @@ static void lfa_calc_pq_spaces(struct isis_spftree *spftree_pc,
 			 * adjacent to the failure, if we haven't done that
 			 * before
 			 */
-			if (!adj_node->lfa.spftree_reverse)
+			if (!adj_node->lfa.spftree_reverse) {
+				struct isis_spf_node *cache_node;
+
 				adj_node->lfa.spftree_reverse =
 					isis_spf_reverse_run(
 						adj_node->lfa.spftree);
 
+				/* Keep it around for the next SPF runs. */
+				cache_node = isis_spf_node_find(
+					&spftree->lfa.cache.nodes,
+					adj_node->sysid);
+				if (cache_node)
+					cache_node->lfa.spftree_reverse =
+						adj_node->lfa.spftree_reverse;
+			}
+
 			lfa_calc_reach_nodes(adj_node->lfa.spftree_reverse,
 					     spftree_reverse, adj_nodes, false,
 					     resource,
@@ -1241,22 +1418,46 @@ int isis_spf_run_neighbors(struct isis_spftree *spftree)
 {
 	struct isis_lsp *lsp;
 	struct isis_spf_node *adj_node;
+	struct isis_spf_node *cache_node, *safe;
 
 	lsp = isis_root_system_lsp(spftree->lspdb, spftree->sysid);
 	if (!lsp)
 		return -1;
 
+	isis_spf_lfa_cache_check(spftree);
+
 	RB_FOREACH (adj_node, isis_spf_nodes, &spftree->adj_nodes) {
-		if (IS_DEBUG_LFA)
-			zlog_debug("ISIS-LFA: running SPF on neighbor %s",
-				   print_sys_hostname(adj_node->sysid));
-
-		/* Compute the SPT on behalf of the neighbor. */
-		adj_node->lfa.spftree = isis_spftree_new(
-			spftree->area, spftree->lspdb, adj_node->sysid,
-			spftree->level, spftree->tree_id, SPF_TYPE_FORWARD,
-			F_SPFTREE_NO_ADJACENCIES | F_SPFTREE_NO_ROUTES);
-		isis_run_spf(adj_node->lfa.spftree);
+		cache_node = isis_spf_node_find(&spftree->lfa.cache.nodes,
+						adj_node->sysid);
+		if (!cache_node) {
+			if (IS_DEBUG_LFA)
+				zlog_debug(
+					"ISIS-LFA: running SPF on neighbor %s",
+					print_sys_hostname(adj_node->sysid));
+
+			/* Compute the SPT on behalf of the neighbor. */
+			cache_node = isis_spf_node_new(
+				&spftree->lfa.cache.nodes, adj_node->sysid);
+			cache_node->lfa.spftree = isis_spftree_new(
+				spftree->area, spftree->lspdb, adj_node->sysid,
+				spftree->level, spftree->tree_id,
+				SPF_TYPE_FORWARD,
+				F_SPFTREE_NO_ADJACENCIES | F_SPFTREE_NO_ROUTES);
+			isis_run_spf(cache_node->lfa.spftree);
+		}
+
+		/* The cache retains ownership of the SPTs. */
+		adj_node->lfa.spftree = cache_node->lfa.spftree;
+		adj_node->lfa.spftree_reverse = cache_node->lfa.spftree_reverse;
+	}
+
+	/* Release the SPTs of routers that are no longer adjacent. */
+	RB_FOREACH_SAFE (cache_node, isis_spf_nodes, &spftree->lfa.cache.nodes,
+			 safe) {
+		if (isis_spf_node_find(&spftree->adj_nodes, cache_node->sysid))
+			continue;
+
+		isis_spf_lfa_cache_node_del(spftree, cache_node);
 	}
 
 	return 0;
@@ -2285,14 +2486,18 @@ void isis_spf_run_lfa(struct isis_area *area, struct isis_spftree *spftree)
 	struct listnode *node;
 	int level = spftree->level;
 
-	/* Run reverse SPF locally. */
-	if (area->rlfa_protected_links[level - 1] > 0
-	    || area->tilfa_protected_links[level - 1] > 0)
-		spftree_reverse = isis_spf_reverse_run(spftree);
-
 	/* Run forward SPF on all adjacent routers. */
 	isis_spf_run_neighbors(spftree);
 
+	/* Run reverse SPF locally, unless the LSDB didn't change. */
+	if (area->rlfa_protected_links[level - 1] > 0
+	    || area->tilfa_protected_links[level - 1] > 0) {
+		if (!spftree->lfa.cache.spftree_reverse)
+			spftree->lfa.cache.spftree_reverse =
+				isis_spf_reverse_run(spftree);
+		spftree_reverse = spftree->lfa.cache.spftree_reverse;
+	}
+
 	/* Check which interfaces are protected. */
 	for (ALL_LIST_ELEMENTS_RO(area->circuit_list, node, circuit)) {
 		struct lfa_protected_resource resource = {};
@@ -2358,7 +2563,4 @@ void isis_spf_run_lfa(struct isis_area *area, struct isis_spftree *spftree)
 					   spftree_reverse, &resource);
 		}
 	}
-
-	if (spftree_reverse)
-		isis_spftree_del(spftree_reverse);
 }
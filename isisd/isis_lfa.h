@@ -159,6 +159,10 @@ bool isis_lfa_excise_node_check(const struct isis_spftree *spftree,
 				const uint8_t *id);
 struct isis_spftree *isis_spf_reverse_run(const struct isis_spftree *spftree);
 int isis_spf_run_neighbors(struct isis_spftree *spftree);
+void isis_spf_lfa_cache_detach(struct isis_spftree *spftree);
+void isis_spf_lfa_cache_clear(struct isis_spftree *spftree);
+void isis_spf_lfa_cache_lsp_changed(struct isis_spftree *spftree,
+				    const struct isis_lsp *lsp);
 int isis_rlfa_activate(struct isis_spftree *spftree, struct rlfa *rlfa,
 		       struct zapi_rlfa_response *response);
 void isis_rlfa_deactivate(struct isis_spftree *spftree, struct rlfa *rlfa);
@@ -66,6 +66,30 @@ static int lsp_refresh(struct thread *thread);
 static int lsp_l1_refresh_pseudo(struct thread *thread);
 static int lsp_l2_refresh_pseudo(struct thread *thread);
 
+/*
+ * Let the SPTs cached across SPF runs know about an LSP change, so that the
+ * ones it may affect are recalculated.
+ */
+static void lsp_spf_cache_changed(struct isis_lsp *lsp)
+{
+	struct isis_spftree *spftree;
+
+	for (int tree = SPFTREE_IPV4; tree < SPFTREE_COUNT; tree++) {
+		spftree = lsp->area->spftree[tree][lsp->level - 1];
+		if (spftree)
+			isis_spf_lfa_cache_lsp_changed(spftree, lsp);
+	}
+}
+
+/*
+ * Note an LSP change that can affect SPF results.
+ */
+static void lsp_spf_changed(struct isis_lsp *lsp)
+{
+	lsp_spf_cache_changed(lsp);
+	isis_spf_schedule(lsp->area, lsp->level);
+}
+
 static void lsp_destroy(struct isis_lsp *lsp);
 
 int lsp_id_cmp(uint8_t *id1, uint8_t *id2)
@@ -139,7 +163,7 @@ static void lsp_destroy(struct isis_lsp *lsp)
 		}
 	}
 
-	isis_spf_schedule(lsp->area, lsp->level);
+	lsp_spf_changed(lsp);
 
 	if (lsp->pdu)
 		stream_free(lsp->pdu);
@@ -334,7 +358,7 @@ void lsp_inc_seqno(struct isis_lsp *lsp, uint32_t seqno)
 	lsp->hdr.seqno = newseq;
 
 	lsp_pack_pdu(lsp);
-	isis_spf_schedule(lsp->area, lsp->level);
+	lsp_spf_changed(lsp);
 }
 
 static void lsp_purge_add_poi(struct isis_lsp *lsp,
@@ -367,6 +391,7 @@ static void lsp_purge(struct isis_lsp *lsp, int level,
 	lsp->level = level;
 	lsp->age_out = lsp->area->max_lsp_lifetime[level - 1];
 	lsp->area->lsp_purge_count[level - 1]++;
+	lsp_spf_cache_changed(lsp);
 
 	lsp_purge_add_poi(lsp, sender);
 
@@ -540,10 +565,38 @@ static void lsp_link_fragment(struct isis_lsp *lsp, struct isis_lsp *lsp0)
 	}
 }
 
+/*
+ * Check whether a received LSP instance differs from the installed one in
+ * anything but its sequence number, lifetime and checksum, i.e. whether it
+ * is more than a refresh.
+ */
+static bool lsp_content_changed(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
+				struct stream *stream)
+{
+	size_t hdr_len = ISIS_FIXED_HDR_LEN + ISIS_LSP_HDR_LEN;
+	size_t len = stream_get_endp(stream);
+
+	if (!lsp->pdu || !lsp->hdr.rem_lifetime || !hdr->rem_lifetime)
+		return true;
+
+	if (lsp->hdr.lsp_bits != hdr->lsp_bits)
+		return true;
+
+	if (stream_get_endp(lsp->pdu) != len || len < hdr_len)
+		return true;
+
+	return memcmp(STREAM_DATA(lsp->pdu) + hdr_len,
+		      STREAM_DATA(stream) + hdr_len, len - hdr_len)
+	       != 0;
+}
+
 void lsp_update(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 		struct isis_tlvs *tlvs, struct stream *stream,
 		struct isis_area *area, int level, bool confusion)
 {
+	bool changed = confusion || lsp->own_lsp
+		       || lsp_content_changed(lsp, hdr, stream);
+
 	if (lsp->own_lsp) {
 		flog_err(
 			EC_LIB_DEVELOPMENT,
@@ -570,8 +623,9 @@ void lsp_update(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 			lsp_link_fragment(lsp, lsp0);
 	}
 
-	if (lsp->hdr.seqno)
-		isis_spf_schedule(lsp->area, lsp->level);
+	/* A refresh with unchanged content doesn't affect SPF. */
+	if (lsp->hdr.seqno && changed)
+		lsp_spf_changed(lsp);
 }
 
 /* creation of LSP directly from what we received */
@@ -637,7 +691,7 @@ void lsp_insert(struct lspdb_head *head, struct isis_lsp *lsp)
 {
 	lspdb_add(head, lsp);
 	if (lsp->hdr.seqno)
-		isis_spf_schedule(lsp->area, lsp->level);
+		lsp_spf_changed(lsp);
 }
 
 /*
@@ -936,10 +990,20 @@ static void lsp_build(struct isis_lsp *lsp, struct isis_area *area)
 	int level = lsp->level;
 	struct listnode *node;
 	struct isis_lsp *frag;
+	struct isis_tlvs *prev_tlvs[256];
+	struct isis_tlvs *frag_tlvs[256];
 
-	lsp_clear_data(lsp);
-	for (ALL_LIST_ELEMENTS_RO(lsp->lspu.frags, node, frag))
-		lsp_clear_data(frag);
+	/*
+	 * Hold on to the current content, the entries which are still there
+	 * stay in the fragment they were in.
+	 */
+	memset(prev_tlvs, 0, sizeof(prev_tlvs));
+	prev_tlvs[0] = lsp->tlvs;
+	lsp->tlvs = NULL;
+	for (ALL_LIST_ELEMENTS_RO(lsp->lspu.frags, node, frag)) {
+		prev_tlvs[LSP_FRAGMENT(frag->hdr.lsp_id)] = frag->tlvs;
+		frag->tlvs = NULL;
+	}
 
 	lsp->tlvs = isis_alloc_tlvs();
 	lsp_debug("ISIS (%s): Constructing local system LSP for level %d",
@@ -1241,8 +1305,11 @@ static void lsp_build(struct isis_lsp *lsp, struct isis_area *area)
 	size_t tlv_space = STREAM_WRITEABLE(lsp->pdu) - LLC_LEN;
 	lsp_clear_data(lsp);
 
-	struct list *fragments = isis_fragment_tlvs(tlvs, tlv_space);
-	if (!fragments) {
+	int rv = isis_fragment_tlvs_stable(tlvs, tlv_space, prev_tlvs,
+					   frag_tlvs);
+	for (size_t i = 0; i < array_size(prev_tlvs); i++)
+		isis_free_tlvs(prev_tlvs[i]);
+	if (rv < 0) {
 		zlog_warn("BUG: could not fragment own LSP:");
 		log_multiline(LOG_WARNING, "    ", "%s",
 			      isis_format_tlvs(tlvs));
@@ -1251,29 +1318,23 @@ static void lsp_build(struct isis_lsp *lsp, struct isis_area *area)
 	}
 	isis_free_tlvs(tlvs);
 
-	bool fragment_overflow = false;
-	frag = lsp;
-	for (ALL_LIST_ELEMENTS_RO(fragments, node, tlvs)) {
-		if (node != listhead(fragments)) {
-			if (LSP_FRAGMENT(frag->hdr.lsp_id) == 255) {
-				if (!fragment_overflow) {
-					fragment_overflow = true;
-					zlog_warn(
-						"ISIS (%s): Too much information for 256 fragments",
-						area->area_tag);
-				}
-				isis_free_tlvs(tlvs);
-				continue;
-			}
+	if (rv > 0)
+		zlog_warn("ISIS (%s): Too much information for 256 fragments",
+			  area->area_tag);
+
+	/* Fragments left without content get purged by the caller */
+	for (size_t i = 0; i < array_size(frag_tlvs); i++) {
+		if (!frag_tlvs[i])
+			continue;
 
-			frag = lsp_next_frag(LSP_FRAGMENT(frag->hdr.lsp_id) + 1,
-					     lsp, area, level);
+		frag = lsp;
+		if (i) {
+			frag = lsp_next_frag(i, lsp, area, level);
 			lsp_adjust_stream(frag);
 		}
-		frag->tlvs = tlvs;
+		frag->tlvs = frag_tlvs[i];
 	}
 
-	list_delete(&fragments);
 	lsp_debug("ISIS (%s): LSP construction is complete. Serializing...",
 		  area->area_tag);
 	return;
@@ -1350,6 +1411,63 @@ int lsp_generate(struct isis_area *area, int level)
 	return ISIS_OK;
 }
 
+/* Offsets of the remaining lifetime and LSP ID in an LSP PDU */
+#define LSP_REM_LIFETIME_OFFSET (ISIS_FIXED_HDR_LEN + 2)
+#define LSP_ID_OFFSET (ISIS_FIXED_HDR_LEN + 4)
+
+/*
+ * Check whether a re-packed own LSP is identical to its previous instance,
+ * not taking the remaining lifetime into account.
+ */
+static bool lsp_pdu_unchanged(struct stream *pdu, struct stream *old)
+{
+	size_t len = stream_get_endp(pdu);
+
+	if (stream_get_endp(old) != len || len < LSP_ID_OFFSET)
+		return false;
+
+	return !memcmp(STREAM_DATA(pdu), STREAM_DATA(old),
+		       LSP_REM_LIFETIME_OFFSET)
+	       && !memcmp(STREAM_DATA(pdu) + LSP_ID_OFFSET,
+			  STREAM_DATA(old) + LSP_ID_OFFSET,
+			  len - LSP_ID_OFFSET);
+}
+
+/*
+ * Update and flood a regenerated fragment of our own LSP, unless its
+ * content didn't change. In that case the current instance is kept, and
+ * the next refresh is brought forward so that it is refreshed at least 300
+ * seconds before it expires (RFC 4444).
+ */
+static void lsp_regenerate_frag(struct isis_lsp *lsp, struct stream *old,
+				uint16_t rem_lifetime, uint16_t *refresh_time)
+{
+	struct isis_area *area = lsp->area;
+	int level = lsp->level;
+
+	if (old
+	    && lsp->hdr.rem_lifetime
+		       >= area->lsp_gen_interval[level - 1] + 300) {
+		lsp_pack_pdu(lsp);
+		if (lsp_pdu_unchanged(lsp->pdu, old)) {
+			lsp_debug("ISIS (%s): LSP %s unchanged, not flooding",
+				  area->area_tag,
+				  rawlspid_print(lsp->hdr.lsp_id));
+			*refresh_time = MIN(*refresh_time,
+					    lsp->hdr.rem_lifetime - 300);
+			return;
+		}
+	}
+
+	/* Set the lifetime values of all the fragments to the same value, so
+	 * that no fragment expires before the lsp is refreshed.
+	 */
+	lsp->hdr.rem_lifetime = rem_lifetime;
+	lsp->age_out = ZERO_AGE_LIFETIME;
+	lsp_flood(lsp, NULL);
+	lsp_inc_seqno(lsp, 0);
+}
+
 /*
  * Search own LSPs, update holding time and flood
  */
@@ -1360,6 +1478,7 @@ static int lsp_regenerate(struct isis_area *area, int level)
 	struct listnode *node;
 	uint8_t lspid[ISIS_SYS_ID_LEN + 2];
 	uint16_t rem_lifetime, refresh_time;
+	struct stream *old_pdus[256];
 
 	if ((area == NULL) || (area->is_type & level) != level)
 		return ISIS_ERROR;
@@ -1377,35 +1496,46 @@ static int lsp_regenerate(struct isis_area *area, int level)
 		return ISIS_ERROR;
 	}
 
-	lsp_clear_data(lsp);
+	/*
+	 * Keep a copy of the current fragments, so that only those whose
+	 * content changes are re-sequenced and flooded.
+	 */
+	memset(old_pdus, 0, sizeof(old_pdus));
+	if (lsp->pdu && lsp->hdr.seqno)
+		old_pdus[0] = stream_dup(lsp->pdu);
+	for (ALL_LIST_ELEMENTS_RO(lsp->lspu.frags, node, frag)) {
+		if (frag->tlvs && frag->pdu && frag->hdr.seqno)
+			old_pdus[LSP_FRAGMENT(frag->hdr.lsp_id)] =
+				stream_dup(frag->pdu);
+	}
+
 	lsp_build(lsp, area);
 	rem_lifetime = lsp_rem_lifetime(area, level);
-	lsp->hdr.rem_lifetime = rem_lifetime;
+	refresh_time = lsp_refresh_time(lsp, rem_lifetime);
 	lsp->last_generated = time(NULL);
-	lsp_flood(lsp, NULL);
 	area->lsp_gen_count[level - 1]++;
+	lsp_regenerate_frag(lsp, old_pdus[0], rem_lifetime, &refresh_time);
 	for (ALL_LIST_ELEMENTS_RO(lsp->lspu.frags, node, frag)) {
 		if (!frag->tlvs) {
 			/* Updating and flooding should only affect fragments
-			 * carrying data
+			 * carrying data, the others get purged.
 			 */
+			if (frag->hdr.rem_lifetime)
+				lsp_purge(frag, level, NULL);
 			continue;
 		}
 
 		frag->hdr.lsp_bits =
 			lsp_bits_generate(level, area->overload_bit,
 					  area->attached_bit_send, area);
-		/* Set the lifetime values of all the fragments to the same
-		 * value,
-		 * so that no fragment expires before the lsp is refreshed.
-		 */
-		frag->hdr.rem_lifetime = rem_lifetime;
-		frag->age_out = ZERO_AGE_LIFETIME;
-		lsp_flood(frag, NULL);
+		lsp_regenerate_frag(frag,
+				    old_pdus[LSP_FRAGMENT(frag->hdr.lsp_id)],
+				    rem_lifetime, &refresh_time);
 	}
-	lsp_seqno_update(lsp);
 
-	refresh_time = lsp_refresh_time(lsp, rem_lifetime);
+	for (size_t i = 0; i < array_size(old_pdus); i++)
+		stream_free(old_pdus[i]);
+
 	thread_add_timer(master, lsp_refresh,
 			 &area->lsp_refresh_arg[level - 1], refresh_time,
 			 &area->t_lsp_refresh[level - 1]);
@@ -1999,7 +2129,7 @@ int lsp_tick(struct thread *thread)
 					lsp_flood(lsp, NULL);
 				/* 7.3.16.4 c) record the time to purge
 				 * FIXME */
-				isis_spf_schedule(lsp->area, lsp->level);
+				lsp_spf_changed(lsp);
 			}
 
 			if (lsp->age_out == 0) {
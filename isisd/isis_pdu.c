@@ -2286,6 +2286,58 @@ int send_l2_csnp(struct thread *thread)
 	return ISIS_OK;
 }
 
+/* Pack and send one PSNP, clearing the SSN flags of the LSPs it carries. */
+static int send_psnp_pdu(int level, struct isis_circuit *circuit,
+			 struct isis_tlvs *tlvs, size_t tlv_start,
+			 size_t len_pointer)
+{
+	uint8_t pdu_type = (level == ISIS_LEVEL1) ? L1_PARTIAL_SEQ_NUM
+						  : L2_PARTIAL_SEQ_NUM;
+
+	stream_set_endp(circuit->snd_stream, tlv_start);
+	if (isis_pack_tlvs(tlvs, circuit->snd_stream, len_pointer, false,
+			   false)) {
+		isis_free_tlvs(tlvs);
+		return ISIS_WARNING;
+	}
+
+	if (IS_DEBUG_SNP_PACKETS) {
+		zlog_debug("ISIS-Snp (%s): Sending L%d PSNP on %s, length %zd",
+			   circuit->area->area_tag, level,
+			   circuit->interface->name,
+			   stream_get_endp(circuit->snd_stream));
+		log_multiline(LOG_DEBUG, "              ", "%s",
+			      isis_format_tlvs(tlvs));
+		if (IS_DEBUG_PACKET_DUMP)
+			zlog_dump_data(STREAM_DATA(circuit->snd_stream),
+				       stream_get_endp(circuit->snd_stream));
+	}
+
+	pdu_counter_count(circuit->area->pdu_tx_counters, pdu_type);
+	int retval = circuit->tx(circuit, level);
+	if (retval != ISIS_OK) {
+		flog_err(EC_ISIS_PACKET,
+			 "ISIS-Snp (%s): Send L%d PSNP on %s failed",
+			 circuit->area->area_tag, level,
+			 circuit->interface->name);
+		isis_free_tlvs(tlvs);
+		return retval;
+	}
+
+	/*
+	 * sending succeeded, we can clear SSN flags of this circuit
+	 * for the LSPs in list
+	 */
+	struct isis_lsp_entry *entry_head;
+	entry_head = (struct isis_lsp_entry *)tlvs->lsp_entries.head;
+	for (struct isis_lsp_entry *entry = entry_head; entry;
+	     entry = entry->next)
+		ISIS_CLEAR_FLAG(entry->lsp->SSNflags, circuit);
+	isis_free_tlvs(tlvs);
+
+	return ISIS_OK;
+}
+
 /*
  *  7.3.15.4 action on expiration of partial SNP interval
  *  level 1
@@ -2302,11 +2354,10 @@ static int send_psnp(int level, struct isis_circuit *circuit)
 	if (!circuit->snd_stream)
 		return ISIS_ERROR;
 
-	uint8_t pdu_type = (level == ISIS_LEVEL1) ? L1_PARTIAL_SEQ_NUM
-						  : L2_PARTIAL_SEQ_NUM;
-
 	isis_circuit_stream(circuit, &circuit->snd_stream);
-	fill_fixed_hdr(pdu_type, circuit->snd_stream);
+	fill_fixed_hdr((level == ISIS_LEVEL1) ? L1_PARTIAL_SEQ_NUM
+					      : L2_PARTIAL_SEQ_NUM,
+		       circuit->snd_stream);
 
 	size_t len_pointer = stream_get_endp(circuit->snd_stream);
 	stream_putw(circuit->snd_stream, 0); /* length is filled in later */
@@ -2332,72 +2383,39 @@ static int send_psnp(int level, struct isis_circuit *circuit)
 
 	uint16_t num_lsps =
 		get_max_lsp_count(STREAM_WRITEABLE(circuit->snd_stream));
+	struct isis_lsp *lsp;
+	int retval;
 
-	while (1) {
-		struct isis_lsp *lsp;
-
-		tlvs = isis_alloc_tlvs();
-		if (CHECK_FLAG(passwd->snp_auth, SNP_AUTH_SEND))
-			isis_tlvs_add_auth(tlvs, passwd);
-
-		frr_each (lspdb, &circuit->area->lspdb[level - 1], lsp) {
-			if (ISIS_CHECK_FLAG(lsp->SSNflags, circuit))
-				isis_tlvs_add_lsp_entry(tlvs, lsp);
-
-			if (tlvs->lsp_entries.count == num_lsps)
-				break;
-		}
-
-		if (!tlvs->lsp_entries.count) {
-			isis_free_tlvs(tlvs);
-			return ISIS_OK;
-		}
+	/*
+	 * Walk the LSPDB once, filling each PSNP up to the maximum number of
+	 * entries that fit before sending it.
+	 */
+	tlvs = NULL;
+	frr_each (lspdb, &circuit->area->lspdb[level - 1], lsp) {
+		if (!ISIS_CHECK_FLAG(lsp->SSNflags, circuit))
+			continue;
 
-		stream_set_endp(circuit->snd_stream, tlv_start);
-		if (isis_pack_tlvs(tlvs, circuit->snd_stream, len_pointer,
-				   false, false)) {
-			isis_free_tlvs(tlvs);
-			return ISIS_WARNING;
+		if (!tlvs) {
+			tlvs = isis_alloc_tlvs();
+			if (CHECK_FLAG(passwd->snp_auth, SNP_AUTH_SEND))
+				isis_tlvs_add_auth(tlvs, passwd);
 		}
 
-		if (IS_DEBUG_SNP_PACKETS) {
-			zlog_debug(
-				"ISIS-Snp (%s): Sending L%d PSNP on %s, length %zd",
-				circuit->area->area_tag, level,
-				circuit->interface->name,
-				stream_get_endp(circuit->snd_stream));
-			log_multiline(LOG_DEBUG, "              ", "%s",
-				      isis_format_tlvs(tlvs));
-			if (IS_DEBUG_PACKET_DUMP)
-				zlog_dump_data(
-					STREAM_DATA(circuit->snd_stream),
-					stream_get_endp(circuit->snd_stream));
-		}
+		isis_tlvs_add_lsp_entry(tlvs, lsp);
+		if (tlvs->lsp_entries.count < num_lsps)
+			continue;
 
-		pdu_counter_count(circuit->area->pdu_tx_counters, pdu_type);
-		int retval = circuit->tx(circuit, level);
-		if (retval != ISIS_OK) {
-			flog_err(EC_ISIS_PACKET,
-				 "ISIS-Snp (%s): Send L%d PSNP on %s failed",
-				 circuit->area->area_tag, level,
-				 circuit->interface->name);
-			isis_free_tlvs(tlvs);
+		retval = send_psnp_pdu(level, circuit, tlvs, tlv_start,
+				       len_pointer);
+		tlvs = NULL;
+		if (retval != ISIS_OK)
 			return retval;
-		}
-
-		/*
-		 * sending succeeded, we can clear SSN flags of this circuit
-		 * for the LSPs in list
-		 */
-		struct isis_lsp_entry *entry_head;
-		entry_head = (struct isis_lsp_entry *)tlvs->lsp_entries.head;
-		for (struct isis_lsp_entry *entry = entry_head; entry;
-		     entry = entry->next)
-			ISIS_CLEAR_FLAG(entry->lsp->SSNflags, circuit);
-		isis_free_tlvs(tlvs);
 	}
 
-	return ISIS_OK;
+	if (!tlvs)
+		return ISIS_OK;
+
+	return send_psnp_pdu(level, circuit, tlvs, tlv_start, len_pointer);
 }
 
 int send_l1_psnp(struct thread *thread)
@@ -378,6 +378,8 @@ struct isis_spftree *isis_spftree_new(struct isis_area *area,
 		isis_spf_node_list_init(&tree->lfa.p_space);
 		isis_spf_node_list_init(&tree->lfa.q_space);
 	}
+	isis_spf_node_list_init(&tree->lfa.cache.nodes);
+	isis_spf_node_list_init(&tree->lfa.cache.changed);
 
 	return tree;
 }
@@ -394,6 +396,7 @@ void isis_spftree_del(struct isis_spftree *spftree)
 		isis_spf_node_list_clear(&spftree->lfa.q_space);
 		isis_spf_node_list_clear(&spftree->lfa.p_space);
 	}
+	isis_spf_lfa_cache_clear(spftree);
 	isis_spf_node_list_clear(&spftree->adj_nodes);
 	list_delete(&spftree->sadj_list);
 	isis_vertex_queue_free(&spftree->tents);
@@ -1488,6 +1491,7 @@ static void init_spt(struct isis_spftree *spftree, int mtid)
 {
 	/* Clear data from previous run. */
 	hash_clean(spftree->prefix_sids, NULL);
+	isis_spf_lfa_cache_detach(spftree);
 	isis_spf_node_list_clear(&spftree->adj_nodes);
 	list_delete_all_node(spftree->sadj_list);
 	isis_vertex_queue_clear(&spftree->tents);
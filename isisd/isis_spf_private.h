@@ -353,6 +353,19 @@ struct isis_spftree {
 			uint32_t max_metric;
 		} remote;
 
+		/*
+		 * SPTs computed on behalf of the neighbors (forward and
+		 * reverse) and the local reverse SPT. They only depend on the
+		 * LSDB, and are reused until an LSP of a router they contain,
+		 * or of one of its neighbors, changes. 'changed' holds the
+		 * System IDs of those routers since the last check.
+		 */
+		struct {
+			struct isis_spf_nodes nodes;
+			struct isis_spftree *spftree_reverse;
+			struct isis_spf_nodes changed;
+		} cache;
+
 		/* Protection counters. */
 		struct {
 			uint32_t lfa[SPF_PREFIX_PRIO_MAX];
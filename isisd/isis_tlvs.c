@@ -31,6 +31,8 @@
 #include "stream.h"
 #include "sbuf.h"
 #include "network.h"
+#include "hash.h"
+#include "jhash.h"
 
 #include "isisd/isisd.h"
 #include "isisd/isis_tlvs.h"
@@ -47,6 +49,7 @@
 DEFINE_MTYPE_STATIC(ISISD, ISIS_TLV, "ISIS TLVs");
 DEFINE_MTYPE(ISISD, ISIS_SUBTLV, "ISIS Sub-TLVs");
 DEFINE_MTYPE_STATIC(ISISD, ISIS_MT_ITEM_LIST, "ISIS MT Item Lists");
+DEFINE_MTYPE_STATIC(ISISD, ISIS_FRAG_BINDING, "ISIS LSP fragment binding");
 
 typedef int (*unpack_tlv_func)(enum isis_tlv_context context, uint8_t tlv_type,
 			       uint8_t tlv_len, struct stream *s,
@@ -4110,6 +4113,393 @@ struct list *isis_fragment_tlvs(struct isis_tlvs *tlvs, size_t size)
 	return rv;
 }
 
+/*
+ * Fragmentation of our own LSPs keeps every entry in the fragment it was
+ * advertised in before: a prefix or neighbor which is still present goes back
+ * into its fragment, a withdrawn one just leaves room behind, and only new
+ * entries (or ones which outgrew their fragment) are moved, either into a
+ * fragment which lost entries in the same run or to the tail fragment. A
+ * single change thereby touches the fragments it belongs to, instead of
+ * shifting the content of every fragment behind it.
+ */
+struct frag_binding {
+	enum isis_tlv_type type;
+	uint16_t mtid;
+	uint8_t fragment;
+	uint8_t keylen;
+	/* prefix length and prefix (plus source prefix), or neighbor id */
+	uint8_t key[2 * (1 + IPV6_MAX_BYTELEN)];
+};
+
+struct frag_state {
+	struct hash *bindings;
+	struct isis_tlvs *buckets[256];
+	struct isis_tlvs *spill;
+	unsigned int prev_count[256];
+	unsigned int kept_count[256];
+	uint8_t fragment;
+	bool found;
+};
+
+typedef void (*frag_item_func)(const struct pack_order_entry *pe,
+			       uint16_t mtid, struct isis_item *i, void *arg);
+
+static void frag_walk_items(struct isis_tlvs *tlvs, frag_item_func func,
+			    void *arg)
+{
+	struct isis_item_list *l;
+	struct isis_mt_item_list *m;
+	struct isis_item *i;
+
+	for (size_t pack_idx = 0; pack_idx < array_size(pack_order);
+	     pack_idx++) {
+		const struct pack_order_entry *pe = &pack_order[pack_idx];
+
+		if (pe->how_to_pack == ISIS_ITEMS) {
+			l = (struct isis_item_list *)(((char *)tlvs)
+						      + pe->what_to_pack);
+			for (i = l->head; i; i = i->next)
+				func(pe, ISIS_MT_IPV4_UNICAST, i, arg);
+			continue;
+		}
+
+		m = (struct isis_mt_item_list *)(((char *)tlvs)
+						 + pe->what_to_pack);
+		RB_FOREACH (l, isis_mt_item_list, m) {
+			for (i = l->head; i; i = i->next)
+				func(pe, l->mtid, i, arg);
+		}
+	}
+}
+
+static bool frag_binding_key(const struct pack_order_entry *pe, uint16_t mtid,
+			     struct isis_item *i, struct frag_binding *b)
+{
+	const struct prefix *p = NULL, *src = NULL;
+
+	b->type = pe->type;
+	b->mtid = mtid;
+
+	switch (pe->type) {
+	case ISIS_TLV_OLDSTYLE_REACH:
+		b->keylen = 7;
+		memcpy(b->key, ((struct isis_oldstyle_reach *)i)->id, 7);
+		return true;
+	case ISIS_TLV_EXTENDED_REACH:
+	case ISIS_TLV_MT_REACH:
+		b->keylen = 7;
+		memcpy(b->key, ((struct isis_extended_reach *)i)->id, 7);
+		return true;
+	case ISIS_TLV_IPV4_ADDRESS:
+		b->keylen = IPV4_MAX_BYTELEN;
+		memcpy(b->key, &((struct isis_ipv4_address *)i)->addr,
+		       IPV4_MAX_BYTELEN);
+		return true;
+	case ISIS_TLV_IPV6_ADDRESS:
+		b->keylen = IPV6_MAX_BYTELEN;
+		memcpy(b->key, &((struct isis_ipv6_address *)i)->addr,
+		       IPV6_MAX_BYTELEN);
+		return true;
+	case ISIS_TLV_OLDSTYLE_IP_REACH:
+	case ISIS_TLV_OLDSTYLE_IP_REACH_EXT:
+		p = (struct prefix *)&((struct isis_oldstyle_ip_reach *)i)
+			    ->prefix;
+		break;
+	case ISIS_TLV_EXTENDED_IP_REACH:
+	case ISIS_TLV_MT_IP_REACH:
+		p = (struct prefix *)&((struct isis_extended_ip_reach *)i)
+			    ->prefix;
+		break;
+	case ISIS_TLV_IPV6_REACH:
+	case ISIS_TLV_MT_IPV6_REACH: {
+		struct isis_ipv6_reach *r = (struct isis_ipv6_reach *)i;
+
+		p = (struct prefix *)&r->prefix;
+		if (r->subtlvs && r->subtlvs->source_prefix)
+			src = (struct prefix *)r->subtlvs->source_prefix;
+		break;
+	}
+	default:
+		return false;
+	}
+
+	b->keylen = 0;
+	b->key[b->keylen++] = p->prefixlen;
+	memcpy(&b->key[b->keylen], &p->u.prefix, PSIZE(p->prefixlen));
+	b->keylen += PSIZE(p->prefixlen);
+	if (src) {
+		b->key[b->keylen++] = src->prefixlen;
+		memcpy(&b->key[b->keylen], &src->u.prefix,
+		       PSIZE(src->prefixlen));
+		b->keylen += PSIZE(src->prefixlen);
+	}
+	return true;
+}
+
+static unsigned int frag_binding_hash_key(const void *arg)
+{
+	const struct frag_binding *b = arg;
+
+	return jhash(b->key, b->keylen, (b->type << 16) | b->mtid);
+}
+
+static bool frag_binding_hash_cmp(const void *a1, const void *a2)
+{
+	const struct frag_binding *b1 = a1, *b2 = a2;
+
+	return b1->type == b2->type && b1->mtid == b2->mtid
+	       && b1->keylen == b2->keylen
+	       && !memcmp(b1->key, b2->key, b1->keylen);
+}
+
+static void *frag_binding_alloc(void *arg)
+{
+	struct frag_binding *b = XMALLOC(MTYPE_ISIS_FRAG_BINDING, sizeof(*b));
+
+	*b = *(struct frag_binding *)arg;
+	return b;
+}
+
+static void frag_binding_free(void *arg)
+{
+	XFREE(MTYPE_ISIS_FRAG_BINDING, arg);
+}
+
+static struct frag_binding *frag_binding_lookup(struct frag_state *state,
+						const struct pack_order_entry *pe,
+						uint16_t mtid,
+						struct isis_item *i)
+{
+	struct frag_binding key;
+
+	if (!frag_binding_key(pe, mtid, i, &key))
+		return NULL;
+	return hash_lookup(state->bindings, &key);
+}
+
+/* Remember which fragment an item was advertised in */
+static void frag_record_item(const struct pack_order_entry *pe, uint16_t mtid,
+			     struct isis_item *i, void *arg)
+{
+	struct frag_state *state = arg;
+	struct frag_binding key;
+
+	state->prev_count[state->fragment]++;
+	if (!frag_binding_key(pe, mtid, i, &key))
+		return;
+
+	/* Parallel entries to the same neighbor bind to the first one */
+	key.fragment = state->fragment;
+	hash_get(state->bindings, &key, frag_binding_alloc);
+}
+
+/* Put an item back into its previous fragment, or on the spill list */
+static void frag_place_item(const struct pack_order_entry *pe, uint16_t mtid,
+			    struct isis_item *i, void *arg)
+{
+	struct frag_state *state = arg;
+	struct frag_binding *b;
+	struct isis_tlvs *dest = state->spill;
+
+	b = frag_binding_lookup(state, pe, mtid, i);
+	if (b) {
+		if (!state->buckets[b->fragment])
+			state->buckets[b->fragment] = isis_alloc_tlvs();
+		dest = state->buckets[b->fragment];
+		state->kept_count[b->fragment]++;
+	}
+
+	add_item_to_fragment(i, pe, dest, mtid);
+}
+
+static void frag_copy_item(const struct pack_order_entry *pe, uint16_t mtid,
+			   struct isis_item *i, void *arg)
+{
+	add_item_to_fragment(i, pe, arg, mtid);
+}
+
+/* Is any of the items bound to state->fragment? */
+static void frag_check_item(const struct pack_order_entry *pe, uint16_t mtid,
+			    struct isis_item *i, void *arg)
+{
+	struct frag_state *state = arg;
+	struct frag_binding *b;
+
+	b = frag_binding_lookup(state, pe, mtid, i);
+	if (b && b->fragment == state->fragment)
+		state->found = true;
+}
+
+static void frag_count_item(const struct pack_order_entry *pe, uint16_t mtid,
+			    struct isis_item *i, void *arg)
+{
+	(*(unsigned int *)arg)++;
+}
+
+static bool frag_has_items(struct isis_tlvs *tlvs)
+{
+	unsigned int count = 0;
+
+	frag_walk_items(tlvs, frag_count_item, &count);
+	return count > 0;
+}
+
+/* The TLVs which pack_tlvs() puts into the first fragment only */
+static void frag_copy_fixed_tlvs(struct isis_tlvs *src,
+				 struct isis_tlvs *dest)
+{
+	dest->purge_originator =
+		copy_tlv_purge_originator(src->purge_originator);
+	copy_tlv_protocols_supported(&src->protocols_supported,
+				     &dest->protocols_supported);
+	copy_items(ISIS_CONTEXT_LSP, ISIS_TLV_AREA_ADDRESSES,
+		   &src->area_addresses, &dest->area_addresses);
+	dest->mt_router_info_empty = src->mt_router_info_empty;
+	copy_items(ISIS_CONTEXT_LSP, ISIS_TLV_MT_ROUTER_INFO,
+		   &src->mt_router_info, &dest->mt_router_info);
+	dest->hostname = copy_tlv_dynamic_hostname(src->hostname);
+	dest->router_cap = copy_tlv_router_cap(src->router_cap);
+	dest->te_router_id = copy_tlv_te_router_id(src->te_router_id);
+	dest->threeway_adj = copy_tlv_threeway_adj(src->threeway_adj);
+	dest->spine_leaf = copy_tlv_spine_leaf(src->spine_leaf);
+}
+
+/* Pack tlvs into one fragment, the items which don't fit are added to rest */
+static struct isis_tlvs *frag_pack(struct isis_tlvs *tlvs, size_t size,
+				   struct isis_tlvs *rest)
+{
+	struct list *fragments;
+	struct listnode *node;
+	struct isis_tlvs *first, *fragment_tlvs;
+
+	fragments = isis_fragment_tlvs(tlvs, size);
+	if (!fragments)
+		return NULL;
+
+	first = listgetdata(listhead(fragments));
+	for (ALL_LIST_ELEMENTS_RO(fragments, node, fragment_tlvs)) {
+		if (fragment_tlvs == first)
+			continue;
+		frag_walk_items(fragment_tlvs, frag_copy_item, rest);
+		isis_free_tlvs(fragment_tlvs);
+	}
+	list_delete(&fragments);
+
+	return first;
+}
+
+/*
+ * Like isis_fragment_tlvs(), but places the entries according to the
+ * previous fragments in prev[] (indexed by fragment number, NULL if unused).
+ * The result is stored in frags[], with NULL for fragments left empty.
+ * Returns 0 on success, 1 if not everything fit into 256 fragments and -1
+ * if the TLVs could not be packed at all.
+ */
+int isis_fragment_tlvs_stable(struct isis_tlvs *tlvs, size_t size,
+			      struct isis_tlvs *prev[256],
+			      struct isis_tlvs *frags[256])
+{
+	struct frag_state state;
+	struct list *fragments;
+	struct listnode *node;
+	struct isis_tlvs *fragment_tlvs, *merged, *rest;
+	unsigned int n, tail = 0;
+	int rv = 0;
+
+	memset(&state, 0, sizeof(state));
+	memset(frags, 0, 256 * sizeof(*frags));
+
+	state.bindings = hash_create(frag_binding_hash_key,
+				     frag_binding_hash_cmp,
+				     "ISIS LSP fragment bindings");
+	for (n = 0; n < 256; n++) {
+		if (!prev[n])
+			continue;
+		state.fragment = n;
+		frag_walk_items(prev[n], frag_record_item, &state);
+	}
+
+	state.buckets[0] = isis_alloc_tlvs();
+	frag_copy_fixed_tlvs(tlvs, state.buckets[0]);
+	state.spill = isis_alloc_tlvs();
+	frag_walk_items(tlvs, frag_place_item, &state);
+
+	for (n = 0; n < 256; n++) {
+		if (state.buckets[n])
+			tail = n;
+	}
+
+	for (n = 0; n < tail; n++) {
+		if (!state.buckets[n])
+			continue;
+
+		/*
+		 * A fragment which lost entries changes anyway, so let it
+		 * take new entries in their place - unless that pushes out
+		 * entries which are bound to it.
+		 */
+		if (state.kept_count[n] < state.prev_count[n]
+		    && frag_has_items(state.spill)) {
+			merged = isis_copy_tlvs(state.buckets[n]);
+			frag_walk_items(state.spill, frag_copy_item, merged);
+			rest = isis_alloc_tlvs();
+			frags[n] = frag_pack(merged, size, rest);
+			isis_free_tlvs(merged);
+			if (!frags[n]) {
+				isis_free_tlvs(rest);
+				goto fail;
+			}
+
+			state.fragment = n;
+			state.found = false;
+			frag_walk_items(rest, frag_check_item, &state);
+			if (!state.found) {
+				isis_free_tlvs(state.spill);
+				state.spill = rest;
+				continue;
+			}
+			isis_free_tlvs(frags[n]);
+			isis_free_tlvs(rest);
+		}
+
+		frags[n] = frag_pack(state.buckets[n], size, state.spill);
+		if (!frags[n])
+			goto fail;
+	}
+
+	/* The tail fragment takes what is left, followed by new fragments */
+	frag_walk_items(state.spill, frag_copy_item, state.buckets[tail]);
+	fragments = isis_fragment_tlvs(state.buckets[tail], size);
+	if (!fragments)
+		goto fail;
+
+	n = tail;
+	for (ALL_LIST_ELEMENTS_RO(fragments, node, fragment_tlvs)) {
+		if (n < 256) {
+			frags[n++] = fragment_tlvs;
+			continue;
+		}
+		isis_free_tlvs(fragment_tlvs);
+		rv = 1;
+	}
+	list_delete(&fragments);
+	goto out;
+
+fail:
+	for (n = 0; n < 256; n++) {
+		isis_free_tlvs(frags[n]);
+		frags[n] = NULL;
+	}
+	rv = -1;
+out:
+	for (n = 0; n < 256; n++)
+		isis_free_tlvs(state.buckets[n]);
+	isis_free_tlvs(state.spill);
+	hash_clean(state.bindings, frag_binding_free);
+	hash_free(state.bindings);
+	return rv;
+}
+
 static int unpack_tlv_unknown(enum isis_tlv_context context, uint8_t tlv_type,
 			      uint8_t tlv_len, struct stream *s,
 			      struct sbuf *log, int indent)
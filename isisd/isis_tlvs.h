@@ -547,6 +547,9 @@ int isis_unpack_tlvs(size_t avail_len, struct stream *stream,
 const char *isis_format_tlvs(struct isis_tlvs *tlvs);
 struct isis_tlvs *isis_copy_tlvs(struct isis_tlvs *tlvs);
 struct list *isis_fragment_tlvs(struct isis_tlvs *tlvs, size_t size);
+int isis_fragment_tlvs_stable(struct isis_tlvs *tlvs, size_t size,
+			      struct isis_tlvs *prev[256],
+			      struct isis_tlvs *frags[256]);
 
 #define ISIS_EXTENDED_IP_REACH_DOWN 0x80
 #define ISIS_EXTENDED_IP_REACH_SUBTLV 0x40
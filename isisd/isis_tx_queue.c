@@ -23,6 +23,8 @@
 
 #include "hash.h"
 #include "jhash.h"
+#include "monotime.h"
+#include "typesafe.h"
 
 #include "isisd/isisd.h"
 #include "isisd/isis_flags.h"
@@ -34,21 +36,48 @@
 DEFINE_MTYPE_STATIC(ISISD, TX_QUEUE, "ISIS TX Queue");
 DEFINE_MTYPE_STATIC(ISISD, TX_QUEUE_ENTRY, "ISIS TX Queue Entry");
 
+/* LSP retransmission interval, in seconds. */
+#define TX_QUEUE_RETRY_INTERVAL 5
+/* Retransmissions due within this window (ms) are sent together. */
+#define TX_QUEUE_RETRY_SLACK 100
+/* Maximum number of LSPs sent per run of the queue. */
+#define TX_QUEUE_BURST 128
+
+PREDECL_DLIST(tx_queue_list);
+
+/*
+ * Instead of running one thread per queued LSP, each queue runs a single
+ * thread: LSPs waiting for their first transmission are kept on a FIFO
+ * and sent in bursts, and LSPs waiting for retransmission are kept on a
+ * second list ordered by due time. Since the retransmission interval is
+ * constant, appending to that list keeps it sorted, and a single timer
+ * armed for its head is enough.
+ */
 struct isis_tx_queue {
 	struct isis_circuit *circuit;
 	void (*send_event)(struct isis_circuit *circuit,
 			   struct isis_lsp *, enum isis_tx_type);
 	struct hash *hash;
+
+	struct tx_queue_list_head pending;
+	struct tx_queue_list_head retry;
+	struct thread *t_send;
 };
 
 struct isis_tx_queue_entry {
 	struct isis_lsp *lsp;
 	enum isis_tx_type type;
 	bool is_retry;
-	struct thread *retry;
+	struct timeval due;
+	struct tx_queue_list_head *list;
+	struct tx_queue_list_item item;
 	struct isis_tx_queue *queue;
 };
 
+DECLARE_DLIST(tx_queue_list, struct isis_tx_queue_entry, item);
+
+static int tx_queue_send_event(struct thread *thread);
+
 static unsigned tx_queue_hash_key(const void *p)
 {
 	const struct isis_tx_queue_entry *e = p;
@@ -85,22 +114,34 @@ struct isis_tx_queue *isis_tx_queue_new(
 	rv->send_event = send_event;
 
 	rv->hash = hash_create(tx_queue_hash_key, tx_queue_hash_cmp, NULL);
+	tx_queue_list_init(&rv->pending);
+	tx_queue_list_init(&rv->retry);
 	return rv;
 }
 
+static void tx_queue_unlink(struct isis_tx_queue_entry *e)
+{
+	if (!e->list)
+		return;
+
+	tx_queue_list_del(e->list, e);
+	e->list = NULL;
+}
+
 static void tx_queue_element_free(void *element)
 {
 	struct isis_tx_queue_entry *e = element;
 
-	thread_cancel(&(e->retry));
-
+	tx_queue_unlink(e);
 	XFREE(MTYPE_TX_QUEUE_ENTRY, e);
 }
 
 void isis_tx_queue_free(struct isis_tx_queue *queue)
 {
-	hash_clean(queue->hash, tx_queue_element_free);
+	isis_tx_queue_clean(queue);
 	hash_free(queue->hash);
+	tx_queue_list_fini(&queue->pending);
+	tx_queue_list_fini(&queue->retry);
 	XFREE(MTYPE_TX_QUEUE, queue);
 }
 
@@ -114,21 +155,78 @@ static struct isis_tx_queue_entry *tx_queue_find(struct isis_tx_queue *queue,
 	return hash_lookup(queue->hash, &e);
 }
 
-static int tx_queue_send_event(struct thread *thread)
+/* Arm the queue thread according to what is due next. */
+static void tx_queue_schedule(struct isis_tx_queue *queue)
 {
-	struct isis_tx_queue_entry *e = THREAD_ARG(thread);
-	struct isis_tx_queue *queue = e->queue;
+	struct isis_tx_queue_entry *e;
+	struct timeval remain;
 
-	thread_add_timer(master, tx_queue_send_event, e, 5, &e->retry);
+	thread_cancel(&queue->t_send);
 
-	if (e->is_retry)
-		queue->circuit->area->lsp_rxmt_count++;
-	else
-		e->is_retry = true;
+	if (tx_queue_list_count(&queue->pending)) {
+		thread_add_event(master, tx_queue_send_event, queue, 0,
+				 &queue->t_send);
+		return;
+	}
 
-	queue->send_event(queue->circuit, e->lsp, e->type);
-	/* Don't access e here anymore, send_event might have destroyed it */
+	e = tx_queue_list_first(&queue->retry);
+	if (!e)
+		return;
 
+	if (monotime_until(&e->due, &remain) <= 0)
+		remain.tv_sec = remain.tv_usec = 0;
+	thread_add_timer_tv(master, tx_queue_send_event, queue, &remain,
+			    &queue->t_send);
+}
+
+/*
+ * Pop the next LSP to transmit, if any is due, and requeue it for
+ * retransmission. Due retransmissions go first, so that a steady stream
+ * of new LSPs can't hold them back.
+ */
+static struct isis_tx_queue_entry *
+tx_queue_next(struct isis_tx_queue *queue, const struct timeval *now)
+{
+	struct isis_tx_queue_entry *e;
+	struct timeval limit, slack = {0, TX_QUEUE_RETRY_SLACK * 1000};
+
+	timeradd(now, &slack, &limit);
+	e = tx_queue_list_first(&queue->retry);
+	if (!e || timercmp(&e->due, &limit, >)) {
+		e = tx_queue_list_first(&queue->pending);
+		if (!e)
+			return NULL;
+	}
+
+	tx_queue_unlink(e);
+	e->due = *now;
+	e->due.tv_sec += TX_QUEUE_RETRY_INTERVAL;
+	tx_queue_list_add_tail(&queue->retry, e);
+	e->list = &queue->retry;
+
+	return e;
+}
+
+static int tx_queue_send_event(struct thread *thread)
+{
+	struct isis_tx_queue *queue = THREAD_ARG(thread);
+	struct isis_tx_queue_entry *e;
+	struct timeval now;
+	int sent = 0;
+
+	monotime(&now);
+	while (sent++ < TX_QUEUE_BURST && (e = tx_queue_next(queue, &now))) {
+		if (e->is_retry)
+			queue->circuit->area->lsp_rxmt_count++;
+		else
+			e->is_retry = true;
+
+		queue->send_event(queue->circuit, e->lsp, e->type);
+		/* Don't access e here anymore, send_event might have destroyed
+		 * it */
+	}
+
+	tx_queue_schedule(queue);
 	return 0;
 }
 
@@ -162,11 +260,18 @@ void _isis_tx_queue_add(struct isis_tx_queue *queue,
 	}
 
 	e->type = type;
+	e->is_retry = false;
+
+	if (e->list == &queue->pending)
+		return;
 
-	thread_cancel(&(e->retry));
-	thread_add_event(master, tx_queue_send_event, e, 0, &e->retry);
+	tx_queue_unlink(e);
+	tx_queue_list_add_tail(&queue->pending, e);
+	e->list = &queue->pending;
 
-	e->is_retry = false;
+	/* Replace a pending retransmission timer with an event. */
+	if (tx_queue_list_count(&queue->pending) == 1)
+		tx_queue_schedule(queue);
 }
 
 void _isis_tx_queue_del(struct isis_tx_queue *queue, struct isis_lsp *lsp,
@@ -186,7 +291,7 @@ void _isis_tx_queue_del(struct isis_tx_queue *queue, struct isis_lsp *lsp,
 			   func, file, line);
 	}
 
-	thread_cancel(&(e->retry));
+	tx_queue_unlink(e);
 
 	hash_release(queue->hash, e);
 	XFREE(MTYPE_TX_QUEUE_ENTRY, e);
@@ -203,4 +308,5 @@ unsigned long isis_tx_queue_len(struct isis_tx_queue *queue)
 void isis_tx_queue_clean(struct isis_tx_queue *queue)
 {
 	hash_clean(queue->hash, tx_queue_element_free);
+	thread_cancel(&queue->t_send);
 }
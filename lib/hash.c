@@ -30,6 +30,7 @@
 #include "libfrr.h"
 #include "frr_pthread.h"
 #include "libfrr_trace.h"
+#include "monotime.h"
 
 DEFINE_MTYPE_STATIC(LIB, HASH, "Hash");
 DEFINE_MTYPE_STATIC(LIB, HASH_BUCKET, "Hash Bucket");
@@ -38,6 +39,18 @@ DEFINE_MTYPE_STATIC(LIB, HASH_INDEX, "Hash Index");
 static pthread_mutex_t _hashes_mtx = PTHREAD_MUTEX_INITIALIZER;
 static struct list *_hashes;
 
+/* buckets of RCU hashes carry their own rcu_head */
+struct hash_rcu_bucket {
+	struct hash_bucket hb;
+	struct rcu_head rcu_head;
+};
+
+/* index and bucket->next are plain pointers (outside code walks them), so
+ * use the compiler builtins where hash_lookup_rcu() may be looking.
+ */
+#define hash_load(ptr) __atomic_load_n(&(ptr), __ATOMIC_ACQUIRE)
+#define hash_publish(ptr, val) __atomic_store_n(&(ptr), (val), __ATOMIC_RELEASE)
+
 struct hash *hash_create_size(unsigned int size,
 			      unsigned int (*hash_key)(const void *),
 			      bool (*hash_cmp)(const void *, const void *),
@@ -78,6 +91,47 @@ void *hash_alloc_intern(void *arg)
 	return arg;
 }
 
+void hash_set_rcu(struct hash *hash)
+{
+	struct hash_rcu_index *ri;
+
+	assert(!hash->count);
+	if (hash->rcu_index)
+		return;
+
+	ri = XCALLOC(MTYPE_HASH_INDEX,
+		     sizeof(*ri) + sizeof(ri->index[0]) * hash->size);
+	ri->size = hash->size;
+
+	XFREE(MTYPE_HASH_INDEX, hash->index);
+	hash->index = ri->index;
+	hash->rcu_index = ri;
+}
+
+static struct hash_bucket *hash_bucket_new(struct hash *hash)
+{
+	struct hash_rcu_bucket *rb;
+
+	if (!hash->rcu_index)
+		return XCALLOC(MTYPE_HASH_BUCKET, sizeof(struct hash_bucket));
+
+	rb = XCALLOC(MTYPE_HASH_BUCKET, sizeof(*rb));
+	return &rb->hb;
+}
+
+static void hash_bucket_free(struct hash *hash, struct hash_bucket *hb)
+{
+	struct hash_rcu_bucket *rb;
+
+	if (!hash->rcu_index) {
+		XFREE(MTYPE_HASH_BUCKET, hb);
+		return;
+	}
+
+	rb = container_of(hb, struct hash_rcu_bucket, hb);
+	rcu_free(MTYPE_HASH_BUCKET, rb, rcu_head);
+}
+
 /*
  * ssq = ssq + (new^2 - old^2)
  *     = ssq + ((new + old) * (new - old))
@@ -93,48 +147,213 @@ void *hash_alloc_intern(void *arg)
 						  memory_order_relaxed);       \
 	} while (0)
 
-/* Expand hash if the chain length exceeds the threshold. */
+/* Add hb to the front of the chain at head, which is in hash->index. */
+static void hash_chain_push(struct hash *hash, struct hash_bucket **head,
+			    struct hash_bucket *hb)
+{
+	int oldlen = *head ? (*head)->len : 0;
+	int newlen = oldlen + 1;
+
+	hb->next = *head;
+	if (newlen == 1)
+		hash->stats.empty--;
+	else
+		hb->next->len = 0;
+
+	hb->len = newlen;
+
+	hash_update_ssq(hash, oldlen, newlen);
+
+	hash_publish(*head, hb);
+}
+
+static void hash_pause(struct hash *hash, const struct timeval *start)
+{
+	uint64_t usec = monotime_since(start, NULL);
+
+	hash->stats.resize_usec += usec;
+	if (usec > hash->stats.resize_max_usec)
+		hash->stats.resize_max_usec = usec;
+}
+
+/* Move up to slots chains of a resize in progress to the new index. */
+static void hash_rehash_step(struct hash *hash, unsigned int slots)
+{
+	struct hash_bucket *hb, *hbnext;
+	struct timeval start;
+	unsigned int end;
+
+	if (!hash->old_index)
+		return;
+
+	monotime(&start);
+
+	end = hash->old_size - hash->rehash_pos > slots
+		      ? hash->rehash_pos + slots
+		      : hash->old_size;
+
+	for (; hash->rehash_pos < end; hash->rehash_pos++) {
+		hb = hash->old_index[hash->rehash_pos];
+		if (!hb)
+			continue;
+
+		hash_update_ssq(hash, hb->len, 0);
+		hash->old_index[hash->rehash_pos] = NULL;
+
+		for (; hb; hb = hbnext) {
+			hbnext = hb->next;
+			hash_chain_push(
+				hash, &hash->index[hb->key & (hash->size - 1)],
+				hb);
+		}
+	}
+
+	if (hash->rehash_pos == hash->old_size) {
+		XFREE(MTYPE_HASH_INDEX, hash->old_index);
+		hash->old_size = 0;
+		hash->rehash_pos = 0;
+	}
+
+	hash_pause(hash, &start);
+}
+
+static void hash_rehash_finish(struct hash *hash)
+{
+	hash_rehash_step(hash, UINT_MAX);
+}
+
+/* The not yet moved chain of a resize in progress that key maps to */
+static struct hash_bucket **hash_old_chain(struct hash *hash, unsigned int key)
+{
+	unsigned int i;
+
+	if (!hash->old_index)
+		return NULL;
+
+	i = key & (hash->old_size - 1);
+	return i >= hash->rehash_pos ? &hash->old_index[i] : NULL;
+}
+
+/*
+ * Expand hash if the chain length exceeds the threshold.
+ *
+ * Rather than rehashing everything in one go, which stalls the process for
+ * a long time on big tables, the old index is kept around and its chains
+ * are moved over HASH_REHASH_STEP at a time by the following inserts and
+ * releases.  Lookups check both indexes until that is done.
+ *
+ * RCU hashes (hash_set_rcu()) can't do that since readers only know one
+ * index; they still copy everything at once.
+ */
 static void hash_expand(struct hash *hash)
 {
 	unsigned int i, new_size;
-	struct hash_bucket *hb, *hbnext, **new_index;
+	struct hash_bucket *hb, *hbnext;
+	struct hash_rcu_index *ri, *old_ri;
+	struct timeval start;
 
 	new_size = hash->size * 2;
 
 	if (hash->max_size && new_size > hash->max_size)
 		return;
 
-	new_index = XCALLOC(MTYPE_HASH_INDEX,
-			    sizeof(struct hash_bucket *) * new_size);
+	/* previous resize still going, should hardly ever happen */
+	hash_rehash_finish(hash);
+
+	monotime(&start);
+	hash->stats.resizes++;
+
+	if (!hash->rcu_index) {
+		hash->old_index = hash->index;
+		hash->old_size = hash->size;
+		hash->rehash_pos = 0;
+
+		hash->index = XCALLOC(MTYPE_HASH_INDEX,
+				      sizeof(struct hash_bucket *) * new_size);
+		hash->size = new_size;
+		hash->stats.empty = new_size;
+
+		hash_pause(hash, &start);
+		return;
+	}
+
+	ri = XCALLOC(MTYPE_HASH_INDEX,
+		     sizeof(*ri) + sizeof(ri->index[0]) * new_size);
+	ri->size = new_size;
 
 	hash->stats.empty = new_size;
 
-	for (i = 0; i < hash->size; i++)
-		for (hb = hash->index[i]; hb; hb = hbnext) {
-			unsigned int h = hb->key & (new_size - 1);
+	/* RCU readers may still be walking the old chains, leave them intact
+	 * and put copies of the buckets on the new index
+	 */
+	for (i = 0; i < hash->size; i++) {
+		hb = hash->index[i];
+		if (hb)
+			hash_update_ssq(hash, hb->len, 0);
+
+		for (; hb; hb = hb->next) {
+			struct hash_bucket *copy = hash_bucket_new(hash);
+
+			copy->key = hb->key;
+			copy->data = hb->data;
+			hash_chain_push(hash,
+					&ri->index[copy->key & (new_size - 1)],
+					copy);
+		}
+	}
+
+	old_ri = hash->rcu_index;
+	hash_publish(hash->rcu_index, ri);
+	hash->size = new_size;
+	hash->index = ri->index;
 
+	for (i = 0; i < old_ri->size; i++)
+		for (hb = old_ri->index[i]; hb; hb = hbnext) {
 			hbnext = hb->next;
-			hb->next = new_index[h];
+			hash_bucket_free(hash, hb);
+		}
+	rcu_free(MTYPE_HASH_INDEX, old_ri, rcu_head);
 
-			int oldlen = hb->next ? hb->next->len : 0;
-			int newlen = oldlen + 1;
+	hash_pause(hash, &start);
+}
 
-			if (newlen == 1)
-				hash->stats.empty--;
-			else
-				hb->next->len = 0;
+static struct hash_bucket *hash_chain_find(struct hash *hash,
+					   struct hash_bucket *hb,
+					   unsigned int key, void *data,
+					   unsigned int *probes)
+{
+	for (; hb; hb = hb->next) {
+		(*probes)++;
+		if (hb->key == key && (*hash->hash_cmp)(hb->data, data))
+			return hb;
+	}
+	return NULL;
+}
 
-			hb->len = newlen;
+static struct hash_bucket *hash_find(struct hash *hash, unsigned int key,
+				     void *data, unsigned int *probes)
+{
+	struct hash_bucket *hb, **old;
 
-			hash_update_ssq(hash, oldlen, newlen);
+	hb = hash_chain_find(hash, hash->index[key & (hash->size - 1)], key,
+			     data, probes);
+	if (!hb && (old = hash_old_chain(hash, key)))
+		hb = hash_chain_find(hash, *old, key, data, probes);
 
-			new_index[h] = hb;
-		}
+	return hb;
+}
 
-	/* Switch to new table */
-	XFREE(MTYPE_HASH_INDEX, hash->index);
-	hash->size = new_size;
-	hash->index = new_index;
+/*
+ * Only lookups that may insert are counted: those write to the table
+ * anyway, while plain lookups stay free of stores so that read-only
+ * users can share a table between pthreads.
+ */
+static void hash_count_probes(struct hash *hash, unsigned int probes)
+{
+	hash->stats.lookups++;
+	hash->stats.probes += probes;
+	if (probes > hash->stats.max_probes)
+		hash->stats.max_probes = probes;
 }
 
 void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
@@ -142,7 +361,7 @@ void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
 	frrtrace(2, frr_libfrr, hash_get, hash, data);
 
 	unsigned int key;
-	unsigned int index;
+	unsigned int probes = 0;
 	void *newdata;
 	struct hash_bucket *bucket;
 
@@ -150,45 +369,31 @@ void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
 		return NULL;
 
 	key = (*hash->hash_key)(data);
-	index = key & (hash->size - 1);
 
-	for (bucket = hash->index[index]; bucket != NULL;
-	     bucket = bucket->next) {
-		if (bucket->key == key && (*hash->hash_cmp)(bucket->data, data))
-			return bucket->data;
-	}
+	bucket = hash_find(hash, key, data, &probes);
+	if (alloc_func)
+		hash_count_probes(hash, probes);
+	if (bucket)
+		return bucket->data;
 
 	if (alloc_func) {
 		newdata = (*alloc_func)(data);
 		if (newdata == NULL)
 			return NULL;
 
-		if (HASH_THRESHOLD(hash->count + 1, hash->size)) {
+		hash_rehash_step(hash, HASH_REHASH_STEP);
+		if (HASH_THRESHOLD(hash->count + 1, hash->size))
 			hash_expand(hash);
-			index = key & (hash->size - 1);
-		}
 
-		bucket = XCALLOC(MTYPE_HASH_BUCKET, sizeof(struct hash_bucket));
+		bucket = hash_bucket_new(hash);
 		bucket->data = newdata;
 		bucket->key = key;
-		bucket->next = hash->index[index];
-		hash->index[index] = bucket;
+		hash_chain_push(hash, &hash->index[key & (hash->size - 1)],
+				bucket);
 		hash->count++;
 
 		frrtrace(3, frr_libfrr, hash_insert, hash, data, key);
 
-		int oldlen = bucket->next ? bucket->next->len : 0;
-		int newlen = oldlen + 1;
-
-		if (newlen == 1)
-			hash->stats.empty--;
-		else
-			bucket->next->len = 0;
-
-		bucket->len = newlen;
-
-		hash_update_ssq(hash, oldlen, newlen);
-
 		return bucket->data;
 	}
 	return NULL;
@@ -199,6 +404,26 @@ void *hash_lookup(struct hash *hash, void *data)
 	return hash_get(hash, data, NULL);
 }
 
+void *hash_lookup_rcu(struct hash *hash, void *data)
+{
+	struct hash_rcu_index *ri;
+	struct hash_bucket *hb;
+	unsigned int key;
+
+	rcu_assert_read_locked();
+
+	ri = hash_load(hash->rcu_index);
+	assert(ri);
+
+	key = (*hash->hash_key)(data);
+	for (hb = hash_load(ri->index[key & (ri->size - 1)]); hb;
+	     hb = hash_load(hb->next))
+		if (hb->key == key && (*hash->hash_cmp)(hb->data, data))
+			return hb->data;
+
+	return NULL;
+}
+
 unsigned int string_hash_make(const char *str)
 {
 	unsigned int hash = 0;
@@ -209,42 +434,56 @@ unsigned int string_hash_make(const char *str)
 	return hash;
 }
 
-void *hash_release(struct hash *hash, void *data)
+/* Unlink and free the bucket for data from the chain at head. */
+static void *hash_chain_release(struct hash *hash, struct hash_bucket **head,
+				unsigned int key, void *data, bool in_index)
 {
-	void *ret = NULL;
-	unsigned int key;
-	unsigned int index;
+	void *ret;
 	struct hash_bucket *bucket;
 	struct hash_bucket *pp;
 
-	key = (*hash->hash_key)(data);
-	index = key & (hash->size - 1);
-
-	for (bucket = pp = hash->index[index]; bucket; bucket = bucket->next) {
+	for (bucket = pp = *head; bucket; bucket = bucket->next) {
 		if (bucket->key == key
 		    && (*hash->hash_cmp)(bucket->data, data)) {
-			int oldlen = hash->index[index]->len;
+			int oldlen = (*head)->len;
 			int newlen = oldlen - 1;
 
 			if (bucket == pp)
-				hash->index[index] = bucket->next;
+				hash_publish(*head, bucket->next);
 			else
-				pp->next = bucket->next;
+				hash_publish(pp->next, bucket->next);
 
-			if (hash->index[index])
-				hash->index[index]->len = newlen;
-			else
+			if (*head)
+				(*head)->len = newlen;
+			else if (in_index)
 				hash->stats.empty++;
 
 			hash_update_ssq(hash, oldlen, newlen);
 
 			ret = bucket->data;
-			XFREE(MTYPE_HASH_BUCKET, bucket);
+			hash_bucket_free(hash, bucket);
 			hash->count--;
-			break;
+			return ret;
 		}
 		pp = bucket;
 	}
+	return NULL;
+}
+
+void *hash_release(struct hash *hash, void *data)
+{
+	void *ret;
+	unsigned int key;
+	struct hash_bucket **old;
+
+	hash_rehash_step(hash, HASH_REHASH_STEP);
+
+	key = (*hash->hash_key)(data);
+
+	ret = hash_chain_release(hash, &hash->index[key & (hash->size - 1)],
+				 key, data, true);
+	if (!ret && (old = hash_old_chain(hash, key)))
+		ret = hash_chain_release(hash, old, key, data, false);
 
 	frrtrace(3, frr_libfrr, hash_release, hash, data, ret);
 
@@ -258,6 +497,9 @@ void hash_iterate(struct hash *hash, void (*func)(struct hash_bucket *, void *),
 	struct hash_bucket *hb;
 	struct hash_bucket *hbnext;
 
+	/* walks are O(n) anyway, get rid of the old index for them */
+	hash_rehash_finish(hash);
+
 	for (i = 0; i < hash->size; i++)
 		for (hb = hash->index[i]; hb; hb = hbnext) {
 			/* get pointer to next hash bucket here, in case (*func)
@@ -276,6 +518,8 @@ void hash_walk(struct hash *hash, int (*func)(struct hash_bucket *, void *),
 	struct hash_bucket *hbnext;
 	int ret = HASHWALK_CONTINUE;
 
+	hash_rehash_finish(hash);
+
 	for (i = 0; i < hash->size; i++) {
 		for (hb = hash->index[i]; hb; hb = hbnext) {
 			/* get pointer to next hash bucket here, in case (*func)
@@ -295,17 +539,21 @@ void hash_clean(struct hash *hash, void (*free_func)(void *))
 	struct hash_bucket *hb;
 	struct hash_bucket *next;
 
+	hash_rehash_finish(hash);
+
 	for (i = 0; i < hash->size; i++) {
-		for (hb = hash->index[i]; hb; hb = next) {
+		hb = hash->index[i];
+		hash_publish(hash->index[i], NULL);
+
+		for (; hb; hb = next) {
 			next = hb->next;
 
 			if (free_func)
 				(*free_func)(hb->data);
 
-			XFREE(MTYPE_HASH_BUCKET, hb);
+			hash_bucket_free(hash, hb);
 			hash->count--;
 		}
-		hash->index[i] = NULL;
 	}
 
 	hash->stats.ssq = 0;
@@ -340,7 +588,11 @@ void hash_free(struct hash *hash)
 
 	XFREE(MTYPE_HASH, hash->name);
 
-	XFREE(MTYPE_HASH_INDEX, hash->index);
+	XFREE(MTYPE_HASH_INDEX, hash->old_index);
+	if (hash->rcu_index)
+		rcu_free(MTYPE_HASH_INDEX, hash->rcu_index, rcu_head);
+	else
+		XFREE(MTYPE_HASH_INDEX, hash->index);
 	XFREE(MTYPE_HASH, hash);
 }
 
@@ -359,7 +611,9 @@ DEFUN_NOSH(show_hash_stats,
 	struct listnode *ln;
 	struct ttable *tt = ttable_new(&ttable_styles[TTSTYLE_BLANK]);
 
-	ttable_add_row(tt, "Hash table|Buckets|Entries|Empty|LF|SD|FLF|SD");
+	ttable_add_row(
+		tt,
+		"Hash table|Buckets|Entries|Empty|LF|SD|FLF|SD|Probe|Max|Resizes|Pause|Max");
 	tt->style.cell.lpad = 2;
 	tt->style.cell.rpad = 1;
 	tt->style.corner = '+';
@@ -388,6 +642,14 @@ DEFUN_NOSH(show_hash_stats,
 	 *   As a rule of thumb this number should be less than 2, and ideally
 	 *   <= 1 for optimal performance. A number larger than 3 generally
 	 *   indicates a poor hash function.
+	 *
+	 * - Probe: average number of buckets compared per hash_get() with an
+	 *   alloc function, Max being the most in a single one.  Plain
+	 *   lookups are not counted.
+	 *
+	 * - Resizes: number of times the table was grown.  Pause is the total
+	 *   time spent resizing, Max the longest the table was blocked by it
+	 *   at once (allocating the new index or moving one batch of chains.)
 	 */
 
 	double lf;    // load factor
@@ -427,10 +689,18 @@ DEFUN_NOSH(show_hash_stats,
 		stdv = sqrt(var);
 		fstdv = sqrt(fvar);
 
-		ttable_add_row(tt, "%s|%d|%ld|%.0f%%|%.2lf|%.2lf|%.2lf|%.2lf",
-			       h->name, h->size, h->count,
-			       (h->stats.empty / (double)h->size) * 100, lf,
-			       stdv, flf, fstdv);
+		ttable_add_row(
+			tt,
+			"%s|%d|%ld|%.0f%%|%.2lf|%.2lf|%.2lf|%.2lf|%.2lf|%u|%u|%" PRIu64
+			"us|%" PRIu64 "us",
+			h->name, h->size, h->count,
+			(h->stats.empty / (double)h->size) * 100, lf, stdv, flf,
+			fstdv,
+			h->stats.lookups
+				? h->stats.probes / (double)h->stats.lookups
+				: 0,
+			h->stats.max_probes, h->stats.resizes,
+			h->stats.resize_usec, h->stats.resize_max_usec);
 	}
 	pthread_mutex_unlock(&_hashes_mtx);
 
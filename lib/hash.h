@@ -23,6 +23,7 @@
 
 #include "memory.h"
 #include "frratomic.h"
+#include "frrcu.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +33,8 @@ extern "C" {
 #define HASH_INITIAL_SIZE 256
 /* Expansion threshold */
 #define HASH_THRESHOLD(used, size) ((used) > (size))
+/* Old chains moved to the new index per insert/release while resizing */
+#define HASH_REHASH_STEP 64
 
 #define HASHWALK_CONTINUE 0
 #define HASHWALK_ABORT -1
@@ -53,11 +56,30 @@ struct hash_bucket {
 	void *data;
 };
 
+/* index of a hash readable under RCU, see hash_set_rcu() */
+struct hash_rcu_index {
+	struct rcu_head rcu_head;
+	unsigned int size;
+	struct hash_bucket *index[];
+};
+
 struct hashstats {
 	/* number of empty hash buckets */
 	atomic_uint_fast32_t empty;
 	/* sum of squares of bucket length */
 	atomic_uint_fast32_t ssq;
+
+	/* hash_get() calls that may insert, buckets compared in them, and
+	 * the most in any one
+	 */
+	unsigned long lookups;
+	unsigned long probes;
+	unsigned int max_probes;
+
+	/* number of resizes; time spent and longest single pause in them */
+	unsigned int resizes;
+	uint64_t resize_usec;
+	uint64_t resize_max_usec;
 };
 
 struct hash {
@@ -67,6 +89,14 @@ struct hash {
 	/* Hash table size. Must be power of 2 */
 	unsigned int size;
 
+	/* While resizing, the chains at old_index[rehash_pos .. old_size)
+	 * have not been moved to index yet.  Use hash_iterate()/hash_walk()
+	 * rather than walking index directly.
+	 */
+	struct hash_bucket **old_index;
+	unsigned int old_size;
+	unsigned int rehash_pos;
+
 	/* If max_size is 0 there is no limit */
 	unsigned int max_size;
 
@@ -81,6 +111,9 @@ struct hash {
 
 	struct hashstats stats;
 
+	/* non-NULL if readers use hash_lookup_rcu(); index points into it */
+	struct hash_rcu_index *rcu_index;
+
 	/* hash name */
 	char *name;
 };
@@ -218,6 +251,38 @@ extern void *hash_alloc_intern(void *data);
  */
 extern void *hash_lookup(struct hash *hash, void *data);
 
+/*
+ * Allow other pthreads to look up items with hash_lookup_rcu() while the
+ * owning thread keeps modifying the hash.
+ *
+ * Buckets and indexes of the hash are then freed through RCU.  The data
+ * items are not; if readers use them, they must be released through RCU
+ * by the user as well.  The hash itself must no longer be reachable by
+ * readers when it is passed to hash_free().
+ *
+ * hash
+ *    hash table to operate on; must be empty
+ */
+extern void hash_set_rcu(struct hash *hash);
+
+/*
+ * Lookup for other pthreads, on a hash set up with hash_set_rcu().
+ *
+ * Same as hash_lookup, except that the caller must hold rcu_read_lock() for
+ * as long as it uses the result.  Items added or removed concurrently may
+ * or may not be found.
+ *
+ * hash
+ *    hash table to operate on
+ *
+ * data
+ *    data to look up
+ *
+ * Returns:
+ *    the data item found, or NULL if it was not found
+ */
+extern void *hash_lookup_rcu(struct hash *hash, void *data);
+
 /*
  * Remove an element from a hash table.
  *
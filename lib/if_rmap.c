@@ -256,36 +256,37 @@ DEFUN (no_if_rmap,
 }
 
 
+struct if_rmap_write_arg {
+	struct vty *vty;
+	int write;
+};
+
+static void if_rmap_write_iter(struct hash_bucket *mp, void *arg)
+{
+	struct if_rmap_write_arg *iwa = arg;
+	struct if_rmap *if_rmap = mp->data;
+
+	if (if_rmap->routemap[IF_RMAP_IN]) {
+		vty_out(iwa->vty, " route-map %s in %s\n",
+			if_rmap->routemap[IF_RMAP_IN], if_rmap->ifname);
+		iwa->write++;
+	}
+
+	if (if_rmap->routemap[IF_RMAP_OUT]) {
+		vty_out(iwa->vty, " route-map %s out %s\n",
+			if_rmap->routemap[IF_RMAP_OUT], if_rmap->ifname);
+		iwa->write++;
+	}
+}
+
 /* Configuration write function. */
 int config_write_if_rmap(struct vty *vty,
 			 struct if_rmap_ctx *ctx)
 {
-	unsigned int i;
-	struct hash_bucket *mp;
-	int write = 0;
-	struct hash *ifrmaphash = ctx->ifrmaphash;
-
-	for (i = 0; i < ifrmaphash->size; i++)
-		for (mp = ifrmaphash->index[i]; mp; mp = mp->next) {
-			struct if_rmap *if_rmap;
-
-			if_rmap = mp->data;
-
-			if (if_rmap->routemap[IF_RMAP_IN]) {
-				vty_out(vty, " route-map %s in %s\n",
-					if_rmap->routemap[IF_RMAP_IN],
-					if_rmap->ifname);
-				write++;
-			}
-
-			if (if_rmap->routemap[IF_RMAP_OUT]) {
-				vty_out(vty, " route-map %s out %s\n",
-					if_rmap->routemap[IF_RMAP_OUT],
-					if_rmap->ifname);
-				write++;
-			}
-		}
-	return write;
+	struct if_rmap_write_arg arg = {.vty = vty};
+
+	hash_iterate(ctx->ifrmaphash, if_rmap_write_iter, &arg);
+	return arg.write;
 }
 
 void if_rmap_ctx_delete(struct if_rmap_ctx *ctx)
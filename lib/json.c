@@ -84,3 +84,96 @@ void json_object_free(struct json_object *obj)
 {
 	json_object_put(obj);
 }
+
+void json_stream_init(struct json_stream *js, struct vty *vty, int flags)
+{
+	memset(js, 0, sizeof(*js));
+	js->vty = vty;
+	js->flags = flags;
+}
+
+static void json_stream_string(struct json_stream *js, const char *str)
+{
+	struct json_object *jstr;
+
+	/* Keys are usually prefixes, names or numbers: avoid going through
+	 * json-c if there's nothing to escape.
+	 */
+	for (const char *c = str; *c; c++) {
+		if (*c == '"' || *c == '\\' || (unsigned char)*c < 0x20)
+			goto escape;
+	}
+	vty_out(js->vty, "\"%s\"", str);
+	return;
+
+escape:
+	jstr = json_object_new_string(str);
+	vty_out(js->vty, "%s",
+		json_object_to_json_string_ext(
+			jstr, JSON_C_TO_STRING_NOSLASHESCAPE));
+	json_object_free(jstr);
+}
+
+/* Start a new member of the current container. */
+static void json_stream_member(struct json_stream *js, const char *key)
+{
+	if (js->depth) {
+		if (!js->first[js->depth - 1])
+			vty_out(js->vty, ",");
+		js->first[js->depth - 1] = false;
+		vty_out(js->vty, "\n%*s", js->depth * 2, "");
+	}
+
+	if (key) {
+		json_stream_string(js, key);
+		vty_out(js->vty, ":");
+	}
+}
+
+static void json_stream_open(struct json_stream *js, const char *key,
+			     char opener, char closer)
+{
+	assert(js->depth < JSON_STREAM_MAX_DEPTH);
+
+	json_stream_member(js, key);
+	vty_out(js->vty, "%c", opener);
+	js->first[js->depth] = true;
+	js->closer[js->depth] = closer;
+	js->depth++;
+}
+
+void json_stream_object_open(struct json_stream *js, const char *key)
+{
+	json_stream_open(js, key, '{', '}');
+}
+
+void json_stream_array_open(struct json_stream *js, const char *key)
+{
+	json_stream_open(js, key, '[', ']');
+}
+
+void json_stream_close(struct json_stream *js)
+{
+	assert(js->depth > 0);
+
+	js->depth--;
+	if (!js->first[js->depth])
+		vty_out(js->vty, "\n%*s", js->depth * 2, "");
+	vty_out(js->vty, "%c", js->closer[js->depth]);
+	if (!js->depth)
+		vty_out(js->vty, "\n");
+}
+
+void json_stream_finish(struct json_stream *js)
+{
+	while (js->depth)
+		json_stream_close(js);
+}
+
+void json_stream_add(struct json_stream *js, const char *key,
+		     struct json_object *obj)
+{
+	json_stream_member(js, key);
+	vty_out(js->vty, "%s", json_object_to_json_string_ext(obj, js->flags));
+	json_object_free(obj);
+}
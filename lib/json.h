@@ -59,6 +59,39 @@ extern struct json_object *json_object_lock(struct json_object *obj);
 extern void json_object_free(struct json_object *obj);
 extern void json_array_string_add(json_object *json, const char *str);
 
+/*
+ * Streaming JSON output.
+ *
+ * Large show commands shouldn't build the JSON representation of an entire
+ * table before printing it.  With this API, the enclosing objects and arrays
+ * are written to the vty as they are opened and closed, while their members
+ * are built as (small) json-c objects and printed one at a time, so that
+ * only one member exists in memory at any time.  The output is the same
+ * JSON as if the members had been added to a json-c tree.
+ */
+#define JSON_STREAM_MAX_DEPTH 16
+
+struct json_stream {
+	struct vty *vty;
+	int flags;
+	int depth;
+	bool first[JSON_STREAM_MAX_DEPTH];
+	char closer[JSON_STREAM_MAX_DEPTH];
+};
+
+/* flags are the JSON_C_TO_STRING_* flags used to print the members */
+extern void json_stream_init(struct json_stream *js, struct vty *vty,
+			     int flags);
+/* key must be NULL at the top level and inside arrays */
+extern void json_stream_object_open(struct json_stream *js, const char *key);
+extern void json_stream_array_open(struct json_stream *js, const char *key);
+extern void json_stream_close(struct json_stream *js);
+/* closes all containers that are still open */
+extern void json_stream_finish(struct json_stream *js);
+/* prints obj as a member of the current container, and frees it */
+extern void json_stream_add(struct json_stream *js, const char *key,
+			    struct json_object *obj);
+
 #define JSON_STR "JavaScript Object Notation\n"
 
 /* NOTE: json-c lib has following commit 316da85 which
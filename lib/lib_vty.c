@@ -44,6 +44,8 @@
 #include "vty.h"
 #include "command.h"
 
+DEFINE_HOOK(show_memory, (struct vty *vty), (vty));
+
 #if defined(HAVE_MALLINFO2) || defined(HAVE_MALLINFO)
 static int show_memory_mallinfo(struct vty *vty)
 {
@@ -98,13 +100,16 @@ static int qmem_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 #endif
 			);
 	} else {
-		if (mt->n_max != 0) {
+		struct memtype_stats stats;
+
+		mtype_stats(mt, &stats);
+		if (stats.n_max != 0) {
 			char size[32];
 			snprintf(size, sizeof(size), "%6zu", mt->size);
 #ifdef HAVE_MALLOC_USABLE_SIZE
 #define TSTR " %9zu"
-#define TARG , mt->total
-#define TARG2 , mt->max_size
+#define TARG , stats.total
+#define TARG2 , stats.max_size
 #else
 #define TSTR ""
 #define TARG
@@ -112,15 +117,31 @@ static int qmem_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 #endif
 			vty_out(vty, "%-30s: %8zu %-8s"TSTR" %8zu"TSTR"\n",
 				mt->name,
-				mt->n_alloc,
+				stats.n_alloc,
 				mt->size == 0 ? ""
 					      : mt->size == SIZE_VAR
 							? "variable"
 							: size
 				TARG,
-				mt->n_max
+				stats.n_max
 				TARG2);
 		}
+#ifdef HAVE_MALLOC_USABLE_SIZE
+		/* Pooled MTYPEs: blocks idling in the per-thread caches, and
+		 * bytes allocated on top of what was requested.
+		 */
+		if (mt->pool && stats.n_max != 0) {
+			size_t slack = 0;
+
+			if (mt->size != SIZE_VAR
+			    && stats.total > stats.n_alloc * mt->size)
+				slack = stats.total - stats.n_alloc * mt->size;
+			vty_out(vty,
+				"%-30s  pool: %zu idle blocks (%zu bytes), %zu bytes slack\n",
+				"", stats.n_cached,
+				stats.n_cached * mt->pool_size, slack);
+		}
+#endif
 	}
 	return 0;
 }
@@ -137,6 +158,7 @@ DEFUN_NOSH (show_memory,
 #endif /* HAVE_MALLINFO */
 
 	qmem_walk(qmem_walker, vty);
+	hook_call(show_memory, vty);
 	return CMD_SUCCESS;
 }
 
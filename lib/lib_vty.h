@@ -22,13 +22,19 @@
 #define _ZEBRA_LIB_VTY_H
 
 #include "memory.h"
+#include "hook.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct vty;
+
 extern void lib_cmd_init(void);
 
+/* Daemon-specific lines at the end of "show memory" */
+DECLARE_HOOK(show_memory, (struct vty *vty), (vty));
+
 /* Human friendly string for given byte count */
 #define MTYPE_MEMSTR_LEN 20
 extern const char *mtype_memstr(char *, size_t, unsigned long);
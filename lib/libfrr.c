@@ -41,6 +41,7 @@
 #include "northbound_db.h"
 #include "debug.h"
 #include "frrcu.h"
+#include "segbuf.h"
 #include "frr_pthread.h"
 #include "defaults.h"
 #include "frrscript.h"
@@ -369,6 +370,11 @@ void frr_preinit(struct frr_daemon_info *daemon, int argc, char **argv)
 	 * early in _preinit is perfect.
 	 */
 	systemd_init_env();
+
+	/* segment freelists are per-pthread and need to be set up before
+	 * any pthread is started
+	 */
+	segbuf_init();
 }
 
 bool frr_is_startup_fd(int fd)
@@ -1194,6 +1200,7 @@ void frr_fini(void)
 	zlog_fini();
 	/* frrmod_init -> nothing needed / hooks */
 	rcu_shutdown();
+	mtype_pool_fini();
 
 	if (!debug_memstats_at_exit)
 		return;
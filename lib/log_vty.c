@@ -160,6 +160,8 @@ DEFUN_NOSH (show_logging,
 	    SHOW_STR
 	    "Show current logging configuration\n")
 {
+	struct zlog_async_stats async_stats;
+
 	log_show_syslog(vty);
 
 	vty_out(vty, "Stdout logging: ");
@@ -203,6 +205,15 @@ DEFUN_NOSH (show_logging,
 		(zt_file.record_priority ? "enabled" : "disabled"));
 	vty_out(vty, "Timestamp precision: %d\n", zt_file.ts_subsec);
 
+	zlog_async_stats(&async_stats);
+	vty_out(vty, "Asynchronous logging: %s\n",
+		zlog_get_async() ? "enabled" : "disabled");
+	if (async_stats.n_args || async_stats.n_text || async_stats.n_drops)
+		vty_out(vty,
+			"  %zu messages queued (%zu preformatted), %zu dropped\n",
+			async_stats.n_args + async_stats.n_text,
+			async_stats.n_text, async_stats.n_drops);
+
 	hook_call(zlog_cli_show, vty);
 	return CMD_SUCCESS;
 }
@@ -672,6 +683,18 @@ DEFPY (log_immediate_mode,
 	return CMD_SUCCESS;
 }
 
+/* Enable/disable formatting & writing messages on a separate pthread */
+DEFPY (log_async,
+       log_async_cmd,
+       "[no] log async",
+       NO_STR
+       "Logging control\n"
+       "Format and write log messages on a separate thread\n")
+{
+	zlog_set_async(!no);
+	return CMD_SUCCESS;
+}
+
 void log_config_write(struct vty *vty)
 {
 	bool show_cmdline_hint = false;
@@ -751,6 +774,8 @@ void log_config_write(struct vty *vty)
 		vty_out(vty, "no log error-category\n");
 	if (!zlog_get_prefix_xid())
 		vty_out(vty, "no log unique-id\n");
+	if (zlog_get_async())
+		vty_out(vty, "log async\n");
 }
 
 static int log_vty_init(const char *progname, const char *protoname,
@@ -801,4 +826,5 @@ void log_cmd_init(void)
 	install_element(CONFIG_NODE, &config_log_filterfile_cmd);
 	install_element(CONFIG_NODE, &no_config_log_filterfile_cmd);
 	install_element(CONFIG_NODE, &log_immediate_mode_cmd);
+	install_element(CONFIG_NODE, &log_async_cmd);
 }
@@ -38,22 +38,73 @@ DEFINE_MGROUP(LIB, "libfrr");
 DEFINE_MTYPE(LIB, TMP, "Temporary memory");
 DEFINE_MTYPE(LIB, BITFIELD, "Bitfield memory");
 
+#ifndef thread_local
+#define thread_local __thread
+#endif
+
+/* high-water marks are refreshed every MT_MAX_SAMPLE allocations per shard */
+#define MT_MAX_SAMPLE 64
+
+static atomic_uint_fast32_t mt_shard_next;
+
+static inline struct memtype_shard *mt_shard(struct memtype *mt)
+{
+	static thread_local unsigned int shard_idx;
+
+	if (__builtin_expect(shard_idx == 0, 0))
+		shard_idx = 1 + atomic_fetch_add_explicit(&mt_shard_next, 1,
+							  memory_order_relaxed)
+					% MTYPE_SHARDS;
+	return &mt->shards[shard_idx - 1];
+}
+
+void mtype_stats(struct memtype *mt, struct memtype_stats *stats)
+{
+	size_t oldmax;
+
+	memset(stats, 0, sizeof(*stats));
+	for (size_t i = 0; i < MTYPE_SHARDS; i++) {
+		struct memtype_shard *shard = &mt->shards[i];
+
+		stats->n_alloc += atomic_load_explicit(&shard->n_alloc,
+						       memory_order_relaxed);
+		stats->n_cached += atomic_load_explicit(&shard->n_cached,
+							memory_order_relaxed);
+#ifdef HAVE_MALLOC_USABLE_SIZE
+		stats->total += atomic_load_explicit(&shard->total,
+						     memory_order_relaxed);
+#endif
+	}
+
+	/* note that these may fail, but approximation is sufficient */
+	oldmax = atomic_load_explicit(&mt->n_max, memory_order_relaxed);
+	if (stats->n_alloc > oldmax)
+		atomic_compare_exchange_weak_explicit(&mt->n_max, &oldmax,
+						      stats->n_alloc,
+						      memory_order_relaxed,
+						      memory_order_relaxed);
+	stats->n_max = MAX(oldmax, stats->n_alloc);
+
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	oldmax = atomic_load_explicit(&mt->max_size, memory_order_relaxed);
+	if (stats->total > oldmax)
+		atomic_compare_exchange_weak_explicit(&mt->max_size, &oldmax,
+						      stats->total,
+						      memory_order_relaxed,
+						      memory_order_relaxed);
+	stats->max_size = MAX(oldmax, stats->total);
+#endif
+}
+
 static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
 {
+	struct memtype_shard *shard = mt_shard(mt);
 	size_t current;
 	size_t oldsize;
 
-	current = 1 + atomic_fetch_add_explicit(&mt->n_alloc, 1,
+	current = 1 + atomic_fetch_add_explicit(&shard->n_alloc, 1,
 						memory_order_relaxed);
 
-	oldsize = atomic_load_explicit(&mt->n_max, memory_order_relaxed);
-	if (current > oldsize)
-		/* note that this may fail, but approximation is sufficient */
-		atomic_compare_exchange_weak_explicit(&mt->n_max, &oldsize,
-						      current,
-						      memory_order_relaxed,
-						      memory_order_relaxed);
-
 	oldsize = atomic_load_explicit(&mt->size, memory_order_relaxed);
 	if (oldsize == 0)
 		oldsize = atomic_exchange_explicit(&mt->size, size,
@@ -65,32 +116,252 @@ static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
 #ifdef HAVE_MALLOC_USABLE_SIZE
 	size_t mallocsz = malloc_usable_size(ptr);
 
-	current = mallocsz + atomic_fetch_add_explicit(&mt->total, mallocsz,
-						       memory_order_relaxed);
-	oldsize = atomic_load_explicit(&mt->max_size, memory_order_relaxed);
-	if (current > oldsize)
-		/* note that this may fail, but approximation is sufficient */
-		atomic_compare_exchange_weak_explicit(&mt->max_size, &oldsize,
-						      current,
-						      memory_order_relaxed,
-						      memory_order_relaxed);
+	atomic_fetch_add_explicit(&shard->total, mallocsz,
+				  memory_order_relaxed);
 #endif
+
+	/* Summing up the shards on every allocation would defeat their
+	 * purpose, so the high-water marks are only sampled.
+	 */
+	if (current % MT_MAX_SAMPLE == 0
+	    || (current == 1
+		&& !atomic_load_explicit(&mt->n_max, memory_order_relaxed))) {
+		struct memtype_stats stats;
+
+		mtype_stats(mt, &stats);
+	}
 }
 
 static inline void mt_count_free(struct memtype *mt, void *ptr)
 {
+	struct memtype_shard *shard = mt_shard(mt);
+
 	frrtrace(2, frr_libfrr, memfree, mt, ptr);
 
-	assert(mt->n_alloc);
-	atomic_fetch_sub_explicit(&mt->n_alloc, 1, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&shard->n_alloc, 1, memory_order_relaxed);
 
 #ifdef HAVE_MALLOC_USABLE_SIZE
 	size_t mallocsz = malloc_usable_size(ptr);
 
-	atomic_fetch_sub_explicit(&mt->total, mallocsz, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&shard->total, mallocsz,
+				  memory_order_relaxed);
+#endif
+}
+
+/*
+ * Per-thread caches of freed blocks, for MTYPEs that opted in with
+ * mtype_pool_enable().  Each pool has a slot in the thread-local array;
+ * cached blocks are chained through their first word.
+ *
+ * Only pthreads that allocate from a pool keep freed blocks for
+ * themselves.  Blocks freed elsewhere (e.g. BGP output buffers allocated
+ * on the main pthread and freed on the I/O pthread), or beyond a full
+ * cache, go onto a shared list for the pool.  A pthread whose cache runs
+ * empty takes that whole list over with a single atomic exchange, so
+ * nothing ever pops single blocks off it and there is no ABA problem.
+ */
+#define MTYPE_POOLS_MAX 16
+#define MTYPE_POOL_CACHE 256
+#define MTYPE_POOL_SHARED 1024
+
+struct mt_pool_cache {
+	void *head;
+	unsigned int count;
+	/* this pthread allocates from the pool */
+	bool alloc;
+};
+
+struct mt_pool_shared {
+	void *_Atomic head;
+	atomic_uint count;
+};
+
+static struct memtype *mt_pools[MTYPE_POOLS_MAX];
+static unsigned int mt_pools_count;
+static struct mt_pool_shared mt_pool_shared[MTYPE_POOLS_MAX];
+
+static thread_local struct mt_pool_cache mt_pool_tls[MTYPE_POOLS_MAX];
+static thread_local bool mt_pool_tls_registered;
+static pthread_key_t mt_pool_key;
+static pthread_once_t mt_pool_key_once = PTHREAD_ONCE_INIT;
+
+static void mt_pool_free_list(struct memtype *mt, void *ptr)
+{
+	void *next;
+
+	for (; ptr; ptr = next) {
+		next = *(void **)ptr;
+		atomic_fetch_sub_explicit(&mt_shard(mt)->n_cached, 1,
+					  memory_order_relaxed);
+		free(ptr);
+	}
+}
+
+/* give back the blocks cached by an exiting thread */
+static void mt_pool_thread_exit(void *arg)
+{
+	struct mt_pool_cache *caches = arg;
+
+	for (unsigned int i = 0; i < mt_pools_count; i++) {
+		mt_pool_free_list(mt_pools[i], caches[i].head);
+		caches[i].head = NULL;
+		caches[i].count = 0;
+	}
+}
+
+static void mt_pool_key_init(void)
+{
+	pthread_key_create(&mt_pool_key, mt_pool_thread_exit);
+}
+
+static inline void mt_pool_tls_register(void)
+{
+	if (!mt_pool_tls_registered) {
+		mt_pool_tls_registered = true;
+		pthread_setspecific(mt_pool_key, mt_pool_tls);
+	}
+}
+
+void mtype_pool_enable(struct memtype *mt, size_t size)
+{
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	if (mt->pool || mt_pools_count == MTYPE_POOLS_MAX)
+		return;
+
+	pthread_once(&mt_pool_key_once, mt_pool_key_init);
+
+	mt->pool_size = MAX(size, sizeof(void *));
+	mt_pools[mt_pools_count++] = mt;
+	mt->pool = mt_pools_count;
 #endif
 }
 
+void mtype_pool_fini(void)
+{
+	struct mt_pool_shared *shared;
+
+	if (mt_pool_tls_registered) {
+		mt_pool_tls_registered = false;
+		pthread_setspecific(mt_pool_key, NULL);
+	}
+	mt_pool_thread_exit(mt_pool_tls);
+
+	for (unsigned int i = 0; i < mt_pools_count; i++) {
+		shared = &mt_pool_shared[i];
+		mt_pool_free_list(mt_pools[i],
+				  atomic_exchange_explicit(&shared->head, NULL,
+							   memory_order_acquire));
+		atomic_store_explicit(&shared->count, 0, memory_order_relaxed);
+	}
+}
+
+/* take over all blocks on the pool's shared list */
+static void *mt_pool_take_shared(struct memtype *mt,
+				 struct mt_pool_cache *cache)
+{
+	struct mt_pool_shared *shared = &mt_pool_shared[mt->pool - 1];
+	unsigned int count = 0;
+	void *ptr, *head;
+
+	if (!atomic_load_explicit(&shared->head, memory_order_relaxed))
+		return NULL;
+
+	head = atomic_exchange_explicit(&shared->head, NULL,
+					memory_order_acquire);
+	for (ptr = head; ptr; ptr = *(void **)ptr)
+		count++;
+	atomic_fetch_sub_explicit(&shared->count, count, memory_order_relaxed);
+
+	if (head)
+		mt_pool_tls_register();
+	cache->count = count;
+	return head;
+}
+
+static inline void *mt_pool_get(struct memtype *mt, size_t size)
+{
+	struct mt_pool_cache *cache;
+	void *ptr;
+
+	if (!mt->pool || size > mt->pool_size)
+		return NULL;
+
+	cache = &mt_pool_tls[mt->pool - 1];
+	cache->alloc = true;
+
+	ptr = cache->head;
+	if (!ptr)
+		ptr = mt_pool_take_shared(mt, cache);
+	if (!ptr)
+		return NULL;
+
+	cache->head = *(void **)ptr;
+	cache->count--;
+	atomic_fetch_sub_explicit(&mt_shard(mt)->n_cached, 1,
+				  memory_order_relaxed);
+	return ptr;
+}
+
+static inline bool mt_pool_put_shared(struct memtype *mt, void *ptr)
+{
+	struct mt_pool_shared *shared = &mt_pool_shared[mt->pool - 1];
+	void *head;
+
+	if (atomic_fetch_add_explicit(&shared->count, 1, memory_order_relaxed)
+	    >= MTYPE_POOL_SHARED) {
+		atomic_fetch_sub_explicit(&shared->count, 1,
+					  memory_order_relaxed);
+		return false;
+	}
+
+	/* push only;  the list is only ever emptied as a whole */
+	head = atomic_load_explicit(&shared->head, memory_order_relaxed);
+	do {
+		*(void **)ptr = head;
+	} while (!atomic_compare_exchange_weak_explicit(
+		&shared->head, &head, ptr, memory_order_release,
+		memory_order_relaxed));
+	return true;
+}
+
+static inline bool mt_pool_put(struct memtype *mt, void *ptr)
+{
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	struct mt_pool_cache *cache;
+
+	if (!mt->pool)
+		return false;
+
+	if (malloc_usable_size(ptr) < mt->pool_size)
+		return false;
+
+	cache = &mt_pool_tls[mt->pool - 1];
+	if (!cache->alloc || cache->count >= MTYPE_POOL_CACHE) {
+		if (!mt_pool_put_shared(mt, ptr))
+			return false;
+	} else {
+		mt_pool_tls_register();
+
+		*(void **)ptr = cache->head;
+		cache->head = ptr;
+		cache->count++;
+	}
+	atomic_fetch_add_explicit(&mt_shard(mt)->n_cached, 1,
+				  memory_order_relaxed);
+	return true;
+#else
+	return false;
+#endif
+}
+
+/* pooled MTYPEs allocate full-sized blocks, so that they can be recycled */
+static inline size_t mt_pool_alloc_size(struct memtype *mt, size_t size)
+{
+	if (mt->pool && size <= mt->pool_size)
+		return mt->pool_size;
+	return size;
+}
+
 static inline void *mt_checkalloc(struct memtype *mt, void *ptr, size_t size)
 {
 	frrtrace(3, frr_libfrr, memalloc, mt, ptr, size);
@@ -108,12 +379,22 @@ static inline void *mt_checkalloc(struct memtype *mt, void *ptr, size_t size)
 
 void *qmalloc(struct memtype *mt, size_t size)
 {
-	return mt_checkalloc(mt, malloc(size), size);
+	void *ptr = mt_pool_get(mt, size);
+
+	if (!ptr)
+		ptr = malloc(mt_pool_alloc_size(mt, size));
+	return mt_checkalloc(mt, ptr, size);
 }
 
 void *qcalloc(struct memtype *mt, size_t size)
 {
-	return mt_checkalloc(mt, calloc(size, 1), size);
+	void *ptr = mt_pool_get(mt, size);
+
+	if (ptr)
+		memset(ptr, 0, size);
+	else
+		ptr = calloc(mt_pool_alloc_size(mt, size), 1);
+	return mt_checkalloc(mt, ptr, size);
 }
 
 void *qrealloc(struct memtype *mt, void *ptr, size_t size)
@@ -136,9 +417,12 @@ void qcountfree(struct memtype *mt, void *ptr)
 
 void qfree(struct memtype *mt, void *ptr)
 {
-	if (ptr)
-		mt_count_free(mt, ptr);
-	free(ptr);
+	if (!ptr)
+		return;
+
+	mt_count_free(mt, ptr);
+	if (!mt_pool_put(mt, ptr))
+		free(ptr);
 }
 
 int qmem_walk(qmem_walk_fn *func, void *arg)
@@ -172,13 +456,13 @@ static int qmem_exit_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 			"%s: showing active allocations in memory group %s\n",
 			eda->prefix, mg->name);
 
-	} else if (mt->n_alloc) {
+	} else if (mtype_stats_alloc(mt)) {
 		char size[32];
 		if (!mg->active_at_exit)
 			eda->error++;
 		snprintf(size, sizeof(size), "%10zu", mt->size);
 		fprintf(eda->fp, "%s: memstats:  %-30s: %6zu * %s\n",
-			eda->prefix, mt->name, mt->n_alloc,
+			eda->prefix, mt->name, mtype_stats_alloc(mt),
 			mt->size == SIZE_VAR ? "(variably sized)" : size);
 	}
 	return 0;
@@ -33,16 +33,37 @@ extern "C" {
 #endif
 
 #define SIZE_VAR ~0UL
+
+/* Allocation counters are split in shards, each thread updating only one of
+ * them, so that threads allocating concurrently don't fight over the same
+ * cache line.  The counters of a single shard can underflow when memory is
+ * freed by another thread than the one that allocated it; only their sum is
+ * meaningful.
+ */
+#define MTYPE_SHARDS 4
+
+struct memtype_shard {
+	atomic_size_t n_alloc;
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	atomic_size_t total;
+#endif
+	/* blocks sitting in per-thread pool caches */
+	atomic_size_t n_cached;
+} __attribute__((aligned(64)));
+
 struct memtype {
 	struct memtype *next, **ref;
 	const char *name;
-	atomic_size_t n_alloc;
 	atomic_size_t n_max;
 	atomic_size_t size;
 #ifdef HAVE_MALLOC_USABLE_SIZE
-	atomic_size_t total;
 	atomic_size_t max_size;
 #endif
+	/* see mtype_pool_enable() */
+	unsigned int pool;
+	size_t pool_size;
+
+	struct memtype_shard shards[MTYPE_SHARDS];
 };
 
 struct memgroup {
@@ -120,7 +141,6 @@ struct memgroup {
 		__attribute__((section(".data.mtypes"))) = { {                 \
 			.name = desc,                                          \
 			.next = NULL,                                          \
-			.n_alloc = 0,                                          \
 			.size = 0,                                             \
 			.ref = NULL,                                           \
 	} };                                                                   \
@@ -177,11 +197,43 @@ extern void qfree(struct memtype *mt, void *ptr) __attribute__((nonnull(1)));
 		ptr = NULL;                                                    \
 	} while (0)
 
+struct memtype_stats {
+	size_t n_alloc;
+	size_t n_max;
+	size_t total;
+	size_t max_size;
+	size_t n_cached;
+};
+
+/* sums up the shards of an MTYPE, also updating its high-water marks */
+extern void mtype_stats(struct memtype *mt, struct memtype_stats *stats);
+
 static inline size_t mtype_stats_alloc(struct memtype *mt)
 {
-	return mt->n_alloc;
+	size_t n_alloc = 0;
+
+	for (size_t i = 0; i < MTYPE_SHARDS; i++)
+		n_alloc += atomic_load_explicit(&mt->shards[i].n_alloc,
+						memory_order_relaxed);
+	return n_alloc;
 }
 
+/* Opt-in recycling of freed blocks for MTYPEs with fixed-size allocations:
+ * freed blocks of at least @size bytes are kept in small per-thread caches
+ * and handed out again by the next allocation of up to @size bytes,
+ * bypassing the system allocator.  Blocks freed on a pthread that doesn't
+ * allocate from the pool are handed back through a shared list.  The
+ * blocks remain regular malloc() blocks, so XREALLOC and XCOUNTFREE keep
+ * working.  Call from the daemon's startup code, before any additional
+ * pthread is started.
+ */
+extern void mtype_pool_enable(struct memtype *mt, size_t size);
+/* Release the blocks cached by the calling pthread and on the shared lists.
+ * Other pthreads release their caches on exit;  frr_fini() calls this for
+ * the main pthread once it is the only one left.
+ */
+extern void mtype_pool_fini(void);
+
 /* NB: calls are ordered by memgroup; and there is a call with mt == NULL for
  * each memgroup (so that a header can be printed, and empty memgroups show)
  *
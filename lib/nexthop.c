@@ -366,6 +366,12 @@ bool nexthop_labels_match(const struct nexthop *nh1, const struct nexthop *nh2)
 	return true;
 }
 
+/* Recycle freed nexthops, see mtype_pool_enable() */
+void nexthop_pool_enable(void)
+{
+	mtype_pool_enable(MTYPE_NEXTHOP, sizeof(struct nexthop));
+}
+
 struct nexthop *nexthop_new(void)
 {
 	struct nexthop *nh;
@@ -154,6 +154,7 @@ struct nexthop {
 	} while (0)
 
 struct nexthop *nexthop_new(void);
+extern void nexthop_pool_enable(void);
 
 void nexthop_free(struct nexthop *nexthop);
 void nexthops_free(struct nexthop *nexthop);
@@ -233,6 +233,24 @@ ssize_t printfrr_extp(struct fbuf *buf, struct printfrr_eargs *ea,
 	return -1;
 }
 
+ssize_t bprintfrr_extp(struct fbuf *out, const char **fmt, const void *ptr)
+{
+	struct printfrr_eargs ea = {
+		.fmt = *fmt,
+		.precision = -1,
+		.width = -1,
+	};
+	ssize_t ret;
+
+	if (!printfrr_ext_char((*fmt)[0]))
+		return -1;
+
+	ret = printfrr_extp(out, &ea, ptr);
+	if (ret >= 0)
+		*fmt = ea.fmt;
+	return ret;
+}
+
 ssize_t printfrr_exti(struct fbuf *buf, struct printfrr_eargs *ea,
 		      uintmax_t num)
 {
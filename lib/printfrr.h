@@ -201,6 +201,13 @@ static inline ssize_t printfrr_ext_len(struct printfrr_eargs *ea)
  */
 void printfrr_ext_reg(const struct printfrr_ext *);
 
+/* print a single %p extension on its own, without width/precision/flags.
+ * *fmt points at the extension name (directly after "%p") and is advanced
+ * past everything the extension consumed.  Returns -1 if no extension
+ * matches, in which case nothing is printed and *fmt is left alone.
+ */
+ssize_t bprintfrr_extp(struct fbuf *out, const char **fmt, const void *ptr);
+
 #define printfrr_ext_autoreg_p(matchs, print_fn)                               \
 	static ssize_t print_fn(struct fbuf *, struct printfrr_eargs *,        \
 				const void *);                                 \
@@ -22,10 +22,12 @@
 #include "pullwr.h"
 #include "memory.h"
 #include "monotime.h"
+#include "segbuf.h"
 
 /* defaults */
 #define PULLWR_THRESH	16384	/* size at which we start to call write() */
 #define PULLWR_MAXSPIN	2500	/* max µs to spend grabbing more data */
+#define PULLWR_MAXIOV	64	/* max segments handed to one writev() */
 
 struct pullwr {
 	int fd;
@@ -37,19 +39,17 @@ struct pullwr {
 	void (*fill)(void *, struct pullwr *);
 	void (*err)(void *, struct pullwr *, bool);
 
-	/* ring buffer (although it's "un-ringed" on resizing, it WILL wrap
-	 * around if data is trickling in while keeping it at a constant size)
+	/* pending data;  small writes are copied into pooled segments,
+	 * segbufs are queued by reference
 	 */
-	size_t bufsz, valid, pos;
+	struct segbuf *buf;
 	uint64_t total_written;
-	char *buffer;
 
 	size_t thresh;		/* PULLWR_THRESH */
 	int64_t maxspin;	/* PULLWR_MAXSPIN */
 };
 
 DEFINE_MTYPE_STATIC(LIB, PULLWR_HEAD, "pull-driven write controller");
-DEFINE_MTYPE_STATIC(LIB, PULLWR_BUF,  "pull-driven write buffer");
 
 static int pullwr_run(struct thread *t);
 
@@ -66,6 +66,7 @@ struct pullwr *_pullwr_new(struct thread_master *tm, int fd,
 	pullwr->arg = arg;
 	pullwr->fill = fill;
 	pullwr->err = err;
+	pullwr->buf = segbuf_new();
 
 	pullwr->thresh = PULLWR_THRESH;
 	pullwr->maxspin = PULLWR_MAXSPIN;
@@ -77,7 +78,7 @@ void pullwr_del(struct pullwr *pullwr)
 {
 	THREAD_OFF(pullwr->writer);
 
-	XFREE(MTYPE_PULLWR_BUF, pullwr->buffer);
+	segbuf_free(pullwr->buf);
 	XFREE(MTYPE_PULLWR_HEAD, pullwr);
 }
 
@@ -96,104 +97,23 @@ void pullwr_bump(struct pullwr *pullwr)
 	thread_add_timer(pullwr->tm, pullwr_run, pullwr, 0, &pullwr->writer);
 }
 
-static size_t pullwr_iov(struct pullwr *pullwr, struct iovec *iov)
+void pullwr_write(struct pullwr *pullwr, const void *data, size_t len)
 {
-	size_t len1;
-
-	if (pullwr->valid == 0)
-		return 0;
-
-	if (pullwr->pos + pullwr->valid <= pullwr->bufsz) {
-		iov[0].iov_base = pullwr->buffer + pullwr->pos;
-		iov[0].iov_len = pullwr->valid;
-		return 1;
-	}
-
-	len1 = pullwr->bufsz - pullwr->pos;
-
-	iov[0].iov_base = pullwr->buffer + pullwr->pos;
-	iov[0].iov_len = len1;
-	iov[1].iov_base = pullwr->buffer;
-	iov[1].iov_len = pullwr->valid - len1;
-	return 2;
+	segbuf_put(pullwr->buf, data, len);
+	pullwr_bump(pullwr);
 }
 
-static void pullwr_resize(struct pullwr *pullwr, size_t need)
+void pullwr_write_segbuf(struct pullwr *pullwr, const struct segbuf *sb)
 {
-	struct iovec iov[2];
-	size_t niov, newsize;
-	char *newbuf;
-
-	/* the buffer is maintained at pullwr->thresh * 2 since we'll be
-	 * trying to fill it as long as it's anywhere below pullwr->thresh.
-	 * That means we frequently end up a little short of it and then write
-	 * something that goes over the threshold.  So, just use double.
-	 */
-	if (need) {
-		/* resize up */
-		if (pullwr->bufsz - pullwr->valid >= need)
-			return;
-
-		newsize = MAX((pullwr->valid + need) * 2, pullwr->thresh * 2);
-		newbuf = XMALLOC(MTYPE_PULLWR_BUF, newsize);
-	} else if (!pullwr->valid) {
-		/* resize down, buffer empty */
-		newsize = 0;
-		newbuf = NULL;
-	} else {
-		/* resize down */
-		if (pullwr->bufsz - pullwr->valid < pullwr->thresh)
-			return;
-		newsize = MAX(pullwr->valid, pullwr->thresh * 2);
-		newbuf = XMALLOC(MTYPE_PULLWR_BUF, newsize);
-	}
-
-	niov = pullwr_iov(pullwr, iov);
-	if (niov >= 1) {
-		memcpy(newbuf, iov[0].iov_base, iov[0].iov_len);
-		if (niov >= 2)
-			memcpy(newbuf + iov[0].iov_len,
-				iov[1].iov_base, iov[1].iov_len);
-	}
-
-	XFREE(MTYPE_PULLWR_BUF, pullwr->buffer);
-	pullwr->buffer = newbuf;
-	pullwr->bufsz = newsize;
-	pullwr->pos = 0;
-}
-
-void pullwr_write(struct pullwr *pullwr, const void *data, size_t len)
-{
-	pullwr_resize(pullwr, len);
-
-	if (pullwr->pos + pullwr->valid > pullwr->bufsz) {
-		size_t pos;
-
-		pos = (pullwr->pos + pullwr->valid) % pullwr->bufsz;
-		memcpy(pullwr->buffer + pos, data, len);
-	} else {
-		size_t max1, len1;
-		max1 = pullwr->bufsz - (pullwr->pos + pullwr->valid);
-		max1 = MIN(max1, len);
-
-		memcpy(pullwr->buffer + pullwr->pos + pullwr->valid,
-				data, max1);
-		len1 = len - max1;
-
-		if (len1)
-			memcpy(pullwr->buffer, (char *)data + max1, len1);
-
-	}
-	pullwr->valid += len;
-
+	segbuf_append(pullwr->buf, sb);
 	pullwr_bump(pullwr);
 }
 
 static int pullwr_run(struct thread *t)
 {
 	struct pullwr *pullwr = THREAD_ARG(t);
-	struct iovec iov[2];
-	size_t niov, lastvalid;
+	struct iovec iov[PULLWR_MAXIOV];
+	size_t niov, valid, lastvalid;
 	ssize_t nwr;
 	struct timeval t0;
 	bool maxspun = false;
@@ -201,12 +121,13 @@ static int pullwr_run(struct thread *t)
 	monotime(&t0);
 
 	do {
-		lastvalid = pullwr->valid - 1;
-		while (pullwr->valid < pullwr->thresh
-				&& pullwr->valid != lastvalid
+		valid = SEGBUF_READABLE(pullwr->buf);
+		lastvalid = valid - 1;
+		while (valid < pullwr->thresh && valid != lastvalid
 				&& !maxspun) {
-			lastvalid = pullwr->valid;
+			lastvalid = valid;
 			pullwr->fill(pullwr->arg, pullwr);
+			valid = SEGBUF_READABLE(pullwr->buf);
 
 			/* check after doing at least one fill() call so we
 			 * don't spin without making progress on slow boxes
@@ -216,16 +137,16 @@ static int pullwr_run(struct thread *t)
 				maxspun = true;
 		}
 
-		if (pullwr->valid == 0) {
+		if (valid == 0) {
 			/* we made a fill() call above that didn't feed any
 			 * data in, and we have nothing more queued, so we go
 			 * into idle, i.e. no calling thread_add_write()
 			 */
-			pullwr_resize(pullwr, 0);
+			segbuf_compact(pullwr->buf);
 			return 0;
 		}
 
-		niov = pullwr_iov(pullwr, iov);
+		niov = segbuf_iovec(pullwr->buf, iov, array_size(iov));
 		assert(niov);
 
 		nwr = writev(pullwr->fd, iov, niov);
@@ -242,22 +163,16 @@ static int pullwr_run(struct thread *t)
 		}
 
 		pullwr->total_written += nwr;
-		pullwr->valid -= nwr;
-		pullwr->pos += nwr;
-		pullwr->pos %= pullwr->bufsz;
-	} while (pullwr->valid == 0 && !maxspun);
-	/* pullwr->valid != 0 implies we did an incomplete write, i.e. socket
+		segbuf_forward_getp(pullwr->buf, nwr);
+		segbuf_compact(pullwr->buf);
+		valid = SEGBUF_READABLE(pullwr->buf);
+	} while (valid == 0 && !maxspun);
+	/* valid != 0 implies we did an incomplete write, i.e. socket
 	 * is full and we go wait until it's available for writing again.
 	 */
 
 	thread_add_write(pullwr->tm, pullwr_run, pullwr, pullwr->fd,
 			&pullwr->writer);
-
-	/* if we hit the time limit, just keep the buffer, we'll probably need
-	 * it anyway & another run is already coming up.
-	 */
-	if (!maxspun)
-		pullwr_resize(pullwr, 0);
 	return 0;
 }
 
@@ -267,7 +182,7 @@ void pullwr_stats(struct pullwr *pullwr, uint64_t *total_written,
 	int tmp;
 
 	*total_written = pullwr->total_written;
-	*pending = pullwr->valid;
+	*pending = SEGBUF_READABLE(pullwr->buf);
 
 	if (ioctl(pullwr->fd, TIOCOUTQ, &tmp) != 0)
 		tmp = 0;
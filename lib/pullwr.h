@@ -25,6 +25,7 @@
 
 #include "thread.h"
 #include "stream.h"
+#include "segbuf.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -102,6 +103,10 @@ extern void pullwr_bump(struct pullwr *pullwr);
 extern void pullwr_write(struct pullwr *pullwr,
 		const void *data, size_t len);
 
+/* queues a reference to the readable part of sb, without copying it */
+extern void pullwr_write_segbuf(struct pullwr *pullwr,
+				const struct segbuf *sb);
+
 static inline void pullwr_write_stream(struct pullwr *pullwr,
 		struct stream *s)
 {
@@ -0,0 +1,393 @@
+/*
+ * Refcounted segment buffers
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "segbuf.h"
+#include "memory.h"
+
+DEFINE_MTYPE_STATIC(LIB, SEGBUF, "Segment buffer");
+DEFINE_MTYPE_STATIC(LIB, SEGBUF_SLICES, "Segment buffer slices");
+DEFINE_MTYPE_STATIC(LIB, SEGBUF_SEG, "Segment buffer segment");
+DEFINE_MTYPE_STATIC(LIB, SEGBUF_SEGREF, "Segment buffer stream reference");
+DEFINE_MTYPE_STATIC(LIB, SEGBUF_FIFO, "Segment buffer FIFO");
+
+struct segbuf_seg {
+	atomic_uint_fast32_t refcnt;
+
+	/* capacity and filled part of data;  used only grows, and only while
+	 * there is a single reference
+	 */
+	size_t size;
+	size_t used;
+
+	/* adopted stream (data points into it), or NULL for buf */
+	struct stream *stream;
+	uint8_t *data;
+
+	uint8_t buf[];
+};
+
+#define SEGBUF_SEG_ALLOC (sizeof(struct segbuf_seg) + SEGBUF_SEG_SIZE)
+
+void segbuf_init(void)
+{
+	mtype_pool_enable(MTYPE_SEGBUF, sizeof(struct segbuf));
+	mtype_pool_enable(MTYPE_SEGBUF_SEG, SEGBUF_SEG_ALLOC);
+	mtype_pool_enable(MTYPE_SEGBUF_SEGREF, sizeof(struct segbuf_seg));
+}
+
+static struct segbuf_seg *segbuf_seg_new(size_t size)
+{
+	struct segbuf_seg *seg;
+
+	size = MAX(size, (size_t)SEGBUF_SEG_SIZE);
+	seg = XMALLOC(MTYPE_SEGBUF_SEG, sizeof(*seg) + size);
+	atomic_store_explicit(&seg->refcnt, 1, memory_order_relaxed);
+	seg->size = size;
+	seg->used = 0;
+	seg->stream = NULL;
+	seg->data = seg->buf;
+	return seg;
+}
+
+static struct segbuf_seg *segbuf_seg_stream(struct stream *s)
+{
+	struct segbuf_seg *seg;
+
+	seg = XMALLOC(MTYPE_SEGBUF_SEGREF, sizeof(*seg));
+	atomic_store_explicit(&seg->refcnt, 1, memory_order_relaxed);
+	seg->size = seg->used = stream_get_endp(s);
+	seg->stream = s;
+	seg->data = STREAM_DATA(s);
+	return seg;
+}
+
+static inline struct segbuf_seg *segbuf_seg_ref(struct segbuf_seg *seg)
+{
+	atomic_fetch_add_explicit(&seg->refcnt, 1, memory_order_relaxed);
+	return seg;
+}
+
+static void segbuf_seg_unref(struct segbuf_seg *seg)
+{
+	/* acq_rel so whoever frees the segment sees all prior use of it */
+	if (atomic_fetch_sub_explicit(&seg->refcnt, 1, memory_order_acq_rel)
+	    != 1)
+		return;
+
+	if (seg->stream) {
+		stream_free(seg->stream);
+		XFREE(MTYPE_SEGBUF_SEGREF, seg);
+	} else
+		XFREE(MTYPE_SEGBUF_SEG, seg);
+}
+
+struct segbuf *segbuf_new(void)
+{
+	struct segbuf *sb;
+
+	sb = XCALLOC(MTYPE_SEGBUF, sizeof(*sb));
+	sb->slices = sb->inline_slices;
+	sb->slices_alloc = array_size(sb->inline_slices);
+	return sb;
+}
+
+void segbuf_free(struct segbuf *sb)
+{
+	if (!sb)
+		return;
+
+	for (unsigned int i = 0; i < sb->nslices; i++)
+		segbuf_seg_unref(sb->slices[i].seg);
+	if (sb->slices != sb->inline_slices)
+		XFREE(MTYPE_SEGBUF_SLICES, sb->slices);
+	XFREE(MTYPE_SEGBUF, sb);
+}
+
+/* takes over the caller's reference on seg */
+static void segbuf_add_slice(struct segbuf *sb, struct segbuf_seg *seg,
+			     size_t off, size_t len)
+{
+	struct segbuf_slice *slice;
+
+	if (sb->nslices == sb->slices_alloc) {
+		unsigned int alloc = sb->slices_alloc * 2;
+
+		if (sb->slices == sb->inline_slices) {
+			sb->slices = XMALLOC(MTYPE_SEGBUF_SLICES,
+					     alloc * sizeof(sb->slices[0]));
+			memcpy(sb->slices, sb->inline_slices,
+			       sizeof(sb->inline_slices));
+		} else
+			sb->slices = XREALLOC(MTYPE_SEGBUF_SLICES, sb->slices,
+					      alloc * sizeof(sb->slices[0]));
+		sb->slices_alloc = alloc;
+	}
+
+	slice = &sb->slices[sb->nslices++];
+	slice->seg = seg;
+	slice->off = off;
+	slice->len = len;
+	sb->endp += len;
+}
+
+/* find the slice containing offset *off, and make *off relative to it */
+static unsigned int segbuf_find(const struct segbuf *sb, size_t *off)
+{
+	unsigned int i;
+
+	for (i = 0; i < sb->nslices; i++) {
+		if (*off < sb->slices[i].len)
+			break;
+		*off -= sb->slices[i].len;
+	}
+	return i;
+}
+
+struct segbuf *segbuf_from_stream(struct stream *s)
+{
+	struct segbuf *sb = segbuf_new();
+
+	segbuf_append_stream(sb, s);
+	return sb;
+}
+
+void segbuf_append_stream(struct segbuf *sb, struct stream *s)
+{
+	size_t getp = stream_get_getp(s);
+
+	segbuf_add_slice(sb, segbuf_seg_stream(s), getp,
+			 stream_get_endp(s) - getp);
+}
+
+/* append references to len bytes of src, starting at offset off */
+static void segbuf_append_range(struct segbuf *sb, const struct segbuf *src,
+				size_t off, size_t len)
+{
+	unsigned int i = segbuf_find(src, &off);
+
+	for (; len && i < src->nslices; i++) {
+		const struct segbuf_slice *slice = &src->slices[i];
+		size_t n = MIN(len, slice->len - off);
+
+		segbuf_add_slice(sb, segbuf_seg_ref(slice->seg),
+				 slice->off + off, n);
+		len -= n;
+		off = 0;
+	}
+}
+
+void segbuf_append(struct segbuf *sb, const struct segbuf *src)
+{
+	segbuf_append_range(sb, src, src->getp, SEGBUF_READABLE(src));
+}
+
+struct segbuf *segbuf_clone(const struct segbuf *sb)
+{
+	struct segbuf *clone = segbuf_new();
+
+	segbuf_append(clone, sb);
+	return clone;
+}
+
+struct segbuf *segbuf_slice(const struct segbuf *sb, size_t off, size_t len)
+{
+	struct segbuf *slice = segbuf_new();
+
+	assert(off <= sb->endp && len <= sb->endp - off);
+	segbuf_append_range(slice, sb, off, len);
+	return slice;
+}
+
+void segbuf_put(struct segbuf *sb, const void *data, size_t len)
+{
+	const uint8_t *src = data;
+	struct segbuf_slice *slice;
+	struct segbuf_seg *seg;
+	size_t n;
+
+	if (!len)
+		return;
+
+	/* fill up the last segment if it is ours alone and our slice ends
+	 * where its data ends
+	 */
+	if (sb->nslices) {
+		slice = &sb->slices[sb->nslices - 1];
+		seg = slice->seg;
+
+		if (!seg->stream
+		    && atomic_load_explicit(&seg->refcnt, memory_order_acquire)
+			       == 1
+		    && slice->off + slice->len == seg->used) {
+			n = MIN(len, seg->size - seg->used);
+			memcpy(seg->data + seg->used, src, n);
+			seg->used += n;
+			slice->len += n;
+			sb->endp += n;
+			src += n;
+			len -= n;
+		}
+	}
+
+	if (!len)
+		return;
+
+	seg = segbuf_seg_new(len);
+	memcpy(seg->data, src, len);
+	seg->used = len;
+	segbuf_add_slice(sb, seg, 0, len);
+}
+
+void segbuf_forward_getp(struct segbuf *sb, size_t len)
+{
+	assert(len <= SEGBUF_READABLE(sb));
+	sb->getp += len;
+}
+
+void segbuf_compact(struct segbuf *sb)
+{
+	size_t off = sb->getp;
+	unsigned int i = segbuf_find(sb, &off);
+
+	for (unsigned int j = 0; j < i; j++)
+		segbuf_seg_unref(sb->slices[j].seg);
+
+	sb->nslices -= i;
+	memmove(sb->slices, sb->slices + i, sb->nslices * sizeof(sb->slices[0]));
+
+	if (sb->nslices) {
+		sb->slices[0].off += off;
+		sb->slices[0].len -= off;
+	}
+	sb->endp -= sb->getp;
+	sb->getp = 0;
+}
+
+bool segbuf_get_from(const struct segbuf *sb, size_t off, void *dst,
+		     size_t len)
+{
+	uint8_t *out = dst;
+	unsigned int i;
+
+	if (off > sb->endp || len > sb->endp - off)
+		return false;
+
+	i = segbuf_find(sb, &off);
+	for (; len; i++) {
+		const struct segbuf_slice *slice = &sb->slices[i];
+		size_t n = MIN(len, slice->len - off);
+
+		memcpy(out, slice->seg->data + slice->off + off, n);
+		out += n;
+		len -= n;
+		off = 0;
+	}
+	return true;
+}
+
+uint8_t segbuf_getc_from(const struct segbuf *sb, size_t off)
+{
+	uint8_t c = 0;
+	bool ok;
+
+	ok = segbuf_get_from(sb, off, &c, 1);
+	assert(ok);
+	return c;
+}
+
+unsigned int segbuf_iovec(const struct segbuf *sb, struct iovec *iov,
+			  unsigned int iovcnt)
+{
+	size_t off = sb->getp;
+	unsigned int i = segbuf_find(sb, &off);
+	unsigned int n = 0;
+
+	for (; n < iovcnt && i < sb->nslices; i++) {
+		const struct segbuf_slice *slice = &sb->slices[i];
+
+		iov[n].iov_base = slice->seg->data + slice->off + off;
+		iov[n].iov_len = slice->len - off;
+		off = 0;
+		if (iov[n].iov_len)
+			n++;
+	}
+	return n;
+}
+
+struct stream *segbuf_to_stream(const struct segbuf *sb)
+{
+	size_t len = SEGBUF_READABLE(sb);
+	struct stream *s = stream_new(len ?: 1);
+
+	segbuf_get_from(sb, sb->getp, STREAM_DATA(s), len);
+	stream_set_endp(s, len);
+	return s;
+}
+
+struct segbuf_fifo *segbuf_fifo_new(void)
+{
+	return XCALLOC(MTYPE_SEGBUF_FIFO, sizeof(struct segbuf_fifo));
+}
+
+void segbuf_fifo_free(struct segbuf_fifo *fifo)
+{
+	segbuf_fifo_clean(fifo);
+	XFREE(MTYPE_SEGBUF_FIFO, fifo);
+}
+
+void segbuf_fifo_push(struct segbuf_fifo *fifo, struct segbuf *sb)
+{
+	if (fifo->tail)
+		fifo->tail->next = sb;
+	else
+		fifo->head = sb;
+
+	fifo->tail = sb;
+	sb->next = NULL;
+	atomic_fetch_add_explicit(&fifo->count, 1, memory_order_release);
+}
+
+struct segbuf *segbuf_fifo_pop(struct segbuf_fifo *fifo)
+{
+	struct segbuf *sb = fifo->head;
+
+	if (!sb)
+		return NULL;
+
+	fifo->head = sb->next;
+	if (!fifo->head)
+		fifo->tail = NULL;
+	atomic_fetch_sub_explicit(&fifo->count, 1, memory_order_release);
+
+	sb->next = NULL;
+	return sb;
+}
+
+void segbuf_fifo_clean(struct segbuf_fifo *fifo)
+{
+	struct segbuf *sb, *next;
+
+	for (sb = fifo->head; sb; sb = next) {
+		next = sb->next;
+		segbuf_free(sb);
+	}
+	fifo->head = fifo->tail = NULL;
+	atomic_store_explicit(&fifo->count, 0, memory_order_release);
+}
@@ -0,0 +1,161 @@
+/*
+ * Refcounted segment buffers
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_SEGBUF_H
+#define _FRR_SEGBUF_H
+
+#include <sys/uio.h>
+
+#include "frratomic.h"
+#include "stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A segbuf is a byte string made up of slices of refcounted, immutable
+ * segments.  Cloning or slicing a segbuf only takes references on the
+ * segments, so the same message can sit on any number of output queues (and
+ * be handed between pthreads) without being copied.  A struct stream can be
+ * adopted as a segment as-is with segbuf_from_stream().
+ *
+ * Segment data must not be modified once it is part of a segbuf.  The only
+ * exception is appending with segbuf_put(), which fills up unused space at
+ * the end of the last segment if nobody else holds a reference to it.
+ *
+ * Like a stream, a segbuf has a read position (getp) that is advanced as the
+ * data is consumed, e.g. after a partial write().  Data before getp is kept
+ * until segbuf_compact() is called, so offsets passed to segbuf_get_from()
+ * and friends stay stable.
+ *
+ * A segbuf itself is not locked;  users sharing one between pthreads must
+ * provide their own synchronization.  Segment refcounts are atomic, so
+ * different segbufs referencing the same segments can be used concurrently.
+ */
+
+/* data capacity of a freshly allocated segment (allocation is one page) */
+#define SEGBUF_SEG_SIZE	(4096 - 48)
+/* number of slices a segbuf holds without allocating an extra array */
+#define SEGBUF_INLINE_SLICES 2
+
+struct segbuf_seg;
+
+struct segbuf_slice {
+	struct segbuf_seg *seg;
+	size_t off;
+	size_t len;
+};
+
+struct segbuf {
+	struct segbuf *next;
+
+	/*
+	 * Remainder is ***private*** to segbuf
+	 * Use the appropriate functions/macros
+	 */
+	size_t getp;
+	size_t endp;
+
+	unsigned int nslices;
+	unsigned int slices_alloc;
+	struct segbuf_slice *slices;
+	struct segbuf_slice inline_slices[SEGBUF_INLINE_SLICES];
+};
+
+/* First in first out queue of segbufs.  Unlocked;  count may be read with
+ * segbuf_fifo_count() from other pthreads.
+ */
+struct segbuf_fifo {
+	atomic_size_t count;
+
+	struct segbuf *head;
+	struct segbuf *tail;
+};
+
+/* total length, including data before getp */
+#define SEGBUF_LEN(SB) ((SB)->endp)
+/* number of bytes still to be read */
+#define SEGBUF_READABLE(SB) ((SB)->endp - (SB)->getp)
+
+/* Enable freelist recycling of segments; call at daemon startup, before
+ * additional pthreads are started.  Done by frr_preinit().
+ */
+extern void segbuf_init(void);
+
+extern struct segbuf *segbuf_new(void);
+extern void segbuf_free(struct segbuf *sb);
+
+/* Wrap the readable part of a stream without copying it.  The segbuf takes
+ * ownership of the stream;  it is freed with the last reference.
+ */
+extern struct segbuf *segbuf_from_stream(struct stream *s);
+
+/* New segbuf sharing the readable part of sb / len bytes at offset off
+ * (relative to the start of sb, not getp).  No data is copied.
+ */
+extern struct segbuf *segbuf_clone(const struct segbuf *sb);
+extern struct segbuf *segbuf_slice(const struct segbuf *sb, size_t off,
+				   size_t len);
+
+/* Append without copying: the readable part of src / an adopted stream. */
+extern void segbuf_append(struct segbuf *sb, const struct segbuf *src);
+extern void segbuf_append_stream(struct segbuf *sb, struct stream *s);
+
+/* Append by copying data, reusing tail space of an unshared segment. */
+extern void segbuf_put(struct segbuf *sb, const void *data, size_t len);
+
+extern void segbuf_forward_getp(struct segbuf *sb, size_t len);
+/* Drop all data before getp, releasing segments that become unused. */
+extern void segbuf_compact(struct segbuf *sb);
+
+/* Copy out len bytes at offset off.  Returns false if out of range. */
+extern bool segbuf_get_from(const struct segbuf *sb, size_t off, void *dst,
+			    size_t len);
+extern uint8_t segbuf_getc_from(const struct segbuf *sb, size_t off);
+
+/* Fill iov with the readable data, for writev().  Returns the number of
+ * entries used, at most iovcnt;  the data may not fit entirely.
+ */
+extern unsigned int segbuf_iovec(const struct segbuf *sb, struct iovec *iov,
+				 unsigned int iovcnt);
+
+/* Copy the readable data into a new contiguous stream. */
+extern struct stream *segbuf_to_stream(const struct segbuf *sb);
+
+extern struct segbuf_fifo *segbuf_fifo_new(void);
+extern void segbuf_fifo_free(struct segbuf_fifo *fifo);
+extern void segbuf_fifo_push(struct segbuf_fifo *fifo, struct segbuf *sb);
+extern struct segbuf *segbuf_fifo_pop(struct segbuf_fifo *fifo);
+extern void segbuf_fifo_clean(struct segbuf_fifo *fifo);
+
+static inline struct segbuf *segbuf_fifo_head(struct segbuf_fifo *fifo)
+{
+	return fifo->head;
+}
+
+static inline size_t segbuf_fifo_count(struct segbuf_fifo *fifo)
+{
+	return atomic_load_explicit(&fifo->count, memory_order_relaxed);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_SEGBUF_H */
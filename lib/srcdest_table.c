@@ -75,7 +75,7 @@ static void srcdest_rnode_destroy(route_table_delegate_t *delegate,
 	src_table = srn->src_table;
 	srn->src_table = NULL;
 	route_table_finish(src_table);
-	XFREE(MTYPE_ROUTE_NODE, rn);
+	route_node_release(table, MTYPE_ROUTE_NODE, rn);
 }
 
 route_table_delegate_t _srcdest_dstnode_delegate = {
@@ -102,7 +102,7 @@ static void srcdest_srcnode_destroy(route_table_delegate_t *delegate,
 {
 	struct srcdest_rnode *srn;
 
-	XFREE(MTYPE_ROUTE_SRC_NODE, rn);
+	route_node_release(table, MTYPE_ROUTE_SRC_NODE, rn);
 
 	srn = route_table_get_info(table);
 	if (srn->src_table && route_table_count(srn->src_table) == 0) {
@@ -137,11 +137,16 @@ static struct route_node *srcdest_srcnode_get(struct route_node *rn,
 
 	srn = srcdest_rnode_from_rnode(rn);
 	if (!srn->src_table) {
+		struct route_table *src_table;
+
 		/* this won't use srcdest_rnode, we're already on the source
 		 * here */
-		srn->src_table = route_table_init_with_delegate(
+		src_table = route_table_init_with_delegate(
 			&_srcdest_srcnode_delegate);
-		route_table_set_info(srn->src_table, srn);
+		route_table_set_info(src_table, srn);
+		if (rn->table->rcu)
+			route_table_set_rcu(src_table);
+		__atomic_store_n(&srn->src_table, src_table, __ATOMIC_RELEASE);
 
 		/* there is no route_unlock_node on the original rn here.
 		 * The reference is kept for the src_table. */
@@ -187,6 +192,27 @@ static struct route_node *srcdest_srcnode_lookup(
 
 /* ----- exported functions ----- */
 
+struct route_node *srcdest_rnode_lookup_rcu(struct route_table *table,
+					    union prefixconstptr dst_pu,
+					    const struct prefix_ipv6 *src_p)
+{
+	struct route_node *rn;
+	struct route_table *src_table;
+
+	rn = route_node_lookup_maynull_rcu(table, dst_pu);
+	if (!rn)
+		return NULL;
+	if (!src_p || src_p->prefixlen == 0)
+		return __atomic_load_n(&rn->info, __ATOMIC_ACQUIRE) ? rn : NULL;
+
+	src_table = __atomic_load_n(&srcdest_rnode_from_rnode(rn)->src_table,
+				    __ATOMIC_ACQUIRE);
+	if (!src_table)
+		return NULL;
+
+	return route_node_lookup_rcu(src_table, (const struct prefix *)src_p);
+}
+
 struct route_table *srcdest_table_init(void)
 {
 	return route_table_init_with_delegate(&_srcdest_dstnode_delegate);
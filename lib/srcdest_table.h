@@ -65,6 +65,10 @@ extern struct route_node *srcdest_rnode_get(struct route_table *table,
 extern struct route_node *srcdest_rnode_lookup(struct route_table *table,
 					       union prefixconstptr dst_pu,
 					       const struct prefix_ipv6 *src_p);
+/* see route_node_lookup_rcu() */
+extern struct route_node *
+srcdest_rnode_lookup_rcu(struct route_table *table, union prefixconstptr dst_pu,
+			 const struct prefix_ipv6 *src_p);
 extern void srcdest_rnode_prefixes(const struct route_node *rn,
 				   const struct prefix **p,
 				   const struct prefix **src_p);
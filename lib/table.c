@@ -26,11 +26,59 @@
 #include "prefix.h"
 #include "table.h"
 #include "memory.h"
+#include "frrcu.h"
 #include "sockunion.h"
 #include "libfrr_trace.h"
 
 DEFINE_MTYPE_STATIC(LIB, ROUTE_TABLE, "Route table");
 DEFINE_MTYPE(LIB, ROUTE_NODE, "Route node");
+DEFINE_MTYPE_STATIC(LIB, ROUTE_NODE_RCU, "Route node RCU release");
+
+/* Nodes made by route_node_create() are carved out of per-table chunks, so
+ * that the nodes of a table sit next to each other in memory instead of
+ * being spread over the heap.  Chunks start small, for the many tiny
+ * tables, and double up to ROUTE_NODE_CHUNK_MAX nodes.  Each node is
+ * preceded by a pointer to its chunk; freed nodes go on their chunk's free
+ * list, and a chunk is released once none of its nodes are in use (one
+ * empty chunk is kept, so a table that hovers around a chunk boundary
+ * doesn't keep allocating and freeing it.)
+ */
+#define ROUTE_NODE_CHUNK_MIN 8
+#define ROUTE_NODE_CHUNK_MAX 256
+
+struct route_node_slot {
+	struct route_node_chunk *chunk;
+	struct route_node node;
+};
+
+struct route_node_chunk {
+	struct rn_node_chunks_item item;
+	struct route_node *free_list; /* linked through link[0] */
+	unsigned int used; /* slots carved out so far */
+	unsigned int live; /* nodes currently in use */
+	unsigned int size;
+	struct route_node_slot slots[];
+};
+
+DECLARE_DLIST(rn_node_chunks, struct route_node_chunk, item);
+
+/* Nodes of RCU tables can't be reused or freed while readers may still be
+ * on them; since delegates embed route_node in their own structs, the
+ * deferred free is carried by a separate small record instead of an
+ * rcu_head in every node.
+ */
+struct route_node_rcu {
+	struct rcu_head rcu_head;
+	struct memtype *mt;
+	void *node;
+};
+
+/* node->link and table->top are plain pointers (outside code reads them
+ * directly), so the RCU readers and the writer use the compiler builtins
+ * on them rather than C11 _Atomic.
+ */
+#define rn_load(ptr) __atomic_load_n(&(ptr), __ATOMIC_ACQUIRE)
+#define rn_publish(ptr, val) __atomic_store_n(&(ptr), (val), __ATOMIC_RELEASE)
 
 static void route_table_free(struct route_table *);
 
@@ -53,6 +101,7 @@ route_table_init_with_delegate(route_table_delegate_t *delegate)
 	rt = XCALLOC(MTYPE_ROUTE_TABLE, sizeof(struct route_table));
 	rt->delegate = delegate;
 	rn_hash_node_init(&rt->hash);
+	rn_node_chunks_init(&rt->node_chunks);
 	return rt;
 }
 
@@ -96,6 +145,7 @@ static void route_table_free(struct route_table *rt)
 {
 	struct route_node *tmp_node;
 	struct route_node *node;
+	struct route_node_chunk *chunk;
 
 	if (rt == NULL)
 		return;
@@ -137,8 +187,18 @@ static void route_table_free(struct route_table *rt)
 
 	assert(rt->count == 0);
 
+	/* all nodes are gone, so every chunk left is empty and on the list */
+	while ((chunk = rn_node_chunks_pop(&rt->node_chunks))) {
+		assert(chunk->live == 0);
+		XFREE(MTYPE_ROUTE_NODE, chunk);
+	}
+	rn_node_chunks_fini(&rt->node_chunks);
+
 	rn_hash_node_fini(&rt->hash);
-	XFREE(MTYPE_ROUTE_TABLE, rt);
+	if (rt->rcu)
+		rcu_free(MTYPE_ROUTE_TABLE, rt, rcu_head);
+	else
+		XFREE(MTYPE_ROUTE_TABLE, rt);
 	return;
 }
 
@@ -184,12 +244,44 @@ static void route_common(const struct prefix *n, const struct prefix *p,
 	}
 }
 
+/* prefix_match() for the tree walks; compares whole words for IPv4 and
+ * IPv6 instead of going byte by byte.
+ */
+static inline bool route_prefix_match(const struct prefix *n,
+				      const struct prefix *p)
+{
+	const uint32_t *nw, *pw;
+	unsigned int len, i;
+
+	if (n->prefixlen > p->prefixlen)
+		return false;
+
+	switch (n->family) {
+	case AF_INET:
+		if (!n->prefixlen)
+			return true;
+		return !((n->u.prefix4.s_addr ^ p->u.prefix4.s_addr)
+			 & htonl(0xffffffffU << (32 - n->prefixlen)));
+	case AF_INET6:
+		nw = (const uint32_t *)&n->u.prefix6;
+		pw = (const uint32_t *)&p->u.prefix6;
+		for (i = 0, len = n->prefixlen; len >= 32; i++, len -= 32)
+			if (nw[i] != pw[i])
+				return false;
+		if (!len)
+			return true;
+		return !((nw[i] ^ pw[i]) & htonl(0xffffffffU << (32 - len)));
+	default:
+		return prefix_match(n, p);
+	}
+}
+
 static void set_link(struct route_node *node, struct route_node *new)
 {
 	unsigned int bit = prefix_bit(&new->p.u.prefix, node->p.prefixlen);
 
-	node->link[bit] = new;
 	new->parent = node;
+	rn_publish(node->link[bit], new);
 }
 
 /* Find matched prefix. */
@@ -205,8 +297,7 @@ struct route_node *route_node_match(struct route_table *table,
 
 	/* Walk down tree.  If there is matched route then store it to
 	   matched. */
-	while (node && node->p.prefixlen <= p->prefixlen
-	       && prefix_match(&node->p, p)) {
+	while (node && route_prefix_match(&node->p, p)) {
 		if (node->info)
 			matched = node;
 
@@ -301,8 +392,7 @@ struct route_node *route_node_get(struct route_table *table,
 
 	match = NULL;
 	node = table->top;
-	while (node && node->p.prefixlen <= prefixlen
-	       && prefix_match(&node->p, p)) {
+	while (node && route_prefix_match(&node->p, p)) {
 		if (node->p.prefixlen == prefixlen)
 			return route_lock_node(node);
 
@@ -315,19 +405,24 @@ struct route_node *route_node_get(struct route_table *table,
 		if (match)
 			set_link(match, new);
 		else
-			table->top = new;
+			rn_publish(table->top, new);
 	} else {
+		/* the new interior node has to be complete before it replaces
+		 * node in the tree, for RCU readers
+		 */
 		new = route_node_new(table);
 		route_common(&node->p, p, &new->p);
 		new->p.family = p->family;
 		new->table = table;
-		set_link(new, node);
+		new->link[prefix_bit(&node->p.u.prefix, new->p.prefixlen)] =
+			node;
 		rn_hash_node_add(&table->hash, new);
 
 		if (match)
 			set_link(match, new);
 		else
-			table->top = new;
+			rn_publish(table->top, new);
+		rn_publish(node->parent, new);
 
 		if (new->p.prefixlen != p->prefixlen) {
 			match = new;
@@ -362,15 +457,15 @@ void route_node_delete(struct route_node *node)
 	parent = node->parent;
 
 	if (child)
-		child->parent = parent;
+		rn_publish(child->parent, parent);
 
 	if (parent) {
 		if (parent->l_left == node)
-			parent->l_left = child;
+			rn_publish(parent->l_left, child);
 		else
-			parent->l_right = child;
+			rn_publish(parent->l_right, child);
 	} else
-		node->table->top = child;
+		rn_publish(node->table->top, child);
 
 	node->table->count--;
 
@@ -492,8 +587,45 @@ unsigned long route_table_count(struct route_table *table)
 struct route_node *route_node_create(route_table_delegate_t *delegate,
 				     struct route_table *table)
 {
+	struct route_node_chunk *chunk;
+	struct route_node_slot *slot;
 	struct route_node *node;
-	node = XCALLOC(MTYPE_ROUTE_NODE, sizeof(struct route_node));
+	unsigned int size;
+
+	/* RCU tables can't recycle nodes before readers are done with them */
+	if (table->rcu)
+		return XCALLOC(MTYPE_ROUTE_NODE, sizeof(struct route_node));
+
+	chunk = rn_node_chunks_first(&table->node_chunks);
+	if (!chunk) {
+		size = table->node_chunk_size
+			       ? MIN(table->node_chunk_size * 2,
+				     ROUTE_NODE_CHUNK_MAX)
+			       : ROUTE_NODE_CHUNK_MIN;
+		table->node_chunk_size = size;
+
+		chunk = XMALLOC(MTYPE_ROUTE_NODE,
+				sizeof(*chunk) + size * sizeof(chunk->slots[0]));
+		chunk->free_list = NULL;
+		chunk->used = 0;
+		chunk->live = 0;
+		chunk->size = size;
+		rn_node_chunks_add_head(&table->node_chunks, chunk);
+	}
+
+	if (chunk->free_list) {
+		node = chunk->free_list;
+		chunk->free_list = node->link[0];
+	} else {
+		slot = &chunk->slots[chunk->used++];
+		slot->chunk = chunk;
+		node = &slot->node;
+	}
+
+	if (++chunk->live == chunk->size)
+		rn_node_chunks_del(&table->node_chunks, chunk);
+
+	memset(node, 0, sizeof(*node));
 	return node;
 }
 
@@ -505,7 +637,52 @@ struct route_node *route_node_create(route_table_delegate_t *delegate,
 void route_node_destroy(route_table_delegate_t *delegate,
 			struct route_table *table, struct route_node *node)
 {
-	XFREE(MTYPE_ROUTE_NODE, node);
+	struct route_node_chunk *chunk;
+
+	if (table->rcu) {
+		route_node_release(table, MTYPE_ROUTE_NODE, node);
+		return;
+	}
+
+	chunk = container_of(node, struct route_node_slot, node)->chunk;
+
+	assert(chunk->live);
+	if (chunk->live-- == chunk->size)
+		rn_node_chunks_add_head(&table->node_chunks, chunk);
+	node->link[0] = chunk->free_list;
+	chunk->free_list = node;
+
+	if (chunk->live == 0 && rn_node_chunks_count(&table->node_chunks) > 1) {
+		rn_node_chunks_del(&table->node_chunks, chunk);
+		XFREE(MTYPE_ROUTE_NODE, chunk);
+	}
+}
+
+static void route_node_rcu_free(struct route_node_rcu *rnr)
+{
+	qfree(rnr->mt, rnr->node);
+	XFREE(MTYPE_ROUTE_NODE_RCU, rnr);
+}
+
+/**
+ * route_node_release
+ *
+ * Free the memory of a node that has been taken out of its table.
+ */
+void route_node_release(struct route_table *table, struct memtype *mt,
+			struct route_node *node)
+{
+	struct route_node_rcu *rnr;
+
+	if (!table->rcu) {
+		qfree(mt, node);
+		return;
+	}
+
+	rnr = XMALLOC(MTYPE_ROUTE_NODE_RCU, sizeof(*rnr));
+	rnr->mt = mt;
+	rnr->node = node;
+	rcu_call(route_node_rcu_free, rnr, rcu_head);
 }
 
 /*
@@ -528,6 +705,101 @@ struct route_table *route_table_init(void)
 	return route_table_init_with_delegate(&default_delegate);
 }
 
+void route_table_set_rcu(struct route_table *table)
+{
+	assert(!table->top && !rn_node_chunks_count(&table->node_chunks));
+	table->rcu = true;
+}
+
+/* RCU counterparts of the lookups above; same walks, but no node locking
+ * and every link is loaded once, with acquire semantics.
+ */
+struct route_node *route_node_match_rcu(struct route_table *table,
+					union prefixconstptr pu)
+{
+	const struct prefix *p = pu.p;
+	struct route_node *node, *matched = NULL;
+
+	rcu_assert_read_locked();
+
+	node = rn_load(table->top);
+	while (node && route_prefix_match(&node->p, p)) {
+		if (rn_load(node->info))
+			matched = node;
+
+		if (node->p.prefixlen == p->prefixlen)
+			break;
+
+		node = rn_load(
+			node->link[prefix_bit(&p->u.prefix, node->p.prefixlen)]);
+	}
+	return matched;
+}
+
+/* The exact-match hash isn't safe for concurrent readers, so this walks
+ * the tree instead.
+ */
+struct route_node *route_node_lookup_maynull_rcu(struct route_table *table,
+						 union prefixconstptr pu)
+{
+	struct prefix p;
+	struct route_node *node;
+
+	rcu_assert_read_locked();
+
+	prefix_copy(&p, pu.p);
+	apply_mask(&p);
+
+	node = rn_load(table->top);
+	while (node && route_prefix_match(&node->p, &p)) {
+		if (node->p.prefixlen == p.prefixlen)
+			return node;
+
+		node = rn_load(
+			node->link[prefix_bit(&p.u.prefix, node->p.prefixlen)]);
+	}
+	return NULL;
+}
+
+struct route_node *route_node_lookup_rcu(struct route_table *table,
+					 union prefixconstptr pu)
+{
+	struct route_node *node = route_node_lookup_maynull_rcu(table, pu);
+
+	return (node && rn_load(node->info)) ? node : NULL;
+}
+
+struct route_node *route_top_rcu(struct route_table *table)
+{
+	rcu_assert_read_locked();
+
+	return rn_load(table->top);
+}
+
+struct route_node *route_next_rcu(struct route_node *node)
+{
+	struct route_node *next, *parent;
+
+	rcu_assert_read_locked();
+
+	next = rn_load(node->l_left);
+	if (next)
+		return next;
+	next = rn_load(node->l_right);
+	if (next)
+		return next;
+
+	for (parent = rn_load(node->parent); parent;
+	     node = parent, parent = rn_load(node->parent)) {
+		if (rn_load(parent->l_left) != node)
+			continue;
+		next = rn_load(parent->l_right);
+		if (next)
+			return next;
+	}
+	return NULL;
+}
+
 /**
  * route_table_prefix_iter_cmp
  *
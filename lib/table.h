@@ -23,6 +23,7 @@
 #define _ZEBRA_TABLE_H
 
 #include "memory.h"
+#include "frrcu.h"
 #include "hash.h"
 #include "prefix.h"
 #include "typesafe.h"
@@ -60,12 +61,17 @@ struct route_table_delegate_t_ {
 };
 
 PREDECL_HASH(rn_hash_node);
+PREDECL_DLIST(rn_node_chunks);
 
 /* Routing table top structure. */
 struct route_table {
 	struct route_node *top;
 	struct rn_hash_node_head hash;
 
+	/* node storage for route_node_create(): chunks with free nodes */
+	struct rn_node_chunks_head node_chunks;
+	unsigned int node_chunk_size;
+
 	/*
 	 * Delegate that performs certain functions for this table.
 	 */
@@ -74,6 +80,10 @@ struct route_table {
 
 	unsigned long count;
 
+	/* readers may use the _rcu lookups, see route_table_set_rcu() */
+	bool rcu;
+	struct rcu_head rcu_head;
+
 	/*
 	 * User data.
 	 */
@@ -118,22 +128,28 @@ struct route_table {
 
 /*
  * Macro that defines all fields in a route node.
+ *
+ * The prefix must stay first (the node hash uses prefix_hash_key() on the
+ * node directly); the links follow so that a tree descent finds both in
+ * the same cache line.
  */
 #define ROUTE_NODE_FIELDS                                                      \
 	/* Actual prefix of this radix. */                                     \
 	struct prefix p;                                                       \
                                                                                \
 	/* Tree link. */                                                       \
+	struct route_node *table_rdonly(link[2]);                              \
+                                                                               \
+	/* Each node of route. */                                              \
+	void *info;                                                            \
+                                                                               \
 	struct route_table *table_rdonly(table);                               \
 	struct route_node *table_rdonly(parent);                               \
-	struct route_node *table_rdonly(link[2]);                              \
                                                                                \
 	/* Lock of this radix */                                               \
 	unsigned int table_rdonly(lock);                                       \
                                                                                \
 	struct rn_hash_node_item nodehash;                                     \
-	/* Each node of route. */                                              \
-	void *info;                                                            \
 
 
 /* Each routing entry. */
@@ -198,6 +214,33 @@ static inline void route_table_set_info(struct route_table *table, void *d)
 }
 
 extern void route_table_finish(struct route_table *table);
+
+/*
+ * Let other pthreads read the table under rcu_read_lock() through the
+ * route_node_*_rcu() functions below, without going through the owning
+ * thread.  Must be called on an empty table.
+ *
+ * The table itself is still only modified by its owning thread.  Removed
+ * nodes (and the table itself, in route_table_finish()) are freed through
+ * RCU; node->info is not, whatever it points to must be released through
+ * RCU by the user if readers dereference it.
+ */
+extern void route_table_set_rcu(struct route_table *table);
+
+/*
+ * Lookups for RCU readers.  The caller must hold rcu_read_lock(); the
+ * returned node is NOT locked and is only valid until rcu_read_unlock().
+ * Nodes added or removed concurrently may or may not be seen.
+ */
+extern struct route_node *route_node_match_rcu(struct route_table *table,
+					       union prefixconstptr pu);
+extern struct route_node *route_node_lookup_rcu(struct route_table *table,
+						union prefixconstptr pu);
+extern struct route_node *
+route_node_lookup_maynull_rcu(struct route_table *table,
+			      union prefixconstptr pu);
+extern struct route_node *route_top_rcu(struct route_table *table);
+extern struct route_node *route_next_rcu(struct route_node *node);
 extern struct route_node *route_top(struct route_table *table);
 extern struct route_node *route_next(struct route_node *node);
 extern struct route_node *route_next_until(struct route_node *node,
@@ -223,6 +266,9 @@ extern void route_node_delete(struct route_node *node);
 extern void route_node_destroy(route_table_delegate_t *delegate,
 			       struct route_table *table,
 			       struct route_node *node);
+/* for delegates' destroy_node: XFREE(), deferred through RCU if needed */
+extern void route_node_release(struct route_table *table, struct memtype *mt,
+			       struct route_node *node);
 
 extern struct route_node *route_table_get_next(struct route_table *table,
 					       union prefixconstptr pu);
@@ -69,6 +69,22 @@ static int thread_timer_cmp(const struct thread *a, const struct thread *b)
 }
 
 DECLARE_HEAP(thread_timer_list, struct thread, timeritem, thread_timer_cmp);
+DECLARE_DLIST(thread_timer_wheel, struct thread, wheelitem);
+
+/* Timer wheel geometry: level 0 has 64ms slots, each level above covers
+ * THREAD_WHEEL_SLOTS slots of the one below, about 12 days in total.
+ */
+#define WHEEL_TICK_SHIFT 6
+#define WHEEL_SLOT_BITS 6
+#define WHEEL_SLOT_MASK (THREAD_WHEEL_SLOTS - 1)
+/* timers closer than this go straight to the heap */
+#define WHEEL_NEAR_MSEC 1000
+
+static inline int64_t timer_tick(const struct timeval *tv)
+{
+	return ((int64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000)
+	       >> WHEEL_TICK_SHIFT;
+}
 
 #if defined(__APPLE__)
 #include <mach/mach.h>
@@ -523,6 +539,7 @@ struct thread_master *thread_master_create(const char *name)
 {
 	struct thread_master *rv;
 	struct rlimit limit;
+	struct timeval tv;
 
 	pthread_once(&init_once, &initializer);
 
@@ -563,6 +580,13 @@ struct thread_master *thread_master_create(const char *name)
 	thread_list_init(&rv->ready);
 	thread_list_init(&rv->unuse);
 	thread_timer_list_init(&rv->timer);
+	for (int level = 0; level < THREAD_WHEEL_LEVELS; level++)
+		for (int slot = 0; slot < THREAD_WHEEL_SLOTS; slot++)
+			thread_timer_wheel_init(&rv->wheel.slots[level][slot]);
+	rv->wheel.enabled = true;
+	monotime(&tv);
+	rv->wheel.tick = timer_tick(&tv);
+	rv->wheel.wake = INT64_MAX;
 
 	/* Initialize thread_fetch() settings */
 	rv->spin = true;
@@ -606,6 +630,15 @@ void thread_master_set_name(struct thread_master *master, const char *name)
 	}
 }
 
+void thread_master_set_timer_wheel(struct thread_master *master, bool enable)
+{
+	frr_with_mutex(&master->mtx) {
+		assert(!master->wheel.count
+		       && !thread_timer_list_count(&master->timer));
+		master->wheel.enabled = enable;
+	}
+}
+
 #define THREAD_UNUSED_DEPTH 10
 
 /* Move thread to unuse list. */
@@ -689,6 +722,11 @@ void thread_master_free(struct thread_master *m)
 	thread_array_free(m, m->write);
 	while ((t = thread_timer_list_pop(&m->timer)))
 		thread_free(m, t);
+	for (int level = 0; level < THREAD_WHEEL_LEVELS; level++)
+		for (int slot = 0; slot < THREAD_WHEEL_SLOTS; slot++)
+			while ((t = thread_timer_wheel_pop(
+					&m->wheel.slots[level][slot])))
+				thread_free(m, t);
 	thread_list_free(m, &m->event);
 	thread_list_free(m, &m->ready);
 	thread_list_free(m, &m->unuse);
@@ -1002,14 +1040,170 @@ void _thread_add_read_write(const struct xref_threadsched *xref,
 	}
 }
 
+/*
+ * Timer wheel.  A timer expiring at tick e sits on level 0 if it is due
+ * within THREAD_WHEEL_SLOTS ticks, otherwise on the lowest level whose slots
+ * reach that far.  When the wheel gets to a level 0 slot, its timers move to
+ * the heap, so they still run at their exact deadline and in order with
+ * everything else; higher level slots are re-filed ("cascaded") into the
+ * levels below when the wheel reaches them.  Timers that are cancelled or
+ * re-armed before they get close to expiring, like most keepalive and hold
+ * timers, never touch the heap.
+ *
+ * Returns the tick at which the slot the timer was put in is processed.
+ */
+static int64_t thread_wheel_add(struct thread_master *m, struct thread *thread)
+{
+	int64_t expire = timer_tick(&thread->u.sands);
+	int64_t delta = expire - m->wheel.tick;
+	unsigned int level = 0, shift = 0, slot;
+
+	while (level < THREAD_WHEEL_LEVELS - 1
+	       && delta >= ((int64_t)1 << (shift + WHEEL_SLOT_BITS))) {
+		level++;
+		shift += WHEEL_SLOT_BITS;
+	}
+	/* beyond the top level; park in its furthest slot, and file it again
+	 * from there */
+	if (delta >= ((int64_t)1 << (shift + WHEEL_SLOT_BITS)))
+		expire = m->wheel.tick
+			 + ((int64_t)1 << (shift + WHEEL_SLOT_BITS)) - 1;
+
+	slot = (expire >> shift) & WHEEL_SLOT_MASK;
+	thread_timer_wheel_add_tail(&m->wheel.slots[level][slot], thread);
+	m->wheel.used[level] |= 1ULL << slot;
+	m->wheel.count++;
+	thread->wheel_slot = 1 + level * THREAD_WHEEL_SLOTS + slot;
+
+	return (expire >> shift) << shift;
+}
+
+static struct thread *thread_wheel_pop(struct thread_master *m,
+				       unsigned int level, unsigned int slot)
+{
+	struct thread_timer_wheel_head *head = &m->wheel.slots[level][slot];
+	struct thread *thread;
+
+	thread = thread_timer_wheel_pop(head);
+	if (!thread)
+		return NULL;
+
+	if (!thread_timer_wheel_count(head))
+		m->wheel.used[level] &= ~(1ULL << slot);
+	m->wheel.count--;
+	thread->wheel_slot = 0;
+	return thread;
+}
+
+static void thread_timer_del(struct thread_master *m, struct thread *thread)
+{
+	struct thread_timer_wheel_head *head;
+	unsigned int level, slot;
+
+	if (!thread->wheel_slot) {
+		thread_timer_list_del(&m->timer, thread);
+		return;
+	}
+
+	level = (thread->wheel_slot - 1) / THREAD_WHEEL_SLOTS;
+	slot = (thread->wheel_slot - 1) % THREAD_WHEEL_SLOTS;
+	head = &m->wheel.slots[level][slot];
+
+	thread_timer_wheel_del(head, thread);
+	if (!thread_timer_wheel_count(head))
+		m->wheel.used[level] &= ~(1ULL << slot);
+	m->wheel.count--;
+	thread->wheel_slot = 0;
+}
+
+/* Next tick after wheel.tick at which some slot needs processing. */
+static int64_t thread_wheel_next(struct thread_master *m)
+{
+	int64_t next = INT64_MAX, base, t;
+	unsigned int level, shift, rot;
+	uint64_t used;
+
+	for (level = 0; level < THREAD_WHEEL_LEVELS; level++) {
+		used = m->wheel.used[level];
+		if (!used)
+			continue;
+
+		/* slot "base" has been processed already; rotate so that
+		 * bit 0 is the slot after it */
+		shift = level * WHEEL_SLOT_BITS;
+		base = m->wheel.tick >> shift;
+		rot = (base + 1) & WHEEL_SLOT_MASK;
+		if (rot)
+			used = (used >> rot) | (used << (64 - rot));
+
+		t = (base + 1 + __builtin_ctzll(used)) << shift;
+		if (t < next)
+			next = t;
+	}
+	return next;
+}
+
+/* File a timer on the wheel or heap, relative to wheel.tick. */
+static void thread_timer_file(struct thread_master *m, struct thread *thread)
+{
+	if (timer_tick(&thread->u.sands) > m->wheel.tick)
+		thread_wheel_add(m, thread);
+	else
+		thread_timer_list_add(&m->timer, thread);
+}
+
+static void thread_wheel_run_tick(struct thread_master *m, int64_t tick)
+{
+	struct thread *thread;
+	unsigned int level, shift, slot;
+
+	/* cascade from the top, the lower levels may get timers for this
+	 * very tick */
+	for (level = THREAD_WHEEL_LEVELS - 1; level > 0; level--) {
+		shift = level * WHEEL_SLOT_BITS;
+		if (tick & (((int64_t)1 << shift) - 1))
+			continue;
+
+		slot = (tick >> shift) & WHEEL_SLOT_MASK;
+		while ((thread = thread_wheel_pop(m, level, slot)))
+			thread_timer_file(m, thread);
+	}
+
+	slot = tick & WHEEL_SLOT_MASK;
+	while ((thread = thread_wheel_pop(m, 0, slot)))
+		thread_timer_list_add(&m->timer, thread);
+}
+
+/* Move the wheel forward to now, moving due timers to the heap. */
+static void thread_wheel_advance(struct thread_master *m,
+				 const struct timeval *now)
+{
+	int64_t now_tick = timer_tick(now), next;
+
+	while (m->wheel.tick < now_tick) {
+		next = m->wheel.count ? thread_wheel_next(m) : INT64_MAX;
+		if (next > now_tick) {
+			m->wheel.tick = now_tick;
+			break;
+		}
+		m->wheel.tick = next;
+		thread_wheel_run_tick(m, next);
+	}
+}
+
 static void _thread_add_timer_timeval(const struct xref_threadsched *xref,
 				      struct thread_master *m,
 				      int (*func)(struct thread *), void *arg,
 				      struct timeval *time_relative,
 				      struct thread **t_ptr)
 {
+	static const struct timeval wheel_near = {
+		.tv_sec = WHEEL_NEAR_MSEC / 1000,
+		.tv_usec = (WHEEL_NEAR_MSEC % 1000) * 1000,
+	};
 	struct thread *thread;
 	struct timeval t;
+	int64_t wake = INT64_MAX;
 
 	assert(m != NULL);
 
@@ -1032,7 +1226,12 @@ static void _thread_add_timer_timeval(const struct xref_threadsched *xref,
 
 		frr_with_mutex(&thread->mtx) {
 			thread->u.sands = t;
-			thread_timer_list_add(&m->timer, thread);
+			if (m->wheel.enabled
+			    && timercmp(time_relative, &wheel_near, >=)
+			    && timer_tick(&t) > m->wheel.tick)
+				wake = thread_wheel_add(m, thread);
+			else
+				thread_timer_list_add(&m->timer, thread);
 			if (t_ptr) {
 				*t_ptr = thread;
 				thread->ref = t_ptr;
@@ -1043,7 +1242,9 @@ static void _thread_add_timer_timeval(const struct xref_threadsched *xref,
 		 * might change the time we'll wait for, give the pthread
 		 * a chance to re-compute.
 		 */
-		if (thread_timer_list_first(&m->timer) == thread)
+		if (thread->wheel_slot ? wake < m->wheel.wake
+				       : thread_timer_list_first(&m->timer)
+						 == thread)
 			AWAKEN(m);
 	}
 }
@@ -1286,6 +1487,25 @@ static void cancel_arg_helper(struct thread_master *master,
 
 		t = t_next;
 	}
+
+	for (int level = 0; level < THREAD_WHEEL_LEVELS; level++) {
+		uint64_t used = master->wheel.used[level];
+
+		while (used) {
+			int slot = __builtin_ctzll(used);
+
+			used &= used - 1;
+			frr_each_safe (thread_timer_wheel,
+				       &master->wheel.slots[level][slot], t) {
+				if (t->arg != cr->eventobj)
+					continue;
+				thread_timer_del(master, t);
+				if (t->ref)
+					*t->ref = NULL;
+				thread_add_unuse(master, t);
+			}
+		}
+	}
 }
 
 /**
@@ -1337,7 +1557,7 @@ static void do_thread_cancel(struct thread_master *master)
 			thread_array = master->write;
 			break;
 		case THREAD_TIMER:
-			thread_timer_list_del(&master->timer, thread);
+			thread_timer_del(master, thread);
 			break;
 		case THREAD_EVENT:
 			list = &master->event;
@@ -1523,13 +1743,30 @@ void thread_cancel_async(struct thread_master *master, struct thread **thread,
 }
 /* ------------------------------------------------------------------------- */
 
-static struct timeval *thread_timer_wait(struct thread_timer_list_head *timers,
+static struct timeval *thread_timer_wait(struct thread_master *m,
 					 struct timeval *timer_val)
 {
-	if (!thread_timer_list_count(timers))
+	struct thread *next_timer = thread_timer_list_first(&m->timer);
+	struct timeval wake;
+	int64_t msec;
+
+	/* wake up when the wheel has timers to hand over to the heap */
+	m->wheel.wake = INT64_MAX;
+	if (m->wheel.count) {
+		m->wheel.wake = thread_wheel_next(m);
+		msec = m->wheel.wake << WHEEL_TICK_SHIFT;
+		wake.tv_sec = msec / 1000;
+		wake.tv_usec = (msec % 1000) * 1000;
+
+		if (!next_timer || timercmp(&wake, &next_timer->u.sands, <)) {
+			monotime_until(&wake, timer_val);
+			return timer_val;
+		}
+	}
+
+	if (!next_timer)
 		return NULL;
 
-	struct thread *next_timer = thread_timer_list_first(timers);
 	monotime_until(&next_timer->u.sands, timer_val);
 	return timer_val;
 }
@@ -1654,6 +1891,8 @@ static unsigned int thread_process_timers(struct thread_master *m,
 	struct thread *thread;
 	unsigned int ready = 0;
 
+	thread_wheel_advance(m, timenow);
+
 	while ((thread = thread_timer_list_first(&m->timer))) {
 		if (timercmp(timenow, &thread->u.sands, <))
 			break;
@@ -1743,7 +1982,7 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 		 * once per loop to avoid starvation by events
 		 */
 		if (!thread_list_count(&m->ready))
-			tw = thread_timer_wait(&m->timer, &tv);
+			tw = thread_timer_wait(m, &tv);
 
 		if (thread_list_count(&m->ready) ||
 				(tw && !timercmp(tw, &zerotime, >)))
@@ -54,6 +54,14 @@ struct rusage_t {
 
 PREDECL_LIST(thread_list);
 PREDECL_HEAP(thread_timer_list);
+PREDECL_DLIST(thread_timer_wheel);
+
+/* Timers that are at least a second away are kept on a hierarchical timer
+ * wheel with O(1) add/cancel, and only move to the timer heap shortly before
+ * they expire.
+ */
+#define THREAD_WHEEL_LEVELS 4
+#define THREAD_WHEEL_SLOTS 64
 
 struct fd_handler {
 	/* number of pfd that fit in the allocated space of pfds. This is a
@@ -87,6 +95,15 @@ struct thread_master {
 	struct thread **read;
 	struct thread **write;
 	struct thread_timer_list_head timer;
+	struct {
+		bool enabled;
+		int64_t tick; /* last tick processed */
+		int64_t wake; /* tick the pthread will wake up for */
+		size_t count;
+		uint64_t used[THREAD_WHEEL_LEVELS];
+		struct thread_timer_wheel_head slots[THREAD_WHEEL_LEVELS]
+						    [THREAD_WHEEL_SLOTS];
+	} wheel;
 	struct thread_list_head event, ready, unuse;
 	struct list *cancel_req;
 	bool canceled;
@@ -110,8 +127,12 @@ struct thread_master {
 struct thread {
 	uint8_t type;		  /* thread type */
 	uint8_t add_type;	  /* thread type */
+	uint16_t wheel_slot;	  /* 1 + timer wheel slot, 0 if on the heap */
 	struct thread_list_item threaditem;
-	struct thread_timer_list_item timeritem;
+	union {
+		struct thread_timer_list_item timeritem;
+		struct thread_timer_wheel_item wheelitem;
+	};
 	struct thread **ref;	  /* external reference (if given) */
 	struct thread_master *master; /* pointer to the struct thread_master */
 	int (*func)(struct thread *); /* event function */
@@ -216,6 +237,9 @@ struct cpu_thread_history {
 /* Prototypes. */
 extern struct thread_master *thread_master_create(const char *);
 void thread_master_set_name(struct thread_master *master, const char *name);
+/* choose between the timer wheel (default) and a plain heap; only while no
+ * timers are scheduled */
+void thread_master_set_timer_wheel(struct thread_master *master, bool enable);
 extern void thread_master_free(struct thread_master *);
 extern void thread_master_free_unused(struct thread_master *);
 
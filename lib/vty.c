@@ -72,7 +72,8 @@ enum event {
 #ifdef VTYSH
 	VTYSH_SERV,
 	VTYSH_READ,
-	VTYSH_WRITE
+	VTYSH_WRITE,
+	VTYSH_RESUME
 #endif /* VTYSH */
 };
 
@@ -168,6 +169,55 @@ bool vty_set_include(struct vty *vty, const char *regexp)
 	return ret;
 }
 
+static void vty_defer_finish(struct vty *vty)
+{
+	if (!vty->resume)
+		return;
+
+	if (vty->resume_free)
+		vty->resume_free(vty->resume_arg);
+	vty->resume = NULL;
+	vty->resume_free = NULL;
+	vty->resume_arg = NULL;
+}
+
+int vty_defer(struct vty *vty, vty_resume_fn fn, void *arg,
+	      void (*free_fn)(void *arg))
+{
+	int ret;
+
+#ifdef VTYSH
+	/* "| include" filtering is torn down when the command handler
+	 * returns, so filtered output is produced in one go.
+	 */
+	if (vty->type == VTY_SHELL_SERV && !vty->resume && !vty->filter) {
+		vty->resume = fn;
+		vty->resume_free = free_fn;
+		vty->resume_arg = arg;
+		vty_event(VTYSH_RESUME, vty);
+		return CMD_SUSPEND;
+	}
+#endif /* VTYSH */
+
+	do
+		ret = fn(vty, arg);
+	while (ret == CMD_SUSPEND);
+
+	if (free_fn)
+		free_fn(arg);
+	return ret;
+}
+
+bool vty_defer_yield(struct vty *vty)
+{
+	/* only deferred commands running off the event loop yield */
+	if (!vty->resume)
+		return false;
+
+	return monotime_since(&vty->resume_start, NULL)
+	       > THREAD_YIELD_TIME_SLOT;
+}
+
 /* VTY standard output function. */
 int vty_out(struct vty *vty, const char *format, ...)
 {
@@ -2103,7 +2153,8 @@ static int vtysh_read(struct thread *thread)
 
 	if (vty->status == VTY_CLOSE)
 		vty_close(vty);
-	else
+	else if (!vty->resume)
+		/* a deferred command re-arms this when it is done */
 		vty_event(VTYSH_READ, vty);
 
 	return 0;
@@ -2113,7 +2164,44 @@ static int vtysh_write(struct thread *thread)
 {
 	struct vty *vty = THREAD_ARG(thread);
 
-	vtysh_flush(vty);
+	if (vtysh_flush(vty) < 0)
+		return 0;
+
+	/* client caught up with a deferred command's output */
+	if (vty->resume && !vty->t_write)
+		vty_event(VTYSH_RESUME, vty);
+	return 0;
+}
+
+static int vtysh_resume(struct thread *thread)
+{
+	struct vty *vty = THREAD_ARG(thread);
+	uint8_t header[4] = {0, 0, 0, 0};
+	int ret;
+
+	monotime(&vty->resume_start);
+	ret = vty->resume(vty, vty->resume_arg);
+
+	if (ret == CMD_SUSPEND) {
+		if (vtysh_flush(vty) < 0)
+			return 0;
+		/* Don't produce more output until the client has read what
+		 * is pending; vtysh_write() resumes us once it has. */
+		if (!vty->t_write)
+			vty_event(VTYSH_RESUME, vty);
+		return 0;
+	}
+
+	vty_defer_finish(vty);
+
+	/* same result trailer as vtysh_read() writes */
+	header[3] = ret;
+	buffer_put(vty->obuf, header, 4);
+
+	if (!vty->t_write && (vtysh_flush(vty) < 0))
+		return 0;
+
+	vty_event(VTYSH_READ, vty);
 	return 0;
 }
 
@@ -2154,6 +2242,10 @@ void vty_close(struct vty *vty)
 	THREAD_OFF(vty->t_read);
 	THREAD_OFF(vty->t_write);
 	THREAD_OFF(vty->t_timeout);
+	THREAD_OFF(vty->t_resume);
+
+	/* Drop a deferred command that was still running. */
+	vty_defer_finish(vty);
 
 	/* Flush buffer. */
 	buffer_flush_all(vty->obuf, vty->wfd);
@@ -2622,6 +2714,10 @@ static void vty_event(enum event event, struct vty *vty)
 		thread_add_write(vty_master, vtysh_write, vty, vty->wfd,
 				 &vty->t_write);
 		break;
+	case VTYSH_RESUME:
+		thread_add_event(vty_master, vtysh_resume, vty, 0,
+				 &vty->t_resume);
+		break;
 #endif /* VTYSH */
 	case VTY_READ:
 		thread_add_read(vty_master, vty_read, vty, vty->fd,
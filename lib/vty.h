@@ -58,6 +58,13 @@ struct vty_cfg_change {
 
 PREDECL_DLIST(vtys);
 
+struct vty;
+
+/* Continuation of a deferred command, see vty_defer().  Returns
+ * CMD_SUSPEND while there is more work left, or the final command result.
+ */
+typedef int (*vty_resume_fn)(struct vty *vty, void *arg);
+
 /* VTY struct. */
 struct vty {
 	struct vtys_item itm;
@@ -195,6 +202,13 @@ struct vty {
 	unsigned long v_timeout;
 	struct thread *t_timeout;
 
+	/* Deferred command in progress, and start of its current slice. */
+	vty_resume_fn resume;
+	void (*resume_free)(void *arg);
+	void *resume_arg;
+	struct thread *t_resume;
+	struct timeval resume_start;
+
 	/* What address is this vty comming from. */
 	char address[SU_ADDRSTRLEN];
 
@@ -338,6 +352,19 @@ extern int vty_shell(struct vty *);
 extern int vty_shell_serv(struct vty *);
 extern void vty_hello(struct vty *);
 
+/* Long-running show commands: vty_defer() runs fn repeatedly until it
+ * returns something other than CMD_SUSPEND; the command handler returns
+ * vty_defer()'s result directly.  fn should check vty_defer_yield() as it
+ * goes and return CMD_SUSPEND when that is true, keeping whatever cursor it
+ * needs in arg.  On vtysh sessions the remaining slices run from the event
+ * loop, each one only after the output of the previous one has been
+ * drained by the client; elsewhere fn simply runs to completion.  free_fn
+ * (may be NULL) releases arg when the command finishes or the vty closes.
+ */
+extern int vty_defer(struct vty *vty, vty_resume_fn fn, void *arg,
+		     void (*free_fn)(void *arg));
+extern bool vty_defer_yield(struct vty *vty);
+
 /* ^Z / SIGTSTP handling */
 extern void vty_stdio_suspend(void);
 extern void vty_stdio_resume(void);
@@ -39,20 +39,48 @@ static struct list _work_queues;
  */
 static struct list *work_queues = &_work_queues;
 
-#define WORK_QUEUE_MIN_GRANULARITY 1
+/* max. number of processed items a queue keeps around for reuse */
+#define WORK_QUEUE_FREE_MAX 1024
+
+static int work_queue_mt_run(struct thread *thread);
+
+/* microseconds from b to a */
+static inline int64_t wq_elapsed(const struct timeval *a,
+				 const struct timeval *b)
+{
+	struct timeval tv;
+
+	timersub(a, b, &tv);
+	return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
 
 static struct work_queue_item *work_queue_item_new(struct work_queue *wq)
 {
 	struct work_queue_item *item;
 	assert(wq);
 
-	item = XCALLOC(MTYPE_WORK_QUEUE_ITEM, sizeof(struct work_queue_item));
+	item = wq->free_items;
+	if (item) {
+		wq->free_items = item->next;
+		wq->free_count--;
+		memset(item, 0, sizeof(*item));
+	} else
+		item = XCALLOC(MTYPE_WORK_QUEUE_ITEM,
+			       sizeof(struct work_queue_item));
 
 	return item;
 }
 
-static void work_queue_item_free(struct work_queue_item *item)
+static void work_queue_item_free(struct work_queue *wq,
+				 struct work_queue_item *item)
 {
+	if (wq->free_count < WORK_QUEUE_FREE_MAX) {
+		item->next = wq->free_items;
+		wq->free_items = item;
+		wq->free_count++;
+		return;
+	}
+
 	XFREE(MTYPE_WORK_QUEUE_ITEM, item);
 	return;
 }
@@ -68,11 +96,56 @@ static void work_queue_item_remove(struct work_queue *wq,
 
 	work_queue_item_dequeue(wq, item);
 
-	work_queue_item_free(item);
+	work_queue_item_free(wq, item);
 
 	return;
 }
 
+/* item is done with, account for how long it was queued */
+static void work_queue_item_done(struct work_queue *wq,
+				 struct work_queue_item *item,
+				 const struct timeval *now)
+{
+	int64_t usec = wq_elapsed(now, &item->queued);
+	int64_t limit = 1000;
+	unsigned int bucket = 0;
+
+	if (usec < 0)
+		usec = 0;
+	while (bucket < WQ_LATENCY_BUCKETS - 1 && usec >= limit) {
+		limit *= 10;
+		bucket++;
+	}
+
+	wq->latency.hist[bucket]++;
+	wq->latency.total += usec;
+	if ((uint64_t)usec > wq->latency.max)
+		wq->latency.max = usec;
+	wq->items_run++;
+
+	work_queue_item_remove(wq, item);
+}
+
+/* move items added by other pthreads onto the queue, oldest first */
+static void work_queue_mt_collect(struct work_queue *wq)
+{
+	struct work_queue_item *item, *next, *list = NULL;
+
+	item = atomic_exchange_explicit(&wq->mt_items, NULL,
+					memory_order_seq_cst);
+	for (; item; item = next) {
+		next = item->next;
+		item->next = list;
+		list = item;
+	}
+
+	for (item = list; item; item = next) {
+		next = item->next;
+		item->next = NULL;
+		work_queue_item_enqueue(wq, item);
+	}
+}
+
 /* create new work queue */
 struct work_queue *work_queue_new(struct thread_master *m,
 				  const char *queue_name)
@@ -89,8 +162,6 @@ struct work_queue *work_queue_new(struct thread_master *m,
 
 	listnode_add(work_queues, new);
 
-	new->cycles.granularity = WORK_QUEUE_MIN_GRANULARITY;
-
 	/* Default values, can be overridden by caller */
 	new->spec.hold = WORK_QUEUE_DEFAULT_HOLD;
 	new->spec.yield = THREAD_YIELD_TIME_SLOT;
@@ -102,16 +173,25 @@ struct work_queue *work_queue_new(struct thread_master *m,
 void work_queue_free_and_null(struct work_queue **wqp)
 {
 	struct work_queue *wq = *wqp;
+	struct work_queue_item *item;
 
 	if (wq->thread != NULL)
 		thread_cancel(&(wq->thread));
+	thread_cancel_event(wq->master, wq);
+
+	work_queue_mt_collect(wq);
 
 	while (!work_queue_empty(wq)) {
-		struct work_queue_item *item = work_queue_last_item(wq);
+		item = work_queue_last_item(wq);
 
 		work_queue_item_remove(wq, item);
 	}
 
+	while ((item = wq->free_items)) {
+		wq->free_items = item->next;
+		XFREE(MTYPE_WORK_QUEUE_ITEM, item);
+	}
+
 	listnode_delete(work_queues, wq);
 
 	XFREE(MTYPE_WORK_QUEUE_NAME, wq->name);
@@ -141,10 +221,6 @@ static int work_queue_schedule(struct work_queue *wq, unsigned int delay)
 		else
 			thread_add_event(wq->master, work_queue_run, wq, 0,
 					 &wq->thread);
-
-		/* set thread yield time, if needed */
-		if (wq->thread && wq->spec.yield != THREAD_YIELD_TIME_SLOT)
-			thread_set_yield_time(wq->thread, wq->spec.yield);
 		return 1;
 	} else
 		return 0;
@@ -159,6 +235,7 @@ void work_queue_add(struct work_queue *wq, void *data)
 	item = work_queue_item_new(wq);
 
 	item->data = data;
+	monotime(&item->queued);
 	work_queue_item_enqueue(wq, item);
 
 	work_queue_schedule(wq, wq->spec.hold);
@@ -166,6 +243,49 @@ void work_queue_add(struct work_queue *wq, void *data)
 	return;
 }
 
+/* Lock-free push onto wq->mt_items; the first push after the queue's
+ * thread last collected schedules an event to pick the items up.  The
+ * caller must ensure the queue is not freed while this may run.
+ *
+ * Both sides store to one of mt_items/mt_scheduled and then read the
+ * other, so all four accesses are seq_cst: otherwise the queue's thread
+ * could collect an empty list while we still see mt_scheduled set, and
+ * the item would sit there until the next push.
+ */
+void work_queue_add_mt(struct work_queue *wq, void *data)
+{
+	struct work_queue_item *item, *head;
+
+	assert(wq);
+
+	item = XCALLOC(MTYPE_WORK_QUEUE_ITEM, sizeof(struct work_queue_item));
+	item->data = data;
+	monotime(&item->queued);
+
+	head = atomic_load_explicit(&wq->mt_items, memory_order_relaxed);
+	do {
+		item->next = head;
+	} while (!atomic_compare_exchange_weak_explicit(
+		&wq->mt_items, &head, item, memory_order_seq_cst,
+		memory_order_relaxed));
+
+	if (!atomic_exchange_explicit(&wq->mt_scheduled, true,
+				      memory_order_seq_cst))
+		thread_add_event(wq->master, work_queue_mt_run, wq, 0, NULL);
+}
+
+static int work_queue_mt_run(struct thread *thread)
+{
+	struct work_queue *wq = THREAD_ARG(thread);
+
+	/* clear first, so items pushed from here on schedule us again */
+	atomic_store_explicit(&wq->mt_scheduled, false, memory_order_seq_cst);
+	work_queue_mt_collect(wq);
+
+	work_queue_schedule(wq, wq->spec.hold);
+	return 0;
+}
+
 static void work_queue_item_requeue(struct work_queue *wq,
 				    struct work_queue_item *item)
 {
@@ -183,22 +303,31 @@ DEFUN (show_work_queues,
 {
 	struct listnode *node;
 	struct work_queue *wq;
+	int i;
 
-	vty_out(vty, "%c %8s %5s %8s %8s %21s\n", ' ', "List", "(ms) ",
-		"Q. Runs", "Yields", "Cycle Counts   ");
-	vty_out(vty, "%c %8s %5s %8s %8s %7s %6s %8s %6s %s\n", 'P', "Items",
-		"Hold", "Total", "Total", "Best", "Gran.", "Total", "Avg.",
-		"Name");
+	vty_out(vty, "%c %8s %5s %8s %8s %10s %17s\n", ' ', "List", "(ms) ",
+		"Q. Runs", "Yields", "Items", "Latency (ms) ");
+	vty_out(vty, "%c %8s %5s %8s %8s %10s %8s %8s %s\n", 'P', "Items",
+		"Hold", "Total", "Total", "Total", "Avg.", "Max", "Name");
 
 	for (ALL_LIST_ELEMENTS_RO(work_queues, node, wq)) {
-		vty_out(vty, "%c %8d %5d %8ld %8ld %7d %6d %8ld %6u %s\n",
+		vty_out(vty, "%c %8d %5d %8lu %8lu %10lu %8" PRIu64 " %8" PRIu64
+			     " %s\n",
 			(CHECK_FLAG(wq->flags, WQ_UNPLUGGED) ? ' ' : 'P'),
 			work_queue_item_count(wq), wq->spec.hold, wq->runs,
-			wq->yields, wq->cycles.best, wq->cycles.granularity,
-			wq->cycles.total,
-			(wq->runs) ? (unsigned int)(wq->cycles.total / wq->runs)
-				   : 0,
-			wq->name);
+			wq->yields, wq->items_run,
+			wq->items_run ? wq->latency.total / wq->items_run / 1000
+				      : 0,
+			wq->latency.max / 1000, wq->name);
+	}
+
+	vty_out(vty, "\n%-24s %8s %8s %8s %8s %8s %8s\n", "Latency (ms)",
+		"<1", "<10", "<100", "<1000", "<10000", ">=10000");
+	for (ALL_LIST_ELEMENTS_RO(work_queues, node, wq)) {
+		vty_out(vty, "%-24s", wq->name);
+		for (i = 0; i < WQ_LATENCY_BUCKETS; i++)
+			vty_out(vty, " %8lu", wq->latency.hist[i]);
+		vty_out(vty, "\n");
 	}
 
 	return CMD_SUCCESS;
@@ -242,8 +371,8 @@ int work_queue_run(struct thread *thread)
 	struct work_queue *wq;
 	struct work_queue_item *item, *titem;
 	wq_item_status ret = WQ_SUCCESS;
-	unsigned int cycles = 0;
 	char yielded = 0;
+	struct timeval start, now;
 
 	wq = THREAD_ARG(thread);
 
@@ -251,27 +380,13 @@ int work_queue_run(struct thread *thread)
 
 	wq->thread = NULL;
 
-	/* calculate cycle granularity:
-	 * list iteration == 1 run
-	 * listnode processing == 1 cycle
-	 * granularity == # cycles between checks whether we should yield.
-	 *
-	 * granularity should be > 0, and can increase slowly after each run to
-	 * provide some hysteris, but not past cycles.best or 2*cycles.
-	 *
-	 * Best: starts low, can only increase
-	 *
-	 * Granularity: starts at WORK_QUEUE_MIN_GRANULARITY, can be decreased
-	 *              if we run to end of time slot, can increase otherwise
-	 *              by a small factor.
-	 *
-	 * We could use just the average and save some work, however we want to
-	 * be
-	 * able to adjust quickly to CPU pressure. Average wont shift much if
-	 * daemon has been running a long time.
+	work_queue_mt_collect(wq);
+
+	/* Items are taken off the queue until spec.yield microseconds have
+	 * passed since the start of the run.  The clock read per item also
+	 * gives the completion time for the latency statistics.
 	 */
-	if (wq->cycles.granularity == 0)
-		wq->cycles.granularity = WORK_QUEUE_MIN_GRANULARITY;
+	monotime(&start);
 
 	STAILQ_FOREACH_SAFE (item, &wq->items, wq, titem) {
 		assert(item->data);
@@ -293,6 +408,8 @@ int work_queue_run(struct thread *thread)
 		} while ((ret == WQ_RETRY_NOW)
 			 && (item->ran < wq->spec.max_retries));
 
+		monotime(&now);
+
 		switch (ret) {
 		case WQ_QUEUE_BLOCKED: {
 			/* decrement item->ran again, cause this isn't an item
@@ -330,50 +447,20 @@ int work_queue_run(struct thread *thread)
 		/* fallthru */
 		case WQ_SUCCESS:
 		default: {
-			work_queue_item_remove(wq, item);
+			work_queue_item_done(wq, item, &now);
 			break;
 		}
 		}
 
-		/* completed cycle */
-		cycles++;
-
 		/* test if we should yield */
-		if (!(cycles % wq->cycles.granularity)
-		    && thread_should_yield(thread)) {
+		if (wq_elapsed(&now, &start) >= (int64_t)wq->spec.yield) {
 			yielded = 1;
 			goto stats;
 		}
 	}
 
 stats:
-
-#define WQ_HYSTERESIS_FACTOR 4
-
-	/* we yielded, check whether granularity should be reduced */
-	if (yielded && (cycles < wq->cycles.granularity)) {
-		wq->cycles.granularity =
-			((cycles > 0) ? cycles : WORK_QUEUE_MIN_GRANULARITY);
-	}
-	/* otherwise, should granularity increase? */
-	else if (cycles >= (wq->cycles.granularity)) {
-		if (cycles > wq->cycles.best)
-			wq->cycles.best = cycles;
-
-		/* along with yielded check, provides hysteresis for granularity
-		 */
-		if (cycles > (wq->cycles.granularity * WQ_HYSTERESIS_FACTOR
-			      * WQ_HYSTERESIS_FACTOR))
-			wq->cycles.granularity *=
-				WQ_HYSTERESIS_FACTOR; /* quick ramp-up */
-		else if (cycles
-			 > (wq->cycles.granularity * WQ_HYSTERESIS_FACTOR))
-			wq->cycles.granularity += WQ_HYSTERESIS_FACTOR;
-	}
-#undef WQ_HYSTERIS_FACTOR
-
 	wq->runs++;
-	wq->cycles.total += cycles;
 	if (yielded)
 		wq->yields++;
 
@@ -25,6 +25,7 @@
 
 #include "memory.h"
 #include "queue.h"
+#include "frratomic.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,10 +54,15 @@ typedef enum {
 /* A single work queue item, unsurprisingly */
 struct work_queue_item {
 	STAILQ_ENTRY(work_queue_item) wq;
+	struct work_queue_item *next; /* work_queue_add_mt() / free list */
 	void *data;	 /* opaque data */
 	unsigned short ran; /* # of times item has been run */
+	struct timeval queued; /* when the item was added */
 };
 
+/* queueing latency histogram: <1ms, <10ms, ... <10s, >=10s */
+#define WQ_LATENCY_BUCKETS 6
+
 #define WQ_UNPLUGGED	(1 << 0) /* available for draining */
 
 struct work_queue {
@@ -108,12 +114,21 @@ struct work_queue {
 	int item_count;       /* queued items */
 	unsigned long runs;   /* runs count */
 	unsigned long yields; /* yields count */
+	unsigned long items_run; /* items processed */
+
+	/* items added by other pthreads, newest first */
+	struct work_queue_item *_Atomic mt_items;
+	atomic_bool mt_scheduled;
+
+	/* processed items kept for reuse by work_queue_add() */
+	struct work_queue_item *free_items;
+	unsigned int free_count;
 
 	struct {
-		unsigned int best;
-		unsigned int granularity;
-		unsigned long total;
-	} cycles; /* cycle counts */
+		unsigned long hist[WQ_LATENCY_BUCKETS];
+		uint64_t total; /* usec */
+		uint64_t max;	/* usec */
+	} latency; /* from add to completion */
 
 	/* private state */
 	uint16_t flags; /* user set flag */
@@ -168,6 +183,11 @@ extern void work_queue_free_and_null(struct work_queue **wqp);
 
 /* Add the supplied data as an item onto the workqueue */
 extern void work_queue_add(struct work_queue *wq, void *item);
+/* Same, callable from any pthread.  Items are handed over to the queue's
+ * thread_master before they are run, so they may be picked up after items
+ * added later with work_queue_add().
+ */
+extern void work_queue_add_mt(struct work_queue *wq, void *item);
 
 /* plug the queue, ie prevent it from being drained / processed */
 extern void work_queue_plug(struct work_queue *wq);
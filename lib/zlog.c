@@ -51,11 +51,13 @@
 #include "atomlist.h"
 #include "printfrr.h"
 #include "frrcu.h"
+#include "seqlock.h"
 #include "zlog.h"
 #include "libfrr_trace.h"
 
 DEFINE_MTYPE_STATIC(LIB, LOG_MESSAGE,  "log message");
 DEFINE_MTYPE_STATIC(LIB, LOG_TLSBUF,   "log thread-local buffer");
+DEFINE_MTYPE_STATIC(LIB, LOG_RING,     "log async ring");
 
 DEFINE_HOOK(zlog_init, (const char *progname, const char *protoname,
 			unsigned short instance, uid_t uid, gid_t gid),
@@ -104,6 +106,11 @@ struct zlog_msg {
 	va_list args;
 	const struct xref_logmsg *xref;
 
+	/* thread the message was logged on, if it isn't the current one
+	 * (i.e. for asynchronous logging;  0 otherwise)
+	 */
+	intmax_t tid;
+
 	char *stackbuf;
 	size_t stackbufsz;
 	char *text;
@@ -366,7 +373,7 @@ void zlog_msg_pid(struct zlog_msg *msg, intmax_t *pid, intmax_t *tid)
 	*pid = (intmax_t)getpid();
 #endif
 #ifdef CAN_DO_TLS
-	*tid = zlog_gettid();
+	*tid = msg->tid ? msg->tid : zlog_gettid();
 #else
 	*tid = *pid;
 #endif
@@ -406,6 +413,26 @@ void zlog_tls_buffer_flush(void)
 	zlog_tls->nmsgs = 0;
 }
 
+/* "[XXXXX-XXXXX][EC 12345] " prefix, as configured */
+static size_t zlog_msg_hdr(struct zlog_msg *msg, struct fbuf *fb)
+{
+	bool do_xid, do_ec;
+	size_t need = 0;
+
+	do_ec = atomic_load_explicit(&zlog_ec, memory_order_relaxed);
+	do_xid = atomic_load_explicit(&zlog_xid, memory_order_relaxed);
+
+	if (msg->xref && do_xid && msg->xref->xref.xrefdata->uid[0]) {
+		need += bputch(fb, '[');
+		need += bputs(fb, msg->xref->xref.xrefdata->uid);
+		need += bputch(fb, ']');
+	}
+	if (msg->xref && do_ec && msg->xref->ec)
+		need += bprintfrr(fb, "[EC %u]", msg->xref->ec);
+	if (need)
+		need += bputch(fb, ' ');
+	return need;
+}
 
 static void vzlog_notls(const struct xref_logmsg *xref, int prio,
 			const char *fmt, va_list ap)
@@ -508,6 +535,1043 @@ static void vzlog_tls(struct zlog_tls *zlog_tls, const struct xref_logmsg *xref,
 		XFREE(MTYPE_LOG_MESSAGE, msg->text);
 }
 
+/* asynchronous logging
+ *
+ * With zlog_set_async(true), log messages are neither formatted nor written
+ * on the pthread that logs them.  The caller only copies the arguments into
+ * a compact binary record on a per-pthread single-producer/single-consumer
+ * ring;  a dedicated log pthread picks the records up, formats them using
+ * the format string from the message's xref, and hands them to the targets.
+ *
+ * Anything an argument points to must be resolved on the calling thread
+ * since it may be gone by the time the log pthread gets to it.  %s strings
+ * are copied into the record, and printfrr extensions (%pI4, %pFX, ...) are
+ * printed into it right away.  Messages that can't be split up like this
+ * (no xref, positional arguments, %m, %n, wide characters, ...) are
+ * formatted on the calling thread as a whole and only the text is queued.
+ * Only huge messages (more than a quarter of a ring) fall back to
+ * synchronous output, which means they can overtake queued ones.
+ *
+ * If a ring is full, the message is dropped and counted;  the log pthread
+ * reports drops with a warning.  LOG_CRIT and above always bypass the rings
+ * since they tend to be followed by abort().
+ */
+
+#define ZLOG_RING_SIZE		(64 * 1024)	/* must be a power of 2 */
+#define ZLOG_REC_MAX		2048
+#define ZLOG_REC_ALIGN		16
+#define ZLOG_REC_MAXARGS	24		/* cf. zlog_msg->argpos */
+
+#define ZLOG_ASYNC_BUF_SIZE	(64 * 1024)
+#define ZLOG_ASYNC_MAXMSG	64
+
+enum zlog_rec_type {
+	ZLOG_REC_PAD = 0,
+	ZLOG_REC_ARGS,
+	ZLOG_REC_TEXT,
+};
+
+#define ZLOG_RECARG_NULL	UINT32_MAX
+
+union zlog_recarg {
+	intmax_t i;
+	uintmax_t u;
+	double d;
+	long double ld;
+	const void *p;
+	/* %s and pre-printed %p extensions;  off is relative to the string
+	 * area after the last argument, extlen is the number of format string
+	 * characters the extension consumed.
+	 */
+	struct {
+		uint32_t off;
+		uint32_t len;
+		uint32_t extlen;
+	} s;
+};
+
+struct zlog_rec {
+	uint32_t len;		/* whole record, multiple of ZLOG_REC_ALIGN */
+	uint8_t type;
+	uint8_t prio;
+	/* ZLOG_REC_ARGS: number of args
+	 * ZLOG_REC_TEXT: number of struct fmt_outpos following the text
+	 */
+	uint16_t nargs;
+	uint32_t textlen;
+	struct timespec ts;
+	const struct xref_logmsg *xref;
+
+	union zlog_recarg args[];
+};
+
+PREDECL_ATOMLIST(zlog_rings);
+
+struct zlog_ring {
+	struct zlog_rings_item item;
+
+	/* head is only written by the owning pthread, tail only by the log
+	 * pthread.  Both count up continuously, the ring position is the
+	 * value modulo ZLOG_RING_SIZE.
+	 */
+	atomic_size_t head;
+	atomic_size_t tail;
+
+	atomic_size_t drops;
+	size_t drops_seen;
+	/* owning pthread has exited while the log pthread was running;  freed
+	 * by the log pthread once empty, or by zlog_async_fini()
+	 */
+	atomic_bool dead;
+	intmax_t tid;
+
+	char buf[ZLOG_RING_SIZE] __attribute__((aligned(ZLOG_REC_ALIGN)));
+};
+
+DECLARE_ATOMLIST(zlog_rings, struct zlog_ring, item);
+
+static struct zlog_rings_head zlog_rings;
+static pthread_key_t zlog_ring_key;
+
+static atomic_bool zlog_async_on;
+static atomic_bool zlog_async_stop;
+/* zlog_async_mtx serializes changes to zlog_async_running against pthreads
+ * exiting, so that a ring is freed either by its owner (log pthread not
+ * running) or by the log side (ring marked dead), never both.
+ */
+static pthread_mutex_t zlog_async_mtx = PTHREAD_MUTEX_INITIALIZER;
+static bool zlog_async_running;
+static pthread_t zlog_async_pthread;
+static struct seqlock zlog_async_seq;
+
+/* only written by the log pthread */
+static atomic_size_t zlog_async_n_args, zlog_async_n_text, zlog_async_n_drops;
+
+/* messages formatted on the log pthread, waiting to go to the targets */
+static struct zlog_async_batch {
+	size_t nmsgs;
+	size_t bufpos;
+	struct zlog_msg msgs[ZLOG_ASYNC_MAXMSG];
+	struct zlog_msg *msgp[ZLOG_ASYNC_MAXMSG];
+	char buf[ZLOG_ASYNC_BUF_SIZE];
+} zlog_batch;
+
+static void zlog_ring_exit(void *arg)
+{
+	struct zlog_ring *ring = arg;
+
+	pthread_mutex_lock(&zlog_async_mtx);
+	if (zlog_async_running) {
+		atomic_store_explicit(&ring->dead, true, memory_order_release);
+		ring = NULL;
+	} else
+		zlog_rings_del(&zlog_rings, ring);
+	pthread_mutex_unlock(&zlog_async_mtx);
+
+	XFREE(MTYPE_LOG_RING, ring);
+}
+
+static void zlog_ring_key_init(void) __attribute__((_CONSTRUCTOR(500)));
+static void zlog_ring_key_init(void)
+{
+	pthread_key_create(&zlog_ring_key, zlog_ring_exit);
+}
+
+static void zlog_ring_key_fini(void) __attribute__((_DESTRUCTOR(500)));
+static void zlog_ring_key_fini(void)
+{
+	pthread_key_delete(zlog_ring_key);
+}
+
+static struct zlog_ring *zlog_ring_get(void)
+{
+	struct zlog_ring *ring = pthread_getspecific(zlog_ring_key);
+
+	if (ring)
+		return ring;
+
+	ring = XCALLOC(MTYPE_LOG_RING, sizeof(*ring));
+#ifdef CAN_DO_TLS
+	ring->tid = zlog_gettid();
+#endif
+	pthread_setspecific(zlog_ring_key, ring);
+	zlog_rings_add_head(&zlog_rings, ring);
+	return ring;
+}
+
+static void zlog_ring_push(struct zlog_ring *ring, struct zlog_rec *rec)
+{
+	size_t head, tail, off, pad = 0;
+
+	head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	off = head & (ZLOG_RING_SIZE - 1);
+
+	/* records are contiguous, pad up to the end if needed */
+	if (ZLOG_RING_SIZE - off < rec->len)
+		pad = ZLOG_RING_SIZE - off;
+
+	if (ZLOG_RING_SIZE - (head - tail) < pad + rec->len) {
+		atomic_fetch_add_explicit(&ring->drops, 1,
+					  memory_order_relaxed);
+		return;
+	}
+
+	if (pad) {
+		struct zlog_rec *padrec = (struct zlog_rec *)(ring->buf + off);
+
+		padrec->len = pad;
+		padrec->type = ZLOG_REC_PAD;
+		off = 0;
+	}
+	memcpy(ring->buf + off, rec, rec->len);
+
+	/* seq_cst pairs with zlog_async_drain();  if the ring was empty up
+	 * to here, the log pthread may be asleep and needs a wakeup.
+	 */
+	atomic_store_explicit(&ring->head, head + pad + rec->len,
+			      memory_order_seq_cst);
+	if (atomic_load_explicit(&ring->tail, memory_order_seq_cst) == head)
+		seqlock_bump(&zlog_async_seq);
+}
+
+enum zlog_fmt_len {
+	ZLOG_LEN_NONE = 0,
+	ZLOG_LEN_HH,
+	ZLOG_LEN_H,
+	ZLOG_LEN_L,
+	ZLOG_LEN_LL,
+	ZLOG_LEN_J,
+	ZLOG_LEN_Z,
+	ZLOG_LEN_T,
+	ZLOG_LEN_LDBL,
+};
+
+struct zlog_fmtspec {
+	const char *start;	/* the '%' */
+	const char *lenpos;	/* length modifier, or conversion if none */
+	const char *end;	/* after the conversion character */
+	char conv;
+	enum zlog_fmt_len len;
+	bool plain;		/* no flags, width or precision */
+	bool star_width, star_prec;
+	int prec;		/* literal precision, -1 if none */
+};
+
+/* Parse one conversion specification at fmt (which points at a '%').
+ * This only accepts the plain C99 subset that can be captured and printed
+ * again piecewise;  anything else returns false.  Since both ends use the
+ * same parser, the log pthread only sees format strings accepted here.
+ */
+static bool zlog_fmt_parse(const char *fmt, struct zlog_fmtspec *spec)
+{
+	const char *p = fmt + 1;
+
+	spec->start = fmt;
+	spec->star_width = spec->star_prec = false;
+	spec->prec = -1;
+	spec->len = ZLOG_LEN_NONE;
+
+	while (*p && strchr("-+ #0'", *p))
+		p++;
+
+	if (*p == '*') {
+		spec->star_width = true;
+		p++;
+	} else
+		while (*p >= '0' && *p <= '9')
+			p++;
+
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->star_prec = true;
+			p++;
+		} else {
+			spec->prec = 0;
+			while (*p >= '0' && *p <= '9')
+				spec->prec = spec->prec * 10 + *p++ - '0';
+		}
+	}
+	spec->plain = (p == fmt + 1);
+	spec->lenpos = p;
+
+	switch (*p) {
+	case 'h':
+		p++;
+		spec->len = ZLOG_LEN_H;
+		if (*p == 'h') {
+			p++;
+			spec->len = ZLOG_LEN_HH;
+		}
+		break;
+	case 'l':
+		p++;
+		spec->len = ZLOG_LEN_L;
+		if (*p == 'l') {
+			p++;
+			spec->len = ZLOG_LEN_LL;
+		}
+		break;
+	case 'q':
+		p++;
+		spec->len = ZLOG_LEN_LL;
+		break;
+	case 'j':
+		p++;
+		spec->len = ZLOG_LEN_J;
+		break;
+	case 'z':
+		p++;
+		spec->len = ZLOG_LEN_Z;
+		break;
+	case 't':
+		p++;
+		spec->len = ZLOG_LEN_T;
+		break;
+	case 'L':
+		p++;
+		spec->len = ZLOG_LEN_LDBL;
+		break;
+	}
+
+	spec->conv = *p++;
+	spec->end = p;
+
+	/* keep specbuf in zlog_rec_format() from overflowing */
+	if (spec->end - spec->start > 32)
+		return false;
+
+	switch (spec->conv) {
+	case '%':
+		return spec->plain && spec->len == ZLOG_LEN_NONE;
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		return spec->len != ZLOG_LEN_LDBL;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		return spec->len == ZLOG_LEN_NONE || spec->len == ZLOG_LEN_L
+		       || spec->len == ZLOG_LEN_LDBL;
+	case 'c':
+	case 's':
+	case 'p':
+		return spec->len == ZLOG_LEN_NONE;
+	default:
+		return false;
+	}
+}
+
+static size_t zlog_rec_size(size_t len)
+{
+	return (len + ZLOG_REC_ALIGN - 1) & ~(size_t)(ZLOG_REC_ALIGN - 1);
+}
+
+/* ZLOG_REC_TEXT records have the text first, then the argpos array */
+static size_t zlog_rec_argpos_off(const struct zlog_rec *rec)
+{
+	return zlog_rec_size(offsetof(struct zlog_rec, args) + rec->textlen);
+}
+
+/* capture arguments into rec, which has room for bufsz bytes */
+static bool zlog_rec_args(struct zlog_rec *rec, size_t bufsz, const char *fmt,
+			  va_list ap)
+{
+	union zlog_recarg *arg = rec->args;
+	union zlog_recarg *argend = rec->args + ZLOG_REC_MAXARGS;
+	struct zlog_fmtspec spec;
+	char strs[ZLOG_REC_MAX];
+	size_t slen = 0, len;
+	const char *p, *s;
+	const void *ptr;
+	struct fbuf fb;
+	ssize_t n;
+	int prec;
+
+	while ((p = strchr(fmt, '%'))) {
+		if (!zlog_fmt_parse(p, &spec))
+			return false;
+		fmt = spec.end;
+
+		if (spec.conv == '%')
+			continue;
+		if (arg + spec.star_width + spec.star_prec >= argend)
+			return false;
+
+		if (spec.star_width)
+			arg++->i = va_arg(ap, int);
+		prec = spec.prec;
+		if (spec.star_prec)
+			prec = arg++->i = va_arg(ap, int);
+
+		switch (spec.conv) {
+		case 'd':
+		case 'i':
+			/* %d extensions (%dPF, ...) aren't split out */
+			if (printfrr_ext_char(*fmt))
+				return false;
+
+			switch (spec.len) {
+			case ZLOG_LEN_HH:
+				arg->i = (signed char)va_arg(ap, int);
+				break;
+			case ZLOG_LEN_H:
+				arg->i = (short)va_arg(ap, int);
+				break;
+			case ZLOG_LEN_L:
+				arg->i = va_arg(ap, long);
+				break;
+			case ZLOG_LEN_LL:
+				arg->i = va_arg(ap, long long);
+				break;
+			case ZLOG_LEN_J:
+				arg->i = va_arg(ap, intmax_t);
+				break;
+			case ZLOG_LEN_Z:
+				arg->i = va_arg(ap, ssize_t);
+				break;
+			case ZLOG_LEN_T:
+				arg->i = va_arg(ap, ptrdiff_t);
+				break;
+			default:
+				arg->i = va_arg(ap, int);
+				break;
+			}
+			break;
+
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			switch (spec.len) {
+			case ZLOG_LEN_HH:
+				arg->u = (unsigned char)va_arg(ap, unsigned int);
+				break;
+			case ZLOG_LEN_H:
+				arg->u = (unsigned short)va_arg(ap,
+								unsigned int);
+				break;
+			case ZLOG_LEN_L:
+				arg->u = va_arg(ap, unsigned long);
+				break;
+			case ZLOG_LEN_LL:
+				arg->u = va_arg(ap, unsigned long long);
+				break;
+			case ZLOG_LEN_J:
+				arg->u = va_arg(ap, uintmax_t);
+				break;
+			case ZLOG_LEN_Z:
+				arg->u = va_arg(ap, size_t);
+				break;
+			case ZLOG_LEN_T:
+				arg->u = (uintmax_t)va_arg(ap, ptrdiff_t);
+				break;
+			default:
+				arg->u = va_arg(ap, unsigned int);
+				break;
+			}
+			break;
+
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			if (spec.len == ZLOG_LEN_LDBL)
+				arg->ld = va_arg(ap, long double);
+			else
+				arg->d = va_arg(ap, double);
+			break;
+
+		case 'c':
+			arg->i = va_arg(ap, int);
+			break;
+
+		case 's':
+			s = va_arg(ap, const char *);
+			if (!s) {
+				arg->s.len = ZLOG_RECARG_NULL;
+				break;
+			}
+
+			/* with a precision, s need not be 0-terminated */
+			len = prec >= 0 ? strnlen(s, prec) : strlen(s);
+			if (len + 1 > sizeof(strs) - slen)
+				return false;
+
+			memcpy(strs + slen, s, len);
+			strs[slen + len] = '\0';
+			arg->s.off = slen;
+			arg->s.len = len;
+			slen += len + 1;
+			break;
+
+		case 'p':
+			ptr = va_arg(ap, const void *);
+			if (!printfrr_ext_char(*fmt)) {
+				arg->p = ptr;
+				break;
+			}
+
+			/* the extension's data may be gone by the time the
+			 * log pthread runs, so print it now.
+			 */
+			if (!spec.plain)
+				return false;
+
+			fb.buf = fb.pos = strs + slen;
+			fb.len = sizeof(strs) - slen;
+			fb.outpos = NULL;
+			fb.outpos_n = fb.outpos_i = 0;
+
+			s = fmt;
+			n = bprintfrr_extp(&fb, &fmt, ptr);
+			if (n < 0)
+				/* not an extension, "%p" then literal text */
+				n = bprintfrr(&fb, "%p", ptr);
+			if ((size_t)n + 1 > sizeof(strs) - slen)
+				return false;
+
+			strs[slen + n] = '\0';
+			arg->s.off = slen;
+			arg->s.len = n;
+			arg->s.extlen = fmt - s;
+			slen += n + 1;
+			break;
+		}
+		arg++;
+	}
+
+	rec->type = ZLOG_REC_ARGS;
+	rec->nargs = arg - rec->args;
+
+	len = (char *)arg - (char *)rec + slen;
+	if (len > bufsz)
+		return false;
+
+	memcpy(arg, strs, slen);
+	rec->len = zlog_rec_size(len);
+	return true;
+}
+
+/* fallback: format the message text on the calling thread.  Returns the
+ * record length, which is larger than bufsz if it didn't fit.
+ */
+static size_t zlog_rec_text(struct zlog_rec *rec, size_t bufsz,
+			    const char *fmt, va_list ap)
+{
+	struct fmt_outpos argpos[ZLOG_REC_MAXARGS];
+	char *text = (char *)rec->args;
+	struct fbuf fb = {
+		.buf = text,
+		.pos = text,
+		.len = (char *)rec + bufsz - text,
+		.outpos = argpos,
+		.outpos_n = array_size(argpos),
+	};
+	size_t len;
+	ssize_t n;
+
+	n = vbprintfrr(&fb, fmt, ap);
+
+	rec->type = ZLOG_REC_TEXT;
+	rec->textlen = n;
+	rec->nargs = fb.outpos_i;
+
+	len = zlog_rec_argpos_off(rec) + rec->nargs * sizeof(argpos[0]);
+	if ((size_t)n > fb.len || len > bufsz)
+		return zlog_rec_size(len);
+
+	memcpy((char *)rec + zlog_rec_argpos_off(rec), argpos,
+	       rec->nargs * sizeof(argpos[0]));
+	rec->len = zlog_rec_size(len);
+	return rec->len;
+}
+
+/* returns false if the message needs to go through the synchronous path */
+static bool vzlog_async(const struct xref_logmsg *xref, int prio,
+			const char *fmt, va_list ap)
+{
+	char buf[ZLOG_REC_MAX] __attribute__((aligned(ZLOG_REC_ALIGN)));
+	struct zlog_rec *rec = (struct zlog_rec *)buf;
+	struct zlog_target *zt;
+	bool ignoremsg = true, ok = false;
+	int saved_errno = errno;
+	size_t need;
+	va_list args;
+
+	/* the log pthread itself (e.g. errors from a target) */
+	if (pthread_equal(pthread_self(), zlog_async_pthread))
+		return false;
+
+	/* avoid further processing cost if no target wants this message */
+	rcu_read_lock();
+	frr_each (zlog_targets, &zlog_targets, zt) {
+		if (prio > zt->prio_min)
+			continue;
+		ignoremsg = false;
+		break;
+	}
+	rcu_read_unlock();
+
+	if (ignoremsg)
+		return true;
+
+	memset(rec, 0, sizeof(*rec));
+	clock_gettime(CLOCK_REALTIME, &rec->ts);
+	rec->prio = prio & LOG_PRIMASK;
+	rec->xref = xref;
+
+	/* the format string must be static;  the xref's is */
+	if (xref && fmt == xref->fmtstring) {
+		va_copy(args, ap);
+		ok = zlog_rec_args(rec, sizeof(buf), fmt, args);
+		va_end(args);
+	}
+	if (!ok) {
+		errno = saved_errno;
+		va_copy(args, ap);
+		need = zlog_rec_text(rec, sizeof(buf), fmt, args);
+		va_end(args);
+
+		if (need > sizeof(buf)) {
+			/* keep long messages in order with the rest, but
+			 * don't let them take up too much of the ring
+			 */
+			if (need > ZLOG_RING_SIZE / 4)
+				return false;
+
+			rec = XMALLOC(MTYPE_LOG_MESSAGE, need);
+			memcpy(rec, buf, offsetof(struct zlog_rec, args));
+
+			errno = saved_errno;
+			va_copy(args, ap);
+			zlog_rec_text(rec, need, fmt, args);
+			va_end(args);
+		}
+	}
+
+	zlog_ring_push(zlog_ring_get(), rec);
+
+	if (rec != (struct zlog_rec *)buf)
+		XFREE(MTYPE_LOG_MESSAGE, rec);
+	return true;
+}
+
+/*
+ * log pthread side
+ */
+
+static size_t zlog_bputn(struct fbuf *fb, const char *str, size_t len)
+{
+	size_t ncopy = MIN(len, (size_t)(fb->buf + fb->len - fb->pos));
+
+	memcpy(fb->pos, str, ncopy);
+	fb->pos += ncopy;
+	return len;
+}
+
+/* rebuild the conversion spec with '*' filled in, and integers widened to
+ * intmax_t since that is what the record holds.
+ */
+static void zlog_fmt_spec(char *out, size_t outsz,
+			  const struct zlog_fmtspec *spec,
+			  const union zlog_recarg **argp)
+{
+	struct fbuf fb = { .buf = out, .pos = out, .len = outsz - 1 };
+	const char *p;
+	int val;
+
+	for (p = spec->start; p < spec->lenpos; p++) {
+		if (*p != '*') {
+			bputch(&fb, *p);
+			continue;
+		}
+
+		val = (*argp)++->i;
+		if (p[-1] == '.' && val < 0)
+			/* negative precision is the same as none */
+			fb.pos--;
+		else
+			bprintfrr(&fb, "%d", val);
+	}
+
+	switch (spec->conv) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		bputch(&fb, 'j');
+		break;
+	default:
+		if (spec->len == ZLOG_LEN_LDBL)
+			bputch(&fb, 'L');
+		break;
+	}
+	bputch(&fb, spec->conv);
+	*fb.pos = '\0';
+}
+
+static ssize_t zlog_rec_format(struct fbuf *fb, const struct zlog_rec *rec)
+{
+	const char *fmt = rec->xref->fmtstring, *p, *s;
+	const union zlog_recarg *arg = rec->args;
+	const char *strs = (const char *)(rec->args + rec->nargs);
+	struct zlog_fmtspec spec;
+	char specbuf[64];
+	ssize_t ret = 0;
+
+	while ((p = strchr(fmt, '%'))) {
+		ret += zlog_bputn(fb, fmt, p - fmt);
+
+		zlog_fmt_parse(p, &spec);
+		fmt = spec.end;
+		zlog_fmt_spec(specbuf, sizeof(specbuf), &spec, &arg);
+
+		switch (spec.conv) {
+		case '%':
+			ret += bputch(fb, '%');
+			break;
+		case 'c':
+			ret += bprintfrr(fb, specbuf, (int)arg++->i);
+			break;
+		case 'd':
+		case 'i':
+			ret += bprintfrr(fb, specbuf, arg++->i);
+			break;
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			ret += bprintfrr(fb, specbuf, arg++->u);
+			break;
+		case 's':
+			s = arg->s.len == ZLOG_RECARG_NULL ? NULL
+							   : strs + arg->s.off;
+			ret += bprintfrr(fb, specbuf, s);
+			arg++;
+			break;
+		case 'p':
+			if (printfrr_ext_char(*fmt)) {
+				ret += bprintfrr(fb, "%.*s", (int)arg->s.len,
+						 strs + arg->s.off);
+				fmt += arg->s.extlen;
+			} else
+				ret += bprintfrr(fb, specbuf, arg->p);
+			arg++;
+			break;
+		default:
+			if (spec.len == ZLOG_LEN_LDBL)
+				ret += bprintfrr(fb, specbuf, arg->ld);
+			else
+				ret += bprintfrr(fb, specbuf, arg->d);
+			arg++;
+			break;
+		}
+	}
+	ret += bputs(fb, fmt);
+	return ret;
+}
+
+/* format rec into buf, filling in msg;  returns the length needed */
+static size_t zlog_rec_render(struct zlog_msg *msg, const struct zlog_rec *rec,
+			      char *buf, size_t bufsz)
+{
+	struct fbuf fb = {
+		.buf = buf,
+		.pos = buf,
+		.len = bufsz,
+	};
+	const struct fmt_outpos *argpos;
+	const char *text;
+	size_t need, i;
+
+	need = msg->hdrlen = zlog_msg_hdr(msg, &fb);
+
+	if (rec->type == ZLOG_REC_ARGS) {
+		fb.outpos = msg->argpos;
+		fb.outpos_n = array_size(msg->argpos);
+		fb.outpos_i = 0;
+
+		need += zlog_rec_format(&fb, rec);
+		msg->n_argpos = fb.outpos_i;
+	} else {
+		text = (const char *)rec->args;
+		argpos = (const struct fmt_outpos *)((const char *)rec
+						     + zlog_rec_argpos_off(rec));
+
+		need += zlog_bputn(&fb, text, rec->textlen);
+
+		msg->n_argpos = MIN(rec->nargs, array_size(msg->argpos));
+		for (i = 0; i < msg->n_argpos; i++) {
+			msg->argpos[i].off_start =
+				argpos[i].off_start + msg->hdrlen;
+			msg->argpos[i].off_end = argpos[i].off_end + msg->hdrlen;
+		}
+	}
+
+	msg->textlen = need;
+	need += bputch(&fb, '\n');
+	msg->text = buf;
+	return need;
+}
+
+static void zlog_async_flush(void)
+{
+	struct zlog_target *zt;
+
+	if (!zlog_batch.nmsgs)
+		return;
+
+	rcu_read_lock();
+	frr_each (zlog_targets, &zlog_targets, zt) {
+		if (!zt->logfn)
+			continue;
+
+		zt->logfn(zt, zlog_batch.msgp, zlog_batch.nmsgs);
+	}
+	rcu_read_unlock();
+
+	zlog_batch.nmsgs = 0;
+	zlog_batch.bufpos = 0;
+}
+
+static struct zlog_msg *zlog_async_msg(struct zlog_ring *ring, int prio,
+				       const struct timespec *ts,
+				       const struct xref_logmsg *xref)
+{
+	struct zlog_msg *msg;
+
+	/* avoid malloc() for long messages as far as possible */
+	if (zlog_batch.nmsgs == array_size(zlog_batch.msgs)
+	    || ZLOG_ASYNC_BUF_SIZE - zlog_batch.bufpos < ZLOG_REC_MAX)
+		zlog_async_flush();
+
+	msg = &zlog_batch.msgs[zlog_batch.nmsgs];
+	zlog_batch.msgp[zlog_batch.nmsgs] = msg;
+	memset(msg, 0, sizeof(*msg));
+	msg->ts = *ts;
+	msg->prio = prio;
+	msg->xref = xref;
+	msg->fmt = xref ? xref->fmtstring : NULL;
+	msg->tid = ring->tid;
+	return msg;
+}
+
+static void zlog_async_rec(struct zlog_ring *ring, const struct zlog_rec *rec)
+{
+	struct zlog_msg *msg;
+	char *buf;
+	size_t need, avail;
+
+	msg = zlog_async_msg(ring, rec->prio, &rec->ts, rec->xref);
+
+	buf = zlog_batch.buf + zlog_batch.bufpos;
+	avail = ZLOG_ASYNC_BUF_SIZE - zlog_batch.bufpos;
+
+	need = zlog_rec_render(msg, rec, buf, avail);
+	zlog_batch.nmsgs++;
+
+	if (need <= avail) {
+		zlog_batch.bufpos += need;
+		return;
+	}
+
+	buf = XMALLOC(MTYPE_LOG_MESSAGE, need);
+	zlog_rec_render(msg, rec, buf, need);
+	zlog_async_flush();
+	XFREE(MTYPE_LOG_MESSAGE, buf);
+}
+
+static void zlog_async_drops(struct zlog_ring *ring, size_t drops)
+{
+	struct zlog_msg *msg;
+	struct timespec ts;
+	struct fbuf fb;
+	size_t need;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	msg = zlog_async_msg(ring, LOG_WARNING, &ts, NULL);
+
+	fb.buf = fb.pos = zlog_batch.buf + zlog_batch.bufpos;
+	fb.len = ZLOG_ASYNC_BUF_SIZE - zlog_batch.bufpos;
+	fb.outpos = NULL;
+	fb.outpos_n = fb.outpos_i = 0;
+
+	need = bprintfrr(&fb,
+			 "%zu log messages dropped, asynchronous log buffer full",
+			 drops);
+
+	msg->text = fb.buf;
+	msg->textlen = need;
+	need += bputch(&fb, '\n');
+	zlog_batch.bufpos += need;
+	zlog_batch.nmsgs++;
+}
+
+/* process everything currently in the rings;  returns false if idle */
+static bool zlog_async_drain(void)
+{
+	struct zlog_ring *ring;
+	const struct zlog_rec *rec;
+	size_t head, tail, drops;
+	bool dead, progress = false;
+
+	frr_each_safe (zlog_rings, &zlog_rings, ring) {
+		/* before head, so nothing can be added after seeing it */
+		dead = atomic_load_explicit(&ring->dead, memory_order_acquire);
+		head = atomic_load_explicit(&ring->head, memory_order_seq_cst);
+		tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+		if (tail != head)
+			progress = true;
+
+		while (tail != head) {
+			rec = (const struct zlog_rec *)(
+				ring->buf + (tail & (ZLOG_RING_SIZE - 1)));
+			tail += rec->len;
+
+			if (rec->type == ZLOG_REC_PAD)
+				continue;
+
+			if (rec->type == ZLOG_REC_ARGS)
+				atomic_fetch_add_explicit(&zlog_async_n_args, 1,
+							  memory_order_relaxed);
+			else
+				atomic_fetch_add_explicit(&zlog_async_n_text, 1,
+							  memory_order_relaxed);
+			zlog_async_rec(ring, rec);
+		}
+		atomic_store_explicit(&ring->tail, tail, memory_order_seq_cst);
+
+		drops = atomic_load_explicit(&ring->drops,
+					     memory_order_relaxed);
+		if (drops != ring->drops_seen) {
+			atomic_fetch_add_explicit(&zlog_async_n_drops,
+						  drops - ring->drops_seen,
+						  memory_order_relaxed);
+			zlog_async_drops(ring, drops - ring->drops_seen);
+			ring->drops_seen = drops;
+			progress = true;
+		}
+
+		if (dead) {
+			zlog_rings_del(&zlog_rings, ring);
+			XFREE(MTYPE_LOG_RING, ring);
+			progress = true;
+		}
+	}
+
+	zlog_async_flush();
+	return progress;
+}
+
+static void *zlog_async_main(void *arg)
+{
+	struct rcu_thread *rcu_thread = arg;
+	seqlock_val_t val;
+
+	rcu_thread_start(rcu_thread);
+	rcu_read_unlock();
+
+	for (;;) {
+		val = seqlock_cur(&zlog_async_seq);
+		if (zlog_async_drain())
+			continue;
+		if (atomic_load_explicit(&zlog_async_stop,
+					 memory_order_acquire))
+			break;
+		seqlock_wait(&zlog_async_seq, val);
+	}
+	return NULL;
+}
+
+static void zlog_async_start(void)
+{
+	struct rcu_thread *rcu_thread;
+	sigset_t oldsigs, blocksigs;
+
+	seqlock_init(&zlog_async_seq);
+	seqlock_acquire_val(&zlog_async_seq, SEQLOCK_STARTVAL);
+	atomic_store_explicit(&zlog_async_stop, false, memory_order_relaxed);
+
+	/* signals are handled on the main thread only */
+	sigfillset(&blocksigs);
+	pthread_sigmask(SIG_BLOCK, &blocksigs, &oldsigs);
+
+	rcu_thread = rcu_thread_prepare();
+	pthread_mutex_lock(&zlog_async_mtx);
+	if (pthread_create(&zlog_async_pthread, NULL, zlog_async_main,
+			   rcu_thread)) {
+		pthread_mutex_unlock(&zlog_async_mtx);
+		rcu_thread_unprepare(rcu_thread);
+		pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+		zlog_err("failed to start log pthread: %s", strerror(errno));
+		return;
+	}
+	zlog_async_running = true;
+	pthread_mutex_unlock(&zlog_async_mtx);
+
+	pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+
+#ifdef HAVE_PTHREAD_SETNAME_NP
+# ifdef GNU_LINUX
+	pthread_setname_np(zlog_async_pthread, "log writer");
+# elif defined(__NetBSD__)
+	pthread_setname_np(zlog_async_pthread, "log writer", NULL);
+# endif
+#elif defined(HAVE_PTHREAD_SET_NAME_NP)
+	pthread_set_name_np(zlog_async_pthread, "log writer");
+#endif
+}
+
+static void zlog_async_fini(void)
+{
+	struct zlog_ring *ring;
+
+	if (!zlog_async_running)
+		return;
+
+	atomic_store_explicit(&zlog_async_on, false, memory_order_relaxed);
+	atomic_store_explicit(&zlog_async_stop, true, memory_order_release);
+	seqlock_bump(&zlog_async_seq);
+	pthread_join(zlog_async_pthread, NULL);
+
+	/* The log pthread emptied all rings on its way out.  Rings of
+	 * pthreads that are still alive stay in place, their owners may
+	 * keep pushing to them if async output is enabled again, and free
+	 * them on exit.
+	 */
+	pthread_mutex_lock(&zlog_async_mtx);
+	zlog_async_running = false;
+
+	frr_each_safe (zlog_rings, &zlog_rings, ring) {
+		if (!atomic_load_explicit(&ring->dead, memory_order_acquire)
+		    && ring != pthread_getspecific(zlog_ring_key))
+			continue;
+		zlog_rings_del(&zlog_rings, ring);
+		XFREE(MTYPE_LOG_RING, ring);
+	}
+	pthread_setspecific(zlog_ring_key, NULL);
+	pthread_mutex_unlock(&zlog_async_mtx);
+
+	seqlock_release(&zlog_async_seq);
+}
+
 void vzlogx(const struct xref_logmsg *xref, int prio,
 	    const char *fmt, va_list ap)
 {
@@ -541,6 +1605,11 @@ void vzlogx(const struct xref_logmsg *xref, int prio,
 	XFREE(MTYPE_LOG_MESSAGE, msg);
 #endif
 
+	if (atomic_load_explicit(&zlog_async_on, memory_order_relaxed)
+	    && (prio & LOG_PRIMASK) > LOG_CRIT
+	    && vzlog_async(xref, prio, fmt, ap))
+		return;
+
 	if (zlog_tls)
 		vzlog_tls(zlog_tls, xref, prio, fmt, ap);
 	else
@@ -617,7 +1686,6 @@ const char *zlog_msg_text(struct zlog_msg *msg, size_t *textlen)
 {
 	if (!msg->text) {
 		va_list args;
-		bool do_xid, do_ec;
 		size_t need = 0, hdrlen;
 		struct fbuf fb = {
 			.buf = msg->stackbuf,
@@ -625,18 +1693,7 @@ const char *zlog_msg_text(struct zlog_msg *msg, size_t *textlen)
 			.len = msg->stackbufsz,
 		};
 
-		do_ec = atomic_load_explicit(&zlog_ec, memory_order_relaxed);
-		do_xid = atomic_load_explicit(&zlog_xid, memory_order_relaxed);
-
-		if (msg->xref && do_xid && msg->xref->xref.xrefdata->uid[0]) {
-			need += bputch(&fb, '[');
-			need += bputs(&fb, msg->xref->xref.xrefdata->uid);
-			need += bputch(&fb, ']');
-		}
-		if (msg->xref && do_ec && msg->xref->ec)
-			need += bprintfrr(&fb, "[EC %u]", msg->xref->ec);
-		if (need)
-			need += bputch(&fb, ' ');
+		need = zlog_msg_hdr(msg, &fb);
 
 		msg->hdrlen = hdrlen = need;
 		assert(hdrlen < msg->stackbufsz);
@@ -867,6 +1924,34 @@ void zlog_set_immediate(bool set_p)
 	default_immediate = set_p;
 }
 
+/* Enable or disable asynchronous output through the log pthread, which is
+ * started on first use and keeps running until zlog_fini().
+ */
+void zlog_set_async(bool enable)
+{
+	if (enable && !zlog_async_running)
+		zlog_async_start();
+	if (enable && !zlog_async_running)
+		return;
+
+	atomic_store_explicit(&zlog_async_on, enable, memory_order_relaxed);
+}
+
+bool zlog_get_async(void)
+{
+	return atomic_load_explicit(&zlog_async_on, memory_order_relaxed);
+}
+
+void zlog_async_stats(struct zlog_async_stats *stats)
+{
+	stats->n_args = atomic_load_explicit(&zlog_async_n_args,
+					     memory_order_relaxed);
+	stats->n_text = atomic_load_explicit(&zlog_async_n_text,
+					     memory_order_relaxed);
+	stats->n_drops = atomic_load_explicit(&zlog_async_n_drops,
+					      memory_order_relaxed);
+}
+
 /* common init */
 
 #define TMPBASEDIR "/var/tmp/frr"
@@ -948,6 +2033,7 @@ out_warn:
 
 void zlog_fini(void)
 {
+	zlog_async_fini();
 	hook_call(zlog_fini);
 
 	if (zlog_tmpdirfd >= 0) {
@@ -277,6 +277,22 @@ extern void zlog_tls_buffer_fini(void);
 /* Enable or disable 'immediate' output - default is to buffer messages. */
 extern void zlog_set_immediate(bool set_p);
 
+/* Asynchronous output - messages are formatted and written on a separate
+ * log pthread;  the calling thread only queues up a copy of the arguments.
+ * Messages are dropped (and counted) if the queue is full.
+ */
+extern void zlog_set_async(bool enable);
+extern bool zlog_get_async(void);
+
+struct zlog_async_stats {
+	/* queued as arguments / as text formatted on the calling thread */
+	size_t n_args;
+	size_t n_text;
+	size_t n_drops;
+};
+
+extern void zlog_async_stats(struct zlog_async_stats *stats);
+
 extern const char *zlog_priority_str(int priority);
 
 #ifdef __cplusplus
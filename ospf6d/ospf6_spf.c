@@ -109,11 +109,125 @@ static int ospf6_vertex_id_cmp(void *a, void *b)
 	return ret;
 }
 
+/*
+ * SPF vertices are carved out of chunks and recycled through per-chunk free
+ * lists, keeping their nexthop and child lists allocated. The chunks are
+ * shared by all areas and instances; a chunk is released as soon as none of
+ * its vertices are in use, except that one empty chunk is kept while any
+ * vertex is still allocated.
+ */
+#define OSPF6_VERTEX_CHUNK_SIZE 256
+
+PREDECL_DLIST(ospf6_vertex_chunks);
+
+struct ospf6_vertex_slot {
+	struct ospf6_vertex_chunk *chunk;
+	struct ospf6_vertex vertex;
+};
+
+struct ospf6_vertex_chunk {
+	struct ospf6_vertex_chunks_item item;
+	/* Linked through the parent pointer. */
+	struct ospf6_vertex *free_list;
+	unsigned int used; /* slots carved out so far */
+	unsigned int live; /* vertices currently allocated */
+	struct ospf6_vertex_slot slots[OSPF6_VERTEX_CHUNK_SIZE];
+};
+
+DECLARE_DLIST(ospf6_vertex_chunks, struct ospf6_vertex_chunk, item);
+
+static struct {
+	/* chunks with free vertices */
+	struct ospf6_vertex_chunks_head avail;
+	unsigned long count;
+} vertex_arena = {
+	.avail = INIT_DLIST(vertex_arena.avail),
+};
+
+static void ospf6_vertex_chunk_free(struct ospf6_vertex_chunk *chunk)
+{
+	for (unsigned int i = 0; i < chunk->used; i++) {
+		list_delete(&chunk->slots[i].vertex.nh_list);
+		list_delete(&chunk->slots[i].vertex.child_list);
+	}
+	XFREE(MTYPE_OSPF6_VERTEX, chunk);
+}
+
+static struct ospf6_vertex *ospf6_vertex_alloc(void)
+{
+	struct ospf6_vertex_chunk *chunk;
+	struct ospf6_vertex_slot *slot;
+	struct ospf6_vertex *v;
+	struct list *nh_list, *child_list;
+
+	chunk = ospf6_vertex_chunks_first(&vertex_arena.avail);
+	if (!chunk) {
+		chunk = XMALLOC(MTYPE_OSPF6_VERTEX, sizeof(*chunk));
+		chunk->free_list = NULL;
+		chunk->used = 0;
+		chunk->live = 0;
+		ospf6_vertex_chunks_add_head(&vertex_arena.avail, chunk);
+	}
+
+	if (chunk->free_list) {
+		v = chunk->free_list;
+		chunk->free_list = v->parent;
+		nh_list = v->nh_list;
+		child_list = v->child_list;
+	} else {
+		slot = &chunk->slots[chunk->used++];
+		slot->chunk = chunk;
+		v = &slot->vertex;
+
+		nh_list = list_new();
+		nh_list->cmp = (int (*)(void *, void *))ospf6_nexthop_cmp;
+		nh_list->del = (void (*)(void *))ospf6_nexthop_delete;
+		child_list = list_new();
+		child_list->cmp = ospf6_vertex_id_cmp;
+	}
+
+	if (++chunk->live == OSPF6_VERTEX_CHUNK_SIZE)
+		ospf6_vertex_chunks_del(&vertex_arena.avail, chunk);
+	vertex_arena.count++;
+
+	memset(v, 0, sizeof(*v));
+	v->nh_list = nh_list;
+	v->child_list = child_list;
+
+	return v;
+}
+
+static void ospf6_vertex_delete(struct ospf6_vertex *v)
+{
+	struct ospf6_vertex_chunk *chunk;
+
+	list_delete_all_node(v->nh_list);
+	list_delete_all_node(v->child_list);
+
+	chunk = container_of(v, struct ospf6_vertex_slot, vertex)->chunk;
+
+	assert(vertex_arena.count && chunk->live);
+	if (chunk->live-- == OSPF6_VERTEX_CHUNK_SIZE)
+		ospf6_vertex_chunks_add_head(&vertex_arena.avail, chunk);
+	v->parent = chunk->free_list;
+	chunk->free_list = v;
+	vertex_arena.count--;
+
+	if (vertex_arena.count == 0) {
+		while ((chunk = ospf6_vertex_chunks_pop(&vertex_arena.avail)))
+			ospf6_vertex_chunk_free(chunk);
+	} else if (chunk->live == 0
+		   && ospf6_vertex_chunks_count(&vertex_arena.avail) > 1) {
+		ospf6_vertex_chunks_del(&vertex_arena.avail, chunk);
+		ospf6_vertex_chunk_free(chunk);
+	}
+}
+
 static struct ospf6_vertex *ospf6_vertex_create(struct ospf6_lsa *lsa)
 {
 	struct ospf6_vertex *v;
 
-	v = XMALLOC(MTYPE_OSPF6_VERTEX, sizeof(struct ospf6_vertex));
+	v = ospf6_vertex_alloc();
 
 	/* type */
 	if (ntohs(lsa->header->type) == OSPF6_LSTYPE_ROUTER) {
@@ -150,24 +264,9 @@ static struct ospf6_vertex *ospf6_vertex_create(struct ospf6_lsa *lsa)
 	v->options[1] = *(uint8_t *)(OSPF6_LSA_HEADER_END(lsa->header) + 2);
 	v->options[2] = *(uint8_t *)(OSPF6_LSA_HEADER_END(lsa->header) + 3);
 
-	v->nh_list = list_new();
-	v->nh_list->cmp = (int (*)(void *, void *))ospf6_nexthop_cmp;
-	v->nh_list->del = (void (*)(void *))ospf6_nexthop_delete;
-
-	v->parent = NULL;
-	v->child_list = list_new();
-	v->child_list->cmp = ospf6_vertex_id_cmp;
-
 	return v;
 }
 
-static void ospf6_vertex_delete(struct ospf6_vertex *v)
-{
-	list_delete(&v->nh_list);
-	list_delete(&v->child_list);
-	XFREE(MTYPE_OSPF6_VERTEX, v);
-}
-
 static struct ospf6_lsa *ospf6_lsdesc_lsa(caddr_t lsdesc,
 					  struct ospf6_vertex *v)
 {
@@ -486,6 +585,9 @@ void ospf6_spf_calculation(uint32_t router_id,
 	caddr_t lsdesc;
 	struct ospf6_lsa *lsa;
 	struct in6_addr address;
+	struct prefix vertex_id;
+	struct ospf6_route *route;
+	uint32_t cost;
 
 	ospf6_spf_table_finish(result_table);
 
@@ -536,21 +638,36 @@ void ospf6_spf_calculation(uint32_t router_id,
 			if (OSPF6_LSA_IS_MAXAGE(lsa))
 				continue;
 
+			/*
+			 * Don't bother checking the backlink and creating a
+			 * candidate if the vertex is already part of the tree
+			 * with a lower cost, it would be rejected anyway.
+			 */
+			cost = v->cost;
+			if (VERTEX_IS_TYPE(ROUTER, v))
+				cost += ROUTER_LSDESC_GET_METRIC(lsdesc);
+			ospf6_linkstate_prefix(lsa->header->adv_router,
+					       OSPF6_LSA_IS_TYPE(ROUTER, lsa)
+						       ? htonl(0)
+						       : lsa->header->id,
+					       &vertex_id);
+			route = ospf6_route_lookup(&vertex_id, result_table);
+			if (route && route->path.cost < cost)
+				continue;
+
 			if (!ospf6_lsdesc_backlink(lsa, lsdesc, v))
 				continue;
 
 			w = ospf6_vertex_create(lsa);
 			w->area = oa;
 			w->parent = v;
+			w->cost = cost;
 			if (VERTEX_IS_TYPE(ROUTER, v)) {
-				w->cost = v->cost
-					  + ROUTER_LSDESC_GET_METRIC(lsdesc);
 				w->hops =
 					v->hops
 					+ (VERTEX_IS_TYPE(NETWORK, w) ? 0 : 1);
 			} else {
 				/* NETWORK */
-				w->cost = v->cost;
 				w->hops = v->hops + 1;
 			}
 
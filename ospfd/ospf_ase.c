@@ -639,6 +639,61 @@ void ospf_ase_calculate_timer_add(struct ospf *ospf)
 			 OSPF_ASE_CALC_INTERVAL, &ospf->t_ase_calc);
 }
 
+/*
+ * Besides external_lsas, external LSAs are indexed by advertising router and
+ * by forwarding address, so that the partial route calculation can find the
+ * external routes that a changed inter-area route affects, see
+ * ospf_ase_prc().
+ */
+static void ospf_ase_index_add(struct route_table *rt, struct in_addr addr,
+			       struct ospf_lsa *lsa)
+{
+	struct route_node *rn;
+	struct prefix_ipv4 p;
+	struct list *lst;
+
+	p.family = AF_INET;
+	p.prefix = addr;
+	p.prefixlen = IPV4_MAX_BITLEN;
+
+	rn = route_node_get(rt, (struct prefix *)&p);
+	if ((lst = rn->info) == NULL)
+		rn->info = lst = list_new();
+	else
+		route_unlock_node(rn);
+
+	listnode_add(lst, ospf_lsa_lock(lsa)); /* external LSA index */
+}
+
+static void ospf_ase_index_del(struct route_table *rt, struct in_addr addr,
+			       struct ospf_lsa *lsa)
+{
+	struct route_node *rn;
+	struct prefix_ipv4 p;
+	struct list *lst;
+
+	p.family = AF_INET;
+	p.prefix = addr;
+	p.prefixlen = IPV4_MAX_BITLEN;
+
+	rn = route_node_lookup(rt, (struct prefix *)&p);
+	if (!rn)
+		return;
+
+	lst = rn->info;
+	if (listnode_lookup(lst, lsa)) {
+		listnode_delete(lst, lsa);
+		ospf_lsa_unlock(&lsa); /* external LSA index */
+	}
+
+	if (list_isempty(lst)) {
+		list_delete(&lst);
+		rn->info = NULL;
+		route_unlock_node(rn);
+	}
+	route_unlock_node(rn);
+}
+
 void ospf_ase_register_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
 {
 	struct route_node *rn;
@@ -661,6 +716,12 @@ void ospf_ase_register_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
 	/* We assume that if LSA is deleted from DB
 	   is is also deleted from this RT */
 	listnode_add(lst, ospf_lsa_lock(lsa)); /* external_lsas lst */
+
+	ospf_ase_index_add(top->external_lsas_by_asbr, lsa->data->adv_router,
+			   lsa);
+	if (al->e[0].fwd_addr.s_addr != INADDR_ANY)
+		ospf_ase_index_add(top->external_lsas_by_fwd,
+				   al->e[0].fwd_addr, lsa);
 }
 
 void ospf_ase_unregister_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
@@ -676,6 +737,12 @@ void ospf_ase_unregister_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
 	p.prefixlen = ip_masklen(al->mask);
 	apply_mask_ipv4(&p);
 
+	ospf_ase_index_del(top->external_lsas_by_asbr, lsa->data->adv_router,
+			   lsa);
+	if (al->e[0].fwd_addr.s_addr != INADDR_ANY)
+		ospf_ase_index_del(top->external_lsas_by_fwd,
+				   al->e[0].fwd_addr, lsa);
+
 	rn = route_node_lookup(top->external_lsas, (struct prefix *)&p);
 
 	if (rn) {
@@ -708,38 +775,27 @@ void ospf_ase_external_lsas_finish(struct route_table *rt)
 	route_table_finish(rt);
 }
 
-void ospf_ase_incremental_update(struct ospf *ospf, struct ospf_lsa *lsa)
+/* Recalculate the external route to one destination and install it. */
+static void ospf_ase_prefix_update(struct ospf *ospf, struct prefix_ipv4 *p)
 {
 	struct list *lsas;
 	struct listnode *node;
 	struct route_node *rn, *rn2;
-	struct prefix_ipv4 p;
 	struct route_table *tmp_old;
-	struct as_external_lsa *al;
-
-	al = (struct as_external_lsa *)lsa->data;
-	p.family = AF_INET;
-	p.prefix = lsa->data->id;
-	p.prefixlen = ip_masklen(al->mask);
-	apply_mask_ipv4(&p);
-
-	/* if new_table is NULL, there was no spf calculation, thus
-	   incremental update is unneeded */
-	if (!ospf->new_table)
-		return;
+	struct ospf_lsa *lsa;
 
 	/* If there is already an intra-area or inter-area route
 	   to the destination, no recalculation is necessary
 	   (internal routes take precedence). */
 
-	rn = route_node_lookup(ospf->new_table, (struct prefix *)&p);
+	rn = route_node_lookup(ospf->new_table, (struct prefix *)p);
 	if (rn) {
 		route_unlock_node(rn);
 		if (rn->info)
 			return;
 	}
 
-	rn = route_node_lookup(ospf->external_lsas, (struct prefix *)&p);
+	rn = route_node_lookup(ospf->external_lsas, (struct prefix *)p);
 	assert(rn);
 	assert(rn->info);
 	lsas = rn->info;
@@ -750,9 +806,9 @@ void ospf_ase_incremental_update(struct ospf *ospf, struct ospf_lsa *lsa)
 
 	/* prepare temporary old routing table for compare */
 	tmp_old = route_table_init();
-	rn = route_node_lookup(ospf->old_external_route, (struct prefix *)&p);
+	rn = route_node_lookup(ospf->old_external_route, (struct prefix *)p);
 	if (rn && rn->info) {
-		rn2 = route_node_get(tmp_old, (struct prefix *)&p);
+		rn2 = route_node_get(tmp_old, (struct prefix *)p);
 		rn2->info = rn->info;
 		route_unlock_node(rn);
 	}
@@ -764,12 +820,12 @@ void ospf_ase_incremental_update(struct ospf *ospf, struct ospf_lsa *lsa)
 	if (rn && rn->info)
 		ospf_route_free((struct ospf_route *)rn->info);
 
-	rn2 = route_node_lookup(ospf->new_external_route, (struct prefix *)&p);
+	rn2 = route_node_lookup(ospf->new_external_route, (struct prefix *)p);
 	/* if new route exists, install it to ospf->old_external_route */
 	if (rn2 && rn2->info) {
 		if (!rn)
 			rn = route_node_get(ospf->old_external_route,
-					    (struct prefix *)&p);
+					    (struct prefix *)p);
 		rn->info = rn2->info;
 	} else {
 		/* remove route node from ospf->old_external_route */
@@ -789,3 +845,127 @@ void ospf_ase_incremental_update(struct ospf *ospf, struct ospf_lsa *lsa)
 
 	route_table_finish(tmp_old);
 }
+
+void ospf_ase_incremental_update(struct ospf *ospf, struct ospf_lsa *lsa)
+{
+	struct prefix_ipv4 p;
+	struct as_external_lsa *al;
+
+	al = (struct as_external_lsa *)lsa->data;
+	p.family = AF_INET;
+	p.prefix = lsa->data->id;
+	p.prefixlen = ip_masklen(al->mask);
+	apply_mask_ipv4(&p);
+
+	/* if new_table is NULL, there was no spf calculation, thus
+	   incremental update is unneeded */
+	if (!ospf->new_table)
+		return;
+
+	ospf_ase_prefix_update(ospf, &p);
+}
+
+/* Record the destinations of a list of external LSAs in affected. */
+static void ospf_ase_prc_mark(struct route_table *affected, struct list *lsas)
+{
+	struct listnode *node;
+	struct ospf_lsa *lsa;
+	struct as_external_lsa *al;
+	struct route_node *rn;
+	struct prefix_ipv4 p;
+
+	for (ALL_LIST_ELEMENTS_RO(lsas, node, lsa)) {
+		al = (struct as_external_lsa *)lsa->data;
+		p.family = AF_INET;
+		p.prefix = lsa->data->id;
+		p.prefixlen = ip_masklen(al->mask);
+		apply_mask_ipv4(&p);
+
+		rn = route_node_get(affected, (struct prefix *)&p);
+		if (rn->info)
+			route_unlock_node(rn);
+		else
+			rn->info = lsa;
+	}
+}
+
+/*
+ * Partial route calculation after summary-LSA changes: recalculate only the
+ * external routes that the changed inter-area routes can affect, i.e. those
+ * to a changed destination, through a changed ASBR route, or with a
+ * forwarding address inside a changed destination. The latter two are
+ * looked up in the external LSA indexes.
+ */
+void ospf_ase_prc(struct ospf *ospf, struct route_table *networks,
+		  struct route_table *asbrs)
+{
+	struct route_table *affected;
+	struct route_node *rn, *arn;
+
+	affected = route_table_init();
+
+	for (rn = route_top(networks); rn; rn = route_next(rn)) {
+		if (!rn->info)
+			continue;
+
+		/*
+		 * The inter-area route change has replaced or removed the
+		 * route in zebra, forget about the external one it shadowed.
+		 */
+		arn = route_node_lookup(ospf->old_external_route, &rn->p);
+		if (arn) {
+			ospf_route_free(arn->info);
+			arn->info = NULL;
+			route_unlock_node(arn);
+			route_unlock_node(arn);
+		}
+
+		arn = route_node_lookup(ospf->external_lsas, &rn->p);
+		if (arn) {
+			route_unlock_node(arn);
+			arn = route_node_get(affected, &rn->p);
+			if (arn->info)
+				route_unlock_node(arn);
+			else
+				arn->info = rn->info;
+		}
+
+		/* forwarding addresses inside the destination */
+		arn = route_node_lookup(ospf->external_lsas_by_fwd, &rn->p);
+		if (arn) {
+			ospf_ase_prc_mark(affected, arn->info);
+			route_unlock_node(arn);
+		}
+		for (arn = route_table_get_next(ospf->external_lsas_by_fwd,
+						&rn->p);
+		     arn && prefix_match(&rn->p, &arn->p);
+		     arn = route_next(arn))
+			if (arn->info)
+				ospf_ase_prc_mark(affected, arn->info);
+		if (arn)
+			route_unlock_node(arn);
+	}
+
+	for (rn = route_top(asbrs); rn; rn = route_next(rn)) {
+		if (!rn->info)
+			continue;
+
+		arn = route_node_lookup(ospf->external_lsas_by_asbr, &rn->p);
+		if (arn) {
+			ospf_ase_prc_mark(affected, arn->info);
+			route_unlock_node(arn);
+		}
+	}
+
+	for (rn = route_top(affected); rn; rn = route_next(rn)) {
+		if (!rn->info)
+			continue;
+
+		rn->info = NULL;
+		route_unlock_node(rn);
+
+		ospf_ase_prefix_update(ospf, (struct prefix_ipv4 *)&rn->p);
+	}
+
+	route_table_finish(affected);
+}
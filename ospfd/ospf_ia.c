@@ -44,6 +44,7 @@
 #include "ospfd/ospf_abr.h"
 #include "ospfd/ospf_ia.h"
 #include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_zebra.h"
 
 static struct ospf_route *ospf_find_abr_route(struct route_table *rtrs,
 					      struct prefix_ipv4 *abr,
@@ -284,6 +285,190 @@ static void ospf_examine_summaries(struct ospf_area *area,
 		process_summary_lsa(area, rt, rtrs, lsa);
 }
 
+/*
+ * Partial route calculation for a destination whose summary-LSAs changed,
+ * see RFC 2328 16.5: recompute the inter-area route to network p against the
+ * current routing table and install the difference. Only valid when the
+ * router is not an ABR, in which case all areas' summaries are considered.
+ * Returns true if the route changed.
+ */
+bool ospf_ia_network_prc(struct ospf *ospf, struct prefix_ipv4 *p)
+{
+	struct route_table *rt;
+	struct route_node *rn;
+	struct ospf_route *or = NULL, *new_or = NULL;
+	struct ospf_area *area;
+	struct listnode *node;
+	struct ospf_lsa *lsa;
+	struct summary_lsa *sl;
+
+	rn = route_node_lookup(ospf->new_table, (struct prefix *)p);
+	if (rn) {
+		route_unlock_node(rn);
+		or = rn->info;
+	}
+
+	/* Intra-area paths are always preferred over inter-area ones. */
+	if (or && (or->type != OSPF_DESTINATION_NETWORK
+		   || or->path_type != OSPF_PATH_INTER_AREA))
+		return false;
+
+	rt = route_table_init();
+
+	for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area))
+		for (lsa = ospf_lsdb_lookup_by_id_range(
+			     area->lsdb, OSPF_SUMMARY_LSA, p->prefix,
+			     p->prefixlen, NULL);
+		     lsa;
+		     lsa = ospf_lsdb_lookup_by_id_range(
+			     area->lsdb, OSPF_SUMMARY_LSA, p->prefix,
+			     p->prefixlen, lsa)) {
+			sl = (struct summary_lsa *)lsa->data;
+			if (ip_masklen(sl->mask) == p->prefixlen)
+				process_summary_lsa(area, rt, ospf->new_rtrs,
+						    lsa);
+		}
+
+	rn = route_node_lookup(rt, (struct prefix *)p);
+	if (rn) {
+		new_or = rn->info;
+		rn->info = NULL;
+		route_unlock_node(rn);
+		route_unlock_node(rn);
+	}
+	route_table_finish(rt);
+
+	if (new_or) {
+		if (ospf_route_match_same(ospf->new_table, p, new_or)) {
+			ospf_route_free(new_or);
+			return false;
+		}
+
+		ospf_zebra_add(ospf, p, new_or);
+
+		rn = route_node_get(ospf->new_table, (struct prefix *)p);
+		if (rn->info) {
+			ospf_route_free(rn->info);
+			route_unlock_node(rn);
+		}
+		rn->info = new_or;
+	} else if (or) {
+		ospf_zebra_delete(ospf, p, or);
+
+		rn = route_node_lookup(ospf->new_table, (struct prefix *)p);
+		ospf_route_free(or);
+		rn->info = NULL;
+		route_unlock_node(rn);
+		route_unlock_node(rn);
+	} else
+		return false;
+
+	return true;
+}
+
+/* Whether two routes to a router have the same cost, area and paths. */
+static bool ospf_ia_router_route_same(struct ospf_route *or1,
+				      struct ospf_route *or2)
+{
+	struct listnode *n1, *n2;
+	struct ospf_path *op1, *op2;
+
+	if (or1->path_type != or2->path_type || or1->cost != or2->cost
+	    || or1->u.std.flags != or2->u.std.flags
+	    || !IPV4_ADDR_SAME(&or1->u.std.area_id, &or2->u.std.area_id)
+	    || listcount(or1->paths) != listcount(or2->paths))
+		return false;
+
+	for (n1 = listhead(or1->paths), n2 = listhead(or2->paths); n1 && n2;
+	     n1 = listnextnode_unchecked(n1), n2 = listnextnode_unchecked(n2)) {
+		op1 = listgetdata(n1);
+		op2 = listgetdata(n2);
+
+		if (!IPV4_ADDR_SAME(&op1->nexthop, &op2->nexthop)
+		    || op1->ifindex != op2->ifindex)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * As ospf_ia_network_prc() for the inter-area routes to an ASBR, which are
+ * kept in the current ABR/ASBR routing table. Returns true if the inter-area
+ * routes to the router changed.
+ */
+bool ospf_ia_router_prc(struct ospf *ospf, struct prefix_ipv4 *asbr)
+{
+	struct route_node *rn;
+	struct ospf_route *or, *old_or;
+	struct ospf_area *area;
+	struct listnode *node, *nnode, *onode;
+	struct ospf_lsa *lsa;
+	struct list *old, *routes;
+	unsigned int count = 0;
+	bool changed = false;
+
+	/* Set the current inter-area routes aside to compare against. */
+	old = list_new();
+
+	rn = route_node_lookup(ospf->new_rtrs, (struct prefix *)asbr);
+	if (rn) {
+		route_unlock_node(rn);
+
+		for (ALL_LIST_ELEMENTS((struct list *)rn->info, node, nnode,
+				       or))
+			if (or->path_type == OSPF_PATH_INTER_AREA) {
+				list_delete_node(rn->info, node);
+				listnode_add(old, or);
+			}
+	}
+
+	for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area))
+		for (lsa = ospf_lsdb_lookup_by_id_range(
+			     area->lsdb, OSPF_ASBR_SUMMARY_LSA, asbr->prefix,
+			     IPV4_MAX_BITLEN, NULL);
+		     lsa;
+		     lsa = ospf_lsdb_lookup_by_id_range(
+			     area->lsdb, OSPF_ASBR_SUMMARY_LSA, asbr->prefix,
+			     IPV4_MAX_BITLEN, lsa))
+			process_summary_lsa(area, ospf->new_table,
+					    ospf->new_rtrs, lsa);
+
+	rn = route_node_lookup(ospf->new_rtrs, (struct prefix *)asbr);
+	if (rn) {
+		route_unlock_node(rn);
+
+		for (ALL_LIST_ELEMENTS_RO((struct list *)rn->info, node, or)) {
+			if (or->path_type != OSPF_PATH_INTER_AREA)
+				continue;
+
+			count++;
+			for (ALL_LIST_ELEMENTS_RO(old, onode, old_or))
+				if (ospf_ia_router_route_same(or, old_or))
+					break;
+			if (!onode)
+				changed = true;
+		}
+
+		/* No route at all is left to the router. */
+		routes = rn->info;
+		if (list_isempty(routes)) {
+			list_delete(&routes);
+			rn->info = NULL;
+			route_unlock_node(rn);
+		}
+	}
+
+	if (count != listcount(old))
+		changed = true;
+
+	for (ALL_LIST_ELEMENTS_RO(old, node, or))
+		ospf_route_free(or);
+	list_delete(&old);
+
+	return changed;
+}
+
 int ospf_area_is_transit(struct ospf_area *area)
 {
 	return (area->transit == OSPF_TRANSIT_TRUE)
@@ -40,5 +40,7 @@
 extern void ospf_ia_routing(struct ospf *, struct route_table *,
 			    struct route_table *);
 extern int ospf_area_is_transit(struct ospf_area *);
+extern bool ospf_ia_network_prc(struct ospf *ospf, struct prefix_ipv4 *p);
+extern bool ospf_ia_router_prc(struct ospf *ospf, struct prefix_ipv4 *asbr);
 
 #endif /* _ZEBRA_OSPF_IA_H */
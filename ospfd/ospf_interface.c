@@ -26,6 +26,7 @@
 #include "prefix.h"
 #include "if.h"
 #include "table.h"
+#include "hash.h"
 #include "memory.h"
 #include "command.h"
 #include "stream.h"
@@ -270,6 +271,7 @@ struct ospf_interface *ospf_if_new(struct ospf *ospf, struct interface *ifp,
 	oi->nbr_self = NULL;
 
 	oi->ls_upd_queue = route_table_init();
+	oi->ls_upd_index = ospf_ls_upd_index_new();
 	oi->t_ls_upd_event = NULL;
 	oi->t_ls_ack_direct = NULL;
 
@@ -351,6 +353,7 @@ void ospf_if_free(struct ospf_interface *oi)
 
 	route_table_finish(oi->nbrs);
 	route_table_finish(oi->ls_upd_queue);
+	hash_free(oi->ls_upd_index);
 
 	/* Free any lists that should be freed */
 	list_delete(&oi->nbr_nbma);
@@ -230,7 +230,14 @@ struct ospf_interface {
 	struct ospf_lsa *network_lsa_self; /* network-LSA. */
 	struct list *opaque_lsa_self;      /* Type-9 Opaque-LSAs */
 
+	/* Pending LS Updates, destination -> FIFO list of LSAs. */
 	struct route_table *ls_upd_queue;
+	/* LSAs queued in ls_upd_queue, by destination and LSA key. */
+	struct hash *ls_upd_index;
+
+	/* LS Update pacing token bucket, see ospf->flood_pacing_rate. */
+	uint32_t ls_upd_tokens;
+	struct timeval ls_upd_token_time;
 
 	struct list *ls_ack; /* Link State Acknowledgment list. */
 
@@ -2523,6 +2523,7 @@ ospf_summary_lsa_install(struct ospf *ospf, struct ospf_lsa *new, int rt_recalc)
    necessary to re-examine all the AS-external-LSAs.
 */
 
+		ospf_spf_prc_add_lsa(ospf, new);
 		ospf_spf_calculate_schedule(ospf, SPF_FLAG_SUMMARY_LSA_INSTALL);
 	}
 
@@ -2544,6 +2545,7 @@ static struct ospf_lsa *ospf_summary_asbr_lsa_install(struct ospf *ospf,
    destination is an AS boundary router, it may also be
    necessary to re-examine all the AS-external-LSAs.
 */
+		ospf_spf_prc_add_lsa(ospf, new);
 		ospf_spf_calculate_schedule(ospf,
 					    SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL);
 	}
@@ -2743,8 +2745,14 @@ struct ospf_lsa *ospf_lsa_install(struct ospf *ospf, struct ospf_interface *oi,
 	}
 
 	/* discard old LSA from LSDB */
-	if (old != NULL)
+	if (old != NULL) {
+		/* The previous instance may have described another mask. */
+		if (rt_recalc && old->data->type == OSPF_SUMMARY_LSA
+		    && !IS_LSA_SELF(old))
+			ospf_spf_prc_add_lsa(ospf, old);
+
 		ospf_discard_from_db(ospf, lsdb, lsa);
+	}
 
 	/* Calculate Checksum if self-originated?. */
 	if (IS_LSA_SELF(lsa))
@@ -3087,6 +3095,16 @@ static int ospf_lsa_maxage_walker_remover(struct ospf *ospf,
 			case OSPF_AS_NSSA_LSA:
 				ospf_ase_incremental_update(ospf, lsa);
 				break;
+			case OSPF_SUMMARY_LSA:
+				ospf_spf_prc_add_lsa(ospf, lsa);
+				ospf_spf_calculate_schedule(
+					ospf, SPF_FLAG_SUMMARY_LSA_INSTALL);
+				break;
+			case OSPF_ASBR_SUMMARY_LSA:
+				ospf_spf_prc_add_lsa(ospf, lsa);
+				ospf_spf_calculate_schedule(
+					ospf, SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL);
+				break;
 			default:
 				ospf_spf_calculate_schedule(ospf,
 							    SPF_FLAG_MAXAGE);
@@ -252,6 +252,50 @@ struct ospf_lsa *ospf_lsdb_lookup_by_id_next(struct ospf_lsdb *lsdb,
 	return NULL;
 }
 
+/*
+ * Walk the LSAs of a type whose Link State ID falls within id/masklen, e.g.
+ * all summary-LSAs advertised for one destination (id must be the network
+ * address). Pass the previous result to get the next LSA, NULL to start.
+ */
+struct ospf_lsa *ospf_lsdb_lookup_by_id_range(struct ospf_lsdb *lsdb,
+					      uint8_t type, struct in_addr id,
+					      uint8_t masklen,
+					      struct ospf_lsa *prev)
+{
+	struct route_table *table;
+	struct prefix_ls range, lp;
+	struct route_node *rn;
+	struct ospf_lsa *find;
+
+	table = lsdb->type[type].db;
+
+	memset(&range, 0, sizeof(struct prefix_ls));
+	range.family = 0;
+	range.prefixlen = masklen;
+	range.id = id;
+
+	if (prev)
+		ls_prefix_set(&lp, prev);
+	else
+		lp = range;
+
+	for (rn = route_table_get_next(table, (struct prefix *)&lp); rn;
+	     rn = route_next(rn)) {
+		if (!prefix_match((struct prefix *)&range, &rn->p))
+			break;
+
+		if (rn->info) {
+			find = rn->info;
+			route_unlock_node(rn);
+			return find;
+		}
+	}
+
+	if (rn)
+		route_unlock_node(rn);
+	return NULL;
+}
+
 unsigned long ospf_lsdb_count_all(struct ospf_lsdb *lsdb)
 {
 	return lsdb->total;
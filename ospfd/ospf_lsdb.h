@@ -73,6 +73,11 @@ extern struct ospf_lsa *ospf_lsdb_lookup_by_id(struct ospf_lsdb *, uint8_t,
 extern struct ospf_lsa *ospf_lsdb_lookup_by_id_next(struct ospf_lsdb *, uint8_t,
 						    struct in_addr,
 						    struct in_addr, int);
+extern struct ospf_lsa *ospf_lsdb_lookup_by_id_range(struct ospf_lsdb *lsdb,
+						     uint8_t type,
+						     struct in_addr id,
+						     uint8_t masklen,
+						     struct ospf_lsa *prev);
 extern unsigned long ospf_lsdb_count_all(struct ospf_lsdb *);
 extern unsigned long ospf_lsdb_count(struct ospf_lsdb *, int);
 extern unsigned long ospf_lsdb_count_self(struct ospf_lsdb *, int);
@@ -39,6 +39,7 @@ DEFINE_MTYPE(OSPFD, OSPF_LSA, "OSPF LSA");
 DEFINE_MTYPE(OSPFD, OSPF_LSA_DATA, "OSPF LSA data");
 DEFINE_MTYPE(OSPFD, OSPF_LSDB, "OSPF LSDB");
 DEFINE_MTYPE(OSPFD, OSPF_PACKET, "OSPF packet");
+DEFINE_MTYPE(OSPFD, OSPF_LS_UPD_ENTRY, "OSPF LS Update queue entry");
 DEFINE_MTYPE(OSPFD, OSPF_FIFO, "OSPF FIFO queue");
 DEFINE_MTYPE(OSPFD, OSPF_VERTEX, "OSPF vertex");
 DEFINE_MTYPE(OSPFD, OSPF_VERTEX_PARENT, "OSPF vertex parent");
@@ -38,6 +38,7 @@ DECLARE_MTYPE(OSPF_LSA);
 DECLARE_MTYPE(OSPF_LSA_DATA);
 DECLARE_MTYPE(OSPF_LSDB);
 DECLARE_MTYPE(OSPF_PACKET);
+DECLARE_MTYPE(OSPF_LS_UPD_ENTRY);
 DECLARE_MTYPE(OSPF_FIFO);
 DECLARE_MTYPE(OSPF_VERTEX);
 DECLARE_MTYPE(OSPF_VERTEX_PARENT);
@@ -25,6 +25,8 @@
 #include "thread.h"
 #include "memory.h"
 #include "linklist.h"
+#include "hash.h"
+#include "jhash.h"
 #include "prefix.h"
 #include "if.h"
 #include "table.h"
@@ -3579,8 +3581,166 @@ static int ls_age_increment(struct ospf_lsa *lsa, int delay)
 	return (age > OSPF_LSA_MAXAGE ? OSPF_LSA_MAXAGE : age);
 }
 
+/*
+ * Each destination queue in oi->ls_upd_queue is a FIFO list of LSAs.
+ * oi->ls_upd_index maps a destination and LSA key to the list node holding
+ * that LSA, so an LSA refreshed or re-flooded before the queue is drained is
+ * sent only once, in its most recent instance.
+ */
+struct ospf_ls_upd_entry {
+	struct in_addr dst;
+	uint8_t type;
+	struct in_addr id;
+	struct in_addr adv_router;
+
+	struct listnode *node;
+};
+
+static unsigned int ospf_ls_upd_entry_key(const void *data)
+{
+	const struct ospf_ls_upd_entry *entry = data;
+
+	return jhash_3words(entry->dst.s_addr, entry->id.s_addr,
+			    entry->adv_router.s_addr, entry->type);
+}
+
+static bool ospf_ls_upd_entry_cmp(const void *d1, const void *d2)
+{
+	const struct ospf_ls_upd_entry *e1 = d1, *e2 = d2;
+
+	return e1->dst.s_addr == e2->dst.s_addr && e1->type == e2->type
+	       && e1->id.s_addr == e2->id.s_addr
+	       && e1->adv_router.s_addr == e2->adv_router.s_addr;
+}
+
+static void *ospf_ls_upd_entry_alloc(void *arg)
+{
+	struct ospf_ls_upd_entry *entry;
+
+	entry = XMALLOC(MTYPE_OSPF_LS_UPD_ENTRY, sizeof(*entry));
+	*entry = *(struct ospf_ls_upd_entry *)arg;
+	return entry;
+}
+
+static void ospf_ls_upd_entry_free(void *arg)
+{
+	XFREE(MTYPE_OSPF_LS_UPD_ENTRY, arg);
+}
+
+static void ospf_ls_upd_entry_set(struct ospf_ls_upd_entry *entry,
+				  struct in_addr dst, struct ospf_lsa *lsa)
+{
+	entry->dst = dst;
+	entry->type = lsa->data->type;
+	entry->id = lsa->data->id;
+	entry->adv_router = lsa->data->adv_router;
+	entry->node = NULL;
+}
+
+struct hash *ospf_ls_upd_index_new(void)
+{
+	return hash_create(ospf_ls_upd_entry_key, ospf_ls_upd_entry_cmp,
+			   "OSPF LS Update queue index");
+}
+
+void ospf_ls_upd_index_clean(struct ospf_interface *oi)
+{
+	hash_clean(oi->ls_upd_index, ospf_ls_upd_entry_free);
+}
+
+/* Queue an LSA for transmission to dst. */
+static void ospf_ls_upd_queue_add(struct ospf_interface *oi,
+				  struct list *update, struct in_addr dst,
+				  struct ospf_lsa *lsa)
+{
+	struct ospf_ls_upd_entry tmp, *entry;
+	struct ospf_lsa *old;
+
+	ospf_ls_upd_entry_set(&tmp, dst, lsa);
+	entry = hash_lookup(oi->ls_upd_index, &tmp);
+	if (entry == NULL) {
+		tmp.node = listnode_add(update, ospf_lsa_lock(lsa));
+		hash_get(oi->ls_upd_index, &tmp, ospf_ls_upd_entry_alloc);
+		return;
+	}
+
+	old = listgetdata(entry->node);
+	if (old == lsa || ospf_lsa_more_recent(old, lsa) > 0)
+		return;
+
+	/* Newer instance, send it in place of the queued one. */
+	entry->node->data = ospf_lsa_lock(lsa);
+	ospf_lsa_unlock(&old); /* oi->ls_upd_queue */
+}
+
+/* Remove a queued LSA once it's been sent or dropped. */
+static void ospf_ls_upd_queue_del(struct ospf_interface *oi,
+				  struct list *update, struct in_addr dst,
+				  struct listnode *node)
+{
+	struct ospf_ls_upd_entry tmp, *entry;
+	struct ospf_lsa *lsa = listgetdata(node);
+
+	ospf_ls_upd_entry_set(&tmp, dst, lsa);
+	entry = hash_release(oi->ls_upd_index, &tmp);
+	ospf_ls_upd_entry_free(entry);
+
+	list_delete_node(update, node);
+	ospf_lsa_unlock(&lsa); /* oi->ls_upd_queue */
+}
+
+/*
+ * LS Update pacing. Each interface owns a token bucket refilled at
+ * flood_pacing_rate packets per second, holding at most flood_pacing_burst
+ * tokens. Returns true if an LS Update may be sent now.
+ */
+static bool ospf_ls_upd_pacing_permit(struct ospf_interface *oi)
+{
+	struct ospf *ospf = oi->ospf;
+	uint64_t elapsed, tokens;
+	struct timeval credit;
+
+	if (!ospf->flood_pacing_rate)
+		return true;
+
+	if (oi->ls_upd_tokens < ospf->flood_pacing_burst) {
+		elapsed = monotime_since(&oi->ls_upd_token_time, NULL);
+		if (elapsed >= 1000000)
+			tokens = ospf->flood_pacing_burst;
+		else
+			tokens = elapsed * ospf->flood_pacing_rate / 1000000;
+
+		tokens += oi->ls_upd_tokens;
+		if (tokens >= ospf->flood_pacing_burst) {
+			oi->ls_upd_tokens = ospf->flood_pacing_burst;
+			monotime(&oi->ls_upd_token_time);
+		} else if (tokens > oi->ls_upd_tokens) {
+			/* Only consume the time the new tokens account for,
+			 * so that the fractional credit is kept.
+			 */
+			elapsed = (tokens - oi->ls_upd_tokens) * 1000000
+				  / ospf->flood_pacing_rate;
+			credit.tv_sec = elapsed / 1000000;
+			credit.tv_usec = elapsed % 1000000;
+			timeradd(&oi->ls_upd_token_time, &credit,
+				 &oi->ls_upd_token_time);
+			oi->ls_upd_tokens = tokens;
+		}
+	}
+
+	if (oi->ls_upd_tokens == 0)
+		return false;
+
+	/* A full bucket doesn't accrue, start refilling from now */
+	if (oi->ls_upd_tokens == ospf->flood_pacing_burst)
+		monotime(&oi->ls_upd_token_time);
+
+	oi->ls_upd_tokens--;
+	return true;
+}
+
 static int ospf_make_ls_upd(struct ospf_interface *oi, struct list *update,
-			    struct stream *s)
+			    struct in_addr dst, struct stream *s)
 {
 	struct ospf_lsa *lsa;
 	struct listnode *node;
@@ -3633,8 +3793,7 @@ static int ospf_make_ls_upd(struct ospf_interface *oi, struct list *update,
 		length += ntohs(lsa->data->length);
 		count++;
 
-		list_delete_node(update, node);
-		ospf_lsa_unlock(&lsa); /* oi->ls_upd_queue */
+		ospf_ls_upd_queue_del(oi, update, dst, node);
 	}
 
 	/* Now set #LSAs. */
@@ -3988,6 +4147,7 @@ void ospf_ls_upd_send_lsa(struct ospf_neighbor *nbr, struct ospf_lsa *lsa,
  * on packet sizes (in which case offending LSA is deleted from update list)
  */
 static struct ospf_packet *ospf_ls_upd_packet_new(struct list *update,
+						  struct in_addr dst,
 						  struct ospf_interface *oi)
 {
 	struct ospf_lsa *lsa;
@@ -4030,7 +4190,7 @@ static struct ospf_packet *ospf_ls_upd_packet_new(struct list *update,
 			  "ospf_ls_upd_packet_new: oversized LSA id:%pI4 too big, %d bytes, packet size %ld, dropping it completely. OSPF routing is broken!",
 			  &lsa->data->id, ntohs(lsa->data->length),
 			  (long int)size);
-		list_delete_node(update, ln);
+		ospf_ls_upd_queue_del(oi, update, dst, ln);
 		return NULL;
 	}
 
@@ -4067,7 +4227,9 @@ static void ospf_ls_upd_queue_send(struct ospf_interface *oi,
 	if (listcount(update) == 0)
 		return;
 
-	op = ospf_ls_upd_packet_new(update, oi);
+	op = ospf_ls_upd_packet_new(update, addr, oi);
+	if (op == NULL)
+		return;
 
 	/* Prepare OSPF common header. */
 	ospf_make_header(OSPF_MSG_LS_UPD, oi, op->s);
@@ -4075,7 +4237,7 @@ static void ospf_ls_upd_queue_send(struct ospf_interface *oi,
 	/* Prepare OSPF Link State Update body.
 	 * Includes Type-7 translation.
 	 */
-	length += ospf_make_ls_upd(oi, update, op->s);
+	length += ospf_make_ls_upd(oi, update, addr, op->s);
 
 	/* Fill OSPF header. */
 	ospf_fill_header(oi, op->s, length);
@@ -4131,6 +4293,7 @@ static int ospf_ls_upd_send_queue_event(struct thread *thread)
 	struct route_node *rnext;
 	struct list *update;
 	char again = 0;
+	bool paced = false;
 
 	oi->t_ls_upd_event = NULL;
 
@@ -4145,17 +4308,37 @@ static int ospf_ls_upd_send_queue_event(struct thread *thread)
 
 		update = (struct list *)rn->info;
 
-		ospf_ls_upd_queue_send(oi, update, rn->p.u.prefix4, 0);
+		if (listcount(update)) {
+			if (!paced && !ospf_ls_upd_pacing_permit(oi))
+				paced = true;
+			if (!paced)
+				ospf_ls_upd_queue_send(oi, update,
+						       rn->p.u.prefix4, 0);
+		}
 
-		/* list might not be empty. */
+		/* queue might not be empty. */
 		if (listcount(update) == 0) {
-			list_delete((struct list **)&rn->info);
+			list_delete(&update);
+			rn->info = NULL;
 			route_unlock_node(rn);
 		} else
 			again = 1;
 	}
 
-	if (again != 0) {
+	if (paced) {
+		unsigned long delay;
+
+		/* Out of tokens, retry once the next one is available. */
+		delay = (1000 + oi->ospf->flood_pacing_rate - 1)
+			/ oi->ospf->flood_pacing_rate;
+
+		if (IS_DEBUG_OSPF_EVENT)
+			zlog_debug(
+				"ospf_ls_upd_send_queue: [%s] paced, retrying in %lu msecs",
+				IF_NAME(oi), delay);
+		thread_add_timer_msec(master, ospf_ls_upd_send_queue_event, oi,
+				      delay, &oi->t_ls_upd_event);
+	} else if (again != 0) {
 		if (IS_DEBUG_OSPF_EVENT)
 			zlog_debug(
 				"ospf_ls_upd_send_queue: update lists not cleared, %d nodes to try again, raising new event",
@@ -4217,8 +4400,7 @@ void ospf_ls_upd_send(struct ospf_neighbor *nbr, struct list *update, int flag,
 		route_unlock_node(rn);
 
 	for (ALL_LIST_ELEMENTS_RO(update, node, lsa))
-		listnode_add(rn->info,
-			     ospf_lsa_lock(lsa)); /* oi->ls_upd_queue */
+		ospf_ls_upd_queue_add(oi, rn->info, p.prefix, lsa);
 	if (send_lsupd_now) {
 		struct list *send_update_list;
 		struct route_node *rnext;
@@ -24,12 +24,15 @@
 #include "thread.h"
 #include "memory.h"
 #include "hash.h"
+#include "jhash.h"
 #include "linklist.h"
 #include "prefix.h"
 #include "if.h"
 #include "table.h"
 #include "log.h"
 #include "sockunion.h" /* for inet_ntop () */
+#include "frratomic.h"
+#include "frr_pthread.h"
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_interface.h"
@@ -58,6 +61,19 @@ static const struct vertex vertex_in_spftree = {};
 #define LSA_SPF_IN_SPFTREE	(struct vertex *)&vertex_in_spftree
 #define LSA_SPF_NOT_EXPLORED	NULL
 
+/*
+ * dummy vertex to flag "known to the retained SPF tree, but not on it",
+ * see ospf_spf_retain()
+ */
+static const struct vertex vertex_spf_seen = {};
+#define LSA_SPF_SEEN		(struct vertex *)&vertex_spf_seen
+
+/*
+ * Incremental SPF falls back to a full calculation once more than this
+ * share (in percent) of the tree would have to be recomputed.
+ */
+#define OSPF_SPF_INCREMENTAL_MAX_AFFECTED 50
+
 static void ospf_clear_spf_reason_flags(void)
 {
 	spf_reason_flags = 0;
@@ -89,7 +105,161 @@ static int vertex_cmp(const struct vertex *v1, const struct vertex *v2)
 	}
 	return 0;
 }
-DECLARE_SKIPLIST_NONUNIQ(vertex_pqueue, struct vertex, pqi, vertex_cmp);
+
+/*
+ * The candidate list is an indexed heap: lowering a candidate's distance is
+ * a delete and re-add in O(log n). Equal candidates are popped in the order
+ * their vertices were created, see ospf_vertex_new().
+ */
+static int vertex_pqueue_cmp(const struct vertex *v1, const struct vertex *v2)
+{
+	int32_t delta;
+	int ret;
+
+	ret = vertex_cmp(v1, v2);
+	if (ret)
+		return ret;
+
+	/* serial number arithmetic, the sequence number may wrap */
+	delta = (int32_t)(v1->seq - v2->seq);
+	if (delta < 0)
+		return -1;
+	if (delta > 0)
+		return 1;
+	return 0;
+}
+DECLARE_HEAP(vertex_pqueue, struct vertex, pqi, vertex_pqueue_cmp);
+
+/*
+ * Every SPF run allocates a vertex, parent and nexthop per router and
+ * network, and frees them all once the routing table is built. Carve them
+ * out of chunks rather than allocating each separately. Each object is
+ * preceded by a pointer to its chunk and goes back to that chunk when freed.
+ *
+ * Incremental SPF and TI-LFA keep trees around across runs, so the pools
+ * can't wait for everything to be freed: a chunk is released as soon as
+ * none of its objects are in use. One empty chunk is kept while the pool is
+ * in use, so that a tree growing and shrinking around a chunk boundary
+ * doesn't allocate and free it over and over.
+ */
+#define SPF_POOL_CHUNK_OBJECTS 1024
+
+PREDECL_DLIST(spf_pool_chunks);
+
+struct spf_pool_chunk {
+	struct spf_pool_chunks_item item;
+	void *free_list;
+	unsigned int used; /* objects carved out of data[] so far */
+	unsigned int live; /* objects currently allocated */
+	uint64_t data[];
+};
+
+DECLARE_DLIST(spf_pool_chunks, struct spf_pool_chunk, item);
+
+struct spf_pool {
+	struct memtype *mtype;
+	size_t size; /* object size, including the chunk pointer */
+	struct spf_pool_chunks_head avail; /* chunks with free objects */
+	size_t count;
+};
+
+#define SPF_POOL_INIT(var, mt, type)                                           \
+	{                                                                      \
+		.mtype = mt,                                                   \
+		.size = ((sizeof(type) + sizeof(uint64_t) - 1)                 \
+			 & ~(sizeof(uint64_t) - 1))                            \
+			+ sizeof(void *),                                      \
+		.avail = INIT_DLIST(var.avail),                                \
+	}
+
+/*
+ * The pools are shared by all areas. While area SPFs run in parallel, see
+ * ospf_spf_calculate_areas_parallel(), they are serialized by a mutex.
+ */
+static bool spf_pool_locked;
+static pthread_mutex_t spf_pool_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static struct spf_pool vertex_pool =
+	SPF_POOL_INIT(vertex_pool, MTYPE_OSPF_VERTEX, struct vertex);
+static struct spf_pool vertex_parent_pool =
+	SPF_POOL_INIT(vertex_parent_pool, MTYPE_OSPF_VERTEX_PARENT,
+		      struct vertex_parent);
+static struct spf_pool vertex_nexthop_pool =
+	SPF_POOL_INIT(vertex_nexthop_pool, MTYPE_OSPF_NEXTHOP,
+		      struct vertex_nexthop);
+
+static void *spf_pool_alloc(struct spf_pool *pool)
+{
+	struct spf_pool_chunk *chunk;
+	void **obj;
+
+	if (spf_pool_locked)
+		pthread_mutex_lock(&spf_pool_mtx);
+
+	chunk = spf_pool_chunks_first(&pool->avail);
+	if (!chunk) {
+		chunk = XMALLOC(pool->mtype,
+				sizeof(*chunk)
+					+ SPF_POOL_CHUNK_OBJECTS * pool->size);
+		chunk->free_list = NULL;
+		chunk->used = 0;
+		chunk->live = 0;
+		spf_pool_chunks_add_head(&pool->avail, chunk);
+	}
+
+	if (chunk->free_list) {
+		obj = chunk->free_list;
+		chunk->free_list = *obj;
+	} else {
+		obj = (void **)((char *)chunk->data + chunk->used * pool->size);
+		chunk->used++;
+	}
+
+	if (++chunk->live == SPF_POOL_CHUNK_OBJECTS)
+		spf_pool_chunks_del(&pool->avail, chunk);
+	pool->count++;
+
+	if (spf_pool_locked)
+		pthread_mutex_unlock(&spf_pool_mtx);
+
+	obj[0] = chunk;
+	memset(&obj[1], 0, pool->size - sizeof(void *));
+	return &obj[1];
+}
+
+static void spf_pool_free(struct spf_pool *pool, void *obj)
+{
+	struct spf_pool_chunk *chunk;
+	void **hdr;
+
+	if (!obj)
+		return;
+
+	hdr = (void **)obj - 1;
+	chunk = *hdr;
+
+	if (spf_pool_locked)
+		pthread_mutex_lock(&spf_pool_mtx);
+
+	assert(pool->count && chunk->live);
+	if (chunk->live-- == SPF_POOL_CHUNK_OBJECTS)
+		spf_pool_chunks_add_head(&pool->avail, chunk);
+	*hdr = chunk->free_list;
+	chunk->free_list = hdr;
+	pool->count--;
+
+	if (pool->count == 0) {
+		while ((chunk = spf_pool_chunks_pop(&pool->avail)))
+			XFREE(pool->mtype, chunk);
+	} else if (chunk->live == 0
+		   && spf_pool_chunks_count(&pool->avail) > 1) {
+		spf_pool_chunks_del(&pool->avail, chunk);
+		XFREE(pool->mtype, chunk);
+	}
+
+	if (spf_pool_locked)
+		pthread_mutex_unlock(&spf_pool_mtx);
+}
 
 static void lsdb_clean_stat(struct ospf_lsdb *lsdb)
 {
@@ -108,12 +278,12 @@ static void lsdb_clean_stat(struct ospf_lsdb *lsdb)
 
 static struct vertex_nexthop *vertex_nexthop_new(void)
 {
-	return XCALLOC(MTYPE_OSPF_NEXTHOP, sizeof(struct vertex_nexthop));
+	return spf_pool_alloc(&vertex_nexthop_pool);
 }
 
 static void vertex_nexthop_free(struct vertex_nexthop *nh)
 {
-	XFREE(MTYPE_OSPF_NEXTHOP, nh);
+	spf_pool_free(&vertex_nexthop_pool, nh);
 }
 
 /*
@@ -165,7 +335,7 @@ static struct vertex_parent *vertex_parent_new(struct vertex *v, int backlink,
 {
 	struct vertex_parent *new;
 
-	new = XMALLOC(MTYPE_OSPF_VERTEX_PARENT, sizeof(struct vertex_parent));
+	new = spf_pool_alloc(&vertex_parent_pool);
 
 	new->parent = v;
 	new->backlink = backlink;
@@ -177,7 +347,7 @@ static struct vertex_parent *vertex_parent_new(struct vertex *v, int backlink,
 
 static void vertex_parent_free(void *p)
 {
-	XFREE(MTYPE_OSPF_VERTEX_PARENT, p);
+	spf_pool_free(&vertex_parent_pool, p);
 }
 
 int vertex_parent_cmp(void *aa, void *bb)
@@ -191,9 +361,10 @@ static struct vertex *ospf_vertex_new(struct ospf_area *area,
 {
 	struct vertex *new;
 
-	new = XCALLOC(MTYPE_OSPF_VERTEX, sizeof(struct vertex));
+	new = spf_pool_alloc(&vertex_pool);
 
 	new->flags = 0;
+	new->seq = area->spf_vertex_seq++;
 	new->type = lsa->data->type;
 	new->id = lsa->data->id;
 	new->lsa = lsa->data;
@@ -233,7 +404,7 @@ static void ospf_vertex_free(void *data)
 
 	v->lsa = NULL;
 
-	XFREE(MTYPE_OSPF_VERTEX, v);
+	spf_pool_free(&vertex_pool, v);
 }
 
 static void ospf_vertex_dump(const char *msg, struct vertex *v,
@@ -338,7 +509,7 @@ static struct vertex *ospf_spf_vertex_copy(struct vertex *vertex)
 {
 	struct vertex *copy;
 
-	copy = XCALLOC(MTYPE_OSPF_VERTEX, sizeof(struct vertex));
+	copy = spf_pool_alloc(&vertex_pool);
 
 	memcpy(copy, vertex, sizeof(struct vertex));
 	copy->parents = list_new();
@@ -356,8 +527,7 @@ ospf_spf_vertex_parent_copy(struct vertex_parent *vertex_parent)
 	struct vertex_parent *vertex_parent_copy;
 	struct vertex_nexthop *nexthop_copy, *local_nexthop_copy;
 
-	vertex_parent_copy =
-		XCALLOC(MTYPE_OSPF_VERTEX, sizeof(struct vertex_parent));
+	vertex_parent_copy = spf_pool_alloc(&vertex_parent_pool);
 
 	nexthop_copy = vertex_nexthop_new();
 	local_nexthop_copy = vertex_nexthop_new();
@@ -374,47 +544,91 @@ ospf_spf_vertex_parent_copy(struct vertex_parent *vertex_parent)
 	return vertex_parent_copy;
 }
 
-/* Create a deep copy of a SPF tree */
+/* Original to copy mapping of vertices while copying an SPF tree. */
+PREDECL_HASH(spf_copies);
+struct spf_copy {
+	struct vertex *orig;
+	struct vertex *copy;
+	struct spf_copy *next;
+	struct spf_copies_item item;
+};
+
+static int spf_copies_cmp(const struct spf_copy *a, const struct spf_copy *b)
+{
+	return numcmp((uintptr_t)a->orig, (uintptr_t)b->orig);
+}
+
+static uint32_t spf_copies_hash(const struct spf_copy *c)
+{
+	return jhash(&c->orig, sizeof(c->orig), 0x5bf0c0b1);
+}
+
+DECLARE_HASH(spf_copies, struct spf_copy, item, spf_copies_cmp,
+	     spf_copies_hash);
+
+/* Get the copy of a vertex, creating and queueing it if necessary. */
+static struct vertex *ospf_spf_copy_get(struct spf_copies_head *copies,
+					struct spf_copy ***tail,
+					struct vertex *vertex,
+					struct list *vertex_list)
+{
+	struct spf_copy search = {.orig = vertex}, *copy;
+
+	copy = spf_copies_find(copies, &search);
+	if (copy)
+		return copy->copy;
+
+	copy = XCALLOC(MTYPE_TMP, sizeof(*copy));
+	copy->orig = vertex;
+	copy->copy = ospf_spf_vertex_copy(vertex);
+	listnode_add(vertex_list, copy->copy);
+	spf_copies_add(copies, copy);
+
+	**tail = copy;
+	*tail = &copy->next;
+
+	return copy->copy;
+}
+
+/*
+ * Create a deep copy of a SPF tree. Every vertex is copied and linked once,
+ * however many parents it has, starting with the given one.
+ */
 void ospf_spf_copy(struct vertex *vertex, struct list *vertex_list)
 {
+	struct spf_copies_head copies;
+	struct spf_copy *queue = NULL, **tail = &queue, *copy;
 	struct listnode *node;
-	struct vertex *vertex_copy, *child, *child_copy, *parent_copy;
+	struct vertex *child, *parent_copy;
 	struct vertex_parent *vertex_parent, *vertex_parent_copy;
 
-	/* First check if the node is already in the vertex list */
-	vertex_copy = ospf_spf_vertex_find(vertex->id, vertex_list);
-	if (!vertex_copy) {
-		vertex_copy = ospf_spf_vertex_copy(vertex);
-		listnode_add(vertex_list, vertex_copy);
-	}
-
-	/* Copy all parents, create parent nodes if necessary */
-	for (ALL_LIST_ELEMENTS_RO(vertex->parents, node, vertex_parent)) {
-		parent_copy = ospf_spf_vertex_find(vertex_parent->parent->id,
-						   vertex_list);
-		if (!parent_copy) {
-			parent_copy =
-				ospf_spf_vertex_copy(vertex_parent->parent);
-			listnode_add(vertex_list, parent_copy);
-		}
-		vertex_parent_copy = ospf_spf_vertex_parent_copy(vertex_parent);
-		vertex_parent_copy->parent = parent_copy;
-		listnode_add(vertex_copy->parents, vertex_parent_copy);
-	}
+	spf_copies_init(&copies);
 
-	/* Copy all children, create child nodes if necessary */
-	for (ALL_LIST_ELEMENTS_RO(vertex->children, node, child)) {
-		child_copy = ospf_spf_vertex_find(child->id, vertex_list);
-		if (!child_copy) {
-			child_copy = ospf_spf_vertex_copy(child);
-			listnode_add(vertex_list, child_copy);
+	ospf_spf_copy_get(&copies, &tail, vertex, vertex_list);
+
+	for (copy = queue; copy; copy = copy->next) {
+		/* Copy all parents, create parent nodes if necessary */
+		for (ALL_LIST_ELEMENTS_RO(copy->orig->parents, node,
+					  vertex_parent)) {
+			parent_copy = ospf_spf_copy_get(&copies, &tail,
+							vertex_parent->parent,
+							vertex_list);
+			vertex_parent_copy =
+				ospf_spf_vertex_parent_copy(vertex_parent);
+			vertex_parent_copy->parent = parent_copy;
+			listnode_add(copy->copy->parents, vertex_parent_copy);
 		}
-		listnode_add(vertex_copy->children, child_copy);
+
+		/* Copy all children, create child nodes if necessary */
+		for (ALL_LIST_ELEMENTS_RO(copy->orig->children, node, child))
+			listnode_add(copy->copy->children,
+				     ospf_spf_copy_get(&copies, &tail, child,
+						       vertex_list));
 	}
 
-	/* Finally continue copying with child nodes */
-	for (ALL_LIST_ELEMENTS_RO(vertex->children, node, child))
-		ospf_spf_copy(child, vertex_list);
+	while ((copy = spf_copies_pop(&copies)))
+		XFREE(MTYPE_TMP, copy);
+	spf_copies_fini(&copies);
 }
 
 static void ospf_spf_remove_branch(struct vertex_parent *vertex_parent,
@@ -1444,6 +1658,20 @@ static void ospf_spf_next(struct vertex *v, struct ospf_area *area,
 			continue;
 		}
 
+		/*
+		 * Incremental SPF: W is on the retained part of the tree. If a
+		 * recomputed vertex V offers W an equal or better path, W's
+		 * retained parents are no longer correct, and the incremental
+		 * calculation has to be abandoned.
+		 */
+		if (w_lsa->stat
+		    && CHECK_FLAG(w_lsa->stat->flags, OSPF_VERTEX_RETAINED)) {
+			if (!CHECK_FLAG(v->flags, OSPF_VERTEX_RETAINED)
+			    && distance <= w_lsa->stat->distance)
+				area->spf_incremental_abort = true;
+			continue;
+		}
+
 		/*
 		 * (d) Calculate the link state cost D of the resulting path
 		 * from the root to vertex W.  D is equal to the sum of the link
@@ -1666,34 +1894,23 @@ void ospf_spf_cleanup(struct vertex *spf, struct list *vertex_list)
 		list_delete(&vertex_list);
 }
 
-/* Calculating the shortest-path tree for an area, see RFC2328 16.1. */
-void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
-			struct route_table *new_table,
-			struct route_table *new_rtrs, bool is_dry_run,
-			bool is_root_node)
+/*
+ * Build the shortest-path tree of an area, see RFC2328 16.1. (1)-(3).
+ *
+ * With an 'order' list, the vertices are appended to it in the order they
+ * are added to the tree instead of being entered into the routing tables.
+ * The calculation then only reads the area's LSDB and writes its tree, so
+ * that it can run in a worker thread, see ospf_spf_calculate_areas().
+ */
+static void ospf_spf_dijkstra(struct ospf_area *area,
+			      struct ospf_lsa *root_lsa,
+			      struct route_table *new_table,
+			      struct route_table *new_rtrs, bool is_dry_run,
+			      bool is_root_node, struct list *order)
 {
 	struct vertex_pqueue_head candidate;
 	struct vertex *v;
 
-	if (IS_DEBUG_OSPF_EVENT) {
-		zlog_debug("ospf_spf_calculate: Start");
-		zlog_debug("ospf_spf_calculate: running Dijkstra for area %pI4",
-			   &area->area_id);
-	}
-
-	/*
-	 * If the router LSA of the root is not yet allocated, return this
-	 * area's calculation. In the 'usual' case the root_lsa is the
-	 * self-originated router LSA of the node itself.
-	 */
-	if (!root_lsa) {
-		if (IS_DEBUG_OSPF_EVENT)
-			zlog_debug(
-				"ospf_spf_calculate: Skip area %pI4's calculation due to empty root LSA",
-				&area->area_id);
-		return;
-	}
-
 	/* Initialize the algorithm's data structures, see RFC2328 16.1. (1). */
 
 	/*
@@ -1737,14 +1954,21 @@ void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
 		ospf_vertex_add_parent(v);
 
 		/* RFC2328 16.1. (4). */
-		if (v->type == OSPF_VERTEX_ROUTER)
+		if (order)
+			listnode_add(order, v);
+		else if (v->type == OSPF_VERTEX_ROUTER)
 			ospf_intra_add_router(new_rtrs, v, area);
 		else
 			ospf_intra_add_transit(new_table, v, area);
 
 		/* Iterate back to (2), see RFC2328 16.1. (5). */
 	}
+}
 
+/* Add the stub networks of an area's tree, and account for the run. */
+static void ospf_spf_finish(struct ospf_area *area,
+			    struct route_table *new_table)
+{
 	if (IS_DEBUG_OSPF_EVENT) {
 		ospf_spf_dump(area->spf, 0);
 		ospf_route_table_dump(new_table);
@@ -1765,17 +1989,516 @@ void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
 	area->ts_spf = area->ospf->ts_spf;
 
 	if (IS_DEBUG_OSPF_EVENT)
-		zlog_debug("ospf_spf_calculate: Stop. %zd vertices",
-			   mtype_stats_alloc(MTYPE_OSPF_VERTEX));
+		zlog_debug("ospf_spf_calculate: Stop. %zu vertices",
+			   vertex_pool.count);
 }
 
-void ospf_spf_calculate_area(struct ospf *ospf, struct ospf_area *area,
-			     struct route_table *new_table,
-			     struct route_table *new_rtrs)
+/* Calculating the shortest-path tree for an area, see RFC2328 16.1. */
+void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
+			struct route_table *new_table,
+			struct route_table *new_rtrs, bool is_dry_run,
+			bool is_root_node)
 {
-	ospf_spf_calculate(area, area->router_lsa_self, new_table, new_rtrs,
-			   false, true);
+	if (IS_DEBUG_OSPF_EVENT) {
+		zlog_debug("ospf_spf_calculate: Start");
+		zlog_debug("ospf_spf_calculate: running Dijkstra for area %pI4",
+			   &area->area_id);
+	}
+
+	/*
+	 * If the router LSA of the root is not yet allocated, return this
+	 * area's calculation. In the 'usual' case the root_lsa is the
+	 * self-originated router LSA of the node itself.
+	 */
+	if (!root_lsa) {
+		if (IS_DEBUG_OSPF_EVENT)
+			zlog_debug(
+				"ospf_spf_calculate: Skip area %pI4's calculation due to empty root LSA",
+				&area->area_id);
+		return;
+	}
+
+	ospf_spf_dijkstra(area, root_lsa, new_table, new_rtrs, is_dry_run,
+			  is_root_node, NULL);
+	ospf_spf_finish(area, new_table);
+}
+
+/* Set the SPF stat of all router- and network-LSAs in an area's LSDB */
+static void ospf_spf_lsdb_set_stat(struct ospf_lsdb *lsdb, struct vertex *stat)
+{
+	struct route_node *rn;
+	struct ospf_lsa *lsa;
+
+	for (rn = route_top(lsdb->type[OSPF_ROUTER_LSA].db); rn;
+	     rn = route_next(rn))
+		if ((lsa = rn->info) != NULL)
+			lsa->stat = stat;
+
+	for (rn = route_top(lsdb->type[OSPF_NETWORK_LSA].db); rn;
+	     rn = route_next(rn))
+		if ((lsa = rn->info) != NULL)
+			lsa->stat = stat;
+}
+
+/*
+ * Keep the shortest-path tree of an area for the next incremental SPF.
+ *
+ * Every vertex holds a lock on its LSA, so that the LSA survives being
+ * replaced in the LSDB. LSAs on the tree point back at their vertex, all
+ * other router- and network-LSAs are flagged as seen: any LSA with a NULL
+ * stat at the next run has been installed in between.
+ */
+static void ospf_spf_retain(struct ospf_area *area)
+{
+	struct listnode *node;
+	struct vertex *v;
+
+	ospf_spf_lsdb_set_stat(area->lsdb, LSA_SPF_SEEN);
+
+	for (ALL_LIST_ELEMENTS_RO(area->spf_vertex_list, node, v)) {
+		if (!CHECK_FLAG(v->flags, OSPF_VERTEX_RETAINED)) {
+			ospf_lsa_lock(v->lsa_p);
+			SET_FLAG(v->flags, OSPF_VERTEX_RETAINED);
+		}
+		v->lsa_p->stat = v;
+	}
+}
+
+/* Free a vertex, dropping its LSA lock if it was retained. */
+static void ospf_spf_retained_vertex_free(struct vertex *v)
+{
+	struct ospf_lsa *lsa = v->lsa_p;
+	bool retained = CHECK_FLAG(v->flags, OSPF_VERTEX_RETAINED);
+
+	ospf_vertex_free(v);
+
+	if (retained)
+		ospf_lsa_unlock(&lsa);
+}
+
+/* Free the shortest-path tree retained for incremental SPF, if any. */
+void ospf_spf_incremental_free(struct ospf_area *area)
+{
+	struct listnode *node, *nnode;
+	struct vertex *v;
+
+	if (!area->spf || !CHECK_FLAG(area->spf->flags, OSPF_VERTEX_RETAINED))
+		return;
+
+	lsdb_clean_stat(area->lsdb);
+	ospf_canonical_nexthops_free(area->spf);
+
+	for (ALL_LIST_ELEMENTS(area->spf_vertex_list, node, nnode, v)) {
+		list_delete_node(area->spf_vertex_list, node);
+		ospf_spf_retained_vertex_free(v);
+	}
+	list_delete(&area->spf_vertex_list);
+
+	area->spf = NULL;
+}
+
+/*
+ * Does W's nexthop through parent P belong to W, rather than being inherited?
+ * See ospf_canonical_nexthops_free().
+ */
+static bool ospf_spf_nexthop_is_canonical(struct ospf_area *area,
+					  struct vertex *p)
+{
+	struct listnode *node;
+	struct vertex_parent *vp;
+
+	if (p == area->spf)
+		return true;
+
+	if (p->type != OSPF_VERTEX_NETWORK)
+		return false;
+
+	for (ALL_LIST_ELEMENTS_RO(p->parents, node, vp))
+		if (vp->parent == area->spf)
+			return true;
+
+	return false;
+}
+
+/*
+ * Flag the retained vertices that link to the vertex described by LSA: after
+ * the recomputed part of the tree has been cut off, these are where the
+ * calculation has to resume from. As links are only used if they are
+ * bidirectional, the LSA's own links tell us where to look.
+ */
+static void ospf_spf_incremental_boundary(struct ospf_area *area,
+					  struct ospf_lsa *lsa,
+					  struct list *boundary)
+{
+	struct ospf_lsa *w_lsa;
+	struct router_lsa_link *l;
+	struct in_addr *r;
+	uint8_t *p, *lim;
+
+	if (lsa == NULL || IS_LSA_MAXAGE(lsa))
+		return;
+
+	p = ((uint8_t *)lsa->data) + OSPF_LSA_HEADER_SIZE + 4;
+	lim = ((uint8_t *)lsa->data) + ntohs(lsa->data->length);
+
+	while (p < lim) {
+		w_lsa = NULL;
+
+		if (lsa->data->type == OSPF_ROUTER_LSA) {
+			l = (struct router_lsa_link *)p;
+			p += (OSPF_ROUTER_LSA_LINK_SIZE
+			      + (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
 
+			switch (l->m[0].type) {
+			case LSA_LINK_TYPE_POINTOPOINT:
+			case LSA_LINK_TYPE_VIRTUALLINK:
+				w_lsa = ospf_lsa_lookup(area->ospf, area,
+							OSPF_ROUTER_LSA,
+							l->link_id, l->link_id);
+				break;
+			case LSA_LINK_TYPE_TRANSIT:
+				w_lsa = ospf_lsa_lookup_by_id(
+					area, OSPF_NETWORK_LSA, l->link_id);
+				break;
+			default:
+				break;
+			}
+		} else {
+			r = (struct in_addr *)p;
+			p += sizeof(struct in_addr);
+
+			w_lsa = ospf_lsa_lookup_by_id(area, OSPF_ROUTER_LSA,
+						      *r);
+		}
+
+		if (w_lsa == NULL || w_lsa->stat == NULL
+		    || w_lsa->stat == LSA_SPF_SEEN
+		    || w_lsa->stat == LSA_SPF_IN_SPFTREE)
+			continue;
+
+		if (CHECK_FLAG(w_lsa->stat->flags,
+			       OSPF_VERTEX_AFFECTED | OSPF_VERTEX_BOUNDARY))
+			continue;
+
+		SET_FLAG(w_lsa->stat->flags, OSPF_VERTEX_BOUNDARY);
+		listnode_add(boundary, w_lsa->stat);
+	}
+}
+
+/*
+ * Repair the retained shortest-path tree of an area after LSDB changes.
+ *
+ * Vertices whose LSA changed, and everything below them in the tree, are
+ * cut off and recomputed with Dijkstra, seeded from the retained vertices
+ * linking to them. The rest of the tree keeps its distances and nexthops,
+ * which holds as long as no recomputed vertex offers a retained one an
+ * equal or better path; ospf_spf_next() flags it if that happens.
+ *
+ * LSAs which were only refreshed are rebound to their vertex without
+ * recomputation.
+ *
+ * Returns false if a full SPF calculation is required instead; the
+ * retained tree must then be freed.
+ */
+static bool ospf_spf_incremental_repair(struct ospf_area *area,
+					struct ospf_lsa *root_lsa)
+{
+	struct vertex_pqueue_head candidate;
+	struct list *vertex_list = area->spf_vertex_list;
+	struct list *fresh, *work, *boundary;
+	struct listnode *node, *nnode, *pnode, *pnnode, *cnode;
+	struct vertex_parent *vp;
+	struct vertex *v, *child;
+	struct ospf_lsa *lsa, *cur;
+	struct route_node *rn;
+	unsigned int total, affected = 0;
+	int type;
+
+	total = listcount(vertex_list);
+
+	for (ALL_LIST_ELEMENTS_RO(vertex_list, node, v))
+		UNSET_FLAG(v->flags, OSPF_VERTEX_AFFECTED
+					     | OSPF_VERTEX_LSA_CURRENT
+					     | OSPF_VERTEX_BOUNDARY);
+
+	/* Find out which LSAs changed since the last calculation. */
+	fresh = list_new();
+	for (type = OSPF_ROUTER_LSA; type <= OSPF_NETWORK_LSA; type++) {
+		for (rn = route_top(area->lsdb->type[type].db); rn;
+		     rn = route_next(rn)) {
+			if ((lsa = rn->info) == NULL
+			    || lsa->stat == LSA_SPF_SEEN)
+				continue;
+
+			if (lsa->stat == NULL) {
+				if (!IS_LSA_MAXAGE(lsa))
+					listnode_add(fresh, lsa);
+				continue;
+			}
+
+			if (lsa->stat == LSA_SPF_IN_SPFTREE
+			    || !CHECK_FLAG(lsa->stat->flags,
+					   OSPF_VERTEX_RETAINED)) {
+				/* Not ours: somebody else ran SPF here */
+				route_unlock_node(rn);
+				list_delete(&fresh);
+				return false;
+			}
+
+			if (lsa->stat->lsa_p == lsa && !IS_LSA_MAXAGE(lsa))
+				SET_FLAG(lsa->stat->flags,
+					 OSPF_VERTEX_LSA_CURRENT);
+		}
+	}
+
+	/* Rebind refreshed LSAs, flag the vertices of changed ones */
+	work = list_new();
+	for (ALL_LIST_ELEMENTS_RO(vertex_list, node, v)) {
+		if (CHECK_FLAG(v->flags, OSPF_VERTEX_LSA_CURRENT))
+			continue;
+
+		cur = ospf_lsdb_lookup_by_id(area->lsdb, v->lsa->type,
+					     v->lsa->id, v->lsa->adv_router);
+		if (cur && cur->stat == NULL && !IS_LSA_MAXAGE(cur)
+		    && !ospf_lsa_different(v->lsa_p, cur)) {
+			lsa = v->lsa_p;
+			v->lsa_p = ospf_lsa_lock(cur);
+			v->lsa = cur->data;
+			cur->stat = v;
+			ospf_lsa_unlock(&lsa);
+			SET_FLAG(v->flags, OSPF_VERTEX_LSA_CURRENT);
+			continue;
+		}
+
+		SET_FLAG(v->flags, OSPF_VERTEX_AFFECTED);
+		listnode_add(work, v);
+	}
+
+	if (!CHECK_FLAG(area->spf->flags, OSPF_VERTEX_LSA_CURRENT)
+	    || area->spf->lsa_p != root_lsa) {
+		if (IS_DEBUG_OSPF_EVENT)
+			zlog_debug("%s: area %pI4: root LSA changed", __func__,
+				   &area->area_id);
+		list_delete(&work);
+		list_delete(&fresh);
+		return false;
+	}
+
+	/* The subtrees below changed vertices have to be recomputed, too */
+	for (node = listhead(work); node; node = listnextnode(node)) {
+		v = listgetdata(node);
+		affected++;
+
+		for (ALL_LIST_ELEMENTS_RO(v->children, cnode, child)) {
+			if (CHECK_FLAG(child->flags, OSPF_VERTEX_AFFECTED))
+				continue;
+			SET_FLAG(child->flags, OSPF_VERTEX_AFFECTED);
+			listnode_add(work, child);
+		}
+	}
+
+	/* Rebound LSAs are not fresh */
+	for (ALL_LIST_ELEMENTS(fresh, node, nnode, lsa))
+		if (lsa->stat)
+			list_delete_node(fresh, node);
+
+	if (IS_DEBUG_OSPF_EVENT)
+		zlog_debug(
+			"%s: area %pI4: %u of %u vertices affected, %u new LSAs",
+			__func__, &area->area_id, affected, total,
+			listcount(fresh));
+
+	if ((affected + listcount(fresh)) * 100
+	    > total * OSPF_SPF_INCREMENTAL_MAX_AFFECTED) {
+		list_delete(&work);
+		list_delete(&fresh);
+		return false;
+	}
+
+	/*
+	 * Find the retained vertices the calculation resumes from, while
+	 * LSA stats still point at the vertices.
+	 */
+	boundary = list_new();
+	for (ALL_LIST_ELEMENTS_RO(work, node, v))
+		ospf_spf_incremental_boundary(
+			area,
+			ospf_lsdb_lookup_by_id(area->lsdb, v->lsa->type,
+					       v->lsa->id, v->lsa->adv_router),
+			boundary);
+	for (ALL_LIST_ELEMENTS_RO(fresh, node, lsa))
+		ospf_spf_incremental_boundary(area, lsa, boundary);
+
+	/*
+	 * Cut off the affected vertices. Canonical nexthops are freed first,
+	 * as telling them apart needs the parents to be intact.
+	 */
+	for (ALL_LIST_ELEMENTS_RO(work, node, v)) {
+		for (ALL_LIST_ELEMENTS_RO(v->parents, pnode, vp)) {
+			if (!vp->nexthop
+			    || !ospf_spf_nexthop_is_canonical(area, vp->parent))
+				continue;
+
+			vertex_nexthop_free(vp->nexthop);
+			vp->nexthop = NULL;
+			if (vp->local_nexthop) {
+				vertex_nexthop_free(vp->local_nexthop);
+				vp->local_nexthop = NULL;
+			}
+		}
+	}
+
+	for (ALL_LIST_ELEMENTS_RO(work, node, v))
+		for (ALL_LIST_ELEMENTS(v->parents, pnode, pnnode, vp))
+			if (!CHECK_FLAG(vp->parent->flags,
+					OSPF_VERTEX_AFFECTED))
+				listnode_delete(vp->parent->children, v);
+
+	for (ALL_LIST_ELEMENTS(vertex_list, node, nnode, v)) {
+		if (!CHECK_FLAG(v->flags, OSPF_VERTEX_AFFECTED))
+			continue;
+
+		list_delete_node(vertex_list, node);
+		ospf_spf_retained_vertex_free(v);
+	}
+
+	list_delete(&work);
+	list_delete(&fresh);
+
+	/* Retained vertices are final, everything else is unexplored */
+	ospf_spf_lsdb_set_stat(area->lsdb, LSA_SPF_NOT_EXPLORED);
+	for (ALL_LIST_ELEMENTS_RO(vertex_list, node, v))
+		v->lsa_p->stat = v;
+
+	area->spf_incremental_abort = false;
+	vertex_pqueue_init(&candidate);
+
+	for (ALL_LIST_ELEMENTS_RO(boundary, node, v))
+		ospf_spf_next(v, area, &candidate);
+	list_delete(&boundary);
+
+	while ((v = vertex_pqueue_pop(&candidate))) {
+		v->lsa_p->stat = LSA_SPF_IN_SPFTREE;
+		ospf_vertex_add_parent(v);
+		ospf_spf_next(v, area, &candidate);
+	}
+
+	if (area->spf_incremental_abort) {
+		if (IS_DEBUG_OSPF_EVENT)
+			zlog_debug(
+				"%s: area %pI4: retained paths changed, need full SPF",
+				__func__, &area->area_id);
+		return false;
+	}
+
+	return true;
+}
+
+static int ospf_spf_vertex_order(const void *a, const void *b)
+{
+	const struct vertex *v1 = *(const struct vertex *const *)a;
+	const struct vertex *v2 = *(const struct vertex *const *)b;
+	int ret;
+
+	ret = vertex_cmp(v1, v2);
+	if (ret)
+		return ret;
+
+	return IPV4_ADDR_CMP(&v1->id, &v2->id);
+}
+
+/*
+ * Build the intra-area routes of an area from its (repaired) shortest-path
+ * tree, visiting the vertices in the order Dijkstra would have added them.
+ */
+static void ospf_spf_incremental_routes(struct ospf_area *area,
+					struct route_table *new_table,
+					struct route_table *new_rtrs)
+{
+	struct vertex **vertices;
+	struct listnode *node;
+	struct vertex *v;
+	unsigned int count = 0, i;
+
+	vertices = XMALLOC(MTYPE_TMP, listcount(area->spf_vertex_list)
+					      * sizeof(*vertices));
+	for (ALL_LIST_ELEMENTS_RO(area->spf_vertex_list, node, v)) {
+		UNSET_FLAG(v->flags, OSPF_VERTEX_PROCESSED);
+		vertices[count++] = v;
+	}
+	qsort(vertices, count, sizeof(*vertices), ospf_spf_vertex_order);
+
+	area->abr_count = 0;
+	area->asbr_count = 0;
+	area->transit = OSPF_TRANSIT_FALSE;
+	area->shortcut_capability = 1;
+
+	for (i = 0; i < count; i++) {
+		v = vertices[i];
+
+		if (v->type == OSPF_VERTEX_ROUTER
+		    && IS_ROUTER_LSA_VIRTUAL((struct router_lsa *)v->lsa))
+			area->transit = OSPF_TRANSIT_TRUE;
+
+		if (v == area->spf)
+			continue;
+
+		if (v->type == OSPF_VERTEX_ROUTER)
+			ospf_intra_add_router(new_rtrs, v, area);
+		else
+			ospf_intra_add_transit(new_table, v, area);
+	}
+
+	XFREE(MTYPE_TMP, vertices);
+
+	ospf_spf_process_stubs(area, area->spf, new_table, 0);
+}
+
+/*
+ * Incremental SPF (iSPF) for an area.
+ *
+ * The shortest-path tree of the previous calculation is kept in the area.
+ * If it is still usable, only the part of it affected by LSDB changes is
+ * recomputed, see ospf_spf_incremental_repair(). Otherwise, e.g. for the
+ * first calculation, after a change of the root's own router-LSA, or when a
+ * large part of the tree is affected, this falls back to a full calculation.
+ * Either way the routing tables are rebuilt from the complete tree, and the
+ * tree is retained for the next run; it must be freed with
+ * ospf_spf_incremental_free().
+ */
+void ospf_spf_calculate_incremental(struct ospf_area *area,
+				    struct ospf_lsa *root_lsa,
+				    struct route_table *new_table,
+				    struct route_table *new_rtrs,
+				    bool is_dry_run, bool is_root_node)
+{
+	if (root_lsa && area->spf
+	    && CHECK_FLAG(area->spf->flags, OSPF_VERTEX_RETAINED)
+	    && area->spf_dry_run == is_dry_run
+	    && area->spf_root_node == is_root_node
+	    && ospf_spf_incremental_repair(area, root_lsa)) {
+		ospf_spf_incremental_routes(area, new_table, new_rtrs);
+
+		area->spf_calculation++;
+		area->spf_incremental_calculation++;
+
+		monotime(&area->ospf->ts_spf);
+		area->ts_spf = area->ospf->ts_spf;
+	} else {
+		ospf_spf_incremental_free(area);
+		ospf_spf_calculate(area, root_lsa, new_table, new_rtrs,
+				   is_dry_run, is_root_node);
+	}
+
+	if (area->spf)
+		ospf_spf_retain(area);
+}
+
+/* Compute TI-LFA for an area and release its tree, after a full SPF run. */
+static void ospf_spf_calculate_area_finish(struct ospf *ospf,
+					   struct ospf_area *area,
+					   struct route_table *new_table)
+{
 	if (ospf->ti_lfa_enabled)
 		ospf_ti_lfa_compute(area, new_table,
 				    ospf->ti_lfa_protection_type);
@@ -1786,12 +2509,276 @@ void ospf_spf_calculate_area(struct ospf *ospf, struct ospf_area *area,
 	area->spf_vertex_list = NULL;
 }
 
+void ospf_spf_calculate_area(struct ospf *ospf, struct ospf_area *area,
+			     struct route_table *new_table,
+			     struct route_table *new_rtrs)
+{
+	/*
+	 * TI-LFA runs its own SPF calculations on the area, and virtual links
+	 * make the backbone depend on transit area state outside its LSDB.
+	 */
+	if (ospf->spf_incremental && !ospf->ti_lfa_enabled
+	    && !listcount(ospf->vlinks)) {
+		ospf_spf_calculate_incremental(area, area->router_lsa_self,
+					       new_table, new_rtrs, false,
+					       true);
+		return;
+	}
+
+	ospf_spf_incremental_free(area);
+
+	ospf_spf_calculate(area, area->router_lsa_self, new_table, new_rtrs,
+			   false, true);
+
+	ospf_spf_calculate_area_finish(ospf, area, new_table);
+}
+
+/* Area SPF runs shared between the threads of a parallel calculation. */
+struct ospf_spf_job {
+	struct ospf_area *area;
+	struct ospf_lsa *root_lsa;
+	struct list *order;
+};
+
+struct ospf_spf_jobs {
+	struct ospf_spf_job *job;
+	unsigned int count;
+	_Atomic unsigned int next;
+};
+
+static void ospf_spf_run_jobs(struct ospf_spf_jobs *jobs)
+{
+	struct ospf_spf_job *job;
+	unsigned int i;
+
+	while ((i = atomic_fetch_add_explicit(&jobs->next, 1,
+					      memory_order_relaxed))
+	       < jobs->count) {
+		job = &jobs->job[i];
+		ospf_spf_dijkstra(job->area, job->root_lsa, NULL, NULL, false,
+				  true, job->order);
+	}
+}
+
+/*
+ * Worker pthreads for the parallel calculation. They are started the first
+ * time they're needed and then kept, waiting for the next batch of jobs.
+ * Each batch bumps the generation; every worker picks it up, runs jobs until
+ * none are left and reports back, so the batch can't go away under a worker
+ * that's late to wake up.
+ */
+static struct {
+	pthread_mutex_t mtx;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+
+	struct frr_pthread *fpt[OSPF_SPF_THREADS_MAX - 1];
+	unsigned int count;
+
+	struct ospf_spf_jobs *jobs;
+	unsigned int generation;
+	unsigned int done;
+} spf_workers = {
+	.mtx = PTHREAD_MUTEX_INITIALIZER,
+	.work_cond = PTHREAD_COND_INITIALIZER,
+	.done_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void *ospf_spf_worker_start(void *arg)
+{
+	struct frr_pthread *fpt = arg;
+	struct ospf_spf_jobs *jobs;
+	unsigned int generation;
+
+	frr_pthread_set_name(fpt);
+
+	pthread_mutex_lock(&spf_workers.mtx);
+	generation = spf_workers.generation;
+
+	frr_pthread_notify_running(fpt);
+
+	while (atomic_load_explicit(&fpt->running, memory_order_relaxed)) {
+		if (generation == spf_workers.generation) {
+			pthread_cond_wait(&spf_workers.work_cond,
+					  &spf_workers.mtx);
+			continue;
+		}
+
+		generation = spf_workers.generation;
+		jobs = spf_workers.jobs;
+		pthread_mutex_unlock(&spf_workers.mtx);
+
+		ospf_spf_run_jobs(jobs);
+
+		pthread_mutex_lock(&spf_workers.mtx);
+		if (++spf_workers.done == spf_workers.count)
+			pthread_cond_signal(&spf_workers.done_cond);
+	}
+	pthread_mutex_unlock(&spf_workers.mtx);
+
+	return NULL;
+}
+
+static int ospf_spf_worker_stop(struct frr_pthread *fpt, void **result)
+{
+	assert(fpt->running);
+
+	atomic_store_explicit(&fpt->running, false, memory_order_relaxed);
+
+	pthread_mutex_lock(&spf_workers.mtx);
+	pthread_cond_broadcast(&spf_workers.work_cond);
+	pthread_mutex_unlock(&spf_workers.mtx);
+
+	pthread_join(fpt->thread, result);
+	return 0;
+}
+
+/* Start or stop workers until there are count of them. */
+static void ospf_spf_workers_resize(unsigned int count)
+{
+	struct frr_pthread_attr attr = {
+		.start = ospf_spf_worker_start,
+		.stop = ospf_spf_worker_stop,
+	};
+	struct frr_pthread *fpt;
+
+	while (spf_workers.count > count) {
+		fpt = spf_workers.fpt[--spf_workers.count];
+		frr_pthread_stop(fpt, NULL);
+		frr_pthread_destroy(fpt);
+	}
+
+	while (spf_workers.count < count) {
+		fpt = frr_pthread_new(&attr, "OSPF SPF worker", "ospfd_spf");
+		if (frr_pthread_run(fpt, NULL) < 0) {
+			frr_pthread_destroy(fpt);
+			break;
+		}
+		frr_pthread_wait_running(fpt);
+		spf_workers.fpt[spf_workers.count++] = fpt;
+	}
+}
+
+/* Run a batch of jobs on the workers and the calling thread. */
+static void ospf_spf_workers_run(struct ospf_spf_jobs *jobs)
+{
+	pthread_mutex_lock(&spf_workers.mtx);
+	spf_workers.jobs = jobs;
+	spf_workers.done = 0;
+	spf_workers.generation++;
+	pthread_cond_broadcast(&spf_workers.work_cond);
+	pthread_mutex_unlock(&spf_workers.mtx);
+
+	ospf_spf_run_jobs(jobs);
+
+	pthread_mutex_lock(&spf_workers.mtx);
+	while (spf_workers.done < spf_workers.count)
+		pthread_cond_wait(&spf_workers.done_cond, &spf_workers.mtx);
+	spf_workers.jobs = NULL;
+	pthread_mutex_unlock(&spf_workers.mtx);
+}
+
+void ospf_spf_workers_fini(void)
+{
+	ospf_spf_workers_resize(0);
+}
+
+/*
+ * Run the Dijkstra part of the area SPFs on up to ospf->spf_threads threads,
+ * the calling one included, see ospf_spf_workers_run(). Each area's tree
+ * only depends on its own LSDB, which is not modified while the main thread
+ * waits for the workers. The routing tables are then built from the trees
+ * on the main thread, in the same order as a serial calculation.
+ *
+ * With virtual links the backbone's next hops depend on the transit areas'
+ * routes, so the backbone is calculated serially after the other areas.
+ */
+static void ospf_spf_calculate_areas_parallel(struct ospf *ospf,
+					      struct route_table *new_table,
+					      struct route_table *new_rtrs)
+{
+	struct ospf_spf_jobs jobs = {};
+	struct ospf_spf_job *job;
+	struct ospf_area *area;
+	struct listnode *node, *vnode;
+	struct vertex *v;
+	unsigned int i;
+	bool backbone_serial = ospf->backbone && listcount(ospf->vlinks);
+
+	jobs.job = XCALLOC(MTYPE_TMP,
+			   listcount(ospf->areas) * sizeof(*jobs.job));
+
+	/* Backbone last, as in the serial calculation. */
+	for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area))
+		if (area != ospf->backbone)
+			jobs.job[jobs.count++].area = area;
+	if (ospf->backbone && !backbone_serial)
+		jobs.job[jobs.count++].area = ospf->backbone;
+
+	for (i = 0; i < jobs.count; i++) {
+		job = &jobs.job[i];
+		ospf_spf_incremental_free(job->area);
+		job->root_lsa = job->area->router_lsa_self;
+		if (job->root_lsa)
+			job->order = list_new();
+	}
+
+	ospf_spf_workers_resize(ospf->spf_threads - 1);
+
+	spf_pool_locked = true;
+	ospf_spf_workers_run(&jobs);
+	spf_pool_locked = false;
+
+	for (i = 0; i < jobs.count; i++) {
+		job = &jobs.job[i];
+		area = job->area;
+
+		if (IS_DEBUG_OSPF_EVENT)
+			zlog_debug("%s: area %pI4, %u vertices", __func__,
+				   &area->area_id,
+				   job->order ? listcount(job->order) : 0);
+
+		if (job->order) {
+			/* RFC2328 16.1. (4). */
+			for (ALL_LIST_ELEMENTS_RO(job->order, vnode, v)) {
+				if (v->type == OSPF_VERTEX_ROUTER)
+					ospf_intra_add_router(new_rtrs, v,
+							      area);
+				else
+					ospf_intra_add_transit(new_table, v,
+							       area);
+			}
+			list_delete(&job->order);
+
+			ospf_spf_finish(area, new_table);
+		}
+
+		ospf_spf_calculate_area_finish(ospf, area, new_table);
+	}
+
+	if (backbone_serial)
+		ospf_spf_calculate_area(ospf, ospf->backbone, new_table,
+					new_rtrs);
+
+	XFREE(MTYPE_TMP, jobs.job);
+}
+
 void ospf_spf_calculate_areas(struct ospf *ospf, struct route_table *new_table,
 			      struct route_table *new_rtrs)
 {
 	struct ospf_area *area;
 	struct listnode *node, *nnode;
 
+	/*
+	 * Incremental SPF repairs the retained trees in place, and is cheap
+	 * enough on its own.
+	 */
+	if (ospf->spf_threads > 1 && !ospf->spf_incremental
+	    && listcount(ospf->areas) > 1) {
+		ospf_spf_calculate_areas_parallel(ospf, new_table, new_rtrs);
+		return;
+	}
+
 	/* Calculate SPF for each area. */
 	for (ALL_LIST_ELEMENTS(ospf->areas, node, nnode, area)) {
 		/* Do backbone last, so as to first discover intra-area paths
@@ -1808,6 +2795,117 @@ void ospf_spf_calculate_areas(struct ospf *ospf, struct route_table *new_table,
 					new_rtrs);
 }
 
+/*
+ * Record the destination of a changed summary-LSA for the partial route
+ * calculation. The caller still schedules the calculation itself.
+ */
+void ospf_spf_prc_add_lsa(struct ospf *ospf, struct ospf_lsa *lsa)
+{
+	struct summary_lsa *sl = (struct summary_lsa *)lsa->data;
+	struct route_table *table;
+	struct route_node *rn;
+	struct prefix_ipv4 p;
+
+	p.family = AF_INET;
+	p.prefix = sl->header.id;
+
+	if (sl->header.type == OSPF_SUMMARY_LSA) {
+		p.prefixlen = ip_masklen(sl->mask);
+		table = ospf->prc_networks;
+	} else {
+		p.prefixlen = IPV4_MAX_BITLEN;
+		table = ospf->prc_routers;
+	}
+
+	apply_mask_ipv4(&p);
+
+	rn = route_node_get(table, (struct prefix *)&p);
+	if (rn->info)
+		route_unlock_node(rn);
+	else
+		rn->info = lsa->area;
+}
+
+static void ospf_spf_prc_reset(struct ospf *ospf)
+{
+	route_table_finish(ospf->prc_networks);
+	route_table_finish(ospf->prc_routers);
+	ospf->prc_networks = route_table_init();
+	ospf->prc_routers = route_table_init();
+}
+
+/*
+ * A partial route calculation (PRC) suffices when only summary-LSAs changed:
+ * the intra-area routes and with them the routes to the area border routers
+ * stay the same. ABRs originate summaries out of the routing table and
+ * virtual links feed transit area summaries back into the backbone, leave
+ * those to the full calculation.
+ */
+static bool ospf_spf_prc_possible(struct ospf *ospf)
+{
+	if (!spf_reason_flags
+	    || (spf_reason_flags
+		& ~((1 << SPF_FLAG_SUMMARY_LSA_INSTALL)
+		    | (1 << SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL))))
+		return false;
+
+	if (IS_OSPF_ABR(ospf) || listcount(ospf->vlinks))
+		return false;
+
+	return ospf->new_table && ospf->new_rtrs;
+}
+
+/* RFC 2328 16.5 and 16.6 for the recorded destinations only. */
+static void ospf_spf_prc_calculate(struct ospf *ospf)
+{
+	struct route_node *rn;
+	struct timeval start_time;
+	unsigned long networks = 0, routers = 0, prc_time;
+
+	monotime(&start_time);
+
+	/* Recalculate, keep the destinations whose routes changed. */
+	for (rn = route_top(ospf->prc_routers); rn; rn = route_next(rn)) {
+		if (!rn->info)
+			continue;
+
+		if (ospf_ia_router_prc(ospf, (struct prefix_ipv4 *)&rn->p))
+			routers++;
+		else {
+			rn->info = NULL;
+			route_unlock_node(rn);
+		}
+	}
+
+	for (rn = route_top(ospf->prc_networks); rn; rn = route_next(rn)) {
+		if (!rn->info)
+			continue;
+
+		if (ospf_ia_network_prc(ospf, (struct prefix_ipv4 *)&rn->p))
+			networks++;
+		else {
+			rn->info = NULL;
+			route_unlock_node(rn);
+		}
+	}
+
+	if (networks || routers)
+		ospf_ase_prc(ospf, ospf->prc_networks, ospf->prc_routers);
+
+	ospf_spf_prc_reset(ospf);
+	ospf->prc_calculation++;
+
+	if (networks)
+		ospf_sr_update_task(ospf);
+
+	prc_time = monotime_since(&start_time, NULL);
+
+	if (IS_DEBUG_OSPF_EVENT)
+		zlog_info(
+			"PRC Processing Time(usecs): %lu (%lu networks, %lu routers changed)",
+			prc_time, networks, routers);
+}
+
 /* Worker for SPF calculation scheduler. */
 static int ospf_spf_calculate_schedule_worker(struct thread *thread)
 {
@@ -1823,6 +2921,30 @@ static int ospf_spf_calculate_schedule_worker(struct thread *thread)
 
 	ospf->t_spf_calc = NULL;
 
+	if (ospf_spf_prc_possible(ospf)) {
+		ospf_spf_prc_calculate(ospf);
+		ospf_clear_spf_reason_flags();
+		return 0;
+	}
+
+	/* The full calculation covers the recorded destinations as well. */
+	ospf_spf_prc_reset(ospf);
+
+	/*
+	 * Trees retained for incremental SPF only track LSDB changes, start
+	 * over on anything else.
+	 */
+	if (spf_reason_flags
+	    & ((1 << SPF_FLAG_ABR_STATUS_CHANGE)
+	       | (1 << SPF_FLAG_ASBR_STATUS_CHANGE)
+	       | (1 << SPF_FLAG_CONFIG_CHANGE) | (1 << SPF_FLAG_GR_FINISH))) {
+		struct ospf_area *area;
+		struct listnode *node;
+
+		for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area))
+			ospf_spf_incremental_free(area);
+	}
+
 	ospf_vl_unapprove(ospf);
 
 	/* Execute SPF for each area including backbone, see RFC 2328 16.1. */
@@ -30,10 +30,14 @@
 
 /* values for vertex->flags */
 #define OSPF_VERTEX_PROCESSED      0x01
+#define OSPF_VERTEX_RETAINED       0x02 /* kept for incremental SPF */
+#define OSPF_VERTEX_AFFECTED       0x04 /* to be recomputed by iSPF */
+#define OSPF_VERTEX_LSA_CURRENT    0x08 /* LSA unchanged since last SPF */
+#define OSPF_VERTEX_BOUNDARY       0x10 /* retained, links to recomputed */
 
 /* The "root" is the node running the SPF calculation */
 
-PREDECL_SKIPLIST_NONUNIQ(vertex_pqueue);
+PREDECL_HEAP(vertex_pqueue);
 /* A router or network in an area */
 struct vertex {
 	struct vertex_pqueue_item pqi;
@@ -43,6 +47,7 @@ struct vertex {
 	struct ospf_lsa *lsa_p;
 	struct lsa_header *lsa; /* Router or Network LSA */
 	uint32_t distance;      /* from root to this vertex */
+	uint32_t seq;           /* creation order, breaks candidate ties */
 	struct list *parents;   /* list of parents in SPF tree */
 	struct list *children;  /* list of children in SPF tree*/
 };
@@ -78,12 +83,20 @@ extern void ospf_spf_calculate(struct ospf_area *area,
 			       struct route_table *new_table,
 			       struct route_table *new_rtrs, bool is_dry_run,
 			       bool is_root_node);
+extern void ospf_spf_calculate_incremental(struct ospf_area *area,
+					   struct ospf_lsa *root_lsa,
+					   struct route_table *new_table,
+					   struct route_table *new_rtrs,
+					   bool is_dry_run, bool is_root_node);
+extern void ospf_spf_incremental_free(struct ospf_area *area);
 extern void ospf_spf_calculate_area(struct ospf *ospf, struct ospf_area *area,
 				    struct route_table *new_table,
 				    struct route_table *new_rtrs);
 extern void ospf_spf_calculate_areas(struct ospf *ospf,
 				     struct route_table *new_table,
 				     struct route_table *new_rtrs);
+extern void ospf_spf_prc_add_lsa(struct ospf *ospf, struct ospf_lsa *lsa);
+extern void ospf_spf_workers_fini(void);
 extern void ospf_rtrs_free(struct route_table *);
 extern void ospf_spf_cleanup(struct vertex *spf, struct list *vertex_list);
 extern void ospf_spf_copy(struct vertex *vertex, struct list *vertex_list);
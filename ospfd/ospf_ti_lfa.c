@@ -41,6 +41,15 @@ DECLARE_RBTREE_UNIQ(p_spaces, struct p_space, p_spaces_item,
 DECLARE_RBTREE_UNIQ(q_spaces, struct q_space, q_spaces_item,
 		    q_spaces_compare_func);
 
+static int ti_lfa_rspfs_cmp(const struct ti_lfa_rspf *a,
+			    const struct ti_lfa_rspf *b)
+{
+	return IPV4_ADDR_CMP(&a->root->id, &b->root->id);
+}
+
+DECLARE_RBTREE_UNIQ(ti_lfa_rspfs, struct ti_lfa_rspf, ti_lfa_rspfs_item,
+		    ti_lfa_rspfs_cmp);
+
 static void
 ospf_ti_lfa_generate_p_space(struct ospf_area *area, struct vertex *child,
 			     struct protected_resource *protected_resource,
@@ -379,6 +388,8 @@ static void ospf_ti_lfa_generate_inner_label_stack(
 	/* Cleanup */
 	ospf_ti_lfa_free_p_spaces(area);
 	ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+	ospf_route_table_free(new_table);
+	ospf_rtrs_free(new_rtrs);
 
 	/* ... and copy the current state back. */
 	area->spf = spf_orig;
@@ -630,6 +641,67 @@ ospf_ti_lfa_generate_post_convergence_path(struct list *pc_vertex_list,
 	return pc_path;
 }
 
+/*
+ * Get the reverse SPF tree rooted at a destination, calculating it on first
+ * use. The trees are kept in area->ti_lfa_rspfs until the P spaces of the
+ * area have been generated.
+ */
+static struct ti_lfa_rspf *ospf_ti_lfa_reverse_spf(struct ospf_area *area,
+						   struct vertex *dest)
+{
+	struct route_table *new_table, *new_rtrs;
+	struct ti_lfa_rspf *rspf, rspf_search;
+	struct vertex *spf_orig;
+	struct list *vertex_list_orig;
+
+	rspf_search.root = dest;
+	rspf = ti_lfa_rspfs_find(area->ti_lfa_rspfs, &rspf_search);
+	if (rspf)
+		return rspf;
+
+	new_table = route_table_init();
+	new_rtrs = route_table_init();
+
+	spf_orig = area->spf;
+	vertex_list_orig = area->spf_vertex_list;
+
+	/*
+	 * Generate a new (reversed!) SPF tree for this vertex,
+	 * dry run true, root node false
+	 */
+	area->spf_reversed = true;
+	ospf_spf_calculate(area, dest->lsa_p, new_table, new_rtrs, true, false);
+
+	/* Reset the flag for reverse SPF */
+	area->spf_reversed = false;
+
+	rspf = XCALLOC(MTYPE_OSPF_Q_SPACE, sizeof(struct ti_lfa_rspf));
+	rspf->root = area->spf;
+	rspf->vertex_list = area->spf_vertex_list;
+	ti_lfa_rspfs_add(area->ti_lfa_rspfs, rspf);
+
+	area->spf = spf_orig;
+	area->spf_vertex_list = vertex_list_orig;
+
+	ospf_route_table_free(new_table);
+	ospf_rtrs_free(new_rtrs);
+
+	return rspf;
+}
+
+static void ospf_ti_lfa_free_reverse_spfs(struct ospf_area *area)
+{
+	struct ti_lfa_rspf *rspf;
+
+	while ((rspf = ti_lfa_rspfs_pop(area->ti_lfa_rspfs))) {
+		ospf_spf_cleanup(rspf->root, rspf->vertex_list);
+		XFREE(MTYPE_OSPF_Q_SPACE, rspf);
+	}
+
+	ti_lfa_rspfs_fini(area->ti_lfa_rspfs);
+	XFREE(MTYPE_OSPF_Q_SPACE, area->ti_lfa_rspfs);
+}
+
 static void ospf_ti_lfa_generate_q_spaces(struct ospf_area *area,
 					  struct p_space *p_space,
 					  struct vertex *dest, bool recursive,
@@ -637,7 +709,7 @@ static void ospf_ti_lfa_generate_q_spaces(struct ospf_area *area,
 {
 	struct listnode *node;
 	struct vertex *child;
-	struct route_table *new_table, *new_rtrs;
+	struct ti_lfa_rspf *rspf;
 	struct q_space *q_space, q_space_search;
 	char label_buf[MPLS_LABEL_STRLEN];
 	char res_buf[PROTECTED_RESOURCE_STRLEN];
@@ -675,21 +747,11 @@ static void ospf_ti_lfa_generate_q_spaces(struct ospf_area *area,
 	q_space->q_node_info = XCALLOC(MTYPE_OSPF_Q_SPACE,
 				       sizeof(struct ospf_ti_lfa_node_info));
 
-	new_table = route_table_init();
-	new_rtrs = route_table_init();
-
-	/*
-	 * Generate a new (reversed!) SPF tree for this vertex,
-	 * dry run true, root node false
-	 */
-	area->spf_reversed = true;
-	ospf_spf_calculate(area, dest->lsa_p, new_table, new_rtrs, true, false);
-
-	/* Reset the flag for reverse SPF */
-	area->spf_reversed = false;
-
-	q_space->root = area->spf;
-	q_space->vertex_list = area->spf_vertex_list;
+	/* The Q space gets its own copy of the reverse SPF tree */
+	rspf = ospf_ti_lfa_reverse_spf(area, dest);
+	q_space->vertex_list = list_new();
+	ospf_spf_copy(rspf->root, q_space->vertex_list);
+	q_space->root = listnode_head(q_space->vertex_list);
 	q_space->label_stack = NULL;
 
 	if (pc_path)
@@ -705,6 +767,10 @@ static void ospf_ti_lfa_generate_q_spaces(struct ospf_area *area,
 			"%s: NO backup path found for root %pI4 and destination %pI4 for %s, aborting ...",
 			__func__, &p_space->root->id, &q_space->root->id,
 			res_buf);
+		ospf_spf_cleanup(q_space->root, q_space->vertex_list);
+		XFREE(MTYPE_OSPF_Q_SPACE, q_space->p_node_info);
+		XFREE(MTYPE_OSPF_Q_SPACE, q_space->q_node_info);
+		XFREE(MTYPE_OSPF_Q_SPACE, q_space);
 		return;
 	}
 
@@ -776,6 +842,9 @@ static void ospf_ti_lfa_generate_post_convergence_spf(struct ospf_area *area,
 	p_space->pc_vertex_list = area->spf_vertex_list;
 
 	area->spf_protected_resource = NULL;
+
+	ospf_route_table_free(new_table);
+	ospf_rtrs_free(new_rtrs);
 }
 
 static void
@@ -785,7 +854,17 @@ ospf_ti_lfa_generate_p_space(struct ospf_area *area, struct vertex *child,
 {
 	struct vertex *spf_orig;
 	struct list *vertex_list, *vertex_list_orig;
-	struct p_space *p_space;
+	struct p_space *p_space, p_space_search;
+
+	/*
+	 * Parallel links to a protected node, or several next hops on a
+	 * protected link, yield the same resource more than once.
+	 */
+	p_space_search.protected_resource = protected_resource;
+	if (p_spaces_find(area->p_spaces, &p_space_search)) {
+		XFREE(MTYPE_OSPF_P_SPACE, protected_resource);
+		return;
+	}
 
 	p_space = XCALLOC(MTYPE_OSPF_P_SPACE, sizeof(struct p_space));
 	vertex_list = list_new();
@@ -857,6 +936,10 @@ void ospf_ti_lfa_generate_p_spaces(struct ospf_area *area,
 	zlog_info("%s: Generating P spaces for area %pI4", __func__,
 		  &area->area_id);
 
+	area->ti_lfa_rspfs =
+		XCALLOC(MTYPE_OSPF_Q_SPACE, sizeof(struct ti_lfa_rspfs_head));
+	ti_lfa_rspfs_init(area->ti_lfa_rspfs);
+
 	/*
 	 * Iterate over all stub networks which target other OSPF neighbors.
 	 * Check the nexthop of the child vertex if a stub network is relevant.
@@ -934,6 +1017,8 @@ void ospf_ti_lfa_generate_p_spaces(struct ospf_area *area,
 			}
 		}
 	}
+
+	ospf_ti_lfa_free_reverse_spfs(area);
 }
 
 static struct p_space *ospf_ti_lfa_get_p_space_by_path(struct ospf_area *area,
@@ -2670,6 +2670,96 @@ DEFUN(no_ospf_ti_lfa, no_ospf_ti_lfa_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFUN(ospf_ispf, ospf_ispf_cmd, "ispf",
+      "Enable incremental SPF\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+
+	if (ospf->spf_incremental)
+		return CMD_SUCCESS;
+
+	ospf->spf_incremental = true;
+	ospf_spf_calculate_schedule(ospf, SPF_FLAG_CONFIG_CHANGE);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(no_ospf_ispf, no_ospf_ispf_cmd, "no ispf",
+      NO_STR
+      "Enable incremental SPF\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+
+	if (!ospf->spf_incremental)
+		return CMD_SUCCESS;
+
+	ospf->spf_incremental = false;
+	ospf_spf_calculate_schedule(ospf, SPF_FLAG_CONFIG_CHANGE);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(ospf_spf_threads, ospf_spf_threads_cmd, "spf-threads (1-64)",
+      "Number of threads calculating area SPFs\n"
+      "Number of threads\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+	int idx_number = 1;
+
+	ospf->spf_threads = strtoul(argv[idx_number]->arg, NULL, 10);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(no_ospf_spf_threads, no_ospf_spf_threads_cmd, "no spf-threads [(1-64)]",
+      NO_STR
+      "Number of threads calculating area SPFs\n"
+      "Number of threads\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+
+	ospf->spf_threads = OSPF_SPF_THREADS_DEFAULT;
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(ospf_flood_pacing, ospf_flood_pacing_cmd,
+      "flood-pacing (1-100000) [burst (1-10000)]",
+      "Pace LS Update transmission on each interface\n"
+      "LS Update packets per second\n"
+      "Maximum burst of LS Update packets\n"
+      "Number of packets\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+	int idx_number = 1;
+	int idx = 0;
+
+	ospf->flood_pacing_rate = strtoul(argv[idx_number]->arg, NULL, 10);
+	if (argv_find(argv, argc, "burst", &idx))
+		ospf->flood_pacing_burst =
+			strtoul(argv[idx + 1]->arg, NULL, 10);
+	else
+		ospf->flood_pacing_burst = OSPF_FLOOD_PACING_BURST_DEFAULT;
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(no_ospf_flood_pacing, no_ospf_flood_pacing_cmd,
+      "no flood-pacing [(1-100000) [burst (1-10000)]]",
+      NO_STR
+      "Pace LS Update transmission on each interface\n"
+      "LS Update packets per second\n"
+      "Maximum burst of LS Update packets\n"
+      "Number of packets\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+
+	ospf->flood_pacing_rate = 0;
+	ospf->flood_pacing_burst = OSPF_FLOOD_PACING_BURST_DEFAULT;
+
+	return CMD_SUCCESS;
+}
+
 static void ospf_maxpath_set(struct vty *vty, struct ospf *ospf, uint16_t paths)
 {
 	if (ospf->max_multipath == paths)
@@ -2925,6 +3015,10 @@ static void show_ip_ospf_area(struct vty *vty, struct ospf_area *area,
 		/* Show SPF calculation times. */
 		json_object_int_add(json_area, "spfExecutedCounter",
 				    area->spf_calculation);
+		if (area->ospf->spf_incremental)
+			json_object_int_add(
+				json_area, "spfIncrementalExecutedCounter",
+				area->spf_incremental_calculation);
 		json_object_int_add(json_area, "lsaNumber", area->lsdb->total);
 		json_object_int_add(
 			json_area, "lsaRouterNumber",
@@ -2979,6 +3073,9 @@ static void show_ip_ospf_area(struct vty *vty, struct ospf_area *area,
 		/* Show SPF calculation times. */
 		vty_out(vty, "   SPF algorithm executed %d times\n",
 			area->spf_calculation);
+		if (area->ospf->spf_incremental)
+			vty_out(vty, "   Incremental SPF executed %d times\n",
+				area->spf_incremental_calculation);
 
 		/* Show number of LSA. */
 		vty_out(vty, "   Number of LSA %ld\n", area->lsdb->total);
@@ -3191,6 +3288,10 @@ static int show_ip_ospf_common(struct vty *vty, struct ospf *ospf,
 					    time_store);
 		} else
 			json_object_boolean_true_add(json_vrf, "spfHasNotRun");
+
+		if (ospf->prc_calculation)
+			json_object_int_add(json_vrf, "prcExecutedCounter",
+					    ospf->prc_calculation);
 	} else {
 		vty_out(vty, " SPF algorithm ");
 		if (ospf->ts_spf.tv_sec || ospf->ts_spf.tv_usec) {
@@ -3203,6 +3304,11 @@ static int show_ip_ospf_common(struct vty *vty, struct ospf *ospf,
 						  timebuf, sizeof(timebuf)));
 		} else
 			vty_out(vty, "has not been run\n");
+
+		if (ospf->prc_calculation)
+			vty_out(vty,
+				" Partial route calculation executed %u times\n",
+				ospf->prc_calculation);
 	}
 
 	if (json) {
@@ -3222,6 +3328,15 @@ static int show_ip_ospf_common(struct vty *vty, struct ospf *ospf,
 		/* Show write multiplier values */
 		json_object_int_add(json_vrf, "writeMultiplier",
 				    ospf->write_oi_count);
+		if (ospf->spf_threads != OSPF_SPF_THREADS_DEFAULT)
+			json_object_int_add(json_vrf, "spfThreads",
+					    ospf->spf_threads);
+		if (ospf->flood_pacing_rate) {
+			json_object_int_add(json_vrf, "floodPacingRate",
+					    ospf->flood_pacing_rate);
+			json_object_int_add(json_vrf, "floodPacingBurst",
+					    ospf->flood_pacing_burst);
+		}
 		/* Show refresh parameters. */
 		json_object_int_add(json_vrf, "refreshTimerMsecs",
 				    ospf->lsa_refresh_interval * 1000);
@@ -3239,6 +3354,14 @@ static int show_ip_ospf_common(struct vty *vty, struct ospf *ospf,
 		/* Show write multiplier values */
 		vty_out(vty, " Write Multiplier set to %d \n",
 			ospf->write_oi_count);
+		if (ospf->spf_threads != OSPF_SPF_THREADS_DEFAULT)
+			vty_out(vty, " Area SPFs calculated by %u threads\n",
+				ospf->spf_threads);
+		if (ospf->flood_pacing_rate)
+			vty_out(vty,
+				" LS Update pacing %u packets/sec, burst %u\n",
+				ospf->flood_pacing_rate,
+				ospf->flood_pacing_burst);
 
 		/* Show refresh parameters. */
 		vty_out(vty, " Refresh timer %d secs\n",
@@ -12459,6 +12582,15 @@ static int ospf_config_write_one(struct vty *vty, struct ospf *ospf)
 		vty_out(vty, " ospf write-multiplier %d\n",
 			ospf->write_oi_count);
 
+	/* LS Update pacing print. */
+	if (ospf->flood_pacing_rate) {
+		vty_out(vty, " flood-pacing %u", ospf->flood_pacing_rate);
+		if (ospf->flood_pacing_burst
+		    != OSPF_FLOOD_PACING_BURST_DEFAULT)
+			vty_out(vty, " burst %u", ospf->flood_pacing_burst);
+		vty_out(vty, "\n");
+	}
+
 	if (ospf->max_multipath != MULTIPATH_NUM)
 		vty_out(vty, " maximum-paths %d\n", ospf->max_multipath);
 
@@ -12499,6 +12631,14 @@ static int ospf_config_write_one(struct vty *vty, struct ospf *ospf)
 			vty_out(vty, " fast-reroute ti-lfa\n");
 	}
 
+	/* Incremental SPF print. */
+	if (ospf->spf_incremental)
+		vty_out(vty, " ispf\n");
+
+	/* SPF threads print. */
+	if (ospf->spf_threads != OSPF_SPF_THREADS_DEFAULT)
+		vty_out(vty, " spf-threads %u\n", ospf->spf_threads);
+
 	/* Network area print. */
 	config_write_network_area(vty, ospf);
 
@@ -12963,6 +13103,14 @@ void ospf_vty_init(void)
 	install_element(OSPF_NODE, &ospf_ti_lfa_cmd);
 	install_element(OSPF_NODE, &no_ospf_ti_lfa_cmd);
 
+	/* incremental SPF commands */
+	install_element(OSPF_NODE, &ospf_ispf_cmd);
+	install_element(OSPF_NODE, &no_ospf_ispf_cmd);
+	install_element(OSPF_NODE, &ospf_spf_threads_cmd);
+	install_element(OSPF_NODE, &no_ospf_spf_threads_cmd);
+	install_element(OSPF_NODE, &ospf_flood_pacing_cmd);
+	install_element(OSPF_NODE, &no_ospf_flood_pacing_cmd);
+
 	/* Max path configurations */
 	install_element(OSPF_NODE, &ospf_max_multipath_cmd);
 	install_element(OSPF_NODE, &no_ospf_max_multipath_cmd);
@@ -353,6 +353,10 @@ struct ospf *ospf_new_alloc(unsigned short instance, const char *name)
 	new->new_external_route = route_table_init();
 	new->old_external_route = route_table_init();
 	new->external_lsas = route_table_init();
+	new->external_lsas_by_asbr = route_table_init();
+	new->external_lsas_by_fwd = route_table_init();
+	new->prc_networks = route_table_init();
+	new->prc_routers = route_table_init();
 
 	new->stub_router_startup_time = OSPF_STUB_ROUTER_UNCONFIGURED;
 	new->stub_router_shutdown_time = OSPF_STUB_ROUTER_UNCONFIGURED;
@@ -400,6 +404,8 @@ struct ospf *ospf_new_alloc(unsigned short instance, const char *name)
 	new->t_read = NULL;
 	new->oi_write_q = list_new();
 	new->write_oi_count = OSPF_WRITE_INTERFACE_COUNT_DEFAULT;
+	new->flood_pacing_burst = OSPF_FLOOD_PACING_BURST_DEFAULT;
+	new->spf_threads = OSPF_SPF_THREADS_DEFAULT;
 
 	new->proactive_arp = OSPF_PROACTIVE_ARP_DEFAULT;
 
@@ -653,6 +659,9 @@ void ospf_terminate(void)
 	for (ALL_LIST_ELEMENTS(om->ospf, node, nnode, ospf))
 		ospf_finish(ospf);
 
+	/* Stop the parallel SPF workers */
+	ospf_spf_workers_fini();
+
 	/* Cleanup GR */
 	ospf_gr_helper_stop();
 
@@ -851,6 +860,10 @@ static void ospf_finish_final(struct ospf *ospf)
 	if (ospf->external_lsas) {
 		ospf_ase_external_lsas_finish(ospf->external_lsas);
 	}
+	ospf_ase_external_lsas_finish(ospf->external_lsas_by_asbr);
+	ospf_ase_external_lsas_finish(ospf->external_lsas_by_fwd);
+	route_table_finish(ospf->prc_networks);
+	route_table_finish(ospf->prc_routers);
 
 	for (i = ZEBRA_ROUTE_SYSTEM; i <= ZEBRA_ROUTE_MAX; i++) {
 		struct list *ext_list;
@@ -977,6 +990,8 @@ void ospf_area_lsdb_discard_delete(struct ospf_area *area)
 
 static void ospf_area_free(struct ospf_area *area)
 {
+	ospf_spf_incremental_free(area);
+
 	ospf_opaque_type10_lsa_term(area);
 
 	/* Free LSDBs. */
@@ -1430,6 +1445,7 @@ void ospf_ls_upd_queue_empty(struct ospf_interface *oi)
 			list_delete(&lst);
 			rn->info = NULL;
 		}
+	ospf_ls_upd_index_clean(oi);
 
 	/* remove update event */
 	thread_cancel(&oi->t_ls_upd_event);
@@ -241,6 +241,16 @@ struct ospf {
 
 	struct route_table *external_lsas; /* Database of external LSAs,
 					      prefix is LSA's adv. network*/
+	/* The same LSAs by advertising router and by forwarding address,
+	   see ospf_ase_prc(). */
+	struct route_table *external_lsas_by_asbr;
+	struct route_table *external_lsas_by_fwd;
+
+	/* Destinations of summary-LSAs changed since the last route
+	   calculation, see ospf_spf_prc_add_lsa(). */
+	struct route_table *prc_networks;
+	struct route_table *prc_routers;
+	uint32_t prc_calculation;
 
 	/* Time stamps */
 	struct timeval ts_spf;		/* SPF calculation time stamp. */
@@ -273,6 +283,11 @@ struct ospf {
 	struct thread *t_default_routemap_timer;
 
 	int write_oi_count; /* Num of packets sent per thread invocation */
+
+	/* LS Update pacing, packets per second per interface (0: off). */
+	uint32_t flood_pacing_rate;
+	uint32_t flood_pacing_burst;
+#define OSPF_FLOOD_PACING_BURST_DEFAULT 10
 	struct thread *t_read;
 	int fd;
 	struct stream *ibuf;
@@ -401,6 +416,14 @@ struct ospf {
 	bool ti_lfa_enabled;
 	enum protection_type ti_lfa_protection_type;
 
+	/* Incremental SPF, see ospf_spf_calculate_incremental(). */
+	bool spf_incremental;
+
+	/* Threads running area SPFs, see ospf_spf_calculate_areas(). */
+	unsigned int spf_threads;
+#define OSPF_SPF_THREADS_DEFAULT 1
+#define OSPF_SPF_THREADS_MAX 64
+
 	QOBJ_FIELDS;
 };
 DECLARE_QOBJ_TYPE(ospf);
@@ -462,6 +485,18 @@ struct p_space {
 	struct p_spaces_item p_spaces_item;
 };
 
+/*
+ * Reverse SPF tree rooted at a Q space destination. It does not depend on
+ * the protected resource, so it is calculated once and copied into every
+ * Q space for that destination.
+ */
+PREDECL_RBTREE_UNIQ(ti_lfa_rspfs);
+struct ti_lfa_rspf {
+	struct vertex *root;
+	struct list *vertex_list;
+	struct ti_lfa_rspfs_item ti_lfa_rspfs_item;
+};
+
 /* OSPF area structure. */
 struct ospf_area {
 	/* OSPF instance. */
@@ -553,6 +588,7 @@ struct ospf_area {
 	/* Shortest Path Tree. */
 	struct vertex *spf;
 	struct list *spf_vertex_list;
+	uint32_t spf_vertex_seq; /* next vertex sequence number */
 
 	bool spf_dry_run;   /* flag for checking if the SPF calculation is
 			       intended for the local RIB */
@@ -564,6 +600,7 @@ struct ospf_area {
 
 	/* P/Q spaces for TI-LFA */
 	struct p_spaces_head *p_spaces;
+	struct ti_lfa_rspfs_head *ti_lfa_rspfs;
 
 	/* Threads. */
 	struct thread *t_stub_router;     /* Stub-router timer */
@@ -571,6 +608,10 @@ struct ospf_area {
 
 	/* Statistics field. */
 	uint32_t spf_calculation; /* SPF Calculation Count. */
+	uint32_t spf_incremental_calculation; /* ... of which incremental */
+
+	/* Set when incremental SPF finds the retained tree to be invalid */
+	bool spf_incremental_abort;
 
 	/* reverse SPF (used for TI-LFA Q spaces) */
 	bool spf_reversed;
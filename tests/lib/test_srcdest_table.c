@@ -25,6 +25,7 @@
 
 #include "hash.h"
 #include "memory.h"
+#include "monotime.h"
 #include "prefix.h"
 #include "prng.h"
 #include "srcdest_table.h"
@@ -428,8 +429,106 @@ static void run_prng_test(void)
 	test_state_free(test);
 }
 
+/*
+ * Throughput benchmarks, not part of the regular test run:
+ *
+ *   test_srcdest_table bench [count ...]
+ *
+ * inserts count random IPv6 routes (default 1M and 10M), every eighth one
+ * with a source prefix, then looks each of them up and walks the table.
+ */
+static void bench_rand_prefix(struct prng *prng, struct prefix_ipv6 *p,
+			      unsigned int minlen)
+{
+	int i;
+
+	p->family = AF_INET6;
+	p->prefixlen = minlen + prng_rand(prng) % (65 - minlen);
+	for (i = 0; i < 4; i++)
+		p->prefix.s6_addr32[i] = prng_rand(prng);
+	apply_mask_ipv6(p);
+}
+
+static double bench_rate(unsigned long count, const struct timeval *start)
+{
+	int64_t usec = monotime_since(start, NULL);
+
+	return usec ? count * 1000000.0 / usec : 0;
+}
+
+static void bench_srcdest(struct prng *prng, unsigned long count)
+{
+	struct route_table *table = srcdest_table_init();
+	struct prefix_ipv6 *dst, *src;
+	struct route_node *rn;
+	struct timeval start;
+	unsigned long i, found = 0;
+	double insert, lookup, walk;
+
+	dst = calloc(count, sizeof(*dst));
+	src = calloc(count, sizeof(*src));
+	assert(dst && src);
+
+	for (i = 0; i < count; i++) {
+		bench_rand_prefix(prng, &dst[i], 32);
+		if (!(i % 8))
+			bench_rand_prefix(prng, &src[i], 48);
+	}
+
+	monotime(&start);
+	for (i = 0; i < count; i++) {
+		rn = srcdest_rnode_get(table, &dst[i],
+				       src[i].prefixlen ? &src[i] : NULL);
+		rn->info = &dst[i];
+	}
+	insert = bench_rate(count, &start);
+
+	monotime(&start);
+	for (i = 0; i < count; i++) {
+		rn = srcdest_rnode_lookup(table, &dst[i],
+					  src[i].prefixlen ? &src[i] : NULL);
+		if (rn) {
+			found++;
+			route_unlock_node(rn);
+		}
+	}
+	lookup = bench_rate(count, &start);
+	assert(found == count);
+
+	found = 0;
+	monotime(&start);
+	for (rn = route_top(table); rn; rn = srcdest_route_next(rn))
+		found++;
+	walk = bench_rate(found, &start);
+
+	printf("srcdest %lu routes (%lu nodes): insert %.0f/s, lookup %.0f/s, walk %.0f nodes/s\n",
+	       count, found, insert, lookup, walk);
+
+	route_table_finish(table);
+	free(dst);
+	free(src);
+}
+
+static void run_bench(int argc, char **argv)
+{
+	static const unsigned long defaults[] = {1000000, 10000000};
+	struct prng *prng = prng_new(0);
+	int i;
+
+	for (i = 0; i < (argc ? argc : (int)array_size(defaults)); i++)
+		bench_srcdest(prng, argc ? strtoul(argv[i], NULL, 0)
+					 : defaults[i]);
+
+	prng_free(prng);
+}
+
 int main(int argc, char *argv[])
 {
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		run_bench(argc - 2, argv + 2);
+		return 0;
+	}
+
 	run_prng_test();
 	printf("PRNG Test successful.\n");
 	return 0;
@@ -23,7 +23,9 @@
 #include <stream.h>
 #include <thread.h>
 
+#include "monotime.h"
 #include "printfrr.h"
+#include "segbuf.h"
 
 static unsigned long long ham = 0xdeadbeefdeadbeef;
 struct thread_master *master;
@@ -46,9 +48,188 @@ static void print_stream(struct stream *s)
 	stream_set_getp(s, getp);
 }
 
-int main(void)
+static void print_segbuf(struct segbuf *sb)
 {
+	struct stream *s = segbuf_to_stream(sb);
+	struct iovec iov[8];
+	unsigned int niov;
+
+	niov = segbuf_iovec(sb, iov, array_size(iov));
+	printfrr("segbuf len: %zu, readable: %zu, iov: %u\n", SEGBUF_LEN(sb),
+		 SEGBUF_READABLE(sb), niov);
+	print_stream(s);
+	stream_free(s);
+}
+
+static void test_segbuf(void)
+{
+	struct segbuf *sb, *clone, *slice;
 	struct stream *s;
+	uint8_t buf[SEGBUF_SEG_SIZE];
+	unsigned int i;
+
+	s = stream_new(16);
+	for (i = 0; i < 8; i++)
+		stream_putc(s, i);
+	stream_forward_getp(s, 2);
+
+	/* adopts s, starting at getp */
+	sb = segbuf_from_stream(s);
+	segbuf_put(sb, "\x10\x11\x12", 3);
+	segbuf_put(sb, "\x13", 1);
+	print_segbuf(sb);
+
+	clone = segbuf_clone(sb);
+	slice = segbuf_slice(sb, 4, 4);
+	print_segbuf(slice);
+
+	/* the tail segment is shared now, so this must not touch the clone */
+	segbuf_put(sb, "\x14", 1);
+	print_segbuf(clone);
+
+	segbuf_forward_getp(sb, 7);
+	printfrr("byte at 0: 0x%x, getp 7: 0x%x\n", segbuf_getc_from(sb, 0),
+		 segbuf_getc_from(sb, 7));
+	segbuf_compact(sb);
+	print_segbuf(sb);
+
+	segbuf_free(clone);
+	segbuf_free(slice);
+
+	/* spills over into a second segment */
+	memset(buf, 0xaa, sizeof(buf));
+	segbuf_put(sb, buf, sizeof(buf));
+	printfrr("segbuf len: %zu, iov: %u\n", SEGBUF_LEN(sb),
+		 segbuf_iovec(sb, (struct iovec[4]){}, 4));
+	segbuf_free(sb);
+}
+
+/*
+ * Throughput benchmarks, not part of the regular test run:
+ *
+ *   test_stream bench [count]
+ *
+ * fans count 4k messages out to a number of output queues, once by
+ * duplicating the stream for each queue and once by cloning a segbuf, then
+ * exports each queue entry as iovec like a writev() based writer would.
+ */
+#define BENCH_QUEUES 16
+#define BENCH_MSGSIZE 4096
+
+static double bench_rate(unsigned long count, const struct timeval *start)
+{
+	int64_t usec = monotime_since(start, NULL);
+
+	return usec ? count * 1000000.0 / usec : 0;
+}
+
+static void bench_stream(unsigned long count)
+{
+	struct stream_fifo *fifos[BENCH_QUEUES];
+	struct stream *msg, *s;
+	struct timeval start;
+	size_t bytes = 0;
+	unsigned long i;
+	unsigned int q;
+
+	for (q = 0; q < BENCH_QUEUES; q++)
+		fifos[q] = stream_fifo_new();
+
+	msg = stream_new(BENCH_MSGSIZE);
+	stream_put(msg, NULL, BENCH_MSGSIZE);
+
+	monotime(&start);
+	for (i = 0; i < count; i++) {
+		for (q = 0; q < BENCH_QUEUES; q++)
+			stream_fifo_push(fifos[q], stream_dup(msg));
+
+		for (q = 0; q < BENCH_QUEUES; q++) {
+			s = stream_fifo_pop(fifos[q]);
+			bytes += STREAM_READABLE(s);
+			stream_free(s);
+		}
+	}
+	printf("stream_dup:   %.0f msgs/s, %.0f MB/s\n",
+	       bench_rate(count * BENCH_QUEUES, &start),
+	       bench_rate(bytes, &start) / 1e6);
+
+	stream_free(msg);
+	for (q = 0; q < BENCH_QUEUES; q++)
+		stream_fifo_free(fifos[q]);
+}
+
+static void bench_segbuf(unsigned long count)
+{
+	struct segbuf_fifo *fifos[BENCH_QUEUES];
+	struct segbuf *msg, *sb;
+	struct stream *s;
+	struct timeval start;
+	struct iovec iov[4];
+	unsigned int q, niov;
+	size_t bytes = 0;
+	unsigned long i;
+
+	for (q = 0; q < BENCH_QUEUES; q++)
+		fifos[q] = segbuf_fifo_new();
+
+	s = stream_new(BENCH_MSGSIZE);
+	stream_put(s, NULL, BENCH_MSGSIZE);
+	msg = segbuf_from_stream(s);
+
+	monotime(&start);
+	for (i = 0; i < count; i++) {
+		for (q = 0; q < BENCH_QUEUES; q++)
+			segbuf_fifo_push(fifos[q], segbuf_clone(msg));
+
+		for (q = 0; q < BENCH_QUEUES; q++) {
+			sb = segbuf_fifo_pop(fifos[q]);
+			niov = segbuf_iovec(sb, iov, array_size(iov));
+			while (niov)
+				bytes += iov[--niov].iov_len;
+			segbuf_free(sb);
+		}
+	}
+	printf("segbuf_clone: %.0f msgs/s, %.0f MB/s\n",
+	       bench_rate(count * BENCH_QUEUES, &start),
+	       bench_rate(bytes, &start) / 1e6);
+
+	segbuf_free(msg);
+	for (q = 0; q < BENCH_QUEUES; q++)
+		segbuf_fifo_free(fifos[q]);
+
+	/* small copying appends, as done by byte stream writers */
+	sb = segbuf_new();
+	bytes = 0;
+	monotime(&start);
+	for (i = 0; i < count * BENCH_QUEUES; i++) {
+		segbuf_put(sb, &i, sizeof(i));
+		bytes += sizeof(i);
+		if (SEGBUF_READABLE(sb) >= 16384) {
+			segbuf_forward_getp(sb, SEGBUF_READABLE(sb));
+			segbuf_compact(sb);
+		}
+	}
+	printf("segbuf_put:   %.0f puts/s, %.0f MB/s\n",
+	       bench_rate(count * BENCH_QUEUES, &start),
+	       bench_rate(bytes, &start) / 1e6);
+	segbuf_free(sb);
+}
+
+int main(int argc, char **argv)
+{
+	struct stream *s;
+
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		unsigned long count = 100000;
+
+		if (argc > 2)
+			count = strtoul(argv[2], NULL, 0);
+
+		segbuf_init();
+		bench_stream(count);
+		bench_segbuf(count);
+		return 0;
+	}
 
 	s = stream_new(1024);
 
@@ -68,5 +249,9 @@ int main(void)
 	printfrr("l: 0x%x\n", stream_getl(s));
 	printfrr("q: 0x%" PRIx64 "\n", stream_getq(s));
 
+	stream_free(s);
+
+	test_segbuf();
+
 	return 0;
 }
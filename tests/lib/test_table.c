@@ -23,6 +23,8 @@
 #include "printfrr.h"
 #include "prefix.h"
 #include "table.h"
+#include "frrcu.h"
+#include "monotime.h"
 
 /*
  * test_node_t
@@ -490,6 +492,130 @@ static void test_iter_pause(void)
 	route_table_finish(table);
 }
 
+/*
+ * test_rcu
+ *
+ * Have a second pthread do RCU lookups while the table is being changed.
+ * 10.0.0.0/8 and 10.<n>.0.0/16 (n < RCU_TEST_ANCHORS) are always there; the
+ * churn only adds and removes longer prefixes below 10/8, so every lookup
+ * for an address in 10/8 must find a covering prefix at least as long as
+ * the anchor.
+ */
+#define RCU_TEST_ANCHORS 16
+#define RCU_TEST_ROUNDS 200000
+#define RCU_TEST_LIVE 1024
+
+struct rcu_test {
+	struct route_table *table;
+	struct rcu_thread *rcu_thread;
+	atomic_bool done;
+	unsigned long lookups;
+};
+
+static uint32_t rcu_test_rand(uint32_t *state)
+{
+	*state = *state * 1103515245 + 12345;
+	return *state >> 1;
+}
+
+static void rcu_test_prefix(struct prefix *p, uint32_t addr,
+			    unsigned int len)
+{
+	memset(p, 0, sizeof(*p));
+	p->family = AF_INET;
+	p->prefixlen = len;
+	p->u.prefix4.s_addr = htonl(addr);
+	apply_mask(p);
+}
+
+static void *rcu_test_reader(void *arg)
+{
+	struct rcu_test *rt = arg;
+	struct route_node *rn;
+	struct prefix p;
+	uint32_t state = 1, addr;
+	unsigned int want;
+
+	rcu_thread_start(rt->rcu_thread);
+
+	while (!atomic_load_explicit(&rt->done, memory_order_relaxed)) {
+		addr = 0x0a000000 | (rcu_test_rand(&state) & 0x00ffffff);
+		want = ((addr >> 16) & 0xff) < RCU_TEST_ANCHORS ? 16 : 8;
+		rcu_test_prefix(&p, addr, IPV4_MAX_BITLEN);
+
+		rn = route_node_match_rcu(rt->table, &p);
+		assert(rn && rn->p.prefixlen >= want);
+		assert(prefix_match(&rn->p, &p));
+
+		if (!(++rt->lookups % 64)) {
+			rcu_read_unlock();
+			rcu_read_lock();
+		}
+	}
+	return NULL;
+}
+
+static void test_rcu(void)
+{
+	static int anchor_info, churn_info;
+	static struct route_node *live[RCU_TEST_LIVE];
+	struct rcu_test rt = {};
+	struct route_node *rn;
+	struct prefix p;
+	pthread_t reader;
+	uint32_t state = 2, addr;
+	unsigned int i;
+
+	printf("\n\nTesting RCU lookups against concurrent changes\n");
+
+	rt.table = route_table_init();
+	route_table_set_rcu(rt.table);
+
+	rcu_test_prefix(&p, 0x0a000000, 8);
+	route_node_get(rt.table, &p)->info = &anchor_info;
+	for (i = 0; i < RCU_TEST_ANCHORS; i++) {
+		rcu_test_prefix(&p, 0x0a000000 | (i << 16), 16);
+		route_node_get(rt.table, &p)->info = &anchor_info;
+	}
+
+	rt.rcu_thread = rcu_thread_prepare();
+	assert(!pthread_create(&reader, NULL, rcu_test_reader, &rt));
+
+	/* keep the last RCU_TEST_LIVE added prefixes, remove the oldest */
+	for (i = 0; i < RCU_TEST_ROUNDS; i++) {
+		rn = live[i % RCU_TEST_LIVE];
+		if (rn) {
+			rn->info = NULL;
+			route_unlock_node(rn);
+		}
+
+		addr = 0x0a000000 | (rcu_test_rand(&state) & 0x00ffffff);
+		rcu_test_prefix(&p, addr, 12 + rcu_test_rand(&state) % 21);
+
+		rn = route_node_get(rt.table, &p);
+		if (rn->info) {
+			/* already there, anchor or live */
+			route_unlock_node(rn);
+			rn = NULL;
+		} else
+			rn->info = &churn_info;
+		live[i % RCU_TEST_LIVE] = rn;
+
+		/* let the RCU sweeper make progress */
+		if (!(i % 1024)) {
+			rcu_read_unlock();
+			rcu_read_lock();
+		}
+	}
+
+	atomic_store_explicit(&rt.done, true, memory_order_relaxed);
+	pthread_join(reader, NULL);
+	assert(rt.lookups > 0);
+
+	route_table_finish(rt.table);
+	printf("Verified RCU lookups\n");
+}
+
 /*
  * run_tests
  */
@@ -498,12 +624,122 @@ static void run_tests(void)
 	test_prefix_iter_cmp();
 	test_get_next();
 	test_iter_pause();
+	test_rcu();
+}
+
+/*
+ * Throughput benchmarks, not part of the regular test run:
+ *
+ *   test_table bench [count ...]
+ *
+ * inserts count random IPv4 and IPv6 prefixes (default 1M and 10M), then
+ * does a longest-match lookup for an address inside each of them and
+ * walks the whole table.
+ */
+static uint64_t bench_rand_state = 88172645463325252ULL;
+
+static uint64_t bench_rand(void)
+{
+	bench_rand_state ^= bench_rand_state << 13;
+	bench_rand_state ^= bench_rand_state >> 7;
+	bench_rand_state ^= bench_rand_state << 17;
+	return bench_rand_state;
+}
+
+static double bench_rate(unsigned long count, const struct timeval *start)
+{
+	int64_t usec = monotime_since(start, NULL);
+
+	return usec ? count * 1000000.0 / usec : 0;
+}
+
+static void bench_table(int family, unsigned long count)
+{
+	struct route_table *table = route_table_init();
+	struct prefix *prefixes, addr;
+	struct route_node *rn;
+	struct timeval start;
+	unsigned long i, found = 0;
+	double insert, match, walk;
+
+	prefixes = calloc(count, sizeof(*prefixes));
+	assert(prefixes);
+
+	for (i = 0; i < count; i++) {
+		struct prefix *p = &prefixes[i];
+		uint64_t r = bench_rand();
+
+		p->family = family;
+		if (family == AF_INET) {
+			/* mostly /24 and longer, like a real table */
+			p->prefixlen = 16 + r % 17;
+			p->u.prefix4.s_addr = (uint32_t)(r >> 32);
+		} else {
+			p->prefixlen = 32 + r % 33;
+			memcpy(&p->u.prefix6, &r, sizeof(r));
+			r = bench_rand();
+			memcpy((uint8_t *)&p->u.prefix6 + 8, &r, sizeof(r));
+		}
+		apply_mask(p);
+	}
+
+	monotime(&start);
+	for (i = 0; i < count; i++) {
+		rn = route_node_get(table, &prefixes[i]);
+		rn->info = &prefixes[i];
+	}
+	insert = bench_rate(count, &start);
+
+	monotime(&start);
+	for (i = 0; i < count; i++) {
+		addr = prefixes[i];
+		addr.prefixlen = family == AF_INET ? IPV4_MAX_BITLEN
+						   : IPV6_MAX_BITLEN;
+		rn = route_node_match(table, &addr);
+		if (rn) {
+			found++;
+			route_unlock_node(rn);
+		}
+	}
+	match = bench_rate(count, &start);
+	assert(found == count);
+
+	found = 0;
+	monotime(&start);
+	for (rn = route_top(table); rn; rn = route_next(rn))
+		found++;
+	walk = bench_rate(found, &start);
+
+	printf("%s %lu prefixes (%lu nodes): insert %.0f/s, match %.0f/s, walk %.0f nodes/s\n",
+	       family == AF_INET ? "IPv4" : "IPv6", count, found, insert,
+	       match, walk);
+
+	route_table_finish(table);
+	free(prefixes);
+}
+
+static void run_bench(int argc, char **argv)
+{
+	static const unsigned long defaults[] = {1000000, 10000000};
+	unsigned long count;
+	int i;
+
+	for (i = 0; i < (argc ? argc : (int)array_size(defaults)); i++) {
+		count = argc ? strtoul(argv[i], NULL, 0) : defaults[i];
+		bench_table(AF_INET, count);
+		bench_table(AF_INET6, count);
+	}
 }
 
 /*
  * main
  */
-int main(void)
+int main(int argc, char **argv)
 {
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		run_bench(argc - 2, argv + 2);
+		return 0;
+	}
+
 	run_tests();
 }
@@ -40,17 +40,26 @@ static int dummy_func(struct thread *thread)
 	return 0;
 }
 
-int main(int argc, char **argv)
+static unsigned long msec_between(const struct timeval *a,
+				  const struct timeval *b)
+{
+	return 1000 * (b->tv_sec - a->tv_sec)
+	       + (b->tv_usec - a->tv_usec) / 1000;
+}
+
+static void run(struct prng *prng, struct thread **timers, bool wheel)
 {
-	struct prng *prng;
 	int i;
-	struct thread **timers;
-	struct timeval tv_start, tv_lap, tv_stop;
-	unsigned long t_schedule, t_remove;
+	struct timeval tv_start, tv_lap, tv_rearm, tv_stop;
+	unsigned long t_schedule, t_rearm, t_remove;
+	const char *name = wheel ? "wheel" : "heap";
+
+	/* thread_master_free() doesn't clear the references of timers that
+	 * were still pending in a previous run */
+	memset(timers, 0, SCHEDULE_TIMERS * sizeof(*timers));
 
 	master = thread_master_create(NULL);
-	prng = prng_new(0);
-	timers = calloc(SCHEDULE_TIMERS, sizeof(*timers));
+	thread_master_set_timer_wheel(master, wheel);
 
 	/* create thread structures so they won't be allocated during the
 	 * time measurement */
@@ -72,29 +81,55 @@ int main(int argc, char **argv)
 
 	monotime(&tv_lap);
 
+	/* what keepalive / hold timers do: cancel and add again */
 	for (i = 0; i < REMOVE_TIMERS; i++) {
 		int index;
 
 		index = prng_rand(prng) % SCHEDULE_TIMERS;
 		thread_cancel(&timers[index]);
+		thread_add_timer_msec(master, dummy_func, NULL,
+				      3000 + prng_rand(prng) % 90000,
+				      &timers[index]);
 	}
 
-	monotime(&tv_stop);
+	monotime(&tv_rearm);
 
-	t_schedule = 1000 * (tv_lap.tv_sec - tv_start.tv_sec);
-	t_schedule += (tv_lap.tv_usec - tv_start.tv_usec) / 1000;
+	for (i = 0; i < REMOVE_TIMERS; i++) {
+		int index;
 
-	t_remove = 1000 * (tv_stop.tv_sec - tv_lap.tv_sec);
-	t_remove += (tv_stop.tv_usec - tv_lap.tv_usec) / 1000;
+		index = prng_rand(prng) % SCHEDULE_TIMERS;
+		thread_cancel(&timers[index]);
+	}
 
-	printf("Scheduling %d random timers took %lu.%03lu seconds.\n",
-	       SCHEDULE_TIMERS, t_schedule / 1000, t_schedule % 1000);
-	printf("Removing %d random timers took %lu.%03lu seconds.\n",
-	       REMOVE_TIMERS, t_remove / 1000, t_remove % 1000);
+	monotime(&tv_stop);
+
+	t_schedule = msec_between(&tv_start, &tv_lap);
+	t_rearm = msec_between(&tv_lap, &tv_rearm);
+	t_remove = msec_between(&tv_rearm, &tv_stop);
+
+	printf("[%s] Scheduling %d random timers took %lu.%03lu seconds.\n",
+	       name, SCHEDULE_TIMERS, t_schedule / 1000, t_schedule % 1000);
+	printf("[%s] Re-arming %d random timers took %lu.%03lu seconds.\n",
+	       name, REMOVE_TIMERS, t_rearm / 1000, t_rearm % 1000);
+	printf("[%s] Removing %d random timers took %lu.%03lu seconds.\n",
+	       name, REMOVE_TIMERS, t_remove / 1000, t_remove % 1000);
 	fflush(stdout);
 
-	free(timers);
 	thread_master_free(master);
+}
+
+int main(int argc, char **argv)
+{
+	struct prng *prng;
+	struct thread **timers;
+
+	prng = prng_new(0);
+	timers = calloc(SCHEDULE_TIMERS, sizeof(*timers));
+
+	run(prng, timers, false);
+	run(prng, timers, true);
+
+	free(timers);
 	prng_free(prng);
 	return 0;
 }
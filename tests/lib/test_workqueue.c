@@ -0,0 +1,111 @@
+/*
+ * Test work_queue_add_mt() from several pthreads
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include <pthread.h>
+
+#include "thread.h"
+#include "workqueue.h"
+
+#define NTHREADS 4
+#define NITEMS 20000
+
+struct test_item {
+	unsigned int producer;
+	unsigned int seq;
+};
+
+/* producer NTHREADS is the main thread, using work_queue_add() */
+static struct test_item items[NTHREADS + 1][NITEMS];
+static unsigned int next_seq[NTHREADS + 1];
+static unsigned int processed;
+
+static struct thread_master *master;
+static struct work_queue *wq;
+
+static wq_item_status test_workfunc(struct work_queue *wq, void *data)
+{
+	struct test_item *item = data;
+
+	/* items from one producer must be run in the order they were added */
+	assert(item->seq == next_seq[item->producer]);
+	next_seq[item->producer]++;
+	processed++;
+
+	return WQ_SUCCESS;
+}
+
+static void *producer_func(void *arg)
+{
+	unsigned int producer = (uintptr_t)arg;
+	unsigned int i;
+
+	for (i = 0; i < NITEMS; i++) {
+		work_queue_add_mt(wq, &items[producer][i]);
+		if (i % 1000 == 0)
+			usleep(100);
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t pt[NTHREADS];
+	struct thread t;
+	unsigned int i, j;
+
+	master = thread_master_create(NULL);
+
+	wq = work_queue_new(master, "test");
+	wq->spec.workfunc = test_workfunc;
+	wq->spec.hold = 0;
+
+	for (i = 0; i <= NTHREADS; i++)
+		for (j = 0; j < NITEMS; j++) {
+			items[i][j].producer = i;
+			items[i][j].seq = j;
+		}
+
+	for (i = 0; i < NTHREADS; i++)
+		pthread_create(&pt[i], NULL, producer_func, (void *)(uintptr_t)i);
+
+	/* interleave regular adds while the other pthreads are pushing */
+	for (j = 0; j < NITEMS; j++) {
+		work_queue_add(wq, &items[NTHREADS][j]);
+		if (j % 1000 == 0 && thread_fetch(master, &t))
+			thread_call(&t);
+	}
+
+	while (processed < (NTHREADS + 1) * NITEMS && thread_fetch(master, &t))
+		thread_call(&t);
+
+	for (i = 0; i < NTHREADS; i++)
+		pthread_join(pt[i], NULL);
+
+	for (i = 0; i <= NTHREADS; i++)
+		assert(next_seq[i] == NITEMS);
+	assert(work_queue_empty(wq));
+	assert(wq->items_run == (NTHREADS + 1) * NITEMS);
+
+	work_queue_free_and_null(&wq);
+	thread_master_free(master);
+
+	printf("work queue MT test: OK\n");
+	return 0;
+}
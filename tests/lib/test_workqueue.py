@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestWorkQueue(frrtest.TestMultiOut):
+    program = "./test_workqueue"
+
+
+TestWorkQueue.okfail("work queue MT test")
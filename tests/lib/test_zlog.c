@@ -21,6 +21,8 @@
 #include <memory.h>
 #include "log.h"
 #include "network.h"
+#include "prefix.h"
+#include "frratomic.h"
 
 /* maximum amount of data to hexdump */
 #define MAXDATA 16384
@@ -47,8 +49,129 @@ static bool test_zlog_hexdump(void)
 	return true;
 }
 
+/*
+ * Test asynchronous logging.
+ *
+ * Messages formatted on the log pthread must come out exactly like they do
+ * when formatted synchronously, including argument positions.
+ */
+#define NCAPTURE 32
+
+struct captured {
+	char *text;
+	size_t n_argpos;
+	struct fmt_outpos argpos[24];
+};
+
+static struct captured captured[NCAPTURE];
+static atomic_size_t n_captured;
+
+static void capture_logfn(struct zlog_target *zt, struct zlog_msg *msgs[],
+			  size_t nmsgs)
+{
+	size_t n = atomic_load_explicit(&n_captured, memory_order_relaxed);
+	const struct fmt_outpos *argpos;
+	const char *text;
+	size_t textlen;
+
+	for (size_t i = 0; i < nmsgs && n < NCAPTURE; i++, n++) {
+		text = zlog_msg_text(msgs[i], &textlen);
+		zlog_msg_args(msgs[i], NULL, &captured[n].n_argpos, &argpos);
+
+		captured[n].text = strndup(text, textlen);
+		memcpy(captured[n].argpos, argpos,
+		       MIN(captured[n].n_argpos, 24) * sizeof(argpos[0]));
+	}
+	atomic_store_explicit(&n_captured, n, memory_order_release);
+}
+
+static struct zlog_target capture_zt = {
+	.prio_min = LOG_DEBUG,
+	.logfn = capture_logfn,
+};
+
+static void log_samples(void)
+{
+	struct in_addr addr = { .s_addr = htonl(0xc0000201) };
+	struct prefix p;
+	char longstr[3000];
+
+	str2prefix("198.51.100.0/24", &p);
+	memset(longstr, 'x', sizeof(longstr) - 1);
+	longstr[sizeof(longstr) - 1] = '\0';
+
+	zlog_debug("plain text");
+	zlog_debug("%d %i %u %x %X %o", -1, 42, 3000000000U, 0xdead, 0xbeef,
+		   8);
+	zlog_debug("%hhd %hhx %hd %hx", 200, 0x1ff, 70000, 0x12345);
+	zlog_debug("%ld %lu %lld %llx %jd %zu %zd %td", -1L, 1UL << 40,
+		   -(1LL << 50), 1ULL << 63, (intmax_t)-5, (size_t)7,
+		   (ssize_t)-7, (ptrdiff_t)-9);
+	zlog_info("%5s|%-5s|%.2s|%s|%05d|%+d|% d|%#x", "ab", "cd", "efgh", "",
+		  42, 42, 42, 42);
+	zlog_info("%*d|%-*d|%*d|%.*s|%*.*f|%.*d", 6, 42, 6, 42, -6, 42, 3,
+		  "abcdef", 10, 3, 3.14159, -1, 7);
+	zlog_notice("%f %e %g %a %Lf %.3f", 1.5, 12345.678, 0.0001, 2.0,
+		    (long double)1.25, 2.0 / 3);
+	zlog_warn("%c%%%c 100%%", 'a', 'b');
+	zlog_debug("%p", &p);
+	zlog_debug("%pI4 via %pFX, %pI4X", &addr, &p, &addr);
+	zlog_debug("%s", longstr);
+	errno = ENOENT;
+	zlog_debug("errno: %m");
+	zlog(LOG_DEBUG, "no xref %d", 1);
+}
+
+static bool test_zlog_async(void)
+{
+	struct captured expect[NCAPTURE];
+	size_t nexpect, n, i;
+	bool ok = true;
+
+	zlog_target_replace(NULL, &capture_zt);
+
+	log_samples();
+	nexpect = atomic_load_explicit(&n_captured, memory_order_acquire);
+	memcpy(expect, captured, sizeof(expect));
+	atomic_store_explicit(&n_captured, 0, memory_order_relaxed);
+
+	zlog_set_async(true);
+	log_samples();
+
+	for (i = 0; i < 5000; i++) {
+		n = atomic_load_explicit(&n_captured, memory_order_acquire);
+		if (n >= nexpect)
+			break;
+		usleep(1000);
+	}
+	zlog_set_async(false);
+	zlog_target_replace(&capture_zt, NULL);
+
+	if (n != nexpect) {
+		fprintf(stderr, "async: got %zu messages, expected %zu\n", n,
+			nexpect);
+		return false;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (strcmp(expect[i].text, captured[i].text)
+		    || expect[i].n_argpos != captured[i].n_argpos
+		    || memcmp(expect[i].argpos, captured[i].argpos,
+			      MIN(expect[i].n_argpos, 24)
+				      * sizeof(expect[i].argpos[0]))) {
+			fprintf(stderr, "async mismatch:\n  %s\n  %s\n",
+				expect[i].text, captured[i].text);
+			ok = false;
+		}
+		free(expect[i].text);
+		free(captured[i].text);
+	}
+	return ok;
+}
+
 bool (*tests[])(void) = {
 	test_zlog_hexdump,
+	test_zlog_async,
 };
 
 int main(int argc, char **argv)
@@ -58,5 +181,7 @@ int main(int argc, char **argv)
 	for (unsigned int i = 0; i < array_size(tests); i++)
 		if (!tests[i]())
 			return 1;
+
+	zlog_fini();
 	return 0;
 }
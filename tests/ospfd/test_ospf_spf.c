@@ -12,7 +12,9 @@
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_interface.h"
 #include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_lsdb.h"
 #include "ospfd/ospf_route.h"
 #include "ospfd/ospf_spf.h"
 #include "ospfd/ospf_ti_lfa.h"
@@ -27,7 +29,7 @@ DECLARE_RBTREE_UNIQ(p_spaces, struct p_space, p_spaces_item,
 DECLARE_RBTREE_UNIQ(q_spaces, struct q_space, q_spaces_item,
 		    q_spaces_compare_func);
 
-static struct ospf *test_init(struct ospf_test_node *root)
+static struct ospf *test_init(const char *root_router_id)
 {
 	struct ospf *ospf;
 	struct ospf_area *area;
@@ -40,7 +42,7 @@ static struct ospf *test_init(struct ospf_test_node *root)
 	area = ospf_area_new(ospf, area_id);
 	listnode_add_sort(ospf->areas, area);
 
-	inet_aton(root->router_id, &router_id);
+	inet_aton(root_router_id, &router_id);
 	ospf->router_id = router_id;
 	ospf->router_id_static = router_id;
 	ospf->ti_lfa_enabled = true;
@@ -140,7 +142,7 @@ static int test_run(struct vty *vty, struct ospf_topology *topology,
 {
 	struct ospf *ospf;
 
-	ospf = test_init(root);
+	ospf = test_init(root->router_id);
 
 	/* Inject LSAs into the OSPF backbone according to the topology */
 	if (topology_load(vty, topology, root, ospf)) {
@@ -200,6 +202,660 @@ DEFUN(test_ospf, test_ospf_cmd,
 	return test_run(vty, topology, root, protection_type, verbose);
 }
 
+/*
+ * Random topologies for checking incremental SPF against full SPF, and for
+ * benchmarking SPF.
+ *
+ * Nodes are connected by a ring plus random chords, all point-to-point
+ * links with a /30 each and independent metrics per direction. Node 0 is
+ * the root. Some of the other nodes are ABRs or ASBRs, so that the ABR/ASBR
+ * routing table gets compared as well.
+ */
+#define RANDOM_TOPO_MAX_NODES 10000
+
+struct random_link {
+	unsigned int peer;
+	uint32_t subnet; /* index of the link's /30 in 10.0.0.0/8 */
+	uint16_t metric; /* towards peer */
+};
+
+struct random_node {
+	struct random_link *links;
+	unsigned int count, size;
+};
+
+struct random_topology {
+	unsigned int nodes;
+	uint32_t subnets;
+	struct random_node node[RANDOM_TOPO_MAX_NODES];
+};
+
+static struct random_topology random_topo;
+static uint32_t random_state;
+
+/* xorshift32, so that results don't depend on the libc */
+static uint32_t random_next(void)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+
+	return random_state;
+}
+
+static uint16_t random_metric(void)
+{
+	return 1 + random_next() % 20;
+}
+
+static struct in_addr random_router_id(unsigned int node)
+{
+	struct in_addr id;
+
+	id.s_addr = htonl(0x01000000 + node + 1);
+	return id;
+}
+
+/* Address of node on a link to peer, the lower node gets .1 */
+static struct in_addr random_link_addr(unsigned int node,
+				       struct random_link *link)
+{
+	struct in_addr addr;
+
+	addr.s_addr = htonl(0x0a000000 | (link->subnet << 2)
+			    | (node < link->peer ? 1 : 2));
+	return addr;
+}
+
+static struct random_link *random_topology_find(unsigned int a,
+						unsigned int b)
+{
+	struct random_node *node = &random_topo.node[a];
+	unsigned int i;
+
+	for (i = 0; i < node->count; i++)
+		if (node->links[i].peer == b)
+			return &node->links[i];
+
+	return NULL;
+}
+
+static void random_topology_add(unsigned int a, unsigned int b,
+				uint32_t subnet, uint16_t metric)
+{
+	struct random_node *node = &random_topo.node[a];
+
+	if (node->count == node->size) {
+		node->size = node->size ? node->size * 2 : 4;
+		node->links = XREALLOC(MTYPE_TMP, node->links,
+				       node->size * sizeof(*node->links));
+	}
+
+	node->links[node->count].peer = b;
+	node->links[node->count].subnet = subnet;
+	node->links[node->count].metric = metric;
+	node->count++;
+}
+
+static void random_topology_remove(unsigned int a, unsigned int b)
+{
+	struct random_node *node = &random_topo.node[a];
+	struct random_link *link = random_topology_find(a, b);
+
+	*link = node->links[--node->count];
+}
+
+static void random_topology_link(unsigned int a, unsigned int b)
+{
+	struct random_link *link = random_topology_find(a, b);
+	uint16_t metric_ab = random_metric();
+	uint16_t metric_ba = random_metric();
+
+	if (link) {
+		link->metric = metric_ab;
+		random_topology_find(b, a)->metric = metric_ba;
+		return;
+	}
+
+	random_topology_add(a, b, random_topo.subnets, metric_ab);
+	random_topology_add(b, a, random_topo.subnets, metric_ba);
+	random_topo.subnets++;
+}
+
+static void random_topology_create(unsigned int nodes)
+{
+	unsigned int i;
+
+	random_topo.nodes = nodes;
+	random_topo.subnets = 0;
+
+	for (i = 0; i < nodes && nodes > 1; i++)
+		random_topology_link(i, (i + 1) % nodes);
+
+	for (i = 0; i < nodes; i++) {
+		unsigned int a = random_next() % nodes;
+		unsigned int b = random_next() % nodes;
+
+		if (a != b)
+			random_topology_link(a, b);
+	}
+}
+
+static void random_topology_free(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < random_topo.nodes; i++) {
+		XFREE(MTYPE_TMP, random_topo.node[i].links);
+		random_topo.node[i].count = 0;
+		random_topo.node[i].size = 0;
+	}
+	random_topo.nodes = 0;
+}
+
+static void random_topology_inject(struct ospf *ospf, unsigned int node)
+{
+	struct ospf_area *area = ospf->backbone;
+	struct random_node *rnode = &random_topo.node[node];
+	struct random_link *link;
+	struct in_addr router_id, data, mask;
+	struct stream *s;
+	struct ospf_lsa *new;
+	unsigned long putp;
+	uint16_t link_count = 0;
+	unsigned int i;
+	int length;
+
+	router_id = random_router_id(node);
+
+	s = stream_new(OSPF_MAX_LSA_SIZE);
+	lsa_header_set(s, LSA_OPTIONS_GET(area) | LSA_OPTIONS_NSSA_GET(area),
+		       OSPF_ROUTER_LSA, router_id, router_id);
+
+	if (node == 0)
+		stream_putc(s, router_lsa_flags(area));
+	else if (node % 4 == 1)
+		stream_putc(s, ROUTER_LSA_EXTERNAL);
+	else if (node % 4 == 2)
+		stream_putc(s, ROUTER_LSA_BORDER);
+	else
+		stream_putc(s, 0);
+	stream_putc(s, 0);
+
+	putp = stream_get_endp(s);
+	stream_putw(s, 0);
+
+	masklen2ip(30, &mask);
+	for (i = 0; i < rnode->count; i++) {
+		link = &rnode->links[i];
+
+		data = random_link_addr(node, link);
+		link_info_set(&s, random_router_id(link->peer), data,
+			      LSA_LINK_TYPE_POINTOPOINT, 0, link->metric);
+
+		data.s_addr &= mask.s_addr;
+		link_info_set(&s, data, mask, LSA_LINK_TYPE_STUB, 0,
+			      link->metric);
+		link_count += 2;
+	}
+
+	data.s_addr = 0xffffffff;
+	link_info_set(&s, router_id, data, LSA_LINK_TYPE_STUB, 0, 0);
+	link_count++;
+
+	stream_putw_at(s, putp, link_count);
+
+	length = stream_get_endp(s);
+	((struct lsa_header *)STREAM_DATA(s))->length = htons(length);
+
+	new = ospf_lsa_new_and_data(length);
+	new->area = area;
+	new->vrf_id = area->ospf->vrf_id;
+	if (node == 0)
+		SET_FLAG(new->flags, OSPF_LSA_SELF | OSPF_LSA_SELF_CHECKED);
+
+	memcpy(new->data, STREAM_DATA(s), length);
+	stream_free(s);
+
+	ospf_lsdb_add(area->lsdb, new);
+
+	if (node == 0) {
+		ospf_lsa_unlock(&area->router_lsa_self);
+		area->router_lsa_self = ospf_lsa_lock(new);
+	}
+}
+
+static struct ospf *random_topology_load(void)
+{
+	struct ospf *ospf;
+	char root_id[INET_ADDRSTRLEN];
+	struct in_addr id = random_router_id(0);
+	unsigned int i;
+
+	inet_ntop(AF_INET, &id, root_id, sizeof(root_id));
+	ospf = test_init(root_id);
+
+	for (i = 0; i < random_topo.nodes; i++)
+		random_topology_inject(ospf, i);
+
+	return ospf;
+}
+
+/*
+ * Apply a random change to the topology: change a link metric, or remove
+ * or add a link. Returns the nodes whose router-LSA has to be re-injected.
+ */
+static unsigned int random_topology_change(unsigned int *changed)
+{
+	unsigned int nodes = random_topo.nodes;
+	struct random_link *link;
+	unsigned int a, b, tries;
+
+	for (tries = 0; tries < 64; tries++) {
+		a = random_next() % nodes;
+		b = random_next() % nodes;
+		if (a == b)
+			continue;
+
+		link = random_topology_find(a, b);
+
+		switch (random_next() % 3) {
+		case 0:
+			if (!link)
+				continue;
+			link->metric = random_metric();
+			changed[0] = a;
+			return 1;
+		case 1:
+			if (!link)
+				continue;
+			random_topology_remove(a, b);
+			random_topology_remove(b, a);
+			break;
+		default:
+			if (link)
+				continue;
+			random_topology_link(a, b);
+			break;
+		}
+
+		changed[0] = a;
+		changed[1] = b;
+		return 2;
+	}
+
+	return 0;
+}
+
+/*
+ * Outside of dry runs the calculating router's links are resolved to its
+ * interfaces by router-LSA link position. Give the root a single
+ * point-to-point interface covering all of them.
+ */
+static struct ospf_interface *random_topology_root_if(struct ospf *ospf)
+{
+	struct ospf_interface *oi;
+
+	oi = XCALLOC(MTYPE_TMP, sizeof(*oi));
+	oi->ospf = ospf;
+	oi->area = ospf->backbone;
+	oi->type = OSPF_IFTYPE_POINTOPOINT;
+	oi->ifp = XCALLOC(MTYPE_TMP, sizeof(*oi->ifp));
+	strlcpy(oi->ifp->name, "eth0", sizeof(oi->ifp->name));
+	oi->ifp->ifindex = 1;
+	oi->connected = XCALLOC(MTYPE_TMP, sizeof(*oi->connected));
+	oi->nbrs = route_table_init();
+	oi->lsa_pos_beg = 0;
+	oi->lsa_pos_end = UINT16_MAX;
+
+	listnode_add(ospf->backbone->oiflist, oi);
+
+	return oi;
+}
+
+static void random_topology_root_if_free(struct ospf_interface *oi)
+{
+	listnode_delete(oi->area->oiflist, oi);
+	route_table_finish(oi->nbrs);
+	XFREE(MTYPE_TMP, oi->connected);
+	XFREE(MTYPE_TMP, oi->ifp);
+	XFREE(MTYPE_TMP, oi);
+}
+
+static bool compare_routes(struct ospf_route *or1, struct ospf_route *or2)
+{
+	struct listnode *pnode1, *pnode2;
+	struct ospf_path *path1, *path2;
+
+	if (or1->cost != or2->cost || or1->path_type != or2->path_type
+	    || listcount(or1->paths) != listcount(or2->paths))
+		return false;
+
+	list_sort(or1->paths, sort_paths);
+	list_sort(or2->paths, sort_paths);
+
+	pnode2 = listhead(or2->paths);
+	for (ALL_LIST_ELEMENTS_RO(or1->paths, pnode1, path1)) {
+		path2 = listgetdata(pnode2);
+		pnode2 = listnextnode(pnode2);
+
+		if (path1->nexthop.s_addr != path2->nexthop.s_addr
+		    || path1->adv_router.s_addr != path2->adv_router.s_addr
+		    || path1->ifindex != path2->ifindex)
+			return false;
+	}
+
+	return true;
+}
+
+/* Compare two routing tables, returns the number of differing routes. */
+static unsigned int compare_route_tables(struct vty *vty,
+					 struct route_table *rt1,
+					 struct route_table *rt2, bool verbose)
+{
+	struct route_node *rn1, *rn2;
+	struct ospf_route *or1, *or2;
+	unsigned int count1 = 0, count2 = 0, diffs = 0;
+
+	for (rn2 = route_top(rt2); rn2; rn2 = route_next(rn2))
+		if (rn2->info)
+			count2++;
+
+	for (rn1 = route_top(rt1); rn1; rn1 = route_next(rn1)) {
+		if ((or1 = rn1->info) == NULL)
+			continue;
+		count1++;
+
+		rn2 = route_node_lookup(rt2, &rn1->p);
+		or2 = rn2 ? rn2->info : NULL;
+		if (rn2)
+			route_unlock_node(rn2);
+
+		if (!or2 || !compare_routes(or1, or2)) {
+			diffs++;
+			if (verbose)
+				vty_out(vty, "%% route %pFX differs\n",
+					&rn1->p);
+		}
+	}
+
+	if (count1 != count2) {
+		diffs++;
+		if (verbose)
+			vty_out(vty, "%% route count differs: %u vs %u\n",
+				count1, count2);
+	}
+
+	return diffs;
+}
+
+/*
+ * Compare two ABR/ASBR routing tables, which hold a list of routes per
+ * router. Returns the number of differing routers.
+ */
+static unsigned int compare_router_tables(struct vty *vty,
+					  struct route_table *rt1,
+					  struct route_table *rt2, bool verbose)
+{
+	struct route_node *rn1, *rn2;
+	struct list *routes1, *routes2;
+	struct listnode *node1, *node2;
+	struct ospf_route *or1, *or2;
+	unsigned int count1 = 0, count2 = 0, diffs = 0;
+	bool same;
+
+	for (rn2 = route_top(rt2); rn2; rn2 = route_next(rn2))
+		if (rn2->info)
+			count2++;
+
+	for (rn1 = route_top(rt1); rn1; rn1 = route_next(rn1)) {
+		if ((routes1 = rn1->info) == NULL)
+			continue;
+		count1++;
+
+		rn2 = route_node_lookup(rt2, &rn1->p);
+		routes2 = rn2 ? rn2->info : NULL;
+		if (rn2)
+			route_unlock_node(rn2);
+
+		same = routes2 && listcount(routes1) == listcount(routes2);
+		if (same) {
+			/* one intra-area route per router in a single area */
+			node2 = listhead(routes2);
+			for (ALL_LIST_ELEMENTS_RO(routes1, node1, or1)) {
+				or2 = listgetdata(node2);
+				node2 = listnextnode(node2);
+
+				if (!compare_routes(or1, or2))
+					same = false;
+			}
+		}
+
+		if (!same) {
+			diffs++;
+			if (verbose)
+				vty_out(vty, "%% router route %pFX differs\n",
+					&rn1->p);
+		}
+	}
+
+	if (count1 != count2) {
+		diffs++;
+		if (verbose)
+			vty_out(vty,
+				"%% router route count differs: %u vs %u\n",
+				count1, count2);
+	}
+
+	return diffs;
+}
+
+/*
+ * Check incremental SPF against full SPF over a series of random topology
+ * changes. A dry run calculates from the perspective of another router, as
+ * TI-LFA does; otherwise the root's interfaces are used as for the local
+ * routing table. Returns the number of mismatches.
+ */
+static unsigned int test_run_ispf_mode(struct vty *vty, unsigned int nodes,
+				       uint32_t seed, unsigned int changes,
+				       bool dry_run, bool verbose)
+{
+	struct ospf *ospf_inc, *ospf_full;
+	struct ospf_area *area_inc, *area_full;
+	struct ospf_interface *oi_inc = NULL, *oi_full = NULL;
+	struct route_table *table_inc, *rtrs_inc, *table_full, *rtrs_full;
+	struct timeval start;
+	int64_t time_inc = 0, time_full = 0;
+	unsigned int changed[2], count, i, j;
+	unsigned int mismatches = 0;
+
+	random_state = seed;
+	random_topology_create(nodes);
+
+	ospf_inc = random_topology_load();
+	ospf_full = random_topology_load();
+	area_inc = ospf_inc->backbone;
+	area_full = ospf_full->backbone;
+
+	if (!dry_run) {
+		oi_inc = random_topology_root_if(ospf_inc);
+		oi_full = random_topology_root_if(ospf_full);
+	}
+
+	for (i = 0; i <= changes; i++) {
+		/* The first round computes the initial tree */
+		if (i > 0) {
+			count = random_topology_change(changed);
+			for (j = 0; j < count; j++) {
+				random_topology_inject(ospf_inc, changed[j]);
+				random_topology_inject(ospf_full, changed[j]);
+			}
+		}
+
+		table_inc = route_table_init();
+		rtrs_inc = route_table_init();
+		monotime(&start);
+		ospf_spf_calculate_incremental(area_inc,
+					       area_inc->router_lsa_self,
+					       table_inc, rtrs_inc, dry_run,
+					       !dry_run);
+		time_inc += monotime_since(&start, NULL);
+
+		table_full = route_table_init();
+		rtrs_full = route_table_init();
+		monotime(&start);
+		ospf_spf_calculate(area_full, area_full->router_lsa_self,
+				   table_full, rtrs_full, dry_run, !dry_run);
+		time_full += monotime_since(&start, NULL);
+		ospf_spf_cleanup(area_full->spf, area_full->spf_vertex_list);
+		area_full->spf = NULL;
+		area_full->spf_vertex_list = NULL;
+
+		mismatches += compare_route_tables(vty, table_inc, table_full,
+						   verbose);
+		mismatches += compare_router_tables(vty, rtrs_inc, rtrs_full,
+						    verbose);
+
+		ospf_route_table_free(table_inc);
+		ospf_route_table_free(table_full);
+		ospf_rtrs_free(rtrs_inc);
+		ospf_rtrs_free(rtrs_full);
+	}
+
+	if (verbose)
+		vty_out(vty,
+			"%s: %u of %u calculations incremental, iSPF %" PRId64
+			" usec, full SPF %" PRId64 " usec\n",
+			dry_run ? "dry run" : "root",
+			area_inc->spf_incremental_calculation,
+			area_inc->spf_calculation, time_inc, time_full);
+
+	ospf_spf_incremental_free(area_inc);
+	if (oi_inc)
+		random_topology_root_if_free(oi_inc);
+	if (oi_full)
+		random_topology_root_if_free(oi_full);
+	random_topology_free();
+
+	return mismatches;
+}
+
+static int test_run_ispf(struct vty *vty, unsigned int nodes, uint32_t seed,
+			 unsigned int changes, bool verbose)
+{
+	unsigned int mismatches;
+
+	mismatches = test_run_ispf_mode(vty, nodes, seed, changes, true,
+					verbose);
+	mismatches += test_run_ispf_mode(vty, nodes, seed, changes, false,
+					 verbose);
+
+	vty_out(vty, "%u nodes, %u changes: %s\n", nodes, changes,
+		mismatches ? "iSPF and full SPF differ" : "OK");
+
+	return mismatches ? CMD_WARNING : CMD_SUCCESS;
+}
+
+DEFUN(test_ospf_ispf, test_ospf_ispf_cmd,
+      "test ospf random-topology (2-10000) seed (1-4294967295) changes (1-10000) ispf [verbose]",
+      "Test mode\n"
+      "Choose OSPF for SPF testing\n"
+      "Generate a random network topology\n"
+      "Number of nodes\n"
+      "Seed for the topology and its changes\n"
+      "Seed\n"
+      "Number of random topology changes\n"
+      "Number of changes\n"
+      "Check incremental SPF against full SPF\n"
+      "Verbose output\n")
+{
+	unsigned int nodes, changes;
+	uint32_t seed;
+	int idx = 0;
+	bool verbose = false;
+
+	argv_find(argv, argc, "random-topology", &idx);
+	nodes = strtoul(argv[idx + 1]->arg, NULL, 10);
+
+	argv_find(argv, argc, "seed", &idx);
+	seed = strtoul(argv[idx + 1]->arg, NULL, 10);
+
+	argv_find(argv, argc, "changes", &idx);
+	changes = strtoul(argv[idx + 1]->arg, NULL, 10);
+
+	if (argv_find(argv, argc, "verbose", &idx))
+		verbose = true;
+
+	return test_run_ispf(vty, nodes, seed, changes, verbose);
+}
+
+/* Time full SPF runs over a random topology. */
+static int test_run_spf_benchmark(struct vty *vty, unsigned int nodes,
+				  uint32_t seed, unsigned int runs)
+{
+	struct ospf *ospf;
+	struct ospf_area *area;
+	struct route_table *new_table, *new_rtrs;
+	struct timeval start;
+	int64_t spf_time = 0;
+	unsigned long routes = 0;
+	unsigned int i;
+
+	random_state = seed;
+	random_topology_create(nodes);
+
+	ospf = random_topology_load();
+	area = ospf->backbone;
+
+	for (i = 0; i < runs; i++) {
+		new_table = route_table_init();
+		new_rtrs = route_table_init();
+
+		monotime(&start);
+		ospf_spf_calculate(area, area->router_lsa_self, new_table,
+				   new_rtrs, true, false);
+		ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+		spf_time += monotime_since(&start, NULL);
+
+		area->spf = NULL;
+		area->spf_vertex_list = NULL;
+
+		routes = route_table_count(new_table);
+		ospf_route_table_free(new_table);
+		ospf_rtrs_free(new_rtrs);
+	}
+
+	random_topology_free();
+
+	vty_out(vty,
+		"%u nodes, %lu route nodes: %u SPF runs, %" PRId64
+		" usec per run\n",
+		nodes, routes, runs, spf_time / runs);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(test_ospf_spf_benchmark, test_ospf_spf_benchmark_cmd,
+      "test ospf random-topology (2-10000) seed (1-4294967295) spf-benchmark (1-10000)",
+      "Test mode\n"
+      "Choose OSPF for SPF testing\n"
+      "Generate a random network topology\n"
+      "Number of nodes\n"
+      "Seed for the topology\n"
+      "Seed\n"
+      "Time full SPF calculations\n"
+      "Number of SPF runs\n")
+{
+	unsigned int nodes, runs;
+	uint32_t seed;
+
+	nodes = strtoul(argv[2]->arg, NULL, 10);
+	seed = strtoul(argv[4]->arg, NULL, 10);
+	runs = strtoul(argv[6]->arg, NULL, 10);
+
+	return test_run_spf_benchmark(vty, nodes, seed, runs);
+}
+
 static void vty_do_exit(int isexit)
 {
 	printf("\nend.\n");
@@ -284,6 +940,8 @@ int main(int argc, char **argv)
 
 	/* Install test command. */
 	install_element(VIEW_NODE, &test_ospf_cmd);
+	install_element(VIEW_NODE, &test_ospf_ispf_cmd);
+	install_element(VIEW_NODE, &test_ospf_spf_benchmark_cmd);
 
 	/* needed for SR DB init */
 	ospf_vty_init();
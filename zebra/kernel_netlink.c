@@ -36,6 +36,8 @@
 #include "vrf.h"
 #include "mpls.h"
 #include "lib_errors.h"
+#include "frr_pthread.h"
+#include "typesafe.h"
 
 //#include "zebra/zserv.h"
 #include "zebra/zebra_router.h"
@@ -91,6 +93,29 @@
 
 #define NL_BATCH_RX_BUFSIZE NL_RCV_PKT_BUF_SIZE
 
+/*
+ * Kernel notifications are drained by the listener pthread with recvmmsg():
+ * up to NL_RCV_EVENT_BATCH datagrams per syscall, and at most
+ * NL_RCV_EVENT_ROUNDS syscalls per read event before yielding back to its
+ * event loop.
+ */
+#define NL_RCV_EVENT_BATCH 16
+#define NL_RCV_EVENT_ROUNDS 8
+
+/*
+ * The parsed messages are handed to the main pthread in batches of up to
+ * NL_RX_BATCH_SIZE bytes, of which it dispatches NL_RX_BATCHES_PER_RUN per
+ * event.
+ */
+#define NL_RX_BATCH_SIZE (4 * NL_RCV_PKT_BUF_SIZE)
+#define NL_RX_BATCHES_PER_RUN 16
+
+/* Minimum receive buffer of the neighbor event socket */
+#define NL_RCV_NEIGH_BUFSIZE (32 * 1024 * 1024)
+
+/* Delay before re-reading the neighbor tables after an overrun */
+#define NL_NEIGH_RESYNC_DELAY_MSEC 100
+
 static const struct message nlmsg_str[] = {{RTM_NEWROUTE, "RTM_NEWROUTE"},
 					   {RTM_DELROUTE, "RTM_DELROUTE"},
 					   {RTM_GETROUTE, "RTM_GETROUTE"},
@@ -159,12 +184,67 @@ extern uint32_t nl_rcvbufsize;
 extern struct zebra_privs_t zserv_privs;
 
 DEFINE_MTYPE_STATIC(ZEBRA, NL_BUF, "Zebra Netlink buffers");
+DEFINE_MTYPE_STATIC(ZEBRA, NL_RX_BATCH, "Zebra Netlink event batches");
 
 size_t nl_batch_tx_bufsize;
 char *nl_batch_tx_buf;
 
 char nl_batch_rx_buf[NL_BATCH_RX_BUFSIZE];
 
+/* Only used from the listener pthread, by netlink_listener_drain(). */
+static char nl_event_rx_buf[NL_RCV_EVENT_BATCH][NL_RCV_PKT_BUF_SIZE];
+
+/* Kinds of kernel notifications, see nl_rx_class_of() */
+enum nl_rx_class {
+	NL_RX_LINK,
+	NL_RX_ADDR,
+	NL_RX_ROUTE,
+	NL_RX_NEIGH,
+	NL_RX_NEXTHOP,
+	NL_RX_OTHER,
+};
+
+static const char *const nl_rx_class_str[] = {
+	[NL_RX_LINK] = "link",	     [NL_RX_ADDR] = "address",
+	[NL_RX_ROUTE] = "route",     [NL_RX_NEIGH] = "neighbor",
+	[NL_RX_NEXTHOP] = "nexthop", [NL_RX_OTHER] = "other",
+};
+
+PREDECL_DLIST(nl_rx_batches);
+
+/*
+ * A run of kernel notifications of one kind, in the order the kernel sent
+ * them, on its way from the listener pthread to the main pthread. A batch
+ * with 'overrun' set carries no messages; it marks where the socket lost
+ * notifications.
+ */
+struct nl_rx_batch {
+	struct nl_rx_batches_item entry;
+
+	ns_id_t ns_id;
+	enum nl_rx_class class;
+
+	/* Read from the neighbor event socket */
+	bool neigh;
+	bool overrun;
+
+	uint32_t count;
+	size_t len;
+	size_t size;
+	char buf[];
+};
+
+DECLARE_DLIST(nl_rx_batches, struct nl_rx_batch, entry);
+
+static struct {
+	struct frr_pthread *pthread;
+
+	/* Batches ready for the main pthread */
+	pthread_mutex_t mutex;
+	struct nl_rx_batches_head queue;
+	struct thread *t_process;
+} nl_listener;
+
 _Atomic uint32_t nl_batch_bufsize = NL_DEFAULT_BATCH_BUFSIZE;
 _Atomic uint32_t nl_batch_send_threshold = NL_DEFAULT_BATCH_SEND_THRESHOLD;
 
@@ -251,12 +331,11 @@ static int netlink_recvbuf(struct nlsock *nl, uint32_t newsize)
 	/* Try force option (linux >= 2.6.14) and fall back to normal set */
 	frr_with_privs(&zserv_privs) {
 		ret = setsockopt(nl->sock, SOL_SOCKET, SO_RCVBUFFORCE,
-				 &nl_rcvbufsize,
-				 sizeof(nl_rcvbufsize));
+				 &newsize, sizeof(newsize));
 	}
 	if (ret < 0)
-		ret = setsockopt(nl->sock, SOL_SOCKET, SO_RCVBUF,
-				 &nl_rcvbufsize, sizeof(nl_rcvbufsize));
+		ret = setsockopt(nl->sock, SOL_SOCKET, SO_RCVBUF, &newsize,
+				 sizeof(newsize));
 	if (ret < 0) {
 		flog_err_sys(EC_LIB_SOCKET,
 			     "Can't set %s receive buffer size: %s", nl->name,
@@ -410,23 +489,438 @@ static int dplane_netlink_information_fetch(struct nlmsghdr *h, ns_id_t ns_id,
 	return 0;
 }
 
-static int kernel_read(struct thread *thread)
+static int netlink_parse_error(const struct nlsock *nl, struct nlmsghdr *h,
+			       bool is_cmd, bool startup);
+
+/*
+ * Kind of a kernel notification, for batching.
+ */
+static enum nl_rx_class nl_rx_class_of(const struct nlmsghdr *h)
 {
-	struct zebra_ns *zns = (struct zebra_ns *)THREAD_ARG(thread);
-	struct zebra_dplane_info dp_info;
+	switch (h->nlmsg_type) {
+	case RTM_NEWLINK:
+	case RTM_DELLINK:
+		return NL_RX_LINK;
+	case RTM_NEWADDR:
+	case RTM_DELADDR:
+		return NL_RX_ADDR;
+	case RTM_NEWROUTE:
+	case RTM_DELROUTE:
+		return NL_RX_ROUTE;
+	case RTM_NEWNEIGH:
+	case RTM_DELNEIGH:
+	case RTM_GETNEIGH:
+		return NL_RX_NEIGH;
+	case RTM_NEWNEXTHOP:
+	case RTM_DELNEXTHOP:
+		return NL_RX_NEXTHOP;
+	default:
+		return NL_RX_OTHER;
+	}
+}
+
+static struct nl_rx_batch *nl_rx_batch_new(ns_id_t ns_id, bool neigh,
+					   enum nl_rx_class class, size_t size)
+{
+	struct nl_rx_batch *batch;
 
-	/* Capture key info from ns struct */
-	zebra_dplane_info_from_zns(&dp_info, zns, false);
+	batch = XCALLOC(MTYPE_NL_RX_BATCH, sizeof(*batch) + size);
+	batch->ns_id = ns_id;
+	batch->neigh = neigh;
+	batch->class = class;
+	batch->size = size;
 
-	netlink_parse_info(netlink_information_fetch, &zns->netlink, &dp_info,
-			   5, false);
+	return batch;
+}
+
+/*
+ * Append a message to '*last', the batch most recently added to 'batches',
+ * starting a new batch if it is of a different kind or doesn't fit.
+ */
+static void nl_rx_batch_add(struct nl_rx_batches_head *batches,
+			    struct nl_rx_batch **last, ns_id_t ns_id,
+			    bool neigh, const struct nlmsghdr *h)
+{
+	enum nl_rx_class class = nl_rx_class_of(h);
+	size_t len = NLMSG_ALIGN(h->nlmsg_len);
+	struct nl_rx_batch *batch = *last;
+
+	if (!batch || batch->overrun || batch->class != class
+	    || batch->len + len > batch->size) {
+		batch = nl_rx_batch_new(ns_id, neigh, class,
+					MAX(len, NL_RX_BATCH_SIZE));
+		nl_rx_batches_add_tail(batches, batch);
+		*last = batch;
+	}
+
+	memcpy(batch->buf + batch->len, h, h->nlmsg_len);
+	batch->len += len;
+	batch->count++;
+}
+
+/*
+ * Check a datagram received on a kernel event socket and add its messages
+ * to 'batches'. Runs in the listener pthread.
+ */
+static void netlink_listener_parse(const struct nlsock *nl, ns_id_t ns_id,
+				   bool neigh, const struct mmsghdr *mmsg,
+				   struct nl_rx_batches_head *batches,
+				   struct nl_rx_batch **last)
+{
+	const struct msghdr *msg = &mmsg->msg_hdr;
+	const struct sockaddr_nl *snl = msg->msg_name;
+	int status = mmsg->msg_len;
+	struct nlmsghdr *h;
+
+	if (msg->msg_namelen != sizeof(struct sockaddr_nl)) {
+		flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+			 "%s sender address length error: length %d", nl->name,
+			 msg->msg_namelen);
+		return;
+	}
+
+	if (IS_ZEBRA_DEBUG_KERNEL_MSGDUMP_RECV) {
+		zlog_debug("%s: << netlink message dump [recv]", __func__);
+#ifdef NETLINK_DEBUG
+		nl_dump(msg->msg_iov->iov_base, status);
+#else
+		zlog_hexdump(msg->msg_iov->iov_base, status);
+#endif /* NETLINK_DEBUG */
+	}
+
+	/*
+	 * Ignore messages that maybe sent from
+	 * other actors besides the kernel
+	 */
+	if (snl->nl_pid != 0) {
+		zlog_debug("Ignoring message from pid %u", snl->nl_pid);
+		return;
+	}
+
+	for (h = (struct nlmsghdr *)msg->msg_iov->iov_base;
+	     (status >= 0 && NLMSG_OK(h, (unsigned int)status));
+	     h = NLMSG_NEXT(h, status)) {
+		if (h->nlmsg_type == NLMSG_DONE)
+			return;
+
+		nl_rx_batch_add(batches, last, ns_id, neigh, h);
+	}
+
+	if (msg->msg_flags & MSG_TRUNC)
+		flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+			 "%s error: message truncated", nl->name);
+	else if (status)
+		flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+			 "%s error: data remnant size %d", nl->name, status);
+}
+
+/*
+ * Drain a kernel event socket of a namespace into 'batches'. Runs in the
+ * listener pthread.
+ */
+static void netlink_listener_drain(const struct nlsock *nl, ns_id_t ns_id,
+				   bool neigh,
+				   struct nl_rx_batches_head *batches)
+{
+	struct mmsghdr msgs[NL_RCV_EVENT_BATCH];
+	struct iovec iov[NL_RCV_EVENT_BATCH];
+	struct sockaddr_nl snl[NL_RCV_EVENT_BATCH];
+	struct nl_rx_batch *batch, *last = NULL;
+	int round, count, i;
+
+	for (round = 0; round < NL_RCV_EVENT_ROUNDS; round++) {
+		memset(msgs, 0, sizeof(msgs));
+		for (i = 0; i < NL_RCV_EVENT_BATCH; i++) {
+			iov[i].iov_base = nl_event_rx_buf[i];
+			iov[i].iov_len = sizeof(nl_event_rx_buf[i]);
+			msgs[i].msg_hdr.msg_name = &snl[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(snl[i]);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		do {
+			count = recvmmsg(nl->sock, msgs, NL_RCV_EVENT_BATCH, 0,
+					 NULL);
+		} while (count == -1 && errno == EINTR);
+
+		if (count == -1) {
+			if (errno == EWOULDBLOCK || errno == EAGAIN)
+				break;
+
+			/*
+			 * Lost neighbor notifications are recovered by
+			 * re-reading the neighbor tables, see
+			 * netlink_neigh_resync(); the socket itself is
+			 * still usable.
+			 */
+			if (errno == ENOBUFS && neigh) {
+				batch = nl_rx_batch_new(ns_id, neigh,
+							NL_RX_NEIGH, 0);
+				batch->overrun = true;
+				nl_rx_batches_add_tail(batches, batch);
+				last = batch;
+				continue;
+			}
+
+			flog_err(EC_ZEBRA_RECVMSG_OVERRUN,
+				 "%s recvmmsg overrun: %s", nl->name,
+				 safe_strerror(errno));
+			/*
+			 * In this case we are screwed. There is no good way to
+			 * recover zebra at this point.
+			 */
+			exit(-1);
+		}
+
+		for (i = 0; i < count; i++)
+			netlink_listener_parse(nl, ns_id, neigh, &msgs[i],
+					       batches, &last);
+
+		/* Short read, socket is drained */
+		if (count < NL_RCV_EVENT_BATCH)
+			break;
+	}
+}
+
+static int netlink_rx_process(struct thread *thread);
+
+/*
+ * Read handler for both kernel event sockets of a namespace, runs in the
+ * listener pthread.
+ */
+static int netlink_listener_read(struct thread *thread)
+{
+	struct zebra_ns *zns = THREAD_ARG(thread);
+	struct nl_rx_batches_head batches;
+	struct nl_rx_batch *batch;
+
+	nl_rx_batches_init(&batches);
+
+	/*
+	 * Always drain the main event socket first: a neighbor is only
+	 * reported after the link it is on, and the link message must reach
+	 * the main pthread first.
+	 */
+	netlink_listener_drain(&zns->netlink, zns->ns_id, false, &batches);
+	netlink_listener_drain(&zns->netlink_neigh, zns->ns_id, true,
+			       &batches);
+
+	if (nl_rx_batches_count(&batches)) {
+		frr_with_mutex(&nl_listener.mutex) {
+			while ((batch = nl_rx_batches_pop(&batches)))
+				nl_rx_batches_add_tail(&nl_listener.queue,
+						       batch);
+		}
+
+		thread_add_event(zrouter.master, netlink_rx_process, NULL, 0,
+				 &nl_listener.t_process);
+	}
+	nl_rx_batches_fini(&batches);
 
-	thread_add_read(zrouter.master, kernel_read, zns, zns->netlink.sock,
-			&zns->t_netlink);
+	thread_add_read(nl_listener.pthread->master, netlink_listener_read,
+			zns, zns->netlink.sock, &zns->t_netlink);
+	thread_add_read(nl_listener.pthread->master, netlink_listener_read,
+			zns, zns->netlink_neigh.sock, &zns->t_netlink_neigh);
 
 	return 0;
 }
 
+/*
+ * Drop the batches of a namespace that the main pthread hasn't processed
+ * yet; only those from the neighbor socket if 'neigh_only'.
+ */
+static void netlink_rx_discard(ns_id_t ns_id, bool neigh_only)
+{
+	struct nl_rx_batch *batch;
+
+	if (!nl_listener.pthread)
+		return;
+
+	frr_with_mutex(&nl_listener.mutex) {
+		frr_each_safe (nl_rx_batches, &nl_listener.queue, batch) {
+			if (batch->ns_id != ns_id
+			    || (neigh_only && !batch->neigh))
+				continue;
+
+			nl_rx_batches_del(&nl_listener.queue, batch);
+			XFREE(MTYPE_NL_RX_BATCH, batch);
+		}
+	}
+}
+
+/*
+ * Re-read the neighbor tables of a namespace after its neighbor socket
+ * overran.
+ */
+static int netlink_neigh_resync(struct thread *thread)
+{
+	struct zebra_ns *zns = THREAD_ARG(thread);
+
+	/* Whatever is still queued predates the re-read, which covers it */
+	netlink_rx_discard(zns->ns_id, true);
+
+	zlog_info("%s: re-reading neighbor tables after overrun",
+		  zns->netlink_neigh.name);
+
+	netlink_neigh_cache_resync(zns);
+
+	return 0;
+}
+
+/*
+ * Dispatch one batch of kernel notifications on the main pthread.
+ */
+static void netlink_rx_dispatch(struct nl_rx_batch *batch)
+{
+	struct zebra_ns *zns = zebra_ns_lookup(batch->ns_id);
+	const struct nlsock *nl;
+	struct nlmsghdr *h;
+	size_t offset;
+
+	if (!zns)
+		return;
+
+	nl = batch->neigh ? &zns->netlink_neigh : &zns->netlink;
+
+	if (batch->overrun) {
+		flog_warn(EC_ZEBRA_RECVMSG_OVERRUN,
+			  "%s recvmmsg overrun: neighbor notifications lost, scheduling re-read",
+			  nl->name);
+		thread_add_timer_msec(zrouter.master, netlink_neigh_resync, zns,
+				      NL_NEIGH_RESYNC_DELAY_MSEC,
+				      &zns->t_netlink_resync);
+		return;
+	}
+
+	/* The pending re-read supersedes these */
+	if (batch->neigh && zns->t_netlink_resync)
+		return;
+
+	if (IS_ZEBRA_DEBUG_KERNEL)
+		zlog_debug("%s: %s: %u %s message(s)", __func__, nl->name,
+			   batch->count, nl_rx_class_str[batch->class]);
+
+	for (offset = 0; offset < batch->len;
+	     offset += NLMSG_ALIGN(h->nlmsg_len)) {
+		h = (struct nlmsghdr *)(batch->buf + offset);
+
+		if (h->nlmsg_type == NLMSG_ERROR) {
+			netlink_parse_error(nl, h, false, false);
+			continue;
+		}
+
+		if (IS_ZEBRA_DEBUG_KERNEL)
+			zlog_debug("%s: %s type %s(%u), len=%d, seq=%u, pid=%u",
+				   __func__, nl->name,
+				   nl_msg_type_to_str(h->nlmsg_type),
+				   h->nlmsg_type, h->nlmsg_len, h->nlmsg_seq,
+				   h->nlmsg_pid);
+
+		if (netlink_information_fetch(h, batch->ns_id, false) < 0)
+			zlog_debug("%s filter function error", nl->name);
+	}
+}
+
+/*
+ * Process the batches the listener pthread has queued, a limited number
+ * per run.
+ */
+static int netlink_rx_process(struct thread *thread)
+{
+	struct nl_rx_batches_head batches;
+	struct nl_rx_batch *batch;
+	bool more;
+
+	nl_rx_batches_init(&batches);
+
+	frr_with_mutex(&nl_listener.mutex) {
+		while (nl_rx_batches_count(&batches) < NL_RX_BATCHES_PER_RUN
+		       && (batch = nl_rx_batches_pop(&nl_listener.queue)))
+			nl_rx_batches_add_tail(&batches, batch);
+		more = nl_rx_batches_count(&nl_listener.queue) > 0;
+	}
+
+	if (more)
+		thread_add_event(zrouter.master, netlink_rx_process, NULL, 0,
+				 &nl_listener.t_process);
+
+	while ((batch = nl_rx_batches_pop(&batches))) {
+		netlink_rx_dispatch(batch);
+		XFREE(MTYPE_NL_RX_BATCH, batch);
+	}
+	nl_rx_batches_fini(&batches);
+
+	return 0;
+}
+
+/*
+ * Start reading a namespace's event sockets in the listener pthread; the
+ * pthread itself is started later by kernel_listener_start().
+ */
+static void netlink_listener_add(struct zebra_ns *zns)
+{
+	struct frr_pthread_attr pattr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+
+	if (!nl_listener.pthread) {
+		pthread_mutex_init(&nl_listener.mutex, NULL);
+		nl_rx_batches_init(&nl_listener.queue);
+		nl_listener.pthread = frr_pthread_new(
+			&pattr, "Zebra netlink listener", "zebra_nl_rx");
+	}
+
+	thread_add_read(nl_listener.pthread->master, netlink_listener_read,
+			zns, zns->netlink.sock, &zns->t_netlink);
+	thread_add_read(nl_listener.pthread->master, netlink_listener_read,
+			zns, zns->netlink_neigh.sock, &zns->t_netlink_neigh);
+}
+
+static void netlink_listener_cancel(struct thread **thread)
+{
+	if (!nl_listener.pthread)
+		return;
+
+	if (atomic_load_explicit(&nl_listener.pthread->running,
+				 memory_order_relaxed))
+		thread_cancel_async(nl_listener.pthread->master, thread, NULL);
+	else
+		thread_cancel(thread);
+}
+
+/*
+ * Start the listener pthread. This runs later than kernel_init(), in case
+ * zebra has fork-ed.
+ */
+void kernel_listener_start(void)
+{
+	if (nl_listener.pthread)
+		frr_pthread_run(nl_listener.pthread, NULL);
+}
+
+/*
+ * Stop the listener pthread, after all namespaces are gone.
+ */
+void kernel_listener_stop(void)
+{
+	struct nl_rx_batch *batch;
+
+	if (!nl_listener.pthread)
+		return;
+
+	frr_pthread_stop(nl_listener.pthread, NULL);
+	frr_pthread_destroy(nl_listener.pthread);
+	nl_listener.pthread = NULL;
+
+	thread_cancel(&nl_listener.t_process);
+	while ((batch = nl_rx_batches_pop(&nl_listener.queue)))
+		XFREE(MTYPE_NL_RX_BATCH, batch);
+	nl_rx_batches_fini(&nl_listener.queue);
+	pthread_mutex_destroy(&nl_listener.mutex);
+}
+
 /*
  * Called by the dplane pthread to read incoming OS messages and dispatch them.
  */
@@ -1478,7 +1972,6 @@ void kernel_init(struct zebra_ns *zns)
 		RTMGRP_IPV6_ROUTE              |
 		RTMGRP_IPV6_IFADDR             |
 		RTMGRP_IPV4_MROUTE             |
-		RTMGRP_NEIGH                   |
 		((uint32_t) 1 << (RTNLGRP_IPV4_RULE - 1)) |
 		((uint32_t) 1 << (RTNLGRP_IPV6_RULE - 1)) |
 		((uint32_t) 1 << (RTNLGRP_NEXTHOP - 1));
@@ -1492,6 +1985,21 @@ void kernel_init(struct zebra_ns *zns)
 		exit(-1);
 	}
 
+	/*
+	 * Neighbor notifications come in bursts (host moves) large enough to
+	 * overrun a socket, so they get one of their own: an overrun there
+	 * only needs the neighbor tables re-read.
+	 */
+	snprintf(zns->netlink_neigh.name, sizeof(zns->netlink_neigh.name),
+		 "netlink-neigh (NS %u)", zns->ns_id);
+	zns->netlink_neigh.sock = -1;
+	if (netlink_socket(&zns->netlink_neigh, RTMGRP_NEIGH, zns->ns_id)
+	    < 0) {
+		zlog_err("Failure to create %s socket",
+			 zns->netlink_neigh.name);
+		exit(-1);
+	}
+
 	snprintf(zns->netlink_cmd.name, sizeof(zns->netlink_cmd.name),
 		 "netlink-cmd (NS %u)", zns->ns_id);
 	zns->netlink_cmd.sock = -1;
@@ -1567,6 +2075,10 @@ void kernel_init(struct zebra_ns *zns)
 		flog_err_sys(EC_LIB_SOCKET, "Can't set %s socket flags: %s",
 			     zns->netlink.name, safe_strerror(errno));
 
+	if (fcntl(zns->netlink_neigh.sock, F_SETFL, O_NONBLOCK) < 0)
+		flog_err_sys(EC_LIB_SOCKET, "Can't set %s socket flags: %s",
+			     zns->netlink_neigh.name, safe_strerror(errno));
+
 	if (fcntl(zns->netlink_cmd.sock, F_SETFL, O_NONBLOCK) < 0)
 		zlog_err("Can't set %s socket error: %s(%d)",
 			 zns->netlink_cmd.name, safe_strerror(errno), errno);
@@ -1588,6 +2100,8 @@ void kernel_init(struct zebra_ns *zns)
 		netlink_recvbuf(&zns->netlink_dplane_out, nl_rcvbufsize);
 		netlink_recvbuf(&zns->netlink_dplane_in, nl_rcvbufsize);
 	}
+	netlink_recvbuf(&zns->netlink_neigh,
+			MAX(nl_rcvbufsize, NL_RCV_NEIGH_BUFSIZE));
 
 	/* Set filter for inbound sockets, to exclude events we've generated
 	 * ourselves.
@@ -1595,27 +2109,41 @@ void kernel_init(struct zebra_ns *zns)
 	netlink_install_filter(zns->netlink.sock, zns->netlink_cmd.snl.nl_pid,
 			       zns->netlink_dplane_out.snl.nl_pid);
 
+	netlink_install_filter(zns->netlink_neigh.sock,
+			       zns->netlink_cmd.snl.nl_pid,
+			       zns->netlink_dplane_out.snl.nl_pid);
+
 	netlink_install_filter(zns->netlink_dplane_in.sock,
 			       zns->netlink_cmd.snl.nl_pid,
 			       zns->netlink_dplane_out.snl.nl_pid);
 
-	zns->t_netlink = NULL;
+	netlink_neigh_cache_init(zns);
 
-	thread_add_read(zrouter.master, kernel_read, zns,
-			zns->netlink.sock, &zns->t_netlink);
+	zns->t_netlink = NULL;
+	zns->t_netlink_neigh = NULL;
+	netlink_listener_add(zns);
 
 	rt_netlink_init();
 }
 
 void kernel_terminate(struct zebra_ns *zns, bool complete)
 {
-	thread_cancel(&zns->t_netlink);
+	netlink_listener_cancel(&zns->t_netlink);
+	netlink_listener_cancel(&zns->t_netlink_neigh);
+	thread_cancel(&zns->t_netlink_resync);
+	netlink_rx_discard(zns->ns_id, false);
+	netlink_neigh_cache_fini(zns);
 
 	if (zns->netlink.sock >= 0) {
 		close(zns->netlink.sock);
 		zns->netlink.sock = -1;
 	}
 
+	if (zns->netlink_neigh.sock >= 0) {
+		close(zns->netlink_neigh.sock);
+		zns->netlink_neigh.sock = -1;
+	}
+
 	if (zns->netlink_cmd.sock >= 0) {
 		close(zns->netlink_cmd.sock);
 		zns->netlink_cmd.sock = -1;
@@ -1459,6 +1459,14 @@ void kernel_terminate(struct zebra_ns *zns, bool complete)
 	return;
 }
 
+void kernel_listener_start(void)
+{
+}
+
+void kernel_listener_stop(void)
+{
+}
+
 /*
  * Called by the dplane pthread to read incoming OS messages and dispatch them.
  */
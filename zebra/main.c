@@ -51,6 +51,7 @@
 #include "zebra/label_manager.h"
 #include "zebra/zebra_netns_notify.h"
 #include "zebra/zebra_rnh.h"
+#include "zebra/rt.h"
 #include "zebra/zebra_pbr.h"
 #include "zebra/zebra_vxlan.h"
 #include "zebra/zebra_routemap.h"
@@ -220,6 +221,8 @@ int zebra_finalize(struct thread *dummy)
 	/* Final shutdown of ns resources */
 	ns_walk_func(zebra_ns_final_shutdown, NULL, NULL);
 
+	kernel_listener_stop();
+
 	/* Stop dplane thread and finish any cleanup */
 	zebra_dplane_shutdown();
 
@@ -387,6 +390,9 @@ int main(int argc, char **argv)
 		}
 	}
 
+	/* Nexthops are allocated and freed for every route update. */
+	nexthop_pool_enable();
+
 	zrouter.master = frr_init();
 
 	/* Zebra related initialize. */
@@ -451,6 +457,9 @@ int main(int argc, char **argv)
 	/* Start dataplane system */
 	zebra_dplane_start();
 
+	/* Start reading kernel notifications */
+	kernel_listener_start();
+
 	/* Start the ted module, before zserv */
 	zebra_opaque_start();
 
@@ -128,14 +128,16 @@ static void zebra_redistribute(struct zserv *client, int type,
 					dst_p, vrf_id,
 					CHECK_FLAG(newre->flags,
 						   ZEBRA_FLAG_SELECTED),
-					newre->type, newre->distance,
-					newre->metric, zebra_check_addr(dst_p));
+					re_attr(newre)->type,
+					re_attr(newre)->distance,
+					re_attr(newre)->metric,
+					zebra_check_addr(dst_p));
 
 			if (!CHECK_FLAG(newre->flags, ZEBRA_FLAG_SELECTED))
 				continue;
 			if ((type != ZEBRA_ROUTE_ALL
-			     && (newre->type != type
-				 || newre->instance != instance)))
+			     && (re_attr(newre)->type != type
+				 || re_attr(newre)->instance != instance)))
 				continue;
 			if (!zebra_check_addr(dst_p))
 				continue;
@@ -176,13 +178,14 @@ static bool zebra_redistribute_check(const struct route_entry *re,
 	 * If multi-instance then check for route
 	 * redistribution for given instance.
 	 */
-	if (re->instance
-	    && redist_check_instance(&client->mi_redist[afi][re->type],
-				     re->instance))
+	if (re_attr(re)->instance
+	    && redist_check_instance(&client->mi_redist[afi][re_attr(re)->type],
+				     re_attr(re)->instance))
 		return true;
 
 	/* If redistribution is enabled for give route type. */
-	if (vrf_bitmap_check(client->redist[afi][re->type], re->vrf_id))
+	if (vrf_bitmap_check(client->redist[afi][re_attr(re)->type],
+			     re->vrf_id))
 		return true;
 
 	return false;
@@ -202,8 +205,9 @@ void redistribute_update(const struct prefix *p, const struct prefix *src_p,
 		zlog_debug(
 			"(%u:%u):%pFX: Redist update re %p (%s), old %p (%s)",
 			re->vrf_id, re->table, p, re,
-			zebra_route_string(re->type), prev_re,
-			prev_re ? zebra_route_string(prev_re->type) : "None");
+			zebra_route_string(re_attr(re)->type), prev_re,
+			prev_re ? zebra_route_string(re_attr(prev_re)->type)
+				: "None");
 
 	afi = family2afi(p->family);
 	if (!afi) {
@@ -225,8 +229,10 @@ void redistribute_update(const struct prefix *p, const struct prefix *src_p,
 					"%s: client %s %pFX(%u:%u), type=%d, distance=%d, metric=%d",
 					__func__,
 					zebra_route_string(client->proto), p,
-					re->vrf_id, re->table, re->type,
-					re->distance, re->metric);
+					re->vrf_id, re->table,
+					re_attr(re)->type,
+					re_attr(re)->distance,
+					re_attr(re)->metric);
 			}
 			zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_ADD,
 						 client, p, src_p, re);
@@ -263,9 +269,11 @@ void redistribute_delete(const struct prefix *p, const struct prefix *src_p,
 	if (IS_ZEBRA_DEBUG_RIB) {
 		zlog_debug("%u:%pFX: Redist del: re %p (%s), new re %p (%s)",
 			   vrfid, p, old_re,
-			   old_re ? zebra_route_string(old_re->type) : "None",
+			   old_re ? zebra_route_string(re_attr(old_re)->type)
+				  : "None",
 			   new_re,
-			   new_re ? zebra_route_string(new_re->type) : "None");
+			   new_re ? zebra_route_string(re_attr(new_re)->type)
+				  : "None");
 	}
 
 	afi = family2afi(p->family);
@@ -661,9 +669,9 @@ int zebra_add_import_table_entry(struct zebra_vrf *zvrf, struct route_node *rn,
 	afi = family2afi(rn->p.family);
 	if (rmap_name)
 		ret = zebra_import_table_route_map_check(
-			afi, re->type, re->instance, &rn->p,
+			afi, re_attr(re)->type, re_attr(re)->instance, &rn->p,
 			re->nhe->nhg.nexthop,
-			zvrf->vrf->vrf_id, re->tag, rmap_name);
+			zvrf->vrf->vrf_id, re_attr(re)->tag, rmap_name);
 
 	if (ret != RMAP_PERMITMATCH) {
 		UNSET_FLAG(re->flags, ZEBRA_FLAG_SELECTED);
@@ -677,9 +685,10 @@ int zebra_add_import_table_entry(struct zebra_vrf *zvrf, struct route_node *rn,
 		if (CHECK_FLAG(same->status, ROUTE_ENTRY_REMOVED))
 			continue;
 
-		if (same->type == re->type && same->instance == re->instance
+		if (re_attr(same)->type == re_attr(re)->type
+		    && re_attr(same)->instance == re_attr(re)->instance
 		    && same->table == re->table
-		    && same->type != ZEBRA_ROUTE_CONNECT)
+		    && re_attr(same)->type != ZEBRA_ROUTE_CONNECT)
 			break;
 	}
 
@@ -689,14 +698,13 @@ int zebra_add_import_table_entry(struct zebra_vrf *zvrf, struct route_node *rn,
 	}
 
 	newre = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
-	newre->type = ZEBRA_ROUTE_TABLE;
-	newre->distance = zebra_import_table_distance[afi][re->table];
+	route_entry_attr_set(newre, ZEBRA_ROUTE_TABLE, re->table,
+			     zebra_import_table_distance[afi][re->table],
+			     re_attr(re)->metric, 0);
 	newre->flags = re->flags;
-	newre->metric = re->metric;
 	newre->mtu = re->mtu;
 	newre->table = zvrf->table_id;
 	newre->uptime = monotime(NULL);
-	newre->instance = re->table;
 
 	ng = nexthop_group_new();
 	copy_nexthops(&ng->nexthop, re->nhe->nhg.nexthop, NULL);
@@ -717,8 +725,8 @@ int zebra_del_import_table_entry(struct zebra_vrf *zvrf, struct route_node *rn,
 
 	rib_delete(afi, SAFI_UNICAST, zvrf->vrf->vrf_id, ZEBRA_ROUTE_TABLE,
 		   re->table, re->flags, &p, NULL, re->nhe->nhg.nexthop,
-		   re->nhe_id, zvrf->table_id, re->metric, re->distance,
-		   false);
+		   re->nhe_id, zvrf->table_id, re_attr(re)->metric,
+		   re_attr(re)->distance, false);
 
 	return 0;
 }
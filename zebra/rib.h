@@ -101,24 +101,24 @@ struct route_entry {
 	 */
 	struct nhg_hash_entry *nhe;
 
-	/* Nexthop group from FIB (optional), reflecting what is actually
-	 * installed in the FIB if that differs. The 'backup' group is used
-	 * when backup nexthops are present in the route's nhg.
-	 */
-	struct nexthop_group fib_ng;
-	struct nexthop_group fib_backup_ng;
+	struct opaque *opaque;
+
+	/* Uptime. */
+	time_t uptime;
 
 	/* Nexthop group hash entry ID */
 	uint32_t nhe_id;
 
-	/* Tag */
-	route_tag_t tag;
-
-	/* Uptime. */
-	time_t uptime;
+	/* Type, instance, distance, metric and tag; an index of the shared
+	 * copy, see re_attr().
+	 */
+	uint32_t attr;
 
-	/* Type of this route. */
-	int type;
+	/* Nexthop groups from FIB (optional), shared/refcounted, present only
+	 * while what is actually installed in the FIB differs from the
+	 * route's nhe. An index of the shared copy, see re_fib().
+	 */
+	uint32_t fib;
 
 	/* VRF identifier. */
 	vrf_id_t vrf_id;
@@ -126,9 +126,6 @@ struct route_entry {
 	/* Which routing table */
 	uint32_t table;
 
-	/* Metric */
-	uint32_t metric;
-
 	/* MTU */
 	uint32_t mtu;
 	uint32_t nexthop_mtu;
@@ -159,6 +156,16 @@ struct route_entry {
 
 	/* Sequence value incremented for each dataplane operation */
 	uint32_t dplane_sequence;
+};
+
+/*
+ * Route attributes that are the same for most routes from one source. They
+ * are interned in zrouter.re_attrs and route entries refer to them by a
+ * 32-bit index; use route_entry_attr_set() to change them.
+ */
+struct route_entry_attr {
+	/* Type of this route. */
+	int type;
 
 	/* Source protocol instance */
 	uint16_t instance;
@@ -166,12 +173,64 @@ struct route_entry {
 	/* Distance. */
 	uint8_t distance;
 
-	struct opaque *opaque;
+	/* Metric */
+	uint32_t metric;
+
+	/* Tag */
+	route_tag_t tag;
+
+	uint32_t refcnt;
+	uint32_t index;
 };
 
-#define RIB_SYSTEM_ROUTE(R) RSYSTEM_ROUTE((R)->type)
+/*
+ * FIB-specific nexthop groups of a route entry. 'ng' reflects what is
+ * actually installed in the FIB if that differs from the route's nhg; the
+ * 'backup' group is used when backup nexthops are present in the route's
+ * nhg. Most routes never need these, so they live out of line to keep
+ * struct route_entry small.
+ *
+ * These are interned in zrouter.re_fibs: routes with the same installed
+ * set (e.g. the same ECMP member missing from the FIB) share one
+ * read-only copy. Use route_entry_fib_set() to change a route's groups.
+ */
+struct route_entry_fib {
+	struct nexthop_group ng;
+	struct nexthop_group backup_ng;
+
+	uint32_t refcnt;
+	uint32_t index;
+};
 
-#define RIB_KERNEL_ROUTE(R) RKERNEL_ROUTE((R)->type)
+/*
+ * Index -> object tables for the shared data route entries refer to.
+ * Slot 0 is reserved: for attributes it holds the all-zero set a new
+ * route entry starts out with, for fib groups it means "none".
+ */
+struct route_entry_slots {
+	void **items;
+	uint32_t size;
+	uint32_t top;
+	uint32_t free;
+};
+
+extern struct route_entry_slots re_attr_slots;
+extern struct route_entry_slots re_fib_slots;
+
+static inline const struct route_entry_attr *
+re_attr(const struct route_entry *re)
+{
+	return re_attr_slots.items[re->attr];
+}
+
+static inline struct route_entry_fib *re_fib(const struct route_entry *re)
+{
+	return re_fib_slots.items[re->fib];
+}
+
+#define RIB_SYSTEM_ROUTE(R) RSYSTEM_ROUTE(re_attr(R)->type)
+
+#define RIB_KERNEL_ROUTE(R) RKERNEL_ROUTE(re_attr(R)->type)
 
 /* meta-queue structure:
  * sub-queue 0: nexthop group objects
@@ -357,6 +416,24 @@ enum rib_update_event {
 
 extern void route_entry_copy_nexthops(struct route_entry *re,
 				      struct nexthop *nh);
+extern void route_entry_fib_set(struct route_entry *re,
+				struct nexthop_group *ng,
+				struct nexthop_group *backup_ng);
+extern void route_entry_fib_share(struct route_entry *to,
+				  const struct route_entry *from);
+extern void route_entry_fib_release(struct route_entry *re);
+extern uint32_t route_entry_fib_hash_key(const void *arg);
+extern bool route_entry_fib_hash_equal(const void *arg1, const void *arg2);
+extern void route_entry_fib_hash_free(void *arg);
+extern void route_entry_attr_set(struct route_entry *re, int type,
+				 uint16_t instance, uint8_t distance,
+				 uint32_t metric, route_tag_t tag);
+extern void route_entry_attr_release(struct route_entry *re);
+extern uint32_t route_entry_attr_hash_key(const void *arg);
+extern bool route_entry_attr_hash_equal(const void *arg1, const void *arg2);
+extern void route_entry_attr_hash_free(void *arg);
+extern void route_entry_slots_init(void);
+extern void route_entry_slots_fini(void);
 int route_entry_update_nhe(struct route_entry *re,
 			   struct nhg_hash_entry *new_nhghe);
 
@@ -597,6 +674,11 @@ static inline void rib_tables_iter_cleanup(rib_tables_iter_t *iter)
 DECLARE_HOOK(rib_update, (struct route_node * rn, const char *reason),
 	     (rn, reason));
 
+/* Empty group handed out for routes without fib-specific nexthops;
+ * callers must treat it as read-only.
+ */
+extern struct nexthop_group rib_empty_nhg;
+
 /*
  * Access installed/fib nexthops, which may be a subset of the
  * rib nexthops.
@@ -606,8 +688,10 @@ static inline struct nexthop_group *rib_get_fib_nhg(struct route_entry *re)
 	/* If the fib set is a subset of the active rib set,
 	 * use the dedicated fib list.
 	 */
-	if (CHECK_FLAG(re->status, ROUTE_ENTRY_USE_FIB_NHG))
-		return &(re->fib_ng);
+	if (CHECK_FLAG(re->status, ROUTE_ENTRY_USE_FIB_NHG) && re->fib)
+		return &(re_fib(re)->ng);
+	else if (CHECK_FLAG(re->status, ROUTE_ENTRY_USE_FIB_NHG))
+		return &rib_empty_nhg;
 	else
 		return &(re->nhe->nhg);
 }
@@ -619,7 +703,10 @@ static inline struct nexthop_group *rib_get_fib_nhg(struct route_entry *re)
 static inline struct nexthop_group *rib_get_fib_backup_nhg(
 	struct route_entry *re)
 {
-	return &(re->fib_backup_ng);
+	if (re->fib)
+		return &(re_fib(re)->backup_ng);
+
+	return &rib_empty_nhg;
 }
 
 extern void zebra_vty_init(void);
@@ -61,6 +61,8 @@
 #include "mpls.h"
 #include "vxlan.h"
 #include "printfrr.h"
+#include "hash.h"
+#include "jhash.h"
 
 #include "zebra/zapi_msg.h"
 #include "zebra/zebra_ns.h"
@@ -80,6 +82,8 @@
 #include "zebra/zebra_errors.h"
 #include "zebra/zebra_evpn_mh.h"
 
+DEFINE_MTYPE_STATIC(ZEBRA, NL_NEIGH, "Zebra kernel neighbor cache");
+
 #ifndef AF_MPLS
 #define AF_MPLS 28
 #endif
@@ -929,15 +933,13 @@ static int netlink_route_change_read_unicast(struct nlmsghdr *h, ns_id_t ns_id,
 				(struct rtnexthop *)RTA_DATA(tb[RTA_MULTIPATH]);
 
 			re = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
-			re->type = proto;
-			re->distance = distance;
+			route_entry_attr_set(re, proto, 0, distance, metric,
+					     tag);
 			re->flags = flags;
-			re->metric = metric;
 			re->mtu = mtu;
 			re->vrf_id = vrf_id;
 			re->table = table;
 			re->uptime = monotime(NULL);
-			re->tag = tag;
 			re->nhe_id = nhe_id;
 
 			if (!nhe_id) {
@@ -965,8 +967,10 @@ static int netlink_route_change_read_unicast(struct nlmsghdr *h, ns_id_t ns_id,
 			if (nhe_id || ng)
 				rib_add_multipath(afi, SAFI_UNICAST, &p,
 						  &src_p, re, ng);
-			else
+			else {
+				route_entry_attr_release(re);
 				XFREE(MTYPE_RE, re);
+			}
 		}
 	} else {
 		if (nhe_id) {
@@ -3366,6 +3370,241 @@ static int netlink_macfdb_change(struct nlmsghdr *h, int len, ns_id_t ns_id)
 	return zebra_vxlan_local_mac_del(ifp, br_if, &mac, vid);
 }
 
+/*
+ * The neighbors the kernel has reported, per namespace. After the neighbor
+ * event socket overran, the neighbor tables are read again and whatever is
+ * cached but no longer in the kernel gets a delete, as if the lost
+ * notification had arrived.
+ */
+struct nl_neigh_entry {
+	/* Key, see nl_neigh_entry_key() */
+	ifindex_t ifindex;
+	uint16_t vid;
+	uint8_t family;
+	uint8_t addrlen;
+	/* IP address, or MAC address for AF_BRIDGE */
+	uint8_t addr[IPV6_MAX_BYTELEN];
+	/* Remote VTEP of an AF_BRIDGE entry */
+	struct in_addr dst;
+
+	/* Last reported state, replayed in the delete */
+	uint16_t state;
+	uint8_t flags;
+	uint32_t nhg_id;
+
+	bool seen;
+};
+
+#define NL_NEIGH_KEYLEN offsetof(struct nl_neigh_entry, state)
+
+static unsigned int nl_neigh_entry_hash(const void *arg)
+{
+	return jhash(arg, NL_NEIGH_KEYLEN, 0);
+}
+
+static bool nl_neigh_entry_equal(const void *arg1, const void *arg2)
+{
+	return !memcmp(arg1, arg2, NL_NEIGH_KEYLEN);
+}
+
+static void *nl_neigh_entry_alloc(void *arg)
+{
+	struct nl_neigh_entry *entry;
+
+	entry = XMALLOC(MTYPE_NL_NEIGH, sizeof(*entry));
+	*entry = *(struct nl_neigh_entry *)arg;
+
+	return entry;
+}
+
+static void nl_neigh_entry_free(void *arg)
+{
+	XFREE(MTYPE_NL_NEIGH, arg);
+}
+
+/*
+ * Fill in the cache entry for a neighbor message; false if it has no
+ * usable address.
+ */
+static bool nl_neigh_entry_key(struct nlmsghdr *h, int len,
+			       struct nl_neigh_entry *entry)
+{
+	struct ndmsg *ndm = NLMSG_DATA(h);
+	struct rtattr *tb[NDA_MAX + 1];
+
+	memset(entry, 0, sizeof(*entry));
+	netlink_parse_rtattr_flags(tb, NDA_MAX, NDA_RTA(ndm), len,
+				   NLA_F_NESTED);
+
+	entry->ifindex = ndm->ndm_ifindex;
+	entry->family = ndm->ndm_family;
+	entry->state = ndm->ndm_state;
+	entry->flags = ndm->ndm_flags;
+
+	if (ndm->ndm_family == AF_BRIDGE) {
+		if (!tb[NDA_LLADDR] || RTA_PAYLOAD(tb[NDA_LLADDR]) != ETH_ALEN)
+			return false;
+
+		entry->addrlen = ETH_ALEN;
+		memcpy(entry->addr, RTA_DATA(tb[NDA_LLADDR]), ETH_ALEN);
+		if (tb[NDA_VLAN])
+			entry->vid = *(uint16_t *)RTA_DATA(tb[NDA_VLAN]);
+		if (tb[NDA_DST]
+		    && RTA_PAYLOAD(tb[NDA_DST]) >= IPV4_MAX_BYTELEN)
+			memcpy(&entry->dst, RTA_DATA(tb[NDA_DST]),
+			       IPV4_MAX_BYTELEN);
+		if (tb[NDA_NH_ID])
+			entry->nhg_id = *(uint32_t *)RTA_DATA(tb[NDA_NH_ID]);
+		return true;
+	}
+
+	if (!tb[NDA_DST] || RTA_PAYLOAD(tb[NDA_DST]) > sizeof(entry->addr))
+		return false;
+
+	entry->addrlen = RTA_PAYLOAD(tb[NDA_DST]);
+	memcpy(entry->addr, RTA_DATA(tb[NDA_DST]), entry->addrlen);
+	return true;
+}
+
+static void netlink_neigh_cache_update(struct nlmsghdr *h, int len,
+				       ns_id_t ns_id)
+{
+	struct zebra_ns *zns = zebra_ns_lookup(ns_id);
+	struct nl_neigh_entry lookup, *entry;
+
+	if (!zns || !zns->neigh_cache)
+		return;
+	if (h->nlmsg_type != RTM_NEWNEIGH && h->nlmsg_type != RTM_DELNEIGH)
+		return;
+	if (!nl_neigh_entry_key(h, len, &lookup))
+		return;
+
+	if (h->nlmsg_type == RTM_DELNEIGH) {
+		entry = hash_release(zns->neigh_cache, &lookup);
+		XFREE(MTYPE_NL_NEIGH, entry);
+		return;
+	}
+
+	entry = hash_get(zns->neigh_cache, &lookup, nl_neigh_entry_alloc);
+	entry->state = lookup.state;
+	entry->flags = lookup.flags;
+	entry->nhg_id = lookup.nhg_id;
+	entry->seen = true;
+}
+
+void netlink_neigh_cache_init(struct zebra_ns *zns)
+{
+	zns->neigh_cache = hash_create_size(8, nl_neigh_entry_hash,
+					    nl_neigh_entry_equal,
+					    "Kernel neighbors");
+}
+
+void netlink_neigh_cache_fini(struct zebra_ns *zns)
+{
+	if (!zns->neigh_cache)
+		return;
+
+	hash_clean(zns->neigh_cache, nl_neigh_entry_free);
+	hash_free(zns->neigh_cache);
+	zns->neigh_cache = NULL;
+}
+
+static int nl_neigh_entry_unsee(struct hash_bucket *bucket, void *arg)
+{
+	struct nl_neigh_entry *entry = bucket->data;
+
+	entry->seen = false;
+	return HASHWALK_CONTINUE;
+}
+
+static int nl_neigh_entry_collect(struct hash_bucket *bucket, void *arg)
+{
+	struct nl_neigh_entry *entry = bucket->data;
+
+	if (!entry->seen)
+		listnode_add(arg, entry);
+	return HASHWALK_CONTINUE;
+}
+
+/*
+ * Hand a delete for a neighbor gone from the kernel to the regular
+ * notification handler.
+ */
+static void netlink_neigh_replay_del(struct zebra_ns *zns,
+				     const struct nl_neigh_entry *entry)
+{
+	struct {
+		struct nlmsghdr n;
+		struct ndmsg ndm;
+		char buf[128];
+	} req;
+
+	memset(&req, 0, sizeof(req));
+	req.n.nlmsg_type = RTM_DELNEIGH;
+	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+	req.ndm.ndm_family = entry->family;
+	req.ndm.ndm_ifindex = entry->ifindex;
+	req.ndm.ndm_state = entry->state;
+	req.ndm.ndm_flags = entry->flags;
+	req.ndm.ndm_type = RTN_UNICAST;
+
+	if (entry->family == AF_BRIDGE) {
+		nl_attr_put(&req.n, sizeof(req), NDA_LLADDR, entry->addr,
+			    entry->addrlen);
+		if (entry->vid)
+			nl_attr_put16(&req.n, sizeof(req), NDA_VLAN,
+				      entry->vid);
+		if (entry->dst.s_addr != INADDR_ANY)
+			nl_attr_put(&req.n, sizeof(req), NDA_DST, &entry->dst,
+				    IPV4_MAX_BYTELEN);
+		if (entry->nhg_id)
+			nl_attr_put32(&req.n, sizeof(req), NDA_NH_ID,
+				      entry->nhg_id);
+	} else
+		nl_attr_put(&req.n, sizeof(req), NDA_DST, entry->addr,
+			    entry->addrlen);
+
+	netlink_neigh_change(&req.n, zns->ns_id);
+}
+
+/*
+ * Re-read the neighbor tables (and the bridge FDB when EVPN is in use)
+ * and delete what has disappeared from the kernel since.
+ */
+void netlink_neigh_cache_resync(struct zebra_ns *zns)
+{
+	struct nl_neigh_entry *entry, del;
+	struct list *gone;
+	struct listnode *node;
+
+	hash_walk(zns->neigh_cache, nl_neigh_entry_unsee, NULL);
+
+	netlink_neigh_read(zns);
+	if (is_evpn_enabled())
+		netlink_macfdb_read(zns);
+
+	gone = list_new();
+	hash_walk(zns->neigh_cache, nl_neigh_entry_collect, gone);
+
+	for (ALL_LIST_ELEMENTS_RO(gone, node, entry)) {
+		del = *entry;
+		hash_release(zns->neigh_cache, entry);
+		XFREE(MTYPE_NL_NEIGH, entry);
+
+		/* The FDB is only tracked while EVPN is enabled */
+		if (del.family == AF_BRIDGE && !is_evpn_enabled())
+			continue;
+
+		netlink_neigh_replay_del(zns, &del);
+	}
+
+	if (IS_ZEBRA_DEBUG_KERNEL)
+		zlog_debug("%s: %u neighbor(s) gone from NS %u", __func__,
+			   listcount(gone), zns->ns_id);
+
+	list_delete(&gone);
+}
+
 static int netlink_macfdb_table(struct nlmsghdr *h, ns_id_t ns_id, int startup)
 {
 	int len;
@@ -3384,6 +3623,9 @@ static int netlink_macfdb_table(struct nlmsghdr *h, ns_id_t ns_id, int startup)
 	if (ndm->ndm_family != AF_BRIDGE)
 		return 0;
 
+	if (is_evpn_enabled())
+		netlink_neigh_cache_update(h, len, ns_id);
+
 	return netlink_macfdb_change(h, len, ns_id);
 }
 
@@ -3888,7 +4130,7 @@ static int netlink_neigh_table(struct nlmsghdr *h, ns_id_t ns_id, int startup)
 	if (ndm->ndm_family != AF_INET && ndm->ndm_family != AF_INET6)
 		return 0;
 
-	return netlink_neigh_change(h, len);
+	return netlink_neigh_change(h, ns_id);
 }
 
 /* Request for IP neighbor information from the kernel */
@@ -4048,14 +4290,19 @@ int netlink_neigh_change(struct nlmsghdr *h, ns_id_t ns_id)
 
 	/* Is this a notification for the MAC FDB or IP neighbor table? */
 	ndm = NLMSG_DATA(h);
-	if (ndm->ndm_family == AF_BRIDGE)
+	if (ndm->ndm_family == AF_BRIDGE) {
+		if (is_evpn_enabled())
+			netlink_neigh_cache_update(h, len, ns_id);
 		return netlink_macfdb_change(h, len, ns_id);
+	}
 
 	if (ndm->ndm_type != RTN_UNICAST)
 		return 0;
 
-	if (ndm->ndm_family == AF_INET || ndm->ndm_family == AF_INET6)
+	if (ndm->ndm_family == AF_INET || ndm->ndm_family == AF_INET6) {
+		netlink_neigh_cache_update(h, len, ns_id);
 		return netlink_ipneigh_change(h, len, ns_id);
+	}
 	else {
 		flog_warn(
 			EC_ZEBRA_UNKNOWN_FAMILY,
@@ -95,6 +95,9 @@ extern int netlink_macfdb_read_for_bridge(struct zebra_ns *zns,
 					  struct interface *ifp,
 					  struct interface *br_if);
 extern int netlink_neigh_read(struct zebra_ns *zns);
+extern void netlink_neigh_cache_init(struct zebra_ns *zns);
+extern void netlink_neigh_cache_fini(struct zebra_ns *zns);
+extern void netlink_neigh_cache_resync(struct zebra_ns *zns);
 extern int netlink_neigh_read_for_vlan(struct zebra_ns *zns,
 				       struct interface *vlan_if);
 extern int netlink_macfdb_read_specific_mac(struct zebra_ns *zns,
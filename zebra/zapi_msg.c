@@ -63,6 +63,7 @@
 #include "zebra/zebra_srv6.h"
 
 DEFINE_MTYPE_STATIC(ZEBRA, OPAQUE, "Opaque Data");
+DEFINE_MTYPE_STATIC(ZEBRA, RE_NOTIFY_BATCH, "Route owner notifications");
 
 static int zapi_nhg_decode(struct stream *s, int cmd, struct zapi_nhg *api_nhg);
 
@@ -560,9 +561,9 @@ int zsend_redistribute_route(int cmd, struct zserv *client,
 
 	memset(&api, 0, sizeof(api));
 	api.vrf_id = re->vrf_id;
-	api.type = re->type;
+	api.type = re_attr(re)->type;
 	api.safi = SAFI_UNICAST;
-	api.instance = re->instance;
+	api.instance = re_attr(re)->instance;
 	api.flags = re->flags;
 
 	afi = family2afi(p->family);
@@ -627,12 +628,12 @@ int zsend_redistribute_route(int cmd, struct zserv *client,
 
 	/* Attributes. */
 	SET_FLAG(api.message, ZAPI_MESSAGE_DISTANCE);
-	api.distance = re->distance;
+	api.distance = re_attr(re)->distance;
 	SET_FLAG(api.message, ZAPI_MESSAGE_METRIC);
-	api.metric = re->metric;
-	if (re->tag) {
+	api.metric = re_attr(re)->metric;
+	if (re_attr(re)->tag) {
 		SET_FLAG(api.message, ZAPI_MESSAGE_TAG);
-		api.tag = re->tag;
+		api.tag = re_attr(re)->tag;
 	}
 	SET_FLAG(api.message, ZAPI_MESSAGE_MTU);
 	api.mtu = re->mtu;
@@ -680,8 +681,8 @@ static int zsend_ipv4_nexthop_lookup_mrib(struct zserv *client,
 	if (re) {
 		struct nexthop_group *nhg;
 
-		stream_putc(s, re->distance);
-		stream_putl(s, re->metric);
+		stream_putc(s, re_attr(re)->distance);
+		stream_putl(s, re_attr(re)->metric);
 		num = 0;
 		/* remember position for nexthop_num */
 		nump = stream_get_endp(s);
@@ -738,6 +739,74 @@ int zsend_nhg_notify(uint16_t type, uint16_t instance, uint32_t session_id,
 	return zserv_send_message(client, s);
 }
 
+/*
+ * Route-owner notifications held back for one client, see
+ * zsend_route_notify_owner_hold().
+ */
+struct route_notify_batch {
+	struct zserv *client;
+	struct stream_fifo fifo;
+};
+
+/* Non-NULL while notifications are held back */
+static struct list *route_notify_batches;
+
+static int route_notify_send(struct zserv *client, struct stream *s)
+{
+	struct route_notify_batch *rnb;
+	struct listnode *node;
+
+	if (!route_notify_batches)
+		return zserv_send_message(client, s);
+
+	for (ALL_LIST_ELEMENTS_RO(route_notify_batches, node, rnb))
+		if (rnb->client == client)
+			break;
+
+	if (!rnb) {
+		rnb = XCALLOC(MTYPE_RE_NOTIFY_BATCH, sizeof(*rnb));
+		rnb->client = client;
+		stream_fifo_init(&rnb->fifo);
+		listnode_add(route_notify_batches, rnb);
+	}
+
+	stream_fifo_push(&rnb->fifo, s);
+
+	return 0;
+}
+
+/*
+ * Hold back route-owner notifications until
+ * zsend_route_notify_owner_flush(), which hands each client its
+ * notifications in one go.
+ */
+void zsend_route_notify_owner_hold(void)
+{
+	if (!route_notify_batches)
+		route_notify_batches = list_new();
+}
+
+void zsend_route_notify_owner_flush(void)
+{
+	struct list *batches = route_notify_batches;
+	struct route_notify_batch *rnb;
+
+	if (!batches)
+		return;
+
+	route_notify_batches = NULL;
+
+	while ((rnb = listnode_head(batches))) {
+		listnode_delete(batches, rnb);
+
+		zserv_send_batch(rnb->client, &rnb->fifo);
+		stream_fifo_deinit(&rnb->fifo);
+		XFREE(MTYPE_RE_NOTIFY_BATCH, rnb);
+	}
+
+	list_delete(&batches);
+}
+
 /*
  * Common utility send route notification, called from a path using a
  * route_entry and from a path using a dataplane context.
@@ -792,14 +861,15 @@ static int route_notify_internal(const struct prefix *p, int type,
 
 	stream_putw_at(s, 0, stream_get_endp(s));
 
-	return zserv_send_message(client, s);
+	return route_notify_send(client, s);
 }
 
 int zsend_route_notify_owner(struct route_entry *re, const struct prefix *p,
 			     enum zapi_route_notify_owner note,
 			     afi_t afi, safi_t safi)
 {
-	return (route_notify_internal(p, re->type, re->instance, re->vrf_id,
+	return (route_notify_internal(p, re_attr(re)->type,
+				      re_attr(re)->instance, re->vrf_id,
 				      re->table, note, afi, safi));
 }
 
@@ -2003,6 +2073,9 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	int ret;
 	vrf_id_t vrf_id;
 	struct nhg_hash_entry nhe;
+	uint8_t distance = 0;
+	uint32_t metric = 0;
+	route_tag_t tag = 0;
 
 	s = msg;
 	if (zapi_route_decode(s, &api) < 0) {
@@ -2021,8 +2094,6 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 
 	/* Allocate new route. */
 	re = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
-	re->type = api.type;
-	re->instance = api.instance;
 	re->flags = api.flags;
 	re->uptime = monotime(NULL);
 	re->vrf_id = vrf_id;
@@ -2074,11 +2145,12 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	}
 
 	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_DISTANCE))
-		re->distance = api.distance;
+		distance = api.distance;
 	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_METRIC))
-		re->metric = api.metric;
+		metric = api.metric;
 	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_TAG))
-		re->tag = api.tag;
+		tag = api.tag;
+	route_entry_attr_set(re, api.type, api.instance, distance, metric, tag);
 	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_MTU))
 		re->mtu = api.mtu;
 
@@ -2096,6 +2168,7 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 			  __func__);
 		nexthop_group_delete(&ng);
 		zebra_nhg_backup_free(&bnhg);
+		route_entry_attr_release(re);
 		XFREE(MTYPE_RE, re);
 		return;
 	}
@@ -2108,6 +2181,7 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 			  __func__, api.safi);
 		nexthop_group_delete(&ng);
 		zebra_nhg_backup_free(&bnhg);
+		route_entry_attr_release(re);
 		XFREE(MTYPE_RE, re);
 		return;
 	}
@@ -2136,6 +2210,7 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	 */
 	if (ret == -1) {
 		client->error_cnt++;
+		route_entry_attr_release(re);
 		XFREE(MTYPE_RE, re);
 	}
 
@@ -82,6 +82,8 @@ extern int zsend_route_notify_owner(struct route_entry *re,
 				    afi_t afi, safi_t safi);
 extern int zsend_route_notify_owner_ctx(const struct zebra_dplane_ctx *ctx,
 					enum zapi_route_notify_owner note);
+extern void zsend_route_notify_owner_hold(void);
+extern void zsend_route_notify_owner_flush(void);
 
 extern void zsend_rule_notify_owner(const struct zebra_dplane_ctx *ctx,
 				    enum zapi_rule_notify_owner note);
@@ -2338,8 +2338,8 @@ int dplane_ctx_route_init(struct zebra_dplane_ctx *ctx, enum dplane_op_e op,
 	ctx->zd_op = op;
 	ctx->zd_status = ZEBRA_DPLANE_REQUEST_SUCCESS;
 
-	ctx->u.rinfo.zd_type = re->type;
-	ctx->u.rinfo.zd_old_type = re->type;
+	ctx->u.rinfo.zd_type = re_attr(re)->type;
+	ctx->u.rinfo.zd_old_type = re_attr(re)->type;
 
 	/* Prefixes: dest, and optional source */
 	srcdest_rnode_prefixes(rn, &p, &src_p);
@@ -2353,15 +2353,15 @@ int dplane_ctx_route_init(struct zebra_dplane_ctx *ctx, enum dplane_op_e op,
 
 	ctx->zd_table_id = re->table;
 
-	ctx->u.rinfo.zd_metric = re->metric;
-	ctx->u.rinfo.zd_old_metric = re->metric;
+	ctx->u.rinfo.zd_metric = re_attr(re)->metric;
+	ctx->u.rinfo.zd_old_metric = re_attr(re)->metric;
 	ctx->zd_vrf_id = re->vrf_id;
 	ctx->u.rinfo.zd_mtu = re->mtu;
 	ctx->u.rinfo.zd_nexthop_mtu = re->nexthop_mtu;
-	ctx->u.rinfo.zd_instance = re->instance;
-	ctx->u.rinfo.zd_tag = re->tag;
-	ctx->u.rinfo.zd_old_tag = re->tag;
-	ctx->u.rinfo.zd_distance = re->distance;
+	ctx->u.rinfo.zd_instance = re_attr(re)->instance;
+	ctx->u.rinfo.zd_tag = re_attr(re)->tag;
+	ctx->u.rinfo.zd_old_tag = re_attr(re)->tag;
+	ctx->u.rinfo.zd_distance = re_attr(re)->distance;
 
 	table = srcdest_rnode_table(rn);
 	info = table->info;
@@ -3023,11 +3023,13 @@ dplane_route_update_internal(struct route_node *rn,
 				zebra_router_get_next_sequence();
 			ctx->zd_old_seq = old_re->dplane_sequence;
 
-			ctx->u.rinfo.zd_old_tag = old_re->tag;
-			ctx->u.rinfo.zd_old_type = old_re->type;
-			ctx->u.rinfo.zd_old_instance = old_re->instance;
-			ctx->u.rinfo.zd_old_distance = old_re->distance;
-			ctx->u.rinfo.zd_old_metric = old_re->metric;
+			ctx->u.rinfo.zd_old_tag = re_attr(old_re)->tag;
+			ctx->u.rinfo.zd_old_type = re_attr(old_re)->type;
+			ctx->u.rinfo.zd_old_instance =
+				re_attr(old_re)->instance;
+			ctx->u.rinfo.zd_old_distance =
+				re_attr(old_re)->distance;
+			ctx->u.rinfo.zd_old_metric = re_attr(old_re)->metric;
 			ctx->u.rinfo.nhe.old_id = old_re->nhe->id;
 
 #ifndef HAVE_NETLINK
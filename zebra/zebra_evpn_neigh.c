@@ -88,24 +88,22 @@ struct hash *zebra_neigh_db_create(const char *desc)
 	return hash_create_size(8, neigh_hash_keymake, neigh_cmp, desc);
 }
 
+static void num_dup_detected_neighs_iter(struct hash_bucket *hb, void *arg)
+{
+	struct zebra_neigh *nbr = (struct zebra_neigh *)hb->data;
+	uint32_t *num_neighs = arg;
+
+	if (CHECK_FLAG(nbr->flags, ZEBRA_NEIGH_DUPLICATE))
+		(*num_neighs)++;
+}
+
 uint32_t num_dup_detected_neighs(struct zebra_evpn *zevpn)
 {
-	unsigned int i;
 	uint32_t num_neighs = 0;
-	struct hash *hash;
-	struct hash_bucket *hb;
-	struct zebra_neigh *nbr;
 
-	hash = zevpn->neigh_table;
-	if (!hash)
-		return num_neighs;
-	for (i = 0; i < hash->size; i++) {
-		for (hb = hash->index[i]; hb; hb = hb->next) {
-			nbr = (struct zebra_neigh *)hb->data;
-			if (CHECK_FLAG(nbr->flags, ZEBRA_NEIGH_DUPLICATE))
-				num_neighs++;
-		}
-	}
+	if (zevpn->neigh_table)
+		hash_iterate(zevpn->neigh_table, num_dup_detected_neighs_iter,
+			     &num_neighs);
 
 	return num_neighs;
 }
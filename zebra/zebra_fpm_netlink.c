@@ -141,7 +141,7 @@ struct netlink_route_info {
 	uint8_t rtm_protocol;
 	uint8_t af;
 	struct prefix *prefix;
-	uint32_t *metric;
+	const uint32_t *metric;
 	unsigned int num_nhs;
 
 	/*
@@ -299,9 +299,9 @@ static int netlink_route_info_fill(struct netlink_route_info *ri, int cmd,
 		return 0;
 	}
 
-	ri->rtm_protocol = netlink_proto_from_route_type(re->type);
+	ri->rtm_protocol = netlink_proto_from_route_type(re_attr(re)->type);
 	ri->rtm_type = RTN_UNICAST;
-	ri->metric = &re->metric;
+	ri->metric = &re_attr(re)->metric;
 
 	for (ALL_NEXTHOPS(re->nhe->nhg, nexthop)) {
 		if (ri->num_nhs >= zrouter.multipath_num)
@@ -164,10 +164,10 @@ static Fpm__AddRoute *create_add_route_message(qpb_allocator_t *allocator,
 	 */
 	msg->sub_address_family = QPB__SUB_ADDRESS_FAMILY__UNICAST;
 	msg->key = fpm_route_key_create(allocator, rib_dest_prefix(dest));
-	qpb_protocol_set(&msg->protocol, re->type);
+	qpb_protocol_set(&msg->protocol, re_attr(re)->type);
 	msg->has_route_type = 1;
 	msg->route_type = FPM__ROUTE_TYPE__NORMAL;
-	msg->metric = re->metric;
+	msg->metric = re_attr(re)->metric;
 
 	/*
 	 * Figure out the set of nexthops to be added to the message.
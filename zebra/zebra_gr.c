@@ -565,8 +565,9 @@ static int32_t zebra_gr_delete_stale_route(struct client_gr_info *info,
 					 * after restart then do not delete
 					 * the route
 					 */
-					if (re->type == proto
-					    && re->instance == instance) {
+					if (re_attr(re)->type == proto
+					    && re_attr(re)->instance
+						       == instance) {
 						zebra_gr_process_route_entry(
 							s_client, rn, re);
 						n++;
@@ -52,6 +52,8 @@
 DEFINE_MTYPE_STATIC(ZEBRA, LSP, "MPLS LSP object");
 DEFINE_MTYPE_STATIC(ZEBRA, FEC, "MPLS FEC object");
 DEFINE_MTYPE_STATIC(ZEBRA, NHLFE, "MPLS nexthop object");
+DEFINE_MTYPE_STATIC(ZEBRA, LSP_INDEX, "MPLS LSP index");
+DEFINE_MTYPE_STATIC(ZEBRA, LSP_INDEX_PAGE, "MPLS LSP index page");
 
 int mpls_enabled;
 bool mpls_pw_reach_strict; /* Strict reachability checking */
@@ -91,12 +93,15 @@ static void lsp_processq_del(struct work_queue *wq, void *data);
 static void lsp_processq_complete(struct work_queue *wq);
 static int lsp_processq_add(struct zebra_lsp *lsp);
 static void *lsp_alloc(void *p);
+static struct zebra_lsp *lsp_lookup(struct zebra_vrf *zvrf,
+				    mpls_label_t label);
+static struct zebra_lsp *lsp_get(struct zebra_vrf *zvrf, mpls_label_t label);
 
 /* Check whether lsp can be freed - no nhlfes, e.g., and call free api */
-static void lsp_check_free(struct hash *lsp_table, struct zebra_lsp **plsp);
+static void lsp_check_free(struct zebra_vrf *zvrf, struct zebra_lsp **plsp);
 
 /* Free lsp; sets caller's pointer to NULL */
-static void lsp_free(struct hash *lsp_table, struct zebra_lsp **plsp);
+static void lsp_free(struct zebra_vrf *zvrf, struct zebra_lsp **plsp);
 
 static char *nhlfe2str(const struct zebra_nhlfe *nhlfe, char *buf, int size);
 static char *nhlfe_config_str(const struct zebra_nhlfe *nhlfe, char *buf,
@@ -118,7 +123,7 @@ static int nhlfe_del(struct zebra_nhlfe *nhlfe);
 static void nhlfe_free(struct zebra_nhlfe *nhlfe);
 static void nhlfe_out_label_update(struct zebra_nhlfe *nhlfe,
 				   struct mpls_label_stack *nh_label);
-static int mpls_lsp_uninstall_all(struct hash *lsp_table, struct zebra_lsp *lsp,
+static int mpls_lsp_uninstall_all(struct zebra_vrf *zvrf, struct zebra_lsp *lsp,
 				  enum lsp_types_t type);
 static int mpls_static_lsp_uninstall_all(struct zebra_vrf *zvrf,
 					 mpls_label_t in_label);
@@ -168,8 +173,6 @@ static void clear_nhlfe_installed(struct zebra_lsp *lsp)
 static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 		       struct route_node *rn, struct route_entry *re)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 	struct nexthop *nexthop;
@@ -178,16 +181,14 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 	int added, changed;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
-	lsp_type = lsp_type_from_re_type(re->type);
+	lsp_type = lsp_type_from_re_type(re_attr(re)->type);
 	added = changed = 0;
 
 	/* Locate or allocate LSP entry. */
-	tmp_ile.in_label = label;
-	lsp = hash_get(lsp_table, &tmp_ile, lsp_alloc);
+	lsp = lsp_get(zvrf, label);
 	if (!lsp)
 		return -1;
 
@@ -261,7 +262,7 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 		if (lsp_processq_add(lsp))
 			return -1;
 	} else {
-		lsp_check_free(lsp_table, &lsp);
+		lsp_check_free(zvrf, &lsp);
 	}
 
 	return 0;
@@ -273,20 +274,16 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
  */
 static int lsp_uninstall(struct zebra_vrf *zvrf, mpls_label_t label)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 	char buf[BUFSIZ];
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, label);
 	if (!lsp || (nhlfe_list_first(&lsp->nhlfe_list) == NULL))
 		return 0;
 
@@ -317,7 +314,7 @@ static int lsp_uninstall(struct zebra_vrf *zvrf, mpls_label_t label)
 		if (lsp_processq_add(lsp))
 			return -1;
 	} else {
-		lsp_check_free(lsp_table, &lsp);
+		lsp_check_free(zvrf, &lsp);
 	}
 
 	return 0;
@@ -633,7 +630,7 @@ static int nhlfe_nexthop_active_ipv4(struct zebra_nhlfe *nhlfe,
 
 		for (match_nh = match->nhe->nhg.nexthop; match_nh;
 		     match_nh = match_nh->next) {
-			if (match->type == ZEBRA_ROUTE_CONNECT
+			if (re_attr(match)->type == ZEBRA_ROUTE_CONNECT
 			    || nexthop->ifindex == match_nh->ifindex) {
 				nexthop->ifindex = match_nh->ifindex;
 				return 1;
@@ -676,7 +673,7 @@ static int nhlfe_nexthop_active_ipv6(struct zebra_nhlfe *nhlfe,
 
 	/* Locate a valid connected route. */
 	RNODE_FOREACH_RE (rn, match) {
-		if ((match->type == ZEBRA_ROUTE_CONNECT)
+		if ((re_attr(match)->type == ZEBRA_ROUTE_CONNECT)
 		    && !CHECK_FLAG(match->status, ROUTE_ENTRY_REMOVED)
 		    && CHECK_FLAG(match->flags, ZEBRA_FLAG_SELECTED))
 			break;
@@ -1035,14 +1032,12 @@ static void lsp_processq_del(struct work_queue *wq, void *data)
 {
 	struct zebra_vrf *zvrf;
 	struct zebra_lsp *lsp;
-	struct hash *lsp_table;
 	struct zebra_nhlfe *nhlfe;
 
 	zvrf = vrf_info_lookup(VRF_DEFAULT);
 	assert(zvrf);
 
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table) // unexpected
+	if (!zvrf->lsp_table) // unexpected
 		return;
 
 	lsp = (struct zebra_lsp *)data;
@@ -1065,7 +1060,7 @@ static void lsp_processq_del(struct work_queue *wq, void *data)
 			nhlfe_del(nhlfe);
 	}
 
-	lsp_check_free(lsp_table, &lsp);
+	lsp_check_free(zvrf, &lsp);
 }
 
 /*
@@ -1116,10 +1111,121 @@ static void *lsp_alloc(void *p)
 	return ((void *)lsp);
 }
 
+/*
+ * Does this in-label fall into the range covered by the dense LSP index?
+ */
+static inline bool lsp_index_covers(mpls_label_t label)
+{
+	return (label >= MPLS_LABEL_UNRESERVED_MIN && label <= MPLS_LABEL_MAX);
+}
+
+static struct zebra_lsp *lsp_index_lookup(const struct zebra_lsp_index *index,
+					  mpls_label_t label)
+{
+	const struct zebra_lsp_index_page *page;
+
+	page = index->pages[label >> LSP_INDEX_PAGE_BITS];
+	if (!page)
+		return NULL;
+
+	return page->lsps[label & LSP_INDEX_PAGE_MASK];
+}
+
+/*
+ * Set or clear (lsp == NULL) the index slot for an in-label, allocating
+ * or releasing the page holding it as needed.
+ */
+static void lsp_index_set(struct zebra_lsp_index *index, mpls_label_t label,
+			  struct zebra_lsp *lsp)
+{
+	struct zebra_lsp_index_page **ppage;
+	struct zebra_lsp **slot;
+
+	ppage = &index->pages[label >> LSP_INDEX_PAGE_BITS];
+	if (!*ppage) {
+		if (!lsp)
+			return;
+
+		*ppage = XCALLOC(MTYPE_LSP_INDEX_PAGE,
+				 sizeof(struct zebra_lsp_index_page));
+		index->pages_allocated++;
+	}
+
+	slot = &(*ppage)->lsps[label & LSP_INDEX_PAGE_MASK];
+	if (*slot == lsp)
+		return;
+
+	if (lsp && !*slot) {
+		(*ppage)->count++;
+		index->count++;
+	} else if (!lsp) {
+		(*ppage)->count--;
+		index->count--;
+	}
+	*slot = lsp;
+
+	if ((*ppage)->count == 0) {
+		XFREE(MTYPE_LSP_INDEX_PAGE, *ppage);
+		index->pages_allocated--;
+	}
+}
+
+static void lsp_index_free(struct zebra_lsp_index **pindex)
+{
+	struct zebra_lsp_index *index = *pindex;
+	uint32_t i;
+
+	if (!index)
+		return;
+
+	for (i = 0; i < LSP_INDEX_NUM_PAGES; i++)
+		XFREE(MTYPE_LSP_INDEX_PAGE, index->pages[i]);
+
+	XFREE(MTYPE_LSP_INDEX, *pindex);
+}
+
+/*
+ * Find the LSP for an in-label. Unreserved labels are resolved through
+ * the dense index, anything else falls back to the ile hash.
+ */
+static struct zebra_lsp *lsp_lookup(struct zebra_vrf *zvrf,
+				    mpls_label_t label)
+{
+	struct zebra_ile tmp_ile;
+
+	if (zvrf->lsp_index && lsp_index_covers(label))
+		return lsp_index_lookup(zvrf->lsp_index, label);
+
+	tmp_ile.in_label = label;
+	return hash_lookup(zvrf->lsp_table, &tmp_ile);
+}
+
+/*
+ * Locate or allocate the LSP for an in-label, keeping the dense index in
+ * sync with the ile hash.
+ */
+static struct zebra_lsp *lsp_get(struct zebra_vrf *zvrf, mpls_label_t label)
+{
+	struct zebra_ile tmp_ile;
+	struct zebra_lsp *lsp;
+
+	lsp = lsp_lookup(zvrf, label);
+	if (lsp)
+		return lsp;
+
+	tmp_ile.in_label = label;
+	lsp = hash_get(zvrf->lsp_table, &tmp_ile, lsp_alloc);
+
+	if (zvrf->lsp_index && lsp_index_covers(label))
+		lsp_index_set(zvrf->lsp_index, label, lsp);
+
+	return lsp;
+}
+
 /*
  * Check whether lsp can be freed - no nhlfes, e.g., and call free api
  */
-static void lsp_check_free(struct hash *lsp_table, struct zebra_lsp **plsp)
+static void lsp_check_free(struct zebra_vrf *zvrf, struct zebra_lsp **plsp)
 {
 	struct zebra_lsp *lsp;
 
@@ -1131,14 +1237,14 @@ static void lsp_check_free(struct hash *lsp_table, struct zebra_lsp **plsp)
 	if ((nhlfe_list_first(&lsp->nhlfe_list) == NULL) &&
 	    (nhlfe_list_first(&lsp->backup_nhlfe_list) == NULL) &&
 	    !CHECK_FLAG(lsp->flags, LSP_FLAG_SCHEDULED))
-		lsp_free(lsp_table, plsp);
+		lsp_free(zvrf, plsp);
 }
 
 /*
- * Dtor for an LSP: remove from ile hash, release any internal allocations,
- * free LSP object.
+ * Dtor for an LSP: remove from ile hash and label index, release any
+ * internal allocations, free LSP object.
  */
-static void lsp_free(struct hash *lsp_table, struct zebra_lsp **plsp)
+static void lsp_free(struct zebra_vrf *zvrf, struct zebra_lsp **plsp)
 {
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
@@ -1160,7 +1266,10 @@ static void lsp_free(struct hash *lsp_table, struct zebra_lsp **plsp)
 	frr_each_safe(nhlfe_list, &lsp->backup_nhlfe_list, nhlfe)
 		nhlfe_del(nhlfe);
 
-	hash_release(lsp_table, &lsp->ile);
+	if (zvrf->lsp_index && lsp_index_covers(lsp->ile.in_label))
+		lsp_index_set(zvrf->lsp_index, lsp->ile.in_label, NULL);
+
+	hash_release(zvrf->lsp_table, &lsp->ile);
 	XFREE(MTYPE_LSP, lsp);
 
 	*plsp = NULL;
@@ -1409,7 +1518,7 @@ static void nhlfe_out_label_update(struct zebra_nhlfe *nhlfe,
 	nhlfe->nexthop->nh_label->label[0] = nh_label->label[0];
 }
 
-static int mpls_lsp_uninstall_all(struct hash *lsp_table, struct zebra_lsp *lsp,
+static int mpls_lsp_uninstall_all(struct zebra_vrf *zvrf, struct zebra_lsp *lsp,
 				  enum lsp_types_t type)
 {
 	struct zebra_nhlfe *nhlfe;
@@ -1471,7 +1580,7 @@ static int mpls_lsp_uninstall_all(struct hash *lsp_table, struct zebra_lsp *lsp,
 		if (lsp_processq_add(lsp))
 			return -1;
 	} else {
-		lsp_check_free(lsp_table, &lsp);
+		lsp_check_free(zvrf, &lsp);
 	}
 
 	return 0;
@@ -1484,22 +1593,18 @@ static int mpls_lsp_uninstall_all(struct hash *lsp_table, struct zebra_lsp *lsp,
 static int mpls_static_lsp_uninstall_all(struct zebra_vrf *zvrf,
 					 mpls_label_t in_label)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, in_label);
 	if (!lsp || (nhlfe_list_first(&lsp->nhlfe_list) == NULL))
 		return 0;
 
-	return mpls_lsp_uninstall_all(lsp_table, lsp, ZEBRA_LSP_STATIC);
+	return mpls_lsp_uninstall_all(zvrf, lsp, ZEBRA_LSP_STATIC);
 }
 
 static json_object *nhlfe_json(struct zebra_nhlfe *nhlfe)
@@ -1705,18 +1810,19 @@ static json_object *lsp_json(struct zebra_lsp *lsp)
 }
 
 
+static void hash_get_sorted_list_iter(struct hash_bucket *hb, void *arg)
+{
+	listnode_add_sort(arg, hb->data);
+}
+
 /* Return a sorted linked list of the hash contents */
 static struct list *hash_get_sorted_list(struct hash *hash, void *cmp)
 {
-	unsigned int i;
-	struct hash_bucket *hb;
 	struct list *sorted_list = list_new();
 
 	sorted_list->cmp = (int (*)(void *, void *))cmp;
 
-	for (i = 0; i < hash->size; i++)
-		for (hb = hash->index[i]; hb; hb = hb->next)
-			listnode_add_sort(sorted_list, hb->data);
+	hash_iterate(hash, hash_get_sorted_list_iter, sorted_list);
 
 	return sorted_list;
 }
@@ -1735,6 +1841,44 @@ static int lsp_cmp(const struct zebra_lsp *lsp1, const struct zebra_lsp *lsp2)
 	return 0;
 }
 
+/*
+ * Return a linked list of the LSP table in in-label order. The dense index
+ * already keeps unreserved labels sorted, so only the (few) reserved
+ * labels need a hash lookup.
+ */
+static struct list *lsp_get_sorted_list(struct zebra_vrf *zvrf)
+{
+	const struct zebra_lsp_index_page *page;
+	struct list *sorted_list;
+	struct zebra_lsp *lsp;
+	mpls_label_t label;
+	uint32_t i, j;
+
+	if (!zvrf->lsp_index)
+		return hash_get_sorted_list(zvrf->lsp_table, lsp_cmp);
+
+	sorted_list = list_new();
+
+	for (label = MPLS_LABEL_RESERVED_MIN; label <= MPLS_LABEL_RESERVED_MAX;
+	     label++) {
+		lsp = lsp_lookup(zvrf, label);
+		if (lsp)
+			listnode_add(sorted_list, lsp);
+	}
+
+	for (i = 0; i < LSP_INDEX_NUM_PAGES; i++) {
+		page = zvrf->lsp_index->pages[i];
+		if (!page)
+			continue;
+
+		for (j = 0; j < LSP_INDEX_PAGE_SIZE; j++)
+			if (page->lsps[j])
+				listnode_add(sorted_list, page->lsps[j]);
+	}
+
+	return sorted_list;
+}
+
 /*
  * Initialize work queue for processing changed LSPs.
  */
@@ -1765,8 +1909,6 @@ void zebra_mpls_lsp_dplane_result(struct zebra_dplane_ctx *ctx)
 {
 	struct zebra_vrf *zvrf;
 	mpls_label_t label;
-	struct zebra_ile tmp_ile;
-	struct hash *lsp_table;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 	struct nexthop *nexthop;
@@ -1793,10 +1935,7 @@ void zebra_mpls_lsp_dplane_result(struct zebra_dplane_ctx *ctx)
 		if (zvrf == NULL)
 			break;
 
-		lsp_table = zvrf->lsp_table;
-
-		tmp_ile.in_label = label;
-		lsp = hash_lookup(lsp_table, &tmp_ile);
+		lsp = lsp_lookup(zvrf, label);
 		if (lsp == NULL) {
 			if (IS_ZEBRA_DEBUG_DPLANE)
 				zlog_debug("LSP ctx %p: in-label %u not found",
@@ -2043,8 +2182,6 @@ static int update_nhlfes_from_ctx(struct nhlfe_list_head *nhlfe_head,
 void zebra_mpls_process_dplane_notify(struct zebra_dplane_ctx *ctx)
 {
 	struct zebra_vrf *zvrf;
-	struct zebra_ile tmp_ile;
-	struct hash *lsp_table;
 	struct zebra_lsp *lsp;
 	const struct nhlfe_list_head *ctx_list;
 	int start_count = 0, end_count = 0; /* Installed counts */
@@ -2061,10 +2198,7 @@ void zebra_mpls_process_dplane_notify(struct zebra_dplane_ctx *ctx)
 	if (zvrf == NULL)
 		goto done;
 
-	lsp_table = zvrf->lsp_table;
-
-	tmp_ile.in_label = dplane_ctx_get_in_label(ctx);
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, dplane_ctx_get_in_label(ctx));
 	if (lsp == NULL) {
 		if (is_debug)
 			zlog_debug("dplane LSP notif: in-label %u not found",
@@ -2470,7 +2604,7 @@ static int zebra_mpls_cleanup_fecs_for_client(struct zserv *client)
 }
 
 struct lsp_uninstall_args {
-	struct hash *lsp_table;
+	struct zebra_vrf *zvrf;
 	enum lsp_types_t type;
 };
 
@@ -2490,7 +2624,7 @@ static int zebra_mpls_cleanup_zclient_labels(struct zserv *client)
 			continue;
 
 		/* Cleanup LSPs. */
-		args.lsp_table = zvrf->lsp_table;
+		args.zvrf = zvrf;
 		args.type = lsp_type_from_re_type(client->proto);
 		hash_iterate(zvrf->lsp_table, mpls_lsp_uninstall_all_type,
 			     &args);
@@ -2770,7 +2904,8 @@ int mpls_ftn_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 	RNODE_FOREACH_RE (rn, re) {
 		if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
 			continue;
-		if (re->type == route_type && re->instance == route_instance)
+		if (re_attr(re)->type == route_type
+		    && re_attr(re)->instance == route_instance)
 			break;
 	}
 	if (re == NULL)
@@ -2899,20 +3034,16 @@ int mpls_zapi_labels_process(bool add_p, struct zebra_vrf *zvrf,
 	bool found;
 	afi_t afi = AFI_IP;
 	const struct prefix *prefix = NULL;
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp = NULL;
 
 	/* Prep LSP for add case */
 	if (add_p) {
 		/* Lookup table. */
-		lsp_table = zvrf->lsp_table;
-		if (!lsp_table)
+		if (!zvrf->lsp_table)
 			return -1;
 
 		/* Find or create LSP object */
-		tmp_ile.in_label = zl->local_label;
-		lsp = hash_get(lsp_table, &tmp_ile, lsp_alloc);
+		lsp = lsp_get(zvrf, zl->local_label);
 		if (!lsp)
 			return -1;
 	}
@@ -2931,8 +3062,8 @@ int mpls_zapi_labels_process(bool add_p, struct zebra_vrf *zvrf,
 			RNODE_FOREACH_RE(rn, re) {
 				if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
 					continue;
-				if (re->type == zl->route.type &&
-				    re->instance == zl->route.instance)
+				if (re_attr(re)->type == zl->route.type &&
+				    re_attr(re)->instance == zl->route.instance)
 					break;
 			}
 		}
@@ -3179,19 +3310,15 @@ int mpls_lsp_install(struct zebra_vrf *zvrf, enum lsp_types_t type,
 		     const mpls_label_t *out_labels, enum nexthop_types_t gtype,
 		     const union g_addr *gate, ifindex_t ifindex)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* Find or create LSP object */
-	tmp_ile.in_label = in_label;
-	lsp = hash_get(lsp_table, &tmp_ile, lsp_alloc);
+	lsp = lsp_get(zvrf, in_label);
 	if (!lsp)
 		return -1;
 
@@ -3272,17 +3399,12 @@ static int lsp_backup_znh_install(struct zebra_lsp *lsp, enum lsp_types_t type,
 
 struct zebra_lsp *mpls_lsp_find(struct zebra_vrf *zvrf, mpls_label_t in_label)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
-
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return NULL;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	return hash_lookup(lsp_table, &tmp_ile);
+	return lsp_lookup(zvrf, in_label);
 }
 
 /*
@@ -3294,21 +3416,17 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 		       const union g_addr *gate, ifindex_t ifindex,
 		       bool backup_p)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 	char buf[NEXTHOP_STRLEN];
 	bool schedule_lsp = false;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, in_label);
 	if (!lsp)
 		return 0;
 
@@ -3345,7 +3463,7 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 		nhlfe_del(nhlfe);
 
 		/* Free LSP entry if no other NHLFEs and not scheduled. */
-		lsp_check_free(lsp_table, &lsp);
+		lsp_check_free(zvrf, &lsp);
 	}
 	return 0;
 }
@@ -3353,22 +3471,18 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 int mpls_lsp_uninstall_all_vrf(struct zebra_vrf *zvrf, enum lsp_types_t type,
 			       mpls_label_t in_label)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, in_label);
 	if (!lsp)
 		return 0;
 
-	return mpls_lsp_uninstall_all(lsp_table, lsp, type);
+	return mpls_lsp_uninstall_all(zvrf, lsp, type);
 }
 
 /*
@@ -3379,17 +3493,15 @@ static void mpls_lsp_uninstall_all_type(struct hash_bucket *bucket, void *ctxt)
 {
 	struct lsp_uninstall_args *args = ctxt;
 	struct zebra_lsp *lsp;
-	struct hash *lsp_table;
 
 	lsp = (struct zebra_lsp *)bucket->data;
 	if (nhlfe_list_first(&lsp->nhlfe_list) == NULL)
 		return;
 
-	lsp_table = args->lsp_table;
-	if (!lsp_table)
+	if (!args->zvrf->lsp_table)
 		return;
 
-	mpls_lsp_uninstall_all(lsp_table, lsp, args->type);
+	mpls_lsp_uninstall_all(args->zvrf, lsp, args->type);
 }
 
 /*
@@ -3700,19 +3812,15 @@ void zebra_mpls_lsp_schedule(struct zebra_vrf *zvrf)
 void zebra_mpls_print_lsp(struct vty *vty, struct zebra_vrf *zvrf,
 			  mpls_label_t label, bool use_json)
 {
-	struct hash *lsp_table;
 	struct zebra_lsp *lsp;
-	struct zebra_ile tmp_ile;
 	json_object *json = NULL;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_lookup(zvrf, label);
 	if (!lsp)
 		return;
 
@@ -3736,7 +3844,7 @@ void zebra_mpls_print_lsp_table(struct vty *vty, struct zebra_vrf *zvrf,
 	struct zebra_lsp *lsp = NULL;
 	struct zebra_nhlfe *nhlfe = NULL;
 	struct listnode *node = NULL;
-	struct list *lsp_list = hash_get_sorted_list(zvrf->lsp_table, lsp_cmp);
+	struct list *lsp_list = lsp_get_sorted_list(zvrf);
 
 	if (use_json) {
 		json = json_object_new_object();
@@ -4025,6 +4133,7 @@ void zebra_mpls_close_tables(struct zebra_vrf *zvrf)
 	hash_iterate(zvrf->lsp_table, lsp_uninstall_from_kernel, NULL);
 	hash_clean(zvrf->lsp_table, NULL);
 	hash_free(zvrf->lsp_table);
+	lsp_index_free(&zvrf->lsp_index);
 	hash_clean(zvrf->slsp_table, NULL);
 	hash_free(zvrf->slsp_table);
 	route_table_finish(zvrf->fec_table[AFI_IP]);
@@ -4049,6 +4158,8 @@ void zebra_mpls_init_tables(struct zebra_vrf *zvrf)
 	snprintf(buffer, sizeof(buffer), "ZEBRA LSP table: %s",
 		 zvrf->vrf->name);
 	zvrf->lsp_table = hash_create_size(8, label_hash, label_cmp, buffer);
+	zvrf->lsp_index = XCALLOC(MTYPE_LSP_INDEX,
+				  sizeof(struct zebra_lsp_index));
 	zvrf->fec_table[AFI_IP] = route_table_init();
 	zvrf->fec_table[AFI_IP6] = route_table_init();
 	zvrf->mpls_flags = 0;
@@ -116,6 +116,29 @@ struct zebra_lsp {
 	uint8_t addr_family;
 };
 
+/*
+ * Dense, label-indexed view of the LSP table. The unreserved label space
+ * is split into fixed-size pages that are allocated on first use, so an
+ * in-label lookup is two array indexes and a walk over the pages visits
+ * LSPs in label order. Reserved labels only live in the hash.
+ */
+#define LSP_INDEX_PAGE_BITS 10
+#define LSP_INDEX_PAGE_SIZE (1U << LSP_INDEX_PAGE_BITS)
+#define LSP_INDEX_PAGE_MASK (LSP_INDEX_PAGE_SIZE - 1)
+#define LSP_INDEX_NUM_PAGES ((MPLS_LABEL_MAX >> LSP_INDEX_PAGE_BITS) + 1)
+
+struct zebra_lsp_index_page {
+	/* Number of non-NULL slots, page is freed when this drops to 0 */
+	uint32_t count;
+	struct zebra_lsp *lsps[LSP_INDEX_PAGE_SIZE];
+};
+
+struct zebra_lsp_index {
+	uint32_t count;
+	uint32_t pages_allocated;
+	struct zebra_lsp_index_page *pages[LSP_INDEX_NUM_PAGES];
+};
+
 /*
  * FEC to label binding.
  */
@@ -325,7 +325,7 @@ int lib_vrf_zebra_ribs_rib_route_route_entry_get_keys(
 
 	args->keys->num = 1;
 
-	strlcpy(args->keys->key[0], zebra_route_string(re->type),
+	strlcpy(args->keys->key[0], zebra_route_string(re_attr(re)->type),
 		sizeof(args->keys->key[0]));
 
 	return NB_OK;
@@ -343,7 +343,7 @@ const void *lib_vrf_zebra_ribs_rib_route_route_entry_lookup_entry(
 	proto_type = proto_redistnum(afi, args->keys->key[0]);
 
 	RNODE_FOREACH_RE (rn, re) {
-		if (proto_type == re->type)
+		if (proto_type == re_attr(re)->type)
 			return re;
 	}
 
@@ -358,7 +358,7 @@ struct yang_data *lib_vrf_zebra_ribs_rib_route_route_entry_protocol_get_elem(
 {
 	struct route_entry *re = (struct route_entry *)args->list_entry;
 
-	return yang_data_new_enum(args->xpath, re->type);
+	return yang_data_new_enum(args->xpath, re_attr(re)->type);
 }
 
 /*
@@ -369,8 +369,8 @@ struct yang_data *lib_vrf_zebra_ribs_rib_route_route_entry_instance_get_elem(
 {
 	struct route_entry *re = (struct route_entry *)args->list_entry;
 
-	if (re->instance)
-		return yang_data_new_uint16(args->xpath, re->instance);
+	if (re_attr(re)->instance)
+		return yang_data_new_uint16(args->xpath, re_attr(re)->instance);
 
 	return NULL;
 }
@@ -383,7 +383,7 @@ struct yang_data *lib_vrf_zebra_ribs_rib_route_route_entry_distance_get_elem(
 {
 	struct route_entry *re = (struct route_entry *)args->list_entry;
 
-	return yang_data_new_uint8(args->xpath, re->distance);
+	return yang_data_new_uint8(args->xpath, re_attr(re)->distance);
 }
 
 /*
@@ -394,7 +394,7 @@ struct yang_data *lib_vrf_zebra_ribs_rib_route_route_entry_metric_get_elem(
 {
 	struct route_entry *re = (struct route_entry *)args->list_entry;
 
-	return yang_data_new_uint32(args->xpath, re->metric);
+	return yang_data_new_uint32(args->xpath, re_attr(re)->metric);
 }
 
 /*
@@ -405,8 +405,8 @@ struct yang_data *lib_vrf_zebra_ribs_rib_route_route_entry_tag_get_elem(
 {
 	struct route_entry *re = (struct route_entry *)args->list_entry;
 
-	if (re->tag)
-		return yang_data_new_uint32(args->xpath, re->tag);
+	if (re_attr(re)->tag)
+		return yang_data_new_uint32(args->xpath, re_attr(re)->tag);
 
 	return NULL;
 }
@@ -2193,7 +2193,7 @@ static int nexthop_active(struct nexthop *nexthop, struct nhg_hash_entry *nhe,
 		if (dest && dest->selected_fib
 		    && !CHECK_FLAG(dest->selected_fib->status,
 				   ROUTE_ENTRY_REMOVED)
-		    && dest->selected_fib->type != ZEBRA_ROUTE_TABLE)
+		    && re_attr(dest->selected_fib)->type != ZEBRA_ROUTE_TABLE)
 			match = dest->selected_fib;
 
 		/* If there is no selected route or matched route is EGP, go up
@@ -2209,7 +2209,7 @@ static int nexthop_active(struct nexthop *nexthop, struct nhg_hash_entry *nhe,
 			continue;
 		}
 
-		if (match->type == ZEBRA_ROUTE_CONNECT) {
+		if (re_attr(match)->type == ZEBRA_ROUTE_CONNECT) {
 			/* Directly point connected route. */
 			newhop = match->nhe->nhg.nexthop;
 			if (newhop) {
@@ -2383,15 +2383,15 @@ static unsigned nexthop_active_check(struct route_node *rn,
 	 * and we have to handle that.
 	 */
 	if (!CHECK_FLAG(re->status, ROUTE_ENTRY_INSTALLED) &&
-	    (re->type == ZEBRA_ROUTE_KERNEL ||
-	     re->type == ZEBRA_ROUTE_SYSTEM)) {
+	    (re_attr(re)->type == ZEBRA_ROUTE_KERNEL ||
+	     re_attr(re)->type == ZEBRA_ROUTE_SYSTEM)) {
 		SET_FLAG(nexthop->flags, NEXTHOP_FLAG_ACTIVE);
 		goto skip_check;
 	}
 
 	switch (nexthop->type) {
 	case NEXTHOP_TYPE_IFINDEX:
-		if (nexthop_active(nexthop, nhe, &rn->p, re->type,
+		if (nexthop_active(nexthop, nhe, &rn->p, re_attr(re)->type,
 				   re->flags, &mtu))
 			SET_FLAG(nexthop->flags, NEXTHOP_FLAG_ACTIVE);
 		else
@@ -2400,7 +2400,7 @@ static unsigned nexthop_active_check(struct route_node *rn,
 	case NEXTHOP_TYPE_IPV4:
 	case NEXTHOP_TYPE_IPV4_IFINDEX:
 		family = AFI_IP;
-		if (nexthop_active(nexthop, nhe, &rn->p, re->type,
+		if (nexthop_active(nexthop, nhe, &rn->p, re_attr(re)->type,
 				   re->flags, &mtu))
 			SET_FLAG(nexthop->flags, NEXTHOP_FLAG_ACTIVE);
 		else
@@ -2408,7 +2408,7 @@ static unsigned nexthop_active_check(struct route_node *rn,
 		break;
 	case NEXTHOP_TYPE_IPV6:
 		family = AFI_IP6;
-		if (nexthop_active(nexthop, nhe, &rn->p, re->type,
+		if (nexthop_active(nexthop, nhe, &rn->p, re_attr(re)->type,
 				   re->flags, &mtu))
 			SET_FLAG(nexthop->flags, NEXTHOP_FLAG_ACTIVE);
 		else
@@ -2419,7 +2419,7 @@ static unsigned nexthop_active_check(struct route_node *rn,
 		if (rn->p.family != AF_INET)
 			family = AFI_IP6;
 
-		if (nexthop_active(nexthop, nhe, &rn->p, re->type,
+		if (nexthop_active(nexthop, nhe, &rn->p, re_attr(re)->type,
 				   re->flags, &mtu))
 			SET_FLAG(nexthop->flags, NEXTHOP_FLAG_ACTIVE);
 		else
@@ -2483,8 +2483,9 @@ skip_check:
 	}
 
 	/* It'll get set if required inside */
-	ret = zebra_route_map_check(family, re->type, re->instance, p, nexthop,
-				    zvrf, re->tag);
+	ret = zebra_route_map_check(family, re_attr(re)->type,
+				    re_attr(re)->instance, p, nexthop, zvrf,
+				    re_attr(re)->tag);
 	if (ret == RMAP_DENYMATCH) {
 		if (IS_ZEBRA_DEBUG_RIB) {
 			zlog_debug(
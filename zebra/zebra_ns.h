@@ -51,6 +51,7 @@ struct zebra_ns {
 
 #ifdef HAVE_NETLINK
 	struct nlsock netlink;        /* kernel messages */
+	struct nlsock netlink_neigh;  /* kernel neighbor messages */
 	struct nlsock netlink_cmd;    /* command channel */
 
 	/* dplane system's channels: one for outgoing programming,
@@ -58,7 +59,16 @@ struct zebra_ns {
 	 */
 	struct nlsock netlink_dplane_out;
 	struct nlsock netlink_dplane_in;
+
+	/* Reads of 'netlink' and 'netlink_neigh', in the listener pthread */
 	struct thread *t_netlink;
+	struct thread *t_netlink_neigh;
+
+	/* Neighbor table re-read after 'netlink_neigh' overran, and the
+	 * neighbors the kernel has reported (see rt_netlink.c)
+	 */
+	struct thread *t_netlink_resync;
+	struct hash *neigh_cache;
 #endif
 
 	struct route_table *if_table;
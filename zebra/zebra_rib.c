@@ -22,6 +22,7 @@
 
 #include "command.h"
 #include "if.h"
+#include "jhash.h"
 #include "linklist.h"
 #include "log.h"
 #include "memory.h"
@@ -40,6 +41,7 @@
 #include "frr_pthread.h"
 #include "printfrr.h"
 #include "frrscript.h"
+#include "lib_vty.h"
 
 #include "zebra/zebra_router.h"
 #include "zebra/connected.h"
@@ -63,6 +65,9 @@
 DEFINE_MGROUP(ZEBRA, "zebra");
 
 DEFINE_MTYPE(ZEBRA, RE,       "Route Entry");
+DEFINE_MTYPE_STATIC(ZEBRA, RE_FIB, "Route Entry FIB nexthops");
+DEFINE_MTYPE_STATIC(ZEBRA, RE_ATTR, "Route Entry attributes");
+DEFINE_MTYPE_STATIC(ZEBRA, RE_SLOTS, "Route Entry index tables");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_DEST,       "RIB destination");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_UPDATE_CTX, "Rib update context object");
 DEFINE_MTYPE_STATIC(ZEBRA, WQ_WRAPPER, "WQ wrapper");
@@ -74,6 +79,25 @@ static pthread_mutex_t dplane_mutex;
 static struct thread *t_dplane;
 static struct dplane_ctx_q rib_dplane_q;
 
+/*
+ * Dataplane results are handled in bounded chunks, so that a burst of
+ * completions cannot hold off client input on the main pthread.
+ * Consecutive route results are collected into batches, sorted by table
+ * and into table iteration order, and resolved against the rib with one
+ * table lookup per run and one walk down each table.
+ */
+#define RIB_DPLANE_RESULTS_LIMIT 4096
+#define RIB_RESULT_BATCH_SIZE 256
+
+struct rib_result_batch {
+	uint32_t count;
+	struct rib_result_entry {
+		struct zebra_dplane_ctx *ctx;
+		/* Arrival order, keeps the sort stable per prefix */
+		uint32_t idx;
+	} entries[RIB_RESULT_BATCH_SIZE];
+};
+
 DEFINE_HOOK(rib_update, (struct route_node * rn, const char *reason),
 	    (rn, reason));
 
@@ -300,6 +324,300 @@ void route_entry_copy_nexthops(struct route_entry *re, struct nexthop *nh)
 	copy_nexthops(&re->nhe->nhg.nexthop, nh, NULL);
 }
 
+struct nexthop_group rib_empty_nhg;
+
+/* The all-zero attributes every route entry starts out with, never freed */
+static struct route_entry_attr re_attr_none;
+
+struct route_entry_slots re_attr_slots;
+struct route_entry_slots re_fib_slots;
+
+static void route_entry_slots_setup(struct route_entry_slots *slots,
+				    void *none)
+{
+	slots->size = 64;
+	slots->items = XCALLOC(MTYPE_RE_SLOTS,
+			       slots->size * sizeof(slots->items[0]));
+	slots->items[0] = none;
+	slots->top = 1;
+	slots->free = 0;
+}
+
+void route_entry_slots_init(void)
+{
+	route_entry_slots_setup(&re_attr_slots, &re_attr_none);
+	route_entry_slots_setup(&re_fib_slots, NULL);
+}
+
+void route_entry_slots_fini(void)
+{
+	XFREE(MTYPE_RE_SLOTS, re_attr_slots.items);
+	XFREE(MTYPE_RE_SLOTS, re_fib_slots.items);
+}
+
+/*
+ * Hand out a slot for 'item'. Released slots are chained through their
+ * item pointer, the chain head is 'free'.
+ */
+static uint32_t route_entry_slot_get(struct route_entry_slots *slots,
+				     void *item)
+{
+	uint32_t index = slots->free;
+
+	if (index) {
+		slots->free = (uint32_t)(uintptr_t)slots->items[index];
+	} else {
+		if (slots->top == slots->size) {
+			slots->size *= 2;
+			slots->items = XREALLOC(
+				MTYPE_RE_SLOTS, slots->items,
+				slots->size * sizeof(slots->items[0]));
+		}
+		index = slots->top++;
+	}
+
+	slots->items[index] = item;
+	return index;
+}
+
+static void route_entry_slot_put(struct route_entry_slots *slots,
+				 uint32_t index)
+{
+	slots->items[index] = (void *)(uintptr_t)slots->free;
+	slots->free = index;
+}
+
+uint32_t route_entry_attr_hash_key(const void *arg)
+{
+	const struct route_entry_attr *attr = arg;
+
+	return jhash_3words(attr->type, attr->metric, attr->tag,
+			    (attr->instance << 8) | attr->distance);
+}
+
+bool route_entry_attr_hash_equal(const void *arg1, const void *arg2)
+{
+	const struct route_entry_attr *attr1 = arg1;
+	const struct route_entry_attr *attr2 = arg2;
+
+	return attr1->type == attr2->type && attr1->instance == attr2->instance
+	       && attr1->distance == attr2->distance
+	       && attr1->metric == attr2->metric && attr1->tag == attr2->tag;
+}
+
+void route_entry_attr_hash_free(void *arg)
+{
+	XFREE(MTYPE_RE_ATTR, arg);
+}
+
+/*
+ * Set the route's type, instance, distance, metric and tag.
+ */
+void route_entry_attr_set(struct route_entry *re, int type, uint16_t instance,
+			  uint8_t distance, uint32_t metric, route_tag_t tag)
+{
+	struct route_entry_attr lookup = {
+		.type = type,
+		.instance = instance,
+		.distance = distance,
+		.metric = metric,
+		.tag = tag,
+	};
+	struct route_entry_attr *attr;
+	uint32_t index = 0;
+
+	if (!route_entry_attr_hash_equal(&lookup, &re_attr_none)) {
+		attr = hash_lookup(zrouter.re_attrs, &lookup);
+		if (!attr) {
+			attr = XCALLOC(MTYPE_RE_ATTR, sizeof(*attr));
+			*attr = lookup;
+			attr->index = route_entry_slot_get(&re_attr_slots,
+							   attr);
+			(void)hash_get(zrouter.re_attrs, attr,
+				       hash_alloc_intern);
+		}
+		attr->refcnt++;
+		index = attr->index;
+	}
+
+	/* 'attr' may be the one the route already holds; it was ref'd above */
+	route_entry_attr_release(re);
+	re->attr = index;
+}
+
+/*
+ * Drop the route's reference to its attributes; it is left with the
+ * all-zero set.
+ */
+void route_entry_attr_release(struct route_entry *re)
+{
+	struct route_entry_attr *attr;
+
+	if (!re->attr)
+		return;
+
+	attr = re_attr_slots.items[re->attr];
+	re->attr = 0;
+	if (--attr->refcnt > 0)
+		return;
+
+	route_entry_slot_put(&re_attr_slots, attr->index);
+	hash_release(zrouter.re_attrs, attr);
+	route_entry_attr_hash_free(attr);
+}
+
+/*
+ * What keeping the attributes and fib groups behind 32-bit indexes saves
+ * compared to carrying the attributes and a fib pointer in every route.
+ */
+static int rib_show_memory(struct vty *vty)
+{
+	size_t routes = mtype_stats_alloc(MTYPE_RE);
+	size_t per_route = offsetof(struct route_entry_attr, refcnt)
+			   + sizeof(struct route_entry_fib *)
+			   - sizeof(((struct route_entry *)0)->attr)
+			   - sizeof(((struct route_entry *)0)->fib);
+	size_t shared = zrouter.re_attrs->count
+				* sizeof(struct route_entry_attr)
+			+ (re_attr_slots.size + re_fib_slots.size)
+				  * sizeof(void *);
+	size_t saved = routes * per_route;
+
+	vty_out(vty, "\nRoute entries: %zu of %zu bytes\n", routes,
+		sizeof(struct route_entry));
+	vty_out(vty, "  %zu bytes saved per route, %lu shared attribute sets\n",
+		per_route, zrouter.re_attrs->count);
+	vty_out(vty, "  %zd bytes saved in total\n",
+		(ssize_t)saved - (ssize_t)shared);
+	return 0;
+}
+
+/*
+ * The fib-specific nexthop groups are interned: besides the nexthops
+ * themselves, the FIB flags and backup indexes are per-route state, so
+ * they have to match as well before two routes may share a copy.
+ */
+static bool route_entry_fib_nhg_same(const struct nexthop_group *nhg1,
+				     const struct nexthop_group *nhg2)
+{
+	const struct nexthop *nh1, *nh2;
+
+	if (!nexthop_group_equal(nhg1, nhg2))
+		return false;
+
+	for (nh1 = nhg1->nexthop, nh2 = nhg2->nexthop; nh1 && nh2;
+	     nh1 = nexthop_next(nh1), nh2 = nexthop_next(nh2)) {
+		if (nh1->flags != nh2->flags
+		    || nh1->backup_num != nh2->backup_num)
+			return false;
+		if (memcmp(nh1->backup_idx, nh2->backup_idx,
+			   nh1->backup_num * sizeof(nh1->backup_idx[0])))
+			return false;
+	}
+
+	return true;
+}
+
+uint32_t route_entry_fib_hash_key(const void *arg)
+{
+	const struct route_entry_fib *fib = arg;
+
+	return jhash_2words(nexthop_group_hash(&fib->ng),
+			    nexthop_group_hash(&fib->backup_ng), 0);
+}
+
+bool route_entry_fib_hash_equal(const void *arg1, const void *arg2)
+{
+	const struct route_entry_fib *fib1 = arg1;
+	const struct route_entry_fib *fib2 = arg2;
+
+	return route_entry_fib_nhg_same(&fib1->ng, &fib2->ng)
+	       && route_entry_fib_nhg_same(&fib1->backup_ng, &fib2->backup_ng);
+}
+
+void route_entry_fib_hash_free(void *arg)
+{
+	struct route_entry_fib *fib = arg;
+
+	nexthops_free(fib->ng.nexthop);
+	nexthops_free(fib->backup_ng.nexthop);
+	XFREE(MTYPE_RE_FIB, fib);
+}
+
+/*
+ * Replace the route's fib-specific nexthop groups. This takes over the
+ * nexthops of 'ng' and 'backup_ng' (either may be NULL); if both are empty
+ * the route goes back to having no fib groups at all.
+ */
+void route_entry_fib_set(struct route_entry *re, struct nexthop_group *ng,
+			 struct nexthop_group *backup_ng)
+{
+	struct route_entry_fib lookup = {};
+	struct route_entry_fib *fib;
+	uint32_t index = 0;
+
+	if (ng) {
+		lookup.ng = *ng;
+		ng->nexthop = NULL;
+	}
+	if (backup_ng) {
+		lookup.backup_ng = *backup_ng;
+		backup_ng->nexthop = NULL;
+	}
+
+	if (lookup.ng.nexthop || lookup.backup_ng.nexthop) {
+		fib = hash_lookup(zrouter.re_fibs, &lookup);
+		if (fib) {
+			nexthops_free(lookup.ng.nexthop);
+			nexthops_free(lookup.backup_ng.nexthop);
+		} else {
+			fib = XCALLOC(MTYPE_RE_FIB, sizeof(*fib));
+			fib->ng = lookup.ng;
+			fib->backup_ng = lookup.backup_ng;
+			fib->index = route_entry_slot_get(&re_fib_slots, fib);
+			(void)hash_get(zrouter.re_fibs, fib, hash_alloc_intern);
+		}
+		fib->refcnt++;
+		index = fib->index;
+	}
+
+	/* 'fib' may be the one the route already holds; it was ref'd above */
+	route_entry_fib_release(re);
+	re->fib = index;
+}
+
+/*
+ * Make 'to' share the fib-specific nexthop groups of 'from'.
+ */
+void route_entry_fib_share(struct route_entry *to,
+			   const struct route_entry *from)
+{
+	route_entry_fib_release(to);
+
+	to->fib = from->fib;
+	if (to->fib)
+		re_fib(to)->refcnt++;
+}
+
+/*
+ * Drop the route's reference to its fib-specific nexthop groups.
+ */
+void route_entry_fib_release(struct route_entry *re)
+{
+	struct route_entry_fib *fib = re_fib(re);
+
+	if (!fib)
+		return;
+
+	re->fib = 0;
+	if (--fib->refcnt > 0)
+		return;
+
+	route_entry_slot_put(&re_fib_slots, fib->index);
+	hash_release(zrouter.re_fibs, fib);
+	route_entry_fib_hash_free(fib);
+}
+
 static void route_entry_attach_ref(struct route_entry *re,
 				   struct nhg_hash_entry *new)
 {
@@ -406,7 +724,7 @@ struct route_entry *rib_match(afi_t afi, safi_t safi, vrf_id_t vrf_id,
 			if (rn)
 				route_lock_node(rn);
 		} else {
-			if (match->type != ZEBRA_ROUTE_CONNECT) {
+			if (re_attr(match)->type != ZEBRA_ROUTE_CONNECT) {
 				if (!CHECK_FLAG(match->status,
 						ROUTE_ENTRY_INSTALLED))
 					return NULL;
@@ -446,7 +764,9 @@ struct route_entry *rib_match_ipv4_multicast(vrf_id_t vrf_id,
 		mre = rib_match(AFI_IP, SAFI_MULTICAST, vrf_id, &gaddr, &m_rn);
 		ure = rib_match(AFI_IP, SAFI_UNICAST, vrf_id, &gaddr, &u_rn);
 		if (mre && ure)
-			re = ure->distance < mre->distance ? ure : mre;
+			re = re_attr(ure)->distance < re_attr(mre)->distance
+				     ? ure
+				     : mre;
 		else if (mre)
 			re = mre;
 		else if (ure)
@@ -509,7 +829,7 @@ struct route_entry *rib_lookup_ipv4(struct prefix_ipv4 *p, vrf_id_t vrf_id)
 	if (!match)
 		return NULL;
 
-	if (match->type == ZEBRA_ROUTE_CONNECT)
+	if (re_attr(match)->type == ZEBRA_ROUTE_CONNECT)
 		return match;
 
 	if (CHECK_FLAG(match->status, ROUTE_ENTRY_INSTALLED))
@@ -526,7 +846,7 @@ int zebra_rib_labeled_unicast(struct route_entry *re)
 {
 	struct nexthop *nexthop = NULL;
 
-	if (re->type != ZEBRA_ROUTE_BGP)
+	if (re_attr(re)->type != ZEBRA_ROUTE_BGP)
 		return 0;
 
 	for (ALL_NEXTHOPS(re->nhe->nhg, nexthop))
@@ -568,7 +888,7 @@ void rib_install_kernel(struct route_node *rn, struct route_entry *re,
 	 * If this is a replace to a new RE let the originator of the RE
 	 * know that they've lost
 	 */
-	if (old && (old != re) && (old->type != re->type))
+	if (old && (old != re) && (re_attr(old)->type != re_attr(re)->type))
 		zsend_route_notify_owner(old, p, ZAPI_ROUTE_BETTER_ADMIN_WON,
 					 info->afi, info->safi);
 
@@ -596,9 +916,13 @@ void rib_install_kernel(struct route_node *rn, struct route_entry *re,
 
 			/* Free old FIB nexthop group */
 			UNSET_FLAG(old->status, ROUTE_ENTRY_USE_FIB_NHG);
-			if (old->fib_ng.nexthop) {
-				nexthops_free(old->fib_ng.nexthop);
-				old->fib_ng.nexthop = NULL;
+			if (old->fib && re_fib(old)->ng.nexthop) {
+				struct nexthop_group backup_ng = {};
+
+				copy_nexthops(&backup_ng.nexthop,
+					      re_fib(old)->backup_ng.nexthop,
+					      NULL);
+				route_entry_fib_set(old, NULL, &backup_ng);
 			}
 		}
 
@@ -838,7 +1162,7 @@ static void rib_process_add_fib(struct zebra_vrf *zvrf, struct route_node *rn,
 	if (IS_ZEBRA_DEBUG_RIB)
 		zlog_debug("%s(%u:%u):%pRN: Adding route rn %p, re %p (%s)",
 			   zvrf_name(zvrf), zvrf_id(zvrf), new->table, rn, rn,
-			   new, zebra_route_string(new->type));
+			   new, zebra_route_string(re_attr(new)->type));
 
 	/* If labeled-unicast route, install transit LSP. */
 	if (zebra_rib_labeled_unicast(new))
@@ -858,7 +1182,7 @@ static void rib_process_del_fib(struct zebra_vrf *zvrf, struct route_node *rn,
 	if (IS_ZEBRA_DEBUG_RIB)
 		zlog_debug("%s(%u:%u):%pRN: Deleting route rn %p, re %p (%s)",
 			   zvrf_name(zvrf), zvrf_id(zvrf), old->table, rn, rn,
-			   old, zebra_route_string(old->type));
+			   old, zebra_route_string(re_attr(old)->type));
 
 	/* If labeled-unicast route, uninstall transit LSP. */
 	if (zebra_rib_labeled_unicast(old))
@@ -909,15 +1233,18 @@ static void rib_process_update_fib(struct zebra_vrf *zvrf,
 						"%s(%u:%u):%pRN: Updating route rn %p, re %p (%s) old %p (%s)",
 						zvrf_name(zvrf), zvrf_id(zvrf),
 						new->table, rn, rn, new,
-						zebra_route_string(new->type),
+						zebra_route_string(
+							re_attr(new)->type),
 						old,
-						zebra_route_string(old->type));
+						zebra_route_string(
+							re_attr(old)->type));
 				else
 					zlog_debug(
 						"%s(%u:%u):%pRN: Updating route rn %p, re %p (%s)",
 						zvrf_name(zvrf), zvrf_id(zvrf),
 						new->table, rn, rn, new,
-						zebra_route_string(new->type));
+						zebra_route_string(
+							re_attr(new)->type));
 			}
 
 			/* If labeled-unicast route, uninstall transit LSP. */
@@ -947,15 +1274,18 @@ static void rib_process_update_fib(struct zebra_vrf *zvrf,
 						"%s(%u:%u):%pRN: Deleting route rn %p, re %p (%s) old %p (%s) - nexthop inactive",
 						zvrf_name(zvrf), zvrf_id(zvrf),
 						new->table, rn, rn, new,
-						zebra_route_string(new->type),
+						zebra_route_string(
+							re_attr(new)->type),
 						old,
-						zebra_route_string(old->type));
+						zebra_route_string(
+							re_attr(old)->type));
 				else
 					zlog_debug(
 						"%s(%u:%u):%pRN: Deleting route rn %p, re %p (%s) - nexthop inactive",
 						zvrf_name(zvrf), zvrf_id(zvrf),
 						new->table, rn, rn, new,
-						zebra_route_string(new->type));
+						zebra_route_string(
+							re_attr(new)->type));
 			}
 
 			/*
@@ -1015,8 +1345,8 @@ static struct route_entry *rib_choose_best(struct route_entry *current,
 	 * or loopback interface.  If not, pick the last connected
 	 * route of the set of lowest metric connected routes.
 	 */
-	if (alternate->type == ZEBRA_ROUTE_CONNECT) {
-		if (current->type != ZEBRA_ROUTE_CONNECT)
+	if (re_attr(alternate)->type == ZEBRA_ROUTE_CONNECT) {
+		if (re_attr(current)->type != ZEBRA_ROUTE_CONNECT)
 			return alternate;
 
 		/* both are connected.  are either loop or vrf? */
@@ -1039,23 +1369,23 @@ static struct route_entry *rib_choose_best(struct route_entry *current,
 		}
 
 		/* Neither are loop or vrf so pick best metric  */
-		if (alternate->metric <= current->metric)
+		if (re_attr(alternate)->metric <= re_attr(current)->metric)
 			return alternate;
 
 		return current;
 	}
 
-	if (current->type == ZEBRA_ROUTE_CONNECT)
+	if (re_attr(current)->type == ZEBRA_ROUTE_CONNECT)
 		return current;
 
 	/* higher distance loses */
-	if (alternate->distance < current->distance)
+	if (re_attr(alternate)->distance < re_attr(current)->distance)
 		return alternate;
-	if (current->distance < alternate->distance)
+	if (re_attr(current)->distance < re_attr(alternate)->distance)
 		return current;
 
 	/* metric tie-breaks equal distance */
-	if (alternate->metric <= current->metric)
+	if (re_attr(alternate)->metric <= re_attr(current)->metric)
 		return alternate;
 
 	return current;
@@ -1118,12 +1448,12 @@ static void rib_process(struct route_node *rn)
 			zlog_debug(
 				"%s(%u:%u):%pRN: Examine re %p (%s) status: %sflags: %sdist %d metric %d",
 				VRF_LOGNAME(vrf), vrf_id, re->table, rn, re,
-				zebra_route_string(re->type),
+				zebra_route_string(re_attr(re)->type),
 				_dump_re_status(re, status_buf,
 						sizeof(status_buf)),
 				zclient_dump_route_flags(re->flags, flags_buf,
 							 sizeof(flags_buf)),
-				re->distance, re->metric);
+				re_attr(re)->distance, re_attr(re)->metric);
 		}
 
 		/* Currently selected re. */
@@ -1149,7 +1479,7 @@ static void rib_process(struct route_node *rn)
 				const struct prefix *p;
 				struct rib_table_info *info;
 
-				if (re->type == ZEBRA_ROUTE_TABLE) {
+				if (re_attr(re)->type == ZEBRA_ROUTE_TABLE) {
 					/* XXX: HERE BE DRAGONS!!!!!
 					 * In all honesty, I have not yet
 					 * figured out what this part does or
@@ -1197,8 +1527,8 @@ static void rib_process(struct route_node *rn)
 		}
 
 		/* Infinite distance. */
-		if (re->distance == DISTANCE_INFINITY &&
-		    re->type != ZEBRA_ROUTE_KERNEL) {
+		if (re_attr(re)->distance == DISTANCE_INFINITY &&
+		    re_attr(re)->type != ZEBRA_ROUTE_KERNEL) {
 			UNSET_FLAG(re->status, ROUTE_ENTRY_CHANGED);
 			continue;
 		}
@@ -1341,19 +1671,21 @@ static bool rib_route_match_ctx(const struct route_entry *re,
 		 * In 'update' case, we test info about the 'previous' or
 		 * 'old' route
 		 */
-		if ((re->type == dplane_ctx_get_old_type(ctx)) &&
-		    (re->instance == dplane_ctx_get_old_instance(ctx))) {
+		if ((re_attr(re)->type == dplane_ctx_get_old_type(ctx)) &&
+		    (re_attr(re)->instance
+		     == dplane_ctx_get_old_instance(ctx))) {
 			result = true;
 
 			/* We use an extra test for statics, and another for
 			 * kernel routes.
 			 */
-			if (re->type == ZEBRA_ROUTE_STATIC &&
-			    (re->distance != dplane_ctx_get_old_distance(ctx) ||
-			     re->tag != dplane_ctx_get_old_tag(ctx))) {
+			if (re_attr(re)->type == ZEBRA_ROUTE_STATIC &&
+			    (re_attr(re)->distance
+				     != dplane_ctx_get_old_distance(ctx) ||
+			     re_attr(re)->tag != dplane_ctx_get_old_tag(ctx))) {
 				result = false;
-			} else if (re->type == ZEBRA_ROUTE_KERNEL &&
-				   re->metric !=
+			} else if (re_attr(re)->type == ZEBRA_ROUTE_KERNEL &&
+				   re_attr(re)->metric !=
 				   dplane_ctx_get_old_metric(ctx)) {
 				result = false;
 			}
@@ -1369,21 +1701,23 @@ static bool rib_route_match_ctx(const struct route_entry *re,
 			goto done;
 		}
 
-		if ((re->type == dplane_ctx_get_type(ctx)) &&
-		    (re->instance == dplane_ctx_get_instance(ctx))) {
+		if ((re_attr(re)->type == dplane_ctx_get_type(ctx)) &&
+		    (re_attr(re)->instance == dplane_ctx_get_instance(ctx))) {
 			result = true;
 
 			/* We use an extra test for statics, and another for
 			 * kernel routes.
 			 */
-			if (re->type == ZEBRA_ROUTE_STATIC &&
-			    (re->distance != dplane_ctx_get_distance(ctx) ||
-			     re->tag != dplane_ctx_get_tag(ctx))) {
+			if (re_attr(re)->type == ZEBRA_ROUTE_STATIC &&
+			    (re_attr(re)->distance
+				     != dplane_ctx_get_distance(ctx) ||
+			     re_attr(re)->tag != dplane_ctx_get_tag(ctx))) {
 				result = false;
-			} else if (re->type == ZEBRA_ROUTE_KERNEL &&
-				   re->metric != dplane_ctx_get_metric(ctx)) {
+			} else if (re_attr(re)->type == ZEBRA_ROUTE_KERNEL &&
+				   re_attr(re)->metric !=
+				   dplane_ctx_get_metric(ctx)) {
 				result = false;
-			} else if (re->type == ZEBRA_ROUTE_CONNECT) {
+			} else if (re_attr(re)->type == ZEBRA_ROUTE_CONNECT) {
 				result = nexthop_group_equal_no_recurse(
 					&re->nhe->nhg, dplane_ctx_get_ng(ctx));
 			}
@@ -1424,24 +1758,25 @@ static void zebra_rib_fixup_system(struct route_node *rn)
 static bool rib_compare_routes(const struct route_entry *re1,
 			       const struct route_entry *re2)
 {
-	if (re1->type != re2->type)
+	if (re_attr(re1)->type != re_attr(re2)->type)
 		return false;
 
-	if (re1->instance != re2->instance)
+	if (re_attr(re1)->instance != re_attr(re2)->instance)
 		return false;
 
-	if (re1->type == ZEBRA_ROUTE_KERNEL && re1->metric != re2->metric)
+	if (re_attr(re1)->type == ZEBRA_ROUTE_KERNEL
+	    && re_attr(re1)->metric != re_attr(re2)->metric)
 		return false;
 
 	if (CHECK_FLAG(re1->flags, ZEBRA_FLAG_RR_USE_DISTANCE) &&
-	    re1->distance != re2->distance)
+	    re_attr(re1)->distance != re_attr(re2)->distance)
 		return false;
 
 	/* We support multiple connected routes: this supports multiple
 	 * v6 link-locals, and we also support multiple addresses in the same
 	 * subnet on a single interface.
 	 */
-	if (re1->type != ZEBRA_ROUTE_CONNECT)
+	if (re_attr(re1)->type != ZEBRA_ROUTE_CONNECT)
 		return true;
 
 	return false;
@@ -1547,6 +1882,9 @@ static bool rib_update_re_from_ctx(struct route_entry *re,
 	bool matched;
 	const struct nexthop_group *ctxnhg;
 	struct nexthop_group *re_nhg;
+	/* New fib-specific groups, interned into 're' at the end */
+	struct nexthop_group fib_ng = {};
+	struct nexthop_group fib_backup_ng = {};
 	bool is_selected = false; /* Is 're' currently the selected re? */
 	bool changed_p = false; /* Change to nexthops? */
 	rib_dest_t *dest;
@@ -1578,8 +1916,8 @@ static bool rib_update_re_from_ctx(struct route_entry *re,
 	/* TODO -- this isn't testing or comparing the FIB flags; we should
 	 * do a more explicit loop, checking the incoming notification's flags.
 	 */
-	if (re->fib_ng.nexthop && ctxnhg->nexthop &&
-	    nexthop_group_equal(&re->fib_ng, ctxnhg))
+	if (re->fib && re_fib(re)->ng.nexthop && ctxnhg->nexthop &&
+	    nexthop_group_equal(&re_fib(re)->ng, ctxnhg))
 		matched = true;
 
 	/* If the new FIB set matches the existing FIB set, we're done. */
@@ -1588,6 +1926,7 @@ static bool rib_update_re_from_ctx(struct route_entry *re,
 			zlog_debug(
 				"%s(%u:%u):%pRN update_from_ctx(): existing fib nhg, no change",
 				VRF_LOGNAME(vrf), re->vrf_id, re->table, rn);
+		copy_nexthops(&fib_ng.nexthop, re_fib(re)->ng.nexthop, NULL);
 		goto check_backups;
 
 	} else if (CHECK_FLAG(re->status, ROUTE_ENTRY_USE_FIB_NHG)) {
@@ -1598,9 +1937,8 @@ static bool rib_update_re_from_ctx(struct route_entry *re,
 			zlog_debug(
 				"%s(%u:%u):%pRN update_from_ctx(): replacing fib nhg",
 				VRF_LOGNAME(vrf), re->vrf_id, re->table, rn);
-		nexthops_free(re->fib_ng.nexthop);
-		re->fib_ng.nexthop = NULL;
 
+		/* The stale fib list is dropped when 're' is updated below */
 		UNSET_FLAG(re->status, ROUTE_ENTRY_USE_FIB_NHG);
 
 		/* Note that the installed nexthops have changed */
@@ -1610,6 +1948,9 @@ static bool rib_update_re_from_ctx(struct route_entry *re,
 			zlog_debug(
 				"%s(%u:%u):%pRN update_from_ctx(): no fib nhg",
 				VRF_LOGNAME(vrf), re->vrf_id, re->table, rn);
+		if (re->fib)
+			copy_nexthops(&fib_ng.nexthop, re_fib(re)->ng.nexthop,
+				      NULL);
 	}
 
 	/*
@@ -1657,7 +1998,7 @@ no_nexthops:
 	/* Set the flag about the dedicated fib list */
 	SET_FLAG(re->status, ROUTE_ENTRY_USE_FIB_NHG);
 	if (ctxnhg->nexthop)
-		copy_nexthops(&(re->fib_ng.nexthop), ctxnhg->nexthop, NULL);
+		copy_nexthops(&fib_ng.nexthop, ctxnhg->nexthop, NULL);
 
 check_backups:
 
@@ -1667,13 +2008,18 @@ check_backups:
 	 * installed, a new fib nhg will be attached to the route.
 	 */
 	re_nhg = zebra_nhg_get_backup_nhg(re->nhe);
-	if (re_nhg == NULL)
-		goto done;	/* No backup nexthops */
+	if (re_nhg == NULL) {
+		/* No backup nexthops */
+		if (re->fib)
+			copy_nexthops(&fib_backup_ng.nexthop,
+				      re_fib(re)->backup_ng.nexthop, NULL);
+		goto done;
+	}
 
 	/* First check the route's 'fib' list of backups, if it's present
 	 * from some previous event.
 	 */
-	re_nhg = &re->fib_backup_ng;
+	re_nhg = rib_get_fib_backup_nhg(re);
 	ctxnhg = dplane_ctx_get_backup_ng(ctx);
 
 	matched = false;
@@ -1686,9 +2032,10 @@ check_backups:
 			zlog_debug(
 				"%s(%u):%pRN update_from_ctx(): existing fib backup nhg, no change",
 				VRF_LOGNAME(vrf), re->vrf_id, rn);
+		copy_nexthops(&fib_backup_ng.nexthop, re_nhg->nexthop, NULL);
 		goto done;
 
-	} else if (re->fib_backup_ng.nexthop) {
+	} else if (re_nhg->nexthop) {
 		/*
 		 * Free stale fib backup list and move on to check
 		 * the route's backups.
@@ -1697,8 +2044,6 @@ check_backups:
 			zlog_debug(
 				"%s(%u):%pRN update_from_ctx(): replacing fib backup nhg",
 				VRF_LOGNAME(vrf), re->vrf_id, rn);
-		nexthops_free(re->fib_backup_ng.nexthop);
-		re->fib_backup_ng.nexthop = NULL;
 
 		/* Note that the installed nexthops have changed */
 		changed_p = true;
@@ -1730,28 +2075,22 @@ check_backups:
 				VRF_LOGNAME(vrf), re->vrf_id, rn,
 				(changed_p ? "true" : "false"));
 
-		copy_nexthops(&(re->fib_backup_ng.nexthop), ctxnhg->nexthop,
-			      NULL);
+		copy_nexthops(&fib_backup_ng.nexthop, ctxnhg->nexthop, NULL);
 	}
 
 done:
+	route_entry_fib_set(re, &fib_ng, &fib_backup_ng);
 
 	return changed_p;
 }
 
 /*
- * Helper to locate a zebra route-node from a dplane context. This is used
- * when processing dplane results, e.g. Note well: the route-node is returned
- * with a ref held - route_unlock_node() must be called eventually.
+ * Helper to locate the zebra route table a dplane context refers to.
  */
-static struct route_node *
-rib_find_rn_from_ctx(const struct zebra_dplane_ctx *ctx)
+static struct route_table *
+rib_find_table_from_ctx(const struct zebra_dplane_ctx *ctx)
 {
-	struct route_table *table = NULL;
-	struct route_node *rn = NULL;
-	const struct prefix *dest_pfx, *src_pfx;
-
-	/* Locate rn and re(s) from ctx */
+	struct route_table *table;
 
 	table = zebra_vrf_lookup_table_with_table_id(
 		dplane_ctx_get_afi(ctx), dplane_ctx_get_safi(ctx),
@@ -1765,29 +2104,54 @@ rib_find_rn_from_ctx(const struct zebra_dplane_ctx *ctx)
 				vrf_id_to_name(dplane_ctx_get_vrf(ctx)),
 				dplane_ctx_get_vrf(ctx));
 		}
-		goto done;
 	}
 
+	return table;
+}
+
+/*
+ * Helper to locate a zebra route-node from a dplane context, within a
+ * table that has already been looked up. Note well: the route-node is
+ * returned with a ref held - route_unlock_node() must be called eventually.
+ */
+static struct route_node *
+rib_find_rn_in_table(struct route_table *table,
+		     const struct zebra_dplane_ctx *ctx)
+{
+	const struct prefix *dest_pfx, *src_pfx;
+
+	if (table == NULL)
+		return NULL;
+
 	dest_pfx = dplane_ctx_get_dest(ctx);
 	src_pfx = dplane_ctx_get_src(ctx);
 
-	rn = srcdest_rnode_get(table, dest_pfx,
-			       src_pfx ? (struct prefix_ipv6 *)src_pfx : NULL);
-
-done:
-	return rn;
+	return srcdest_rnode_get(table, dest_pfx,
+				 src_pfx ? (struct prefix_ipv6 *)src_pfx
+					 : NULL);
 }
 
-
+/*
+ * Helper to locate a zebra route-node from a dplane context. This is used
+ * when processing dplane results, e.g. Note well: the route-node is returned
+ * with a ref held - route_unlock_node() must be called eventually.
+ */
+static struct route_node *
+rib_find_rn_from_ctx(const struct zebra_dplane_ctx *ctx)
+{
+	return rib_find_rn_in_table(rib_find_table_from_ctx(ctx), ctx);
+}
 
 /*
- * Route-update results processing after async dataplane update.
+ * Route-update results processing after async dataplane update. The
+ * route-node for the context, if any, is passed in with a ref held; that
+ * ref is released here.
  */
-static void rib_process_result(struct zebra_dplane_ctx *ctx)
+static void rib_process_result(struct zebra_dplane_ctx *ctx,
+			       struct route_node *rn)
 {
 	struct zebra_vrf *zvrf = NULL;
 	struct vrf *vrf;
-	struct route_node *rn = NULL;
 	struct route_entry *re = NULL, *old_re = NULL, *rib;
 	bool is_update = false;
 	enum dplane_op_e op;
@@ -1802,8 +2166,6 @@ static void rib_process_result(struct zebra_dplane_ctx *ctx)
 	vrf = vrf_lookup_by_id(dplane_ctx_get_vrf(ctx));
 	dest_pfx = dplane_ctx_get_dest(ctx);
 
-	/* Locate rn and re(s) from ctx */
-	rn = rib_find_rn_from_ctx(ctx);
 	if (rn == NULL) {
 		if (IS_ZEBRA_DEBUG_DPLANE) {
 			zlog_debug(
@@ -2052,7 +2414,7 @@ static int rib_count_installed_nh(struct route_entry *re)
 		/* The meaningful flag depends on where the installed
 		 * nexthops reside.
 		 */
-		if (nhg == &(re->fib_ng)) {
+		if (re->fib && nhg == &(re_fib(re)->ng)) {
 			if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_FIB))
 				count++;
 		} else {
@@ -2509,7 +2871,7 @@ static int rib_meta_queue_add(struct meta_queue *mq, void *data)
 	rn = (struct route_node *)data;
 
 	RNODE_FOREACH_RE (rn, curr_re) {
-		curr_qindex = route_info[curr_re->type].meta_q_map;
+		curr_qindex = route_info[re_attr(curr_re)->type].meta_q_map;
 
 		if (curr_qindex <= qindex) {
 			re = curr_re;
@@ -3097,7 +3459,8 @@ void rib_unlink(struct route_node *rn, struct route_entry *re)
 	} else if (re->nhe && re->nhe->nhg.nexthop)
 		nexthops_free(re->nhe->nhg.nexthop);
 
-	nexthops_free(re->fib_ng.nexthop);
+	route_entry_fib_release(re);
+	route_entry_attr_release(re);
 
 	zapi_opaque_free(re->opaque);
 
@@ -3124,7 +3487,8 @@ void rib_delnode(struct route_node *rn, struct route_entry *re)
 		if (IS_ZEBRA_DEBUG_RIB)
 			zlog_debug("%s(%u):%pRN: Freeing route rn %p, re %p (%s)",
 				   vrf_id_to_name(re->vrf_id), re->vrf_id, rn,
-				   rn, re, zebra_route_string(re->type));
+				   rn, re,
+				   zebra_route_string(re_attr(re)->type));
 
 		rib_unlink(rn, re);
 	} else {
@@ -3247,11 +3611,11 @@ void _route_entry_dump(const char *func, union prefixconstptr pp,
 			     : "",
 		   VRF_LOGNAME(vrf), re->vrf_id);
 	zlog_debug("%s: uptime == %lu, type == %u, instance == %d, table == %d",
-		   straddr, (unsigned long)re->uptime, re->type, re->instance,
-		   re->table);
+		   straddr, (unsigned long)re->uptime, re_attr(re)->type,
+		   re_attr(re)->instance, re->table);
 	zlog_debug(
 		"%s: metric == %u, mtu == %u, distance == %u, flags == %sstatus == %s",
-		straddr, re->metric, re->mtu, re->distance,
+		straddr, re_attr(re)->metric, re->mtu, re_attr(re)->distance,
 		zclient_dump_route_flags(re->flags, flags_buf,
 					 sizeof(flags_buf)),
 		_dump_re_status(re, status_buf, sizeof(status_buf)));
@@ -3293,6 +3657,7 @@ int rib_add_multipath_nhe(afi_t afi, safi_t safi, struct prefix *p,
 	struct route_table *table;
 	struct route_node *rn;
 	struct route_entry *same = NULL, *first_same = NULL;
+	const struct route_entry_attr *attr;
 	int ret = 0;
 	int same_count = 0;
 	rib_dest_t *dest;
@@ -3351,8 +3716,11 @@ int rib_add_multipath_nhe(afi_t afi, safi_t safi, struct prefix *p,
 		apply_mask_ipv6(src_p);
 
 	/* Set default distance by route type. */
-	if (re->distance == 0)
-		re->distance = route_distance(re->type);
+	attr = re_attr(re);
+	if (attr->distance == 0)
+		route_entry_attr_set(re, attr->type, attr->instance,
+				     route_distance(attr->type), attr->metric,
+				     attr->tag);
 
 	/* Lookup route node.*/
 	rn = srcdest_rnode_get(table, p, src_p);
@@ -3389,7 +3757,7 @@ int rib_add_multipath_nhe(afi_t afi, safi_t safi, struct prefix *p,
 	if (IS_ZEBRA_DEBUG_RIB) {
 		rnode_debug(rn, re->vrf_id,
 			    "Inserting route rn %p, re %p (%s) existing %p, same_count %d",
-			    rn, re, zebra_route_string(re->type), same,
+			    rn, re, zebra_route_string(re_attr(re)->type), same,
 			    same_count);
 
 		if (IS_ZEBRA_DEBUG_RIB_DETAILED)
@@ -3459,8 +3827,10 @@ int rib_add_multipath(afi_t afi, safi_t safi, struct prefix *p,
 	nexthop_group_delete(&ng);
 
 	/* In error cases, free the route also */
-	if (ret < 0)
+	if (ret < 0) {
+		route_entry_attr_release(re);
 		XFREE(MTYPE_RE, re);
+	}
 
 	return ret;
 }
@@ -3521,17 +3891,18 @@ void rib_delete(afi_t afi, safi_t safi, vrf_id_t vrf_id, int type,
 		if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
 			continue;
 
-		if (re->type != type)
+		if (re_attr(re)->type != type)
 			continue;
-		if (re->instance != instance)
+		if (re_attr(re)->instance != instance)
 			continue;
 		if (CHECK_FLAG(re->flags, ZEBRA_FLAG_RR_USE_DISTANCE) &&
-		    distance != re->distance)
+		    distance != re_attr(re)->distance)
 			continue;
 
-		if (re->type == ZEBRA_ROUTE_KERNEL && re->metric != metric)
+		if (re_attr(re)->type == ZEBRA_ROUTE_KERNEL
+		    && re_attr(re)->metric != metric)
 			continue;
-		if (re->type == ZEBRA_ROUTE_CONNECT &&
+		if (re_attr(re)->type == ZEBRA_ROUTE_CONNECT &&
 		    (rtnh = re->nhe->nhg.nexthop)
 		    && rtnh->type == NEXTHOP_TYPE_IFINDEX && nh) {
 			if (rtnh->ifindex != nh->ifindex)
@@ -3587,7 +3958,8 @@ void rib_delete(afi_t afi, safi_t safi, vrf_id_t vrf_id, int type,
 				rnode_debug(rn, vrf_id,
 					    "rn %p, re %p (%s) was deleted from kernel, adding",
 					    rn, fib,
-					    zebra_route_string(fib->type));
+					    zebra_route_string(
+						    re_attr(fib)->type));
 			}
 			if (allow_delete
 			    || CHECK_FLAG(dest->flags, RIB_ROUTE_ANY_QUEUED)) {
@@ -3692,16 +4064,12 @@ int rib_add(afi_t afi, safi_t safi, vrf_id_t vrf_id, int type,
 
 	/* Allocate new route_entry structure. */
 	re = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
-	re->type = type;
-	re->instance = instance;
-	re->distance = distance;
+	route_entry_attr_set(re, type, instance, distance, metric, tag);
 	re->flags = flags;
-	re->metric = metric;
 	re->mtu = mtu;
 	re->table = table_id;
 	re->vrf_id = vrf_id;
 	re->uptime = monotime(NULL);
-	re->tag = tag;
 	re->nhe_id = nhe_id;
 
 	/* If the owner of the route supplies a shared nexthop-group id,
@@ -3748,7 +4116,7 @@ static void rib_update_route_node(struct route_node *rn, int type)
 	bool re_changed = false;
 
 	RNODE_FOREACH_RE_SAFE (rn, re, next) {
-		if (type == ZEBRA_ROUTE_ALL || type == re->type) {
+		if (type == ZEBRA_ROUTE_ALL || type == re_attr(re)->type) {
 			SET_FLAG(re->status, ROUTE_ENTRY_CHANGED);
 			re_changed = true;
 		}
@@ -4005,8 +4373,8 @@ unsigned long rib_score_proto_table(uint8_t proto, unsigned short instance,
 			RNODE_FOREACH_RE_SAFE (rn, re, next) {
 				if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
 					continue;
-				if (re->type == proto
-				    && re->instance == instance) {
+				if (re_attr(re)->type == proto
+				    && re_attr(re)->instance == instance) {
 					rib_delnode(rn, re);
 					n++;
 				}
@@ -4094,6 +4462,160 @@ done:
 }
 
 
+/*
+ * Is this a route-update result that goes through rib_process_result()?
+ * Updates generated by async notifications are not processed in the rib.
+ */
+static bool rib_ctx_is_route_result(const struct zebra_dplane_ctx *ctx)
+{
+	switch (dplane_ctx_get_op(ctx)) {
+	case DPLANE_OP_ROUTE_INSTALL:
+	case DPLANE_OP_ROUTE_UPDATE:
+	case DPLANE_OP_ROUTE_DELETE:
+		return dplane_ctx_get_notif_provider(ctx) == 0;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Order route results by table, then by prefix in the order a walk of the
+ * table visits them, then by arrival. Results for the same route keep
+ * their relative order.
+ */
+static int rib_result_entry_cmp(const void *a, const void *b)
+{
+	const struct rib_result_entry *ea = a, *eb = b;
+	const struct zebra_dplane_ctx *ca = ea->ctx, *cb = eb->ctx;
+	const struct prefix *pa, *pb;
+	int ret;
+
+	if (dplane_ctx_get_vrf(ca) != dplane_ctx_get_vrf(cb))
+		return numcmp(dplane_ctx_get_vrf(ca), dplane_ctx_get_vrf(cb));
+	if (dplane_ctx_get_table(ca) != dplane_ctx_get_table(cb))
+		return numcmp(dplane_ctx_get_table(ca),
+			      dplane_ctx_get_table(cb));
+	if (dplane_ctx_get_afi(ca) != dplane_ctx_get_afi(cb))
+		return numcmp(dplane_ctx_get_afi(ca), dplane_ctx_get_afi(cb));
+	if (dplane_ctx_get_safi(ca) != dplane_ctx_get_safi(cb))
+		return numcmp(dplane_ctx_get_safi(ca),
+			      dplane_ctx_get_safi(cb));
+
+	ret = route_table_prefix_iter_cmp(dplane_ctx_get_dest(ca),
+					  dplane_ctx_get_dest(cb));
+	if (ret)
+		return ret;
+
+	pa = dplane_ctx_get_src(ca);
+	pb = dplane_ctx_get_src(cb);
+	if (pa && pb)
+		ret = prefix_cmp(pa, pb);
+	else if (pa || pb)
+		ret = pa ? 1 : -1;
+	if (ret)
+		return ret;
+
+	return numcmp(ea->idx, eb->idx);
+}
+
+/*
+ * Locate the route-node for a context, continuing from 'prev', the node
+ * of the result before it in the same table: climb from there to the
+ * nearest node covering the prefix and descend to it. Results are sorted
+ * in table order, so this walks each table once overall. Falls back to a
+ * lookup from the top when the node is new or has a source prefix. The
+ * route-node is returned with a ref held.
+ */
+static struct route_node *rib_walk_to_rn(struct route_table *table,
+					 struct route_node *prev,
+					 const struct zebra_dplane_ctx *ctx)
+{
+	const struct prefix *p = dplane_ctx_get_dest(ctx);
+	struct route_node *node = prev;
+
+	if (table == NULL || dplane_ctx_get_src(ctx))
+		return rib_find_rn_in_table(table, ctx);
+
+	while (node && !prefix_match(&node->p, p))
+		node = node->parent;
+
+	while (node && prefix_match(&node->p, p)) {
+		if (node->p.prefixlen == p->prefixlen)
+			return route_lock_node(node);
+
+		node = node->link[prefix_bit(&p->u.prefix, node->p.prefixlen)];
+	}
+
+	return rib_find_rn_in_table(table, ctx);
+}
+
+/*
+ * Process a batch of route results: sort them so that results for the same
+ * table are adjacent and in table order, resolve the table once per run and
+ * the route-nodes in one walk down it. Owner notifications are sent to each
+ * client in one go once the batch is done.
+ */
+static void rib_process_result_batch(struct rib_result_batch *batch)
+{
+	struct zebra_dplane_ctx *ctx;
+	struct route_table *table = NULL;
+	struct route_node *rn, *prev = NULL;
+	vrf_id_t vrf_id = VRF_UNKNOWN;
+	uint32_t table_id = 0;
+	afi_t afi = AFI_UNSPEC;
+	safi_t safi = SAFI_UNSPEC;
+	bool have_table = false;
+	uint32_t i;
+
+	if (batch->count > 1)
+		qsort(batch->entries, batch->count, sizeof(batch->entries[0]),
+		      rib_result_entry_cmp);
+
+	zsend_route_notify_owner_hold();
+
+	for (i = 0; i < batch->count; i++) {
+		ctx = batch->entries[i].ctx;
+
+		if (!have_table || vrf_id != dplane_ctx_get_vrf(ctx)
+		    || table_id != dplane_ctx_get_table(ctx)
+		    || afi != dplane_ctx_get_afi(ctx)
+		    || safi != dplane_ctx_get_safi(ctx)) {
+			vrf_id = dplane_ctx_get_vrf(ctx);
+			table_id = dplane_ctx_get_table(ctx);
+			afi = dplane_ctx_get_afi(ctx);
+			safi = dplane_ctx_get_safi(ctx);
+			table = rib_find_table_from_ctx(ctx);
+			have_table = true;
+
+			if (prev)
+				route_unlock_node(prev);
+			prev = NULL;
+		}
+
+		rn = rib_walk_to_rn(table, prev, ctx);
+
+		/*
+		 * Keep a ref on the node to continue the walk from, the
+		 * result processing may release the node's last route.
+		 * Nodes of a source table aren't part of the walk.
+		 */
+		if (rn && !dplane_ctx_get_src(ctx)) {
+			if (prev)
+				route_unlock_node(prev);
+			prev = route_lock_node(rn);
+		}
+
+		rib_process_result(ctx, rn);
+	}
+
+	if (prev)
+		route_unlock_node(prev);
+
+	zsend_route_notify_owner_flush();
+
+	batch->count = 0;
+}
+
 /*
  * Handle results from the dataplane system. Dequeue update context
  * structs, dispatch to appropriate internal handlers.
@@ -4103,6 +4625,10 @@ static int rib_process_dplane_results(struct thread *thread)
 	struct zebra_dplane_ctx *ctx;
 	struct dplane_ctx_q ctxlist;
 	bool shut_p = false;
+	struct rib_result_batch batch;
+	uint32_t processed = 0;
+
+	batch.count = 0;
 
 	/* Dequeue a list of completed updates with one lock/unlock cycle */
 
@@ -4162,22 +4688,32 @@ static int rib_process_dplane_results(struct thread *thread)
 					       ("ctx", ctx));
 #endif /* HAVE_SCRIPTING */
 
+			/* Route results are batched; anything else must
+			 * see the results that arrived before it.
+			 */
+			if (rib_ctx_is_route_result(ctx)) {
+				batch.entries[batch.count].ctx = ctx;
+				batch.entries[batch.count].idx = processed;
+				if (++batch.count == RIB_RESULT_BATCH_SIZE)
+					rib_process_result_batch(&batch);
+
+				goto next_ctx;
+			}
+
+			if (batch.count)
+				rib_process_result_batch(&batch);
+
 			switch (dplane_ctx_get_op(ctx)) {
 			case DPLANE_OP_ROUTE_INSTALL:
 			case DPLANE_OP_ROUTE_UPDATE:
 			case DPLANE_OP_ROUTE_DELETE:
-			{
 				/* Bit of special case for route updates
 				 * that were generated by async notifications:
 				 * we don't want to continue processing these
 				 * in the rib.
 				 */
-				if (dplane_ctx_get_notif_provider(ctx) == 0)
-					rib_process_result(ctx);
-				else
-					dplane_ctx_fini(&ctx);
-			}
-			break;
+				dplane_ctx_fini(&ctx);
+				break;
 
 			case DPLANE_OP_ROUTE_NOTIFY:
 				rib_process_dplane_notify(ctx);
@@ -4262,9 +4798,34 @@ static int rib_process_dplane_results(struct thread *thread)
 
 			} /* Dispatch by op code */
 
+next_ctx:
+			/* Yield once we've done a chunk of work */
+			if (++processed >= RIB_DPLANE_RESULTS_LIMIT)
+				break;
+
 			ctx = dplane_ctx_dequeue(&ctxlist);
 		}
 
+		if (batch.count)
+			rib_process_result_batch(&batch);
+
+		if (processed >= RIB_DPLANE_RESULTS_LIMIT) {
+			/* Put what's left back at the head of the
+			 * results queue, and come back for it.
+			 */
+			frr_with_mutex(&dplane_mutex) {
+				dplane_ctx_list_append(&ctxlist,
+						       &rib_dplane_q);
+				dplane_ctx_list_append(&rib_dplane_q,
+						       &ctxlist);
+			}
+
+			thread_add_event(zrouter.master,
+					 rib_process_dplane_results, NULL, 0,
+					 &t_dplane);
+			break;
+		}
+
 	} while (1);
 
 	return 0;
@@ -4317,6 +4878,10 @@ void rib_init(void)
 {
 	check_route_info();
 
+	/* Route entries are the most frequently allocated fixed-size object */
+	mtype_pool_enable(MTYPE_RE, sizeof(struct route_entry));
+	hook_register(show_memory, rib_show_memory);
+
 	rib_queue_init();
 
 	/* Init dataplane, and register for results */
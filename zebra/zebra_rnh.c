@@ -522,17 +522,17 @@ static bool rnh_check_re_nexthops(const struct route_entry *re,
 		if (IS_ZEBRA_DEBUG_NHT_DETAILED)
 			zlog_debug(
 				"        Route Entry %s no nexthops",
-				zebra_route_string(re->type));
+				zebra_route_string(re_attr(re)->type));
 
 		goto done;
 	}
 
 	/* Some special checks if registration asked for them. */
 	if (CHECK_FLAG(rnh->flags, ZEBRA_NHT_CONNECTED)) {
-		if ((re->type == ZEBRA_ROUTE_CONNECT)
-		    || (re->type == ZEBRA_ROUTE_STATIC))
+		if ((re_attr(re)->type == ZEBRA_ROUTE_CONNECT)
+		    || (re_attr(re)->type == ZEBRA_ROUTE_STATIC))
 			ret = true;
-		if (re->type == ZEBRA_ROUTE_NHRP) {
+		if (re_attr(re)->type == ZEBRA_ROUTE_NHRP) {
 
 			for (nexthop = re->nhe->nhg.nexthop;
 			     nexthop;
@@ -606,7 +606,8 @@ zebra_rnh_resolve_nexthop_entry(struct zebra_vrf *zvrf, afi_t afi,
 				if (IS_ZEBRA_DEBUG_NHT_DETAILED)
 					zlog_debug(
 						"        Route Entry %s removed",
-						zebra_route_string(re->type));
+						zebra_route_string(
+							re_attr(re)->type));
 				continue;
 			}
 			if (!CHECK_FLAG(re->flags, ZEBRA_FLAG_SELECTED) &&
@@ -614,7 +615,8 @@ zebra_rnh_resolve_nexthop_entry(struct zebra_vrf *zvrf, afi_t afi,
 				if (IS_ZEBRA_DEBUG_NHT_DETAILED)
 					zlog_debug(
 						"        Route Entry %s !selected",
-						zebra_route_string(re->type));
+						zebra_route_string(
+							re_attr(re)->type));
 				continue;
 			}
 
@@ -622,7 +624,8 @@ zebra_rnh_resolve_nexthop_entry(struct zebra_vrf *zvrf, afi_t afi,
 				if (IS_ZEBRA_DEBUG_NHT_DETAILED)
 					zlog_debug(
 						"        Route Entry %s queued",
-						zebra_route_string(re->type));
+						zebra_route_string(
+							re_attr(re)->type));
 				continue;
 			}
 
@@ -839,6 +842,8 @@ static void free_state(vrf_id_t vrf_id, struct route_entry *re,
 
 	/* free RE and nexthops */
 	zebra_nhg_free(re->nhe);
+	route_entry_fib_release(re);
+	route_entry_attr_release(re);
 	XFREE(MTYPE_RE, re);
 }
 
@@ -856,21 +861,17 @@ static void copy_state(struct rnh *rnh, const struct route_entry *re,
 		return;
 
 	state = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
-	state->type = re->type;
-	state->distance = re->distance;
-	state->metric = re->metric;
+	route_entry_attr_set(state, re_attr(re)->type, 0,
+			     re_attr(re)->distance, re_attr(re)->metric, 0);
 	state->vrf_id = re->vrf_id;
 	state->status = re->status;
 
 	state->nhe = zebra_nhe_copy(re->nhe, 0);
 
-	/* Copy the 'fib' nexthops also, if present - we want to capture
+	/* Share the 'fib' nexthops also, if present - we want to capture
 	 * the true installed nexthops.
 	 */
-	if (re->fib_ng.nexthop)
-		nexthop_group_copy(&state->fib_ng, &re->fib_ng);
-	if (re->fib_backup_ng.nexthop)
-		nexthop_group_copy(&state->fib_backup_ng, &re->fib_backup_ng);
+	route_entry_fib_share(state, re);
 
 	rnh->state = state;
 }
@@ -890,7 +891,8 @@ static struct nexthop *next_valid_primary_nh(struct route_entry *re,
 	/* Fib backup ng present: some backups are installed,
 	 * and we're configured for special handling if there are backups.
 	 */
-	if (rnh_hide_backups && (re->fib_backup_ng.nexthop != NULL))
+	if (rnh_hide_backups && re->fib
+	    && (re_fib(re)->backup_ng.nexthop != NULL))
 		default_path = false;
 
 	/* Default path: no special handling, just using the 'installed'
@@ -1136,10 +1138,10 @@ static bool compare_state(struct route_entry *r1,
 	if ((!r1 && r2) || (r1 && !r2))
 		return true;
 
-	if (r1->distance != r2->distance)
+	if (re_attr(r1)->distance != re_attr(r2)->distance)
 		return true;
 
-	if (r1->metric != r2->metric)
+	if (re_attr(r1)->metric != re_attr(r2)->metric)
 		return true;
 
 	if (!compare_valid_nexthops(r1, r2))
@@ -1197,10 +1199,10 @@ int zebra_send_rnh_update(struct rnh *rnh, struct zserv *client,
 		struct zapi_nexthop znh;
 		struct nexthop_group *nhg;
 
-		stream_putc(s, re->type);
-		stream_putw(s, re->instance);
-		stream_putc(s, re->distance);
-		stream_putl(s, re->metric);
+		stream_putc(s, re_attr(re)->type);
+		stream_putw(s, re_attr(re)->instance);
+		stream_putc(s, re_attr(re)->distance);
+		stream_putl(s, re_attr(re)->metric);
 		num = 0;
 		nump = stream_get_endp(s);
 		stream_putc(s, 0);
@@ -1299,7 +1301,7 @@ static void print_rnh(struct route_node *rn, struct vty *vty)
 							    : "");
 	if (rnh->state) {
 		vty_out(vty, " resolved via %s\n",
-			zebra_route_string(rnh->state->type));
+			zebra_route_string(re_attr(rnh->state)->type));
 		for (nexthop = rnh->state->nhe->nhg.nexthop; nexthop;
 		     nexthop = nexthop->next)
 			print_nh(nexthop, vty);
@@ -1772,10 +1772,10 @@ route_map_result_t zebra_nht_route_map_check(afi_t afi, int client_proto,
 
 	nh_obj.nexthop = nexthop;
 	nh_obj.vrf_id = nexthop->vrf_id;
-	nh_obj.source_protocol = re->type;
-	nh_obj.instance = re->instance;
-	nh_obj.metric = re->metric;
-	nh_obj.tag = re->tag;
+	nh_obj.source_protocol = re_attr(re)->type;
+	nh_obj.instance = re_attr(re)->instance;
+	nh_obj.metric = re_attr(re)->metric;
+	nh_obj.tag = re_attr(re)->tag;
 
 	if (client_proto >= 0 && client_proto < ZEBRA_ROUTE_MAX)
 		rmap = NHT_RM_MAP(zvrf, afi, client_proto);
@@ -247,6 +247,12 @@ void zebra_router_terminate(void)
 	hash_clean(zrouter.nhgs, NULL);
 	hash_free(zrouter.nhgs);
 
+	hash_clean(zrouter.re_fibs, route_entry_fib_hash_free);
+	hash_free(zrouter.re_fibs);
+	hash_clean(zrouter.re_attrs, route_entry_attr_hash_free);
+	hash_free(zrouter.re_attrs);
+	route_entry_slots_fini();
+
 	hash_clean(zrouter.rules_hash, zebra_pbr_rules_free);
 	hash_free(zrouter.rules_hash);
 
@@ -298,6 +304,13 @@ void zebra_router_init(bool asic_offload, bool notify_on_ack)
 	zrouter.nhgs_id =
 		hash_create_size(8, zebra_nhg_id_key, zebra_nhg_hash_id_equal,
 				 "Zebra Router Nexthop Groups ID index");
+	zrouter.re_fibs = hash_create_size(8, route_entry_fib_hash_key,
+					   route_entry_fib_hash_equal,
+					   "Route Entry FIB Nexthops");
+	zrouter.re_attrs = hash_create_size(8, route_entry_attr_hash_key,
+					    route_entry_attr_hash_equal,
+					    "Route Entry Attributes");
+	route_entry_slots_init();
 
 	zrouter.asic_offloaded = asic_offload;
 	zrouter.notify_on_ack = notify_on_ack;
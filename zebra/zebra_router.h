@@ -203,6 +203,16 @@ struct zebra_router {
 	struct hash *nhgs;
 	struct hash *nhgs_id;
 
+	/*
+	 * The hash of interned route entry FIB nexthop groups
+	 */
+	struct hash *re_fibs;
+
+	/*
+	 * The hash of interned route entry attributes
+	 */
+	struct hash *re_attrs;
+
 	/*
 	 * Does the underlying system provide an asic offload
 	 */
@@ -274,8 +274,8 @@ static void check_replace(struct route_node *np2, struct route_entry *re2,
 		return;
 	}
 
-	proto = proto_trans((*re)->type);
-	proto2 = proto_trans(re2->type);
+	proto = proto_trans(re_attr(*re)->type);
+	proto2 = proto_trans(re_attr(re2)->type);
 
 	if (proto2 > proto)
 		return;
@@ -376,7 +376,8 @@ static void get_fwtable_route_node(struct variable *v, oid objid[],
 							 ->gate.ipv4,
 							 (uint8_t *)&nexthop))
 						if (proto
-						    == proto_trans((*re)->type))
+						    == proto_trans(
+							    re_attr(*re)->type))
 							return;
 				}
 			}
@@ -399,7 +400,7 @@ static void get_fwtable_route_node(struct variable *v, oid objid[],
 			RNODE_FOREACH_RE (np2, re2) {
 				int proto2, policy2;
 
-				proto2 = proto_trans(re2->type);
+				proto2 = proto_trans(re_attr(re2)->type);
 				policy2 = 0;
 
 				if ((policy < policy2)
@@ -419,7 +420,7 @@ static void get_fwtable_route_node(struct variable *v, oid objid[],
 		return;
 
 	policy = 0;
-	proto = proto_trans((*re)->type);
+	proto = proto_trans(re_attr(*re)->type);
 
 	*objid_len = v->namelen + 10;
 	pnt = (uint8_t *)&(*np)->p.u.prefix;
@@ -492,7 +493,7 @@ static uint8_t *ipFwTable(struct variable *v, oid objid[], size_t *objid_len,
 		*val_len = sizeof(int);
 		return (uint8_t *)&result;
 	case IPFORWARDPROTO:
-		result = proto_trans(re->type);
+		result = proto_trans(re_attr(re)->type);
 		*val_len = sizeof(int);
 		return (uint8_t *)&result;
 	case IPFORWARDAGE:
@@ -111,6 +111,9 @@ struct zebra_vrf {
 	/* MPLS label forwarding table */
 	struct hash *lsp_table;
 
+	/* Dense in-label index over lsp_table */
+	struct zebra_lsp_index *lsp_index;
+
 	/* MPLS FEC binding table */
 	struct route_table *fec_table[AFI_MAX];
 
@@ -62,6 +62,8 @@
 #include "zebra/table_manager.h"
 #include "zebra/zebra_script.h"
 
+DEFINE_MTYPE_STATIC(ZEBRA, ROUTE_SHOW_WALK, "Route show walk");
+
 extern int allow_delete;
 
 /* context to manage dumps in multiple tables or vrfs */
@@ -432,7 +434,7 @@ static void zebra_show_ip_route_opaque(struct vty *vty, struct route_entry *re,
 	if (!re->opaque)
 		return;
 
-	switch (re->type) {
+	switch (re_attr(re)->type) {
 	case ZEBRA_ROUTE_SHARP:
 		if (json)
 			json_object_string_add(json, "opaque",
@@ -513,16 +515,17 @@ static void vty_show_ip_route_detail(struct vty *vty, struct route_node *rn,
 
 		vty_out(vty, "Routing entry for %s%s\n",
 			srcdest_rnode2str(rn, buf, sizeof(buf)), mcast_info);
-		vty_out(vty, "  Known via \"%s", zebra_route_string(re->type));
-		if (re->instance)
-			vty_out(vty, "[%d]", re->instance);
+		vty_out(vty, "  Known via \"%s",
+			zebra_route_string(re_attr(re)->type));
+		if (re_attr(re)->instance)
+			vty_out(vty, "[%d]", re_attr(re)->instance);
 		vty_out(vty, "\"");
-		vty_out(vty, ", distance %u, metric %u", re->distance,
-			re->metric);
-		if (re->tag) {
-			vty_out(vty, ", tag %u", re->tag);
+		vty_out(vty, ", distance %u, metric %u", re_attr(re)->distance,
+			re_attr(re)->metric);
+		if (re_attr(re)->tag) {
+			vty_out(vty, ", tag %u", re_attr(re)->tag);
 #if defined(SUPPORT_REALMS)
-			if (re->tag > 0 && re->tag <= 255)
+			if (re_attr(re)->tag > 0 && re_attr(re)->tag <= 255)
 				vty_out(vty, "(realm)");
 #endif
 		}
@@ -925,11 +928,11 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 				       srcdest_rnode2str(rn, buf, sizeof(buf)));
 		json_object_int_add(json_route, "prefixLen", rn->p.prefixlen);
 		json_object_string_add(json_route, "protocol",
-				       zebra_route_string(re->type));
+				       zebra_route_string(re_attr(re)->type));
 
-		if (re->instance)
+		if (re_attr(re)->instance)
 			json_object_int_add(json_route, "instance",
-					    re->instance);
+					    re_attr(re)->instance);
 
 		json_object_int_add(json_route, "vrfId", re->vrf_id);
 		json_object_string_add(json_route, "vrfName",
@@ -943,8 +946,8 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 						     "destSelected");
 
 		json_object_int_add(json_route, "distance",
-				    re->distance);
-		json_object_int_add(json_route, "metric", re->metric);
+				    re_attr(re)->distance);
+		json_object_int_add(json_route, "metric", re_attr(re)->metric);
 
 		if (CHECK_FLAG(re->status, ROUTE_ENTRY_INSTALLED))
 			json_object_boolean_true_add(json_route, "installed");
@@ -964,8 +967,9 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 		if (CHECK_FLAG(re->flags, ZEBRA_FLAG_OFFLOAD_FAILED))
 			json_object_boolean_false_add(json_route, "offloaded");
 
-		if (re->tag)
-			json_object_int_add(json_route, "tag", re->tag);
+		if (re_attr(re)->tag)
+			json_object_int_add(json_route, "tag",
+					    re_attr(re)->tag);
 
 		if (re->table)
 			json_object_int_add(json_route, "table", re->table);
@@ -1030,9 +1034,9 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 		nhg_from_backup = true;
 	}
 
-	len = vty_out(vty, "%c", zebra_route_char(re->type));
-	if (re->instance)
-		len += vty_out(vty, "[%d]", re->instance);
+	len = vty_out(vty, "%c", zebra_route_char(re_attr(re)->type));
+	if (re_attr(re)->instance)
+		len += vty_out(vty, "[%d]", re_attr(re)->instance);
 	if (nhg_from_backup && nhg->nexthop) {
 		len += vty_out(
 			vty, "%cb%c %s",
@@ -1048,11 +1052,11 @@ static void vty_show_ip_route(struct vty *vty, struct route_node *rn,
 	}
 
 	/* Distance and metric display. */
-	if (((re->type == ZEBRA_ROUTE_CONNECT) &&
-	     (re->distance || re->metric)) ||
-	    (re->type != ZEBRA_ROUTE_CONNECT))
-		len += vty_out(vty, " [%u/%u]", re->distance,
-			       re->metric);
+	if (((re_attr(re)->type == ZEBRA_ROUTE_CONNECT) &&
+	     (re_attr(re)->distance || re_attr(re)->metric)) ||
+	    (re_attr(re)->type != ZEBRA_ROUTE_CONNECT))
+		len += vty_out(vty, " [%u/%u]", re_attr(re)->distance,
+			       re_attr(re)->metric);
 
 	/* Nexthop information. */
 	for (ALL_NEXTHOPS_PTR(nhg, nexthop)) {
@@ -1138,19 +1142,82 @@ static void vty_show_ip_route_detail_json(struct vty *vty,
 	json_object_free(json);
 }
 
-static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
-				 struct route_table *table, afi_t afi,
-				 bool use_fib, route_tag_t tag,
-				 const struct prefix *longer_prefix_p,
-				 bool supernets_only, int type,
-				 unsigned short ospf_instance_id, bool use_json,
-				 uint32_t tableid, struct route_show_ctx *ctx)
+/* State of a "show ip route" walk, kept across vty_defer() slices.  A
+ * multi-table walk ("vrf all", "table all") resumes at (VRF name, table id,
+ * prefix) and finds each of them again, since any may have gone away while
+ * it was suspended.
+ */
+struct route_show_walk {
+	/* table being shown */
+	vrf_id_t vrf_id;
+	afi_t afi;
+	safi_t safi;
+	uint32_t tableid;
+
+	/* multi-table walks */
+	bool vrf_all;
+	bool table_all;
+	char vrf_name[VRF_NAMSIZ + 1];
+	uint64_t next_tableid; /* table being shown, while in_table */
+	bool in_table;
+
+	/* filters */
+	bool use_fib;
+	bool use_json;
+	route_tag_t tag;
+	const struct prefix *longer_prefix_p;
+	struct prefix longer_prefix;
+	bool supernets_only;
+	int type;
+	unsigned short ospf_instance_id;
+
+	struct route_show_ctx *ctx;
+	struct route_show_ctx ctx_buf;
+
+	/* progress */
+	bool first;
+	struct json_stream js;
+	struct prefix cursor;
+};
+
+static struct route_table *route_show_table(struct zebra_vrf *zvrf,
+					    afi_t afi, safi_t safi,
+					    uint32_t tableid)
+{
+	if (tableid)
+		return zebra_router_find_table(zvrf, tableid, afi,
+					       SAFI_UNICAST);
+	return zebra_vrf_table(afi, safi, zvrf_id(zvrf));
+}
+
+static void do_show_route_start(struct vty *vty, struct route_show_walk *w)
 {
-	struct route_node *rn;
+	w->first = true;
+
+	/* Print routes as they are found, rather than building the JSON
+	 * object of the whole table first.
+	 */
+	if (w->use_json) {
+		json_stream_init(&w->js, vty,
+				 JSON_C_TO_STRING_PRETTY
+					 | JSON_C_TO_STRING_NOSLASHESCAPE);
+		json_stream_object_open(&w->js, NULL);
+	}
+}
+
+/*
+ * Show routes of table starting at (locked) node rn.  Returns CMD_SUSPEND
+ * with w->cursor set to the next prefix to show if the vty asks us to
+ * yield; that only happens between top-level nodes so the source routes
+ * of a src-dest node are never split.
+ */
+static int do_show_route_walk(struct vty *vty, struct zebra_vrf *zvrf,
+			      struct route_table *table, struct route_node *rn,
+			      struct route_show_walk *w)
+{
+	struct route_show_ctx *ctx = w->ctx;
 	struct route_entry *re;
-	int first = 1;
 	rib_dest_t *dest;
-	json_object *json = NULL;
 	json_object *json_prefix = NULL;
 	uint32_t addr;
 	char buf[BUFSIZ];
@@ -1166,26 +1233,28 @@ static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 	 *   => display the VRF and table if specific
 	 */
 
-	if (use_json)
-		json = json_object_new_object();
+	for (; rn; rn = srcdest_route_next(rn)) {
+		if (!rnode_is_srcnode(rn) && vty_defer_yield(vty)) {
+			prefix_copy(&w->cursor, &rn->p);
+			route_unlock_node(rn);
+			return CMD_SUSPEND;
+		}
 
-	/* Show all routes. */
-	for (rn = route_top(table); rn; rn = srcdest_route_next(rn)) {
 		dest = rib_dest_from_rnode(rn);
 
 		RNODE_FOREACH_RE (rn, re) {
-			if (use_fib && re != dest->selected_fib)
+			if (w->use_fib && re != dest->selected_fib)
 				continue;
 
-			if (tag && re->tag != tag)
+			if (w->tag && re_attr(re)->tag != w->tag)
 				continue;
 
-			if (longer_prefix_p
-			    && !prefix_match(longer_prefix_p, &rn->p))
+			if (w->longer_prefix_p
+			    && !prefix_match(w->longer_prefix_p, &rn->p))
 				continue;
 
 			/* This can only be true when the afi is IPv4 */
-			if (supernets_only) {
+			if (w->supernets_only) {
 				addr = ntohl(rn->p.u.prefix4.s_addr);
 
 				if (IN_CLASSC(addr) && rn->p.prefixlen >= 24)
@@ -1198,20 +1267,21 @@ static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 					continue;
 			}
 
-			if (type && re->type != type)
+			if (w->type && re_attr(re)->type != w->type)
 				continue;
 
-			if (ospf_instance_id
-			    && (re->type != ZEBRA_ROUTE_OSPF
-				|| re->instance != ospf_instance_id))
+			if (w->ospf_instance_id
+			    && (re_attr(re)->type != ZEBRA_ROUTE_OSPF
+				|| re_attr(re)->instance
+					   != w->ospf_instance_id))
 				continue;
 
-			if (use_json) {
+			if (w->use_json) {
 				if (!json_prefix)
 					json_prefix = json_object_new_array();
-			} else if (first) {
+			} else if (w->first) {
 				if (!ctx->header_done) {
-					if (afi == AFI_IP)
+					if (w->afi == AFI_IP)
 						vty_out(vty,
 							SHOW_ROUTE_V4_HEADER);
 					else
@@ -1221,66 +1291,223 @@ static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 				if (ctx->multi && ctx->header_done)
 					vty_out(vty, "\n");
 				if (ctx->multi || zvrf_id(zvrf) != VRF_DEFAULT
-				    || tableid) {
-					if (!tableid)
+				    || w->tableid) {
+					if (!w->tableid)
 						vty_out(vty, "VRF %s:\n",
 							zvrf_name(zvrf));
 					else
 						vty_out(vty,
 							"VRF %s table %u:\n",
 							zvrf_name(zvrf),
-							tableid);
+							w->tableid);
 				}
 				ctx->header_done = true;
-				first = 0;
+				w->first = false;
 			}
 
-			vty_show_ip_route(vty, rn, re, json_prefix, use_fib);
+			vty_show_ip_route(vty, rn, re, json_prefix, w->use_fib);
 		}
 
 		if (json_prefix) {
 			prefix2str(&rn->p, buf, sizeof(buf));
-			json_object_object_add(json, buf, json_prefix);
+			json_stream_add(&w->js, buf, json_prefix);
 			json_prefix = NULL;
 		}
 	}
 
-	if (use_json) {
-		vty_out(vty, "%s\n",
-			json_object_to_json_string_ext(
-				json,
-				JSON_C_TO_STRING_PRETTY
-					| JSON_C_TO_STRING_NOSLASHESCAPE));
-		json_object_free(json);
+	if (w->use_json)
+		json_stream_finish(&w->js);
+
+	return CMD_SUCCESS;
+}
+
+/* vty_defer() continuation: look the table up again, since it may have gone
+ * away while we were suspended, and carry on after the cursor the same way
+ * route_table_iter_next() does after a pause.
+ */
+static int do_show_route_resume(struct vty *vty, void *arg)
+{
+	struct route_show_walk *w = arg;
+	struct zebra_vrf *zvrf;
+	struct route_table *table = NULL;
+	struct route_node *rn;
+
+	zvrf = zebra_vrf_lookup_by_id(w->vrf_id);
+	if (zvrf)
+		table = route_show_table(zvrf, w->afi, w->safi, w->tableid);
+	if (!table) {
+		if (w->use_json)
+			json_stream_finish(&w->js);
+		return CMD_SUCCESS;
+	}
+
+	if (w->cursor.family == AF_UNSPEC)
+		rn = route_top(table);
+	else {
+		rn = route_node_lookup_maynull(table, &w->cursor);
+		if (!rn)
+			rn = route_table_get_next(table, &w->cursor);
 	}
+
+	return do_show_route_walk(vty, zvrf, table, rn, w);
+}
+
+static void do_show_route_free(void *arg)
+{
+	XFREE(MTYPE_ROUTE_SHOW_WALK, arg);
 }
 
-static void do_show_ip_route_all(struct vty *vty, struct zebra_vrf *zvrf,
-				 afi_t afi, bool use_fib, bool use_json,
-				 route_tag_t tag,
-				 const struct prefix *longer_prefix_p,
-				 bool supernets_only, int type,
-				 unsigned short ospf_instance_id,
-				 struct route_show_ctx *ctx)
+static struct route_show_walk *
+route_show_walk_new(afi_t afi, safi_t safi, bool use_fib, bool use_json,
+		    route_tag_t tag, const struct prefix *longer_prefix_p,
+		    bool supernets_only, int type,
+		    unsigned short ospf_instance_id, uint32_t tableid)
+{
+	struct route_show_walk *w;
+
+	w = XCALLOC(MTYPE_ROUTE_SHOW_WALK, sizeof(*w));
+	w->afi = afi;
+	w->safi = safi;
+	w->tableid = tableid;
+	w->use_fib = use_fib;
+	w->use_json = use_json;
+	w->tag = tag;
+	if (longer_prefix_p) {
+		prefix_copy(&w->longer_prefix, longer_prefix_p);
+		w->longer_prefix_p = &w->longer_prefix;
+	}
+	w->supernets_only = supernets_only;
+	w->type = type;
+	w->ospf_instance_id = ospf_instance_id;
+	w->ctx = &w->ctx_buf;
+
+	return w;
+}
+
+/* VRF the multi-table walk is at, or the next one by name if it is gone */
+static struct vrf *route_show_multi_vrf(struct route_show_walk *w)
+{
+	struct vrf vrf;
+
+	strlcpy(vrf.name, w->vrf_name, sizeof(vrf.name));
+	if (!w->vrf_all)
+		return RB_FIND(vrf_name_head, &vrfs_by_name, &vrf);
+	return RB_NFIND(vrf_name_head, &vrfs_by_name, &vrf);
+}
+
+/* Next table of zvrf to show, starting at table id w->next_tableid */
+static struct route_table *route_show_multi_table(struct route_show_walk *w,
+						  struct zebra_vrf *zvrf)
 {
 	struct zebra_router_table *zrt;
 	struct rib_table_info *info;
 
-	RB_FOREACH (zrt, zebra_router_table_head,
-		    &zrouter.tables) {
-		info = route_table_get_info(zrt->table);
+	if (!w->table_all) {
+		if (w->next_tableid > w->tableid)
+			return NULL;
+		return route_show_table(zvrf, w->afi, w->safi, w->tableid);
+	}
 
+	/* zrouter.tables is sorted by table id first */
+	RB_FOREACH (zrt, zebra_router_table_head, &zrouter.tables) {
+		if (zrt->tableid < w->next_tableid)
+			continue;
+		info = route_table_get_info(zrt->table);
 		if (zvrf != info->zvrf)
 			continue;
-		if (zrt->afi != afi ||
-		    zrt->safi != SAFI_UNICAST)
+		if (zrt->afi != w->afi || zrt->safi != w->safi)
 			continue;
 
-		do_show_ip_route(vty, zvrf_name(zvrf), afi, SAFI_UNICAST,
-				 use_fib, use_json, tag, longer_prefix_p,
-				 supernets_only, type, ospf_instance_id,
-				 zrt->tableid, ctx);
+		w->tableid = zrt->tableid;
+		return zrt->table;
 	}
+
+	return NULL;
+}
+
+/* Leave the table the walk is in, e.g. because it went away */
+static void route_show_multi_leave(struct route_show_walk *w)
+{
+	if (w->in_table && w->use_json)
+		json_stream_finish(&w->js);
+	w->in_table = false;
+}
+
+/* vty_defer() continuation of a multi-table walk */
+static int do_show_route_multi_resume(struct vty *vty, void *arg)
+{
+	struct route_show_walk *w = arg;
+	struct vrf *vrf;
+	struct zebra_vrf *zvrf;
+	struct route_table *table;
+	struct route_node *rn;
+	int ret;
+
+	for (vrf = route_show_multi_vrf(w); vrf;
+	     vrf = w->vrf_all ? RB_NEXT(vrf_name_head, vrf) : NULL) {
+		if (strcmp(vrf->name, w->vrf_name)) {
+			route_show_multi_leave(w);
+			strlcpy(w->vrf_name, vrf->name, sizeof(w->vrf_name));
+			w->next_tableid = 0;
+		}
+
+		zvrf = vrf->info;
+		if (!zvrf || !zvrf->table[w->afi][w->safi]) {
+			route_show_multi_leave(w);
+			continue;
+		}
+
+		while ((table = route_show_multi_table(w, zvrf))) {
+			if (w->in_table && w->tableid != w->next_tableid)
+				route_show_multi_leave(w);
+
+			if (!w->in_table) {
+				w->in_table = true;
+				w->next_tableid = w->tableid;
+				do_show_route_start(vty, w);
+				rn = route_top(table);
+			} else {
+				rn = route_node_lookup_maynull(table,
+							       &w->cursor);
+				if (!rn)
+					rn = route_table_get_next(table,
+								  &w->cursor);
+			}
+
+			ret = do_show_route_walk(vty, zvrf, table, rn, w);
+			if (ret == CMD_SUSPEND)
+				return ret;
+
+			w->in_table = false;
+			w->next_tableid = (uint64_t)w->tableid + 1;
+		}
+		route_show_multi_leave(w);
+	}
+	route_show_multi_leave(w);
+
+	return CMD_SUCCESS;
+}
+
+static int do_show_ip_route_multi(struct vty *vty, struct vrf *vrf, afi_t afi,
+				  bool use_fib, bool use_json, route_tag_t tag,
+				  const struct prefix *longer_prefix_p,
+				  bool supernets_only, int type,
+				  unsigned short ospf_instance_id,
+				  uint32_t tableid, bool table_all)
+{
+	struct route_show_walk *w;
+
+	w = route_show_walk_new(afi, SAFI_UNICAST, use_fib, use_json, tag,
+				longer_prefix_p, supernets_only, type,
+				ospf_instance_id, tableid);
+	w->vrf_all = !vrf;
+	if (vrf)
+		strlcpy(w->vrf_name, vrf->name, sizeof(w->vrf_name));
+	w->table_all = table_all;
+	w->ctx_buf.multi = true;
+
+	return vty_defer(vty, do_show_route_multi_resume, w,
+			 do_show_route_free);
 }
 
 static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
@@ -1293,6 +1520,7 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 {
 	struct route_table *table;
 	struct zebra_vrf *zvrf = NULL;
+	struct route_show_walk *w;
 
 	if (!(zvrf = zebra_vrf_lookup_by_name(vrf_name))) {
 		if (use_json)
@@ -1310,21 +1538,23 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 		return CMD_SUCCESS;
 	}
 
-	if (tableid)
-		table = zebra_router_find_table(zvrf, tableid, afi, SAFI_UNICAST);
-	else
-		table = zebra_vrf_table(afi, safi, zvrf_id(zvrf));
+	table = route_show_table(zvrf, afi, safi, tableid);
 	if (!table) {
 		if (use_json)
 			vty_out(vty, "{}\n");
 		return CMD_SUCCESS;
 	}
 
-	do_show_route_helper(vty, zvrf, table, afi, use_fib, tag,
-			     longer_prefix_p, supernets_only, type,
-			     ospf_instance_id, use_json, tableid, ctx);
+	/* A single table can be big; let the event loop run in between. */
+	w = route_show_walk_new(afi, safi, use_fib, use_json, tag,
+				longer_prefix_p, supernets_only, type,
+				ospf_instance_id, tableid);
+	w->vrf_id = zvrf_id(zvrf);
+	w->ctx_buf = *ctx;
 
-	return CMD_SUCCESS;
+	do_show_route_start(vty, w);
+
+	return vty_defer(vty, do_show_route_resume, w, do_show_route_free);
 }
 
 DEFPY (show_ip_nht,
@@ -1841,8 +2071,9 @@ DEFPY (show_route,
 	struct vrf *vrf;
 	int type = 0;
 	struct zebra_vrf *zvrf;
+	vrf_id_t vrf_id = VRF_DEFAULT;
 	struct route_show_ctx ctx = {
-		.multi = vrf_all || table_all,
+		.multi = false,
 	};
 
 	if (!vrf_is_backend_netns()) {
@@ -1864,53 +2095,33 @@ DEFPY (show_route,
 		}
 	}
 
-	if (vrf_all) {
-		RB_FOREACH (vrf, vrf_name_head, &vrfs_by_name) {
-			if ((zvrf = vrf->info) == NULL
-			    || (zvrf->table[afi][SAFI_UNICAST] == NULL))
-				continue;
-
-			if (table_all)
-				do_show_ip_route_all(vty, zvrf, afi, !!fib,
-						     !!json, tag,
-						     prefix_str ? prefix : NULL,
-						     !!supernets_only, type,
-						     ospf_instance_id, &ctx);
-			else
-				do_show_ip_route(vty, zvrf_name(zvrf), afi,
-						 SAFI_UNICAST, !!fib, !!json,
-						 tag,
-						 prefix_str ? prefix : NULL,
-						 !!supernets_only, type,
-						 ospf_instance_id, table, &ctx);
-		}
-	} else {
-		vrf_id_t vrf_id = VRF_DEFAULT;
+	if (vrf_all)
+		return do_show_ip_route_multi(vty, NULL, afi, !!fib, !!json,
+					      tag, prefix_str ? prefix : NULL,
+					      !!supernets_only, type,
+					      ospf_instance_id, table,
+					      !!table_all);
 
-		if (vrf_name)
-			VRF_GET_ID(vrf_id, vrf_name, !!json);
-		vrf = vrf_lookup_by_id(vrf_id);
-		if (!vrf)
-			return CMD_SUCCESS;
+	if (vrf_name)
+		VRF_GET_ID(vrf_id, vrf_name, !!json);
+	vrf = vrf_lookup_by_id(vrf_id);
+	if (!vrf)
+		return CMD_SUCCESS;
 
-		zvrf = vrf->info;
-		if (!zvrf)
-			return CMD_SUCCESS;
+	zvrf = vrf->info;
+	if (!zvrf)
+		return CMD_SUCCESS;
 
-		if (table_all)
-			do_show_ip_route_all(vty, zvrf, afi, !!fib, !!json, tag,
-					     prefix_str ? prefix : NULL,
-					     !!supernets_only, type,
-					     ospf_instance_id, &ctx);
-		else
-			do_show_ip_route(vty, vrf->name, afi, SAFI_UNICAST,
-					 !!fib, !!json, tag,
-					 prefix_str ? prefix : NULL,
-					 !!supernets_only, type,
-					 ospf_instance_id, table, &ctx);
-	}
+	if (table_all)
+		return do_show_ip_route_multi(vty, vrf, afi, !!fib, !!json,
+					      tag, prefix_str ? prefix : NULL,
+					      !!supernets_only, type,
+					      ospf_instance_id, 0, true);
 
-	return CMD_SUCCESS;
+	return do_show_ip_route(vty, vrf->name, afi, SAFI_UNICAST, !!fib,
+				!!json, tag, prefix_str ? prefix : NULL,
+				!!supernets_only, type, ospf_instance_id, table,
+				&ctx);
 }
 
 ALIAS_HIDDEN (show_route,
@@ -2273,19 +2484,22 @@ static void show_ip_route_dump_vty(struct vty *vty, struct route_table *table)
 			vty_out(vty, "Route: %s\n",
 				srcdest_rnode2str(rn, buf, sizeof(buf)));
 			vty_out(vty, "   protocol: %s\n",
-				zebra_route_string(re->type));
-			vty_out(vty, "   instance: %u\n", re->instance);
+				zebra_route_string(re_attr(re)->type));
+			vty_out(vty, "   instance: %u\n",
+				re_attr(re)->instance);
 			vty_out(vty, "   VRF ID: %u\n", re->vrf_id);
 			vty_out(vty, "   VRF name: %s\n",
 				vrf_id_to_name(re->vrf_id));
 			vty_out(vty, "   flags: %u\n", re->flags);
 
-			if (re->type != ZEBRA_ROUTE_CONNECT) {
-				vty_out(vty, "   distance: %u\n", re->distance);
-				vty_out(vty, "   metric: %u\n", re->metric);
+			if (re_attr(re)->type != ZEBRA_ROUTE_CONNECT) {
+				vty_out(vty, "   distance: %u\n",
+					re_attr(re)->distance);
+				vty_out(vty, "   metric: %u\n",
+					re_attr(re)->metric);
 			}
 
-			vty_out(vty, "   tag: %u\n", re->tag);
+			vty_out(vty, "   tag: %u\n", re_attr(re)->tag);
 
 			uptime = monotime(&tv);
 			uptime -= re->uptime;
@@ -2354,14 +2568,14 @@ static void vty_show_ip_route_summary(struct vty *vty,
 
 	for (rn = route_top(table); rn; rn = srcdest_route_next(rn))
 		RNODE_FOREACH_RE (rn, re) {
-			is_ibgp = (re->type == ZEBRA_ROUTE_BGP
+			is_ibgp = (re_attr(re)->type == ZEBRA_ROUTE_BGP
 				   && CHECK_FLAG(re->flags, ZEBRA_FLAG_IBGP));
 
 			rib_cnt[ZEBRA_ROUTE_TOTAL]++;
 			if (is_ibgp)
 				rib_cnt[ZEBRA_ROUTE_IBGP]++;
 			else
-				rib_cnt[re->type]++;
+				rib_cnt[re_attr(re)->type]++;
 
 			if (CHECK_FLAG(re->status, ROUTE_ENTRY_INSTALLED)) {
 				fib_cnt[ZEBRA_ROUTE_TOTAL]++;
@@ -2369,21 +2583,21 @@ static void vty_show_ip_route_summary(struct vty *vty,
 				if (is_ibgp)
 					fib_cnt[ZEBRA_ROUTE_IBGP]++;
 				else
-					fib_cnt[re->type]++;
+					fib_cnt[re_attr(re)->type]++;
 			}
 
 			if (CHECK_FLAG(re->flags, ZEBRA_FLAG_TRAPPED)) {
 				if (is_ibgp)
 					trap_cnt[ZEBRA_ROUTE_IBGP]++;
 				else
-					trap_cnt[re->type]++;
+					trap_cnt[re_attr(re)->type]++;
 			}
 
 			if (CHECK_FLAG(re->flags, ZEBRA_FLAG_OFFLOADED)) {
 				if (is_ibgp)
 					offload_cnt[ZEBRA_ROUTE_IBGP]++;
 				else
-					offload_cnt[re->type]++;
+					offload_cnt[re_attr(re)->type]++;
 			}
 		}
 
@@ -2538,14 +2752,14 @@ static void vty_show_ip_route_summary_prefix(struct vty *vty,
 			cnt = 0;
 			if (CHECK_FLAG(re->status, ROUTE_ENTRY_INSTALLED)) {
 				fib_cnt[ZEBRA_ROUTE_TOTAL]++;
-				fib_cnt[re->type]++;
+				fib_cnt[re_attr(re)->type]++;
 			}
 			for (nexthop = re->nhe->nhg.nexthop; (!cnt && nexthop);
 			     nexthop = nexthop->next) {
 				cnt++;
 				rib_cnt[ZEBRA_ROUTE_TOTAL]++;
-				rib_cnt[re->type]++;
-				if (re->type == ZEBRA_ROUTE_BGP
+				rib_cnt[re_attr(re)->type]++;
+				if (re_attr(re)->type == ZEBRA_ROUTE_BGP
 				    && CHECK_FLAG(re->flags, ZEBRA_FLAG_IBGP)) {
 					rib_cnt[ZEBRA_ROUTE_IBGP]++;
 					if (CHECK_FLAG(re->status,
@@ -406,15 +406,16 @@ static void zl3vni_print_rmac(struct zebra_mac *zrmac, struct vty *vty,
 static void zevpn_print_mac_hash_all_evpn(struct hash_bucket *bucket, void *ctxt)
 {
 	struct vty *vty;
-	json_object *json = NULL, *json_evpn = NULL;
+	json_object *json_evpn = NULL;
 	json_object *json_mac = NULL;
 	struct zebra_evpn *zevpn;
 	uint32_t num_macs;
 	struct mac_walk_ctx *wctx = ctxt;
+	struct json_stream *js;
 	char vni_str[VNI_STR_LEN];
 
 	vty = wctx->vty;
-	json = wctx->json;
+	js = wctx->js;
 
 	zevpn = (struct zebra_evpn *)bucket->data;
 	wctx->zevpn = zevpn;
@@ -429,14 +430,14 @@ static void zevpn_print_mac_hash_all_evpn(struct hash_bucket *bucket, void *ctxt
 	if (wctx->print_dup)
 		num_macs = num_dup_detected_macs(zevpn);
 
-	if (json) {
+	if (js) {
 		json_evpn = json_object_new_object();
 		json_mac = json_object_new_object();
 		snprintf(vni_str, VNI_STR_LEN, "%u", zevpn->vni);
 	}
 
 	if (!CHECK_FLAG(wctx->flags, SHOW_REMOTE_MAC_FROM_VTEP)) {
-		if (json == NULL) {
+		if (js == NULL) {
 			vty_out(vty, "\nVNI %u #MACs (local and remote) %u\n\n",
 				zevpn->vni, num_macs);
 			vty_out(vty,
@@ -449,16 +450,17 @@ static void zevpn_print_mac_hash_all_evpn(struct hash_bucket *bucket, void *ctxt
 	}
 
 	if (!num_macs) {
-		if (json) {
+		if (js) {
 			json_object_int_add(json_evpn, "numMacs", num_macs);
-			json_object_object_add(json, vni_str, json_evpn);
+			json_object_free(json_mac);
+			json_stream_add(js, vni_str, json_evpn);
 		}
 		return;
 	}
 
 	/* assign per-evpn to wctx->json object to fill macs
-	 * under the evpn. Re-assign primary json object to fill
-	 * next evpn information.
+	 * under the evpn. The evpn is printed right away, so that the
+	 * macs of all evpns are never held in memory at the same time.
 	 */
 	wctx->json = json_mac;
 	if (wctx->print_dup)
@@ -466,11 +468,13 @@ static void zevpn_print_mac_hash_all_evpn(struct hash_bucket *bucket, void *ctxt
 			     wctx);
 	else
 		hash_iterate(zevpn->mac_table, zebra_evpn_print_mac_hash, wctx);
-	wctx->json = json;
-	if (json) {
+	wctx->json = NULL;
+	if (js) {
 		if (wctx->count)
 			json_object_object_add(json_evpn, "macs", json_mac);
-		json_object_object_add(json, vni_str, json_evpn);
+		else
+			json_object_free(json_mac);
+		json_stream_add(js, vni_str, json_evpn);
 	}
 }
 
@@ -2926,27 +2930,26 @@ void zebra_vxlan_print_macs_all_vni(struct vty *vty, struct zebra_vrf *zvrf,
 				    bool print_dup, bool use_json)
 {
 	struct mac_walk_ctx wctx;
-	json_object *json = NULL;
+	struct json_stream js;
 
 	if (!is_evpn_enabled()) {
 		if (use_json)
 			vty_out(vty, "{}\n");
 		return;
 	}
-	if (use_json)
-		json = json_object_new_object();
 
 	memset(&wctx, 0, sizeof(struct mac_walk_ctx));
 	wctx.vty = vty;
-	wctx.json = json;
 	wctx.print_dup = print_dup;
-	hash_iterate(zvrf->evpn_table, zevpn_print_mac_hash_all_evpn, &wctx);
-
 	if (use_json) {
-		vty_out(vty, "%s\n", json_object_to_json_string_ext(
-					     json, JSON_C_TO_STRING_PRETTY));
-		json_object_free(json);
+		json_stream_init(&js, vty, JSON_C_TO_STRING_PRETTY);
+		json_stream_object_open(&js, NULL);
+		wctx.js = &js;
 	}
+	hash_iterate(zvrf->evpn_table, zevpn_print_mac_hash_all_evpn, &wctx);
+
+	if (use_json)
+		json_stream_finish(&js);
 }
 
 /*
@@ -2989,26 +2992,24 @@ void zebra_vxlan_print_macs_all_vni_vtep(struct vty *vty,
 					 struct in_addr vtep_ip, bool use_json)
 {
 	struct mac_walk_ctx wctx;
-	json_object *json = NULL;
+	struct json_stream js;
 
 	if (!is_evpn_enabled())
 		return;
 
-	if (use_json)
-		json = json_object_new_object();
-
 	memset(&wctx, 0, sizeof(struct mac_walk_ctx));
 	wctx.vty = vty;
 	wctx.flags = SHOW_REMOTE_MAC_FROM_VTEP;
 	wctx.r_vtep_ip = vtep_ip;
-	wctx.json = json;
-	hash_iterate(zvrf->evpn_table, zevpn_print_mac_hash_all_evpn, &wctx);
-
 	if (use_json) {
-		vty_out(vty, "%s\n", json_object_to_json_string_ext(
-					     json, JSON_C_TO_STRING_PRETTY));
-		json_object_free(json);
+		json_stream_init(&js, vty, JSON_C_TO_STRING_PRETTY);
+		json_stream_object_open(&js, NULL);
+		wctx.js = &js;
 	}
+	hash_iterate(zvrf->evpn_table, zevpn_print_mac_hash_all_evpn, &wctx);
+
+	if (use_json)
+		json_stream_finish(&js);
 }
 
 /*
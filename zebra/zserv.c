@@ -55,6 +55,7 @@
 #include "lib/frratomic.h"        /* for atomic_load_explicit, atomic_stor... */
 #include "lib/lib_errors.h"       /* for generic ferr ids */
 #include "lib/printfrr.h"         /* for string functions */
+#include "lib/segbuf.h"           /* for segbuf, segbuf_iovec */
 
 #include "zebra/debug.h"          /* for various debugging macros */
 #include "zebra/rib.h"            /* for rib_score_proto */
@@ -91,6 +92,8 @@ enum zserv_client_event {
 	ZSERV_CLIENT_READ,
 	/* Schedule a buffer write */
 	ZSERV_CLIENT_WRITE,
+	/* Schedule a buffer write once the cork timer expires */
+	ZSERV_CLIENT_WRITE_CORKED,
 };
 
 /*
@@ -125,6 +128,7 @@ enum zserv_event {
  */
 static void zserv_client_event(struct zserv *client,
 			       enum zserv_client_event event);
+static int zserv_write_uncork(struct thread *thread);
 
 /*
  * Zebra server event driver for the main thread.
@@ -193,9 +197,92 @@ static void zserv_client_fail(struct zserv *client)
 
 	THREAD_OFF(client->t_read);
 	THREAD_OFF(client->t_write);
+	THREAD_OFF(client->t_write_cork);
 	zserv_event(client, ZSERV_HANDLE_CLIENT_FAIL);
 }
 
+/*
+ * Map a value onto a log2 histogram bucket; the last bucket also collects
+ * everything that does not fit.
+ */
+static unsigned int zserv_write_hist_bucket(uint64_t val)
+{
+	unsigned int bucket = 0;
+
+	while (val > 1 && bucket < ZSERV_WRITE_HIST_BUCKETS - 1) {
+		val >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/*
+ * Account for one flush of the output queue.
+ *
+ * msgs
+ *    number of messages taken off the output queue
+ *
+ * latency
+ *    time, in usec, the oldest of those messages spent on the queue
+ */
+static void zserv_write_stats_update(struct zserv *client, uint32_t msgs,
+				     int64_t latency)
+{
+	uint32_t max_depth;
+
+	atomic_fetch_add_explicit(&client->write_flush_cnt, 1,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&client->write_msg_cnt, msgs,
+				  memory_order_relaxed);
+
+	max_depth = atomic_load_explicit(&client->write_max_depth,
+					 memory_order_relaxed);
+	if (msgs > max_depth)
+		atomic_store_explicit(&client->write_max_depth, msgs,
+				      memory_order_relaxed);
+
+	atomic_fetch_add_explicit(
+		&client->write_depth_hist[zserv_write_hist_bucket(msgs)], 1,
+		memory_order_relaxed);
+	atomic_fetch_add_explicit(
+		&client->write_lat_hist[zserv_write_hist_bucket(
+			latency > 0 ? latency : 0)],
+		1, memory_order_relaxed);
+}
+
+/* max number of messages handed to one writev() */
+#define ZSERV_WRITE_IOV 128
+
+/*
+ * Write as much of the client's write buffer as the socket accepts.
+ *
+ * Large messages sit in the buffer by reference, their streams are freed
+ * once they have been written completely.
+ */
+static buffer_status_t zserv_flush(struct zserv *client)
+{
+	struct iovec iov[ZSERV_WRITE_IOV];
+	unsigned int niov;
+	ssize_t nbytes;
+
+	while (SEGBUF_READABLE(client->wb)) {
+		niov = segbuf_iovec(client->wb, iov, array_size(iov));
+		nbytes = writev(client->sock, iov, niov);
+		if (nbytes < 0) {
+			if (ERRNO_IO_RETRY(errno))
+				break;
+			return BUFFER_ERROR;
+		}
+		if (nbytes == 0)
+			break;
+		segbuf_forward_getp(client->wb, nbytes);
+	}
+
+	segbuf_compact(client->wb);
+	return SEGBUF_READABLE(client->wb) ? BUFFER_PENDING : BUFFER_EMPTY;
+}
+
 /*
  * Write all pending messages to client socket.
  *
@@ -215,6 +302,11 @@ static void zserv_client_fail(struct zserv *client)
  * enqueuing packets onto an intermediary queue, but the intermediary queue
  * allows us to expose information about input and output queues to the user in
  * terms of number of packets rather than size of data.
+ *
+ * Producers cork the output queue during message bursts (see
+ * zserv_write_corked()), so that a single invocation of this function usually
+ * moves many messages into the buffer and hands them to the kernel in a few
+ * writev() calls.
  */
 static int zserv_write(struct thread *thread)
 {
@@ -222,9 +314,12 @@ static int zserv_write(struct thread *thread)
 	struct stream *msg;
 	uint32_t wcmd = 0;
 	struct stream_fifo *cache;
+	struct timeval first_queued;
+	struct timeval now;
+	uint32_t msgs = 0;
 
 	/* If we have any data pending, try to flush it first */
-	switch (buffer_flush_all(client->wb, client->sock)) {
+	switch (zserv_flush(client)) {
 	case BUFFER_ERROR:
 		goto zwrite_fail;
 	case BUFFER_PENDING:
@@ -239,10 +334,26 @@ static int zserv_write(struct thread *thread)
 
 	cache = stream_fifo_new();
 
+	monotime(&now);
+
 	frr_with_mutex(&client->obuf_mtx) {
-		while (stream_fifo_head(client->obuf_fifo))
+		while (stream_fifo_head(client->obuf_fifo)) {
 			stream_fifo_push(cache,
 					 stream_fifo_pop(client->obuf_fifo));
+			msgs++;
+		}
+
+		first_queued = client->obuf_first_queued;
+		client->obuf_bytes = 0;
+		client->obuf_last_flush = now;
+		client->obuf_last_flush_msgs = msgs;
+	}
+
+	if (msgs) {
+		timersub(&now, &first_queued, &now);
+		zserv_write_stats_update(client, msgs,
+					 (int64_t)now.tv_sec * 1000000LL
+						 + now.tv_usec);
 	}
 
 	if (cache->tail) {
@@ -251,16 +362,27 @@ static int zserv_write(struct thread *thread)
 		wcmd = stream_getw_from(msg, ZAPI_HEADER_CMD_LOCATION);
 	}
 
+	/*
+	 * Hand the messages to the write buffer.  Mostly filled streams are
+	 * queued as they are, without copying;  small messages in large
+	 * streams are copied so a slow client doesn't pin their allocation.
+	 */
 	while (stream_fifo_head(cache)) {
 		msg = stream_fifo_pop(cache);
-		buffer_put(client->wb, STREAM_DATA(msg), stream_get_endp(msg));
-		stream_free(msg);
+		if (stream_get_endp(msg) >= STREAM_SIZE(msg) / 2) {
+			stream_set_getp(msg, 0);
+			segbuf_append_stream(client->wb, msg);
+		} else {
+			segbuf_put(client->wb, STREAM_DATA(msg),
+				   stream_get_endp(msg));
+			stream_free(msg);
+		}
 	}
 
 	stream_fifo_free(cache);
 
 	/* If we have any data pending, try to flush it first */
-	switch (buffer_flush_all(client->wb, client->sock)) {
+	switch (zserv_flush(client)) {
 	case BUFFER_ERROR:
 		goto zwrite_fail;
 	case BUFFER_PENDING:
@@ -473,6 +595,12 @@ static void zserv_client_event(struct zserv *client,
 		thread_add_write(client->pthread->master, zserv_write, client,
 				 client->sock, &client->t_write);
 		break;
+	case ZSERV_CLIENT_WRITE_CORKED:
+		thread_add_timer_msec(client->pthread->master,
+				      zserv_write_uncork, client,
+				      ZSERV_WRITE_CORK_MSEC,
+				      &client->t_write_cork);
+		break;
 	}
 }
 
@@ -533,13 +661,55 @@ static int zserv_process_messages(struct thread *thread)
 	return 0;
 }
 
+/*
+ * Account for messages just pushed onto the output queue and decide whether
+ * the write should be held back. Must be called with obuf_mtx held.
+ *
+ * Writes are corked only while the client is in the middle of a burst, i.e.
+ * the previous flush was recent and carried more than one message. A lone
+ * message on an otherwise idle session, such as the reply to a synchronous
+ * request, goes out right away. Once enough data is queued, the cork is
+ * pulled regardless of the timer.
+ */
+static bool zserv_write_corked(struct zserv *client, size_t bytes)
+{
+	if (client->obuf_bytes == 0)
+		monotime(&client->obuf_first_queued);
+
+	client->obuf_bytes += bytes;
+
+	if (client->obuf_bytes >= ZSERV_WRITE_CORK_BYTES)
+		return false;
+
+	if (client->obuf_last_flush_msgs <= 1)
+		return false;
+
+	return monotime_since(&client->obuf_last_flush, NULL)
+	       < ZSERV_WRITE_CORK_MSEC * 1000;
+}
+
+/*
+ * The cork timer fired: write out whatever accumulated in the meantime.
+ */
+static int zserv_write_uncork(struct thread *thread)
+{
+	struct zserv *client = THREAD_ARG(thread);
+
+	zserv_client_event(client, ZSERV_CLIENT_WRITE);
+	return 0;
+}
+
 int zserv_send_message(struct zserv *client, struct stream *msg)
 {
+	bool corked;
+
 	frr_with_mutex(&client->obuf_mtx) {
 		stream_fifo_push(client->obuf_fifo, msg);
+		corked = zserv_write_corked(client, stream_get_endp(msg));
 	}
 
-	zserv_client_event(client, ZSERV_CLIENT_WRITE);
+	zserv_client_event(client, corked ? ZSERV_CLIENT_WRITE_CORKED
+					  : ZSERV_CLIENT_WRITE);
 
 	return 0;
 }
@@ -550,16 +720,22 @@ int zserv_send_message(struct zserv *client, struct stream *msg)
 int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo)
 {
 	struct stream *msg;
+	size_t bytes = 0;
+	bool corked;
 
 	frr_with_mutex(&client->obuf_mtx) {
 		msg = stream_fifo_pop(fifo);
 		while (msg) {
+			bytes += stream_get_endp(msg);
 			stream_fifo_push(client->obuf_fifo, msg);
 			msg = stream_fifo_pop(fifo);
 		}
+
+		corked = zserv_write_corked(client, bytes);
 	}
 
-	zserv_client_event(client, ZSERV_CLIENT_WRITE);
+	zserv_client_event(client, corked ? ZSERV_CLIENT_WRITE_CORKED
+					  : ZSERV_CLIENT_WRITE);
 
 	return 0;
 }
@@ -623,8 +799,7 @@ static void zserv_client_free(struct zserv *client)
 		stream_fifo_free(client->ibuf_fifo);
 	if (client->obuf_fifo)
 		stream_fifo_free(client->obuf_fifo);
-	if (client->wb)
-		buffer_free(client->wb);
+	segbuf_free(client->wb);
 
 	/* Free buffer mutexes */
 	pthread_mutex_destroy(&client->obuf_mtx);
@@ -750,7 +925,7 @@ static struct zserv *zserv_client_create(int sock)
 	client->obuf_work = stream_new(stream_size);
 	pthread_mutex_init(&client->ibuf_mtx, NULL);
 	pthread_mutex_init(&client->obuf_mtx, NULL);
-	client->wb = buffer_new(0);
+	client->wb = segbuf_new();
 	TAILQ_INIT(&(client->gr_info_queue));
 
 	atomic_store_explicit(&client->connect_time, (uint32_t) monotime(NULL),
@@ -1000,6 +1175,24 @@ static char *zserv_time_buf(time_t *time1, char *buf, int buflen)
 	return buf;
 }
 
+/* Display the non-empty buckets of a client output histogram */
+static void zebra_show_client_write_hist(struct vty *vty, const char *label,
+					 _Atomic uint32_t *hist)
+{
+	uint32_t cnt;
+	int i;
+
+	vty_out(vty, "%s", label);
+	for (i = 0; i < ZSERV_WRITE_HIST_BUCKETS; i++) {
+		cnt = atomic_load_explicit(&hist[i], memory_order_relaxed);
+		if (cnt)
+			vty_out(vty, " %s%llu:%u",
+				i == ZSERV_WRITE_HIST_BUCKETS - 1 ? ">=" : "",
+				1ULL << i, cnt);
+	}
+	vty_out(vty, "\n");
+}
+
 /* Display client info details */
 static void zebra_show_client_detail(struct vty *vty, struct zserv *client)
 {
@@ -1099,6 +1292,18 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client)
 		client->local_es_evi_add_cnt, 0, client->local_es_evi_del_cnt);
 	vty_out(vty, "Errors: %u\n", client->error_cnt);
 
+	vty_out(vty, "Output: %u msgs in %u flushes, max %u msgs per flush\n",
+		atomic_load_explicit(&client->write_msg_cnt,
+				     memory_order_relaxed),
+		atomic_load_explicit(&client->write_flush_cnt,
+				     memory_order_relaxed),
+		atomic_load_explicit(&client->write_max_depth,
+				     memory_order_relaxed));
+	zebra_show_client_write_hist(vty, "Msgs per flush:",
+				     client->write_depth_hist);
+	zebra_show_client_write_hist(vty, "Queue latency (usec):",
+				     client->write_lat_hist);
+
 #if defined DEV_BUILD
 	vty_out(vty, "Input Fifo: %zu:%zu Output Fifo: %zu:%zu\n",
 		client->ibuf_fifo->count, client->ibuf_fifo->max_count,
@@ -32,6 +32,7 @@
 #include "lib/vrf.h"          /* for vrf_bitmap_t */
 #include "lib/zclient.h"      /* for redist_proto */
 #include "lib/stream.h"       /* for stream, stream_fifo */
+#include "lib/segbuf.h"       /* for segbuf */
 #include "lib/thread.h"       /* for thread, thread_master */
 #include "lib/linklist.h"     /* for list */
 #include "lib/workqueue.h"    /* for work_queue */
@@ -59,6 +60,17 @@ extern "C" {
 /* Count of stale routes processed in timer context */
 #define ZEBRA_MAX_STALE_ROUTE_COUNT 50000
 
+/*
+ * Output corking: while a client is receiving a burst of messages, writes
+ * are held back until either ZSERV_WRITE_CORK_BYTES are queued or the
+ * oldest queued message has waited ZSERV_WRITE_CORK_MSEC.
+ */
+#define ZSERV_WRITE_CORK_BYTES (64 * 1024)
+#define ZSERV_WRITE_CORK_MSEC 2
+
+/* Number of log2 buckets in the per-client output histograms */
+#define ZSERV_WRITE_HIST_BUCKETS 16
+
 /* Graceful Restart information */
 struct client_gr_info {
 	/* VRF for which GR enabled */
@@ -110,17 +122,30 @@ struct zserv {
 	pthread_mutex_t obuf_mtx;
 	struct stream_fifo *obuf_fifo;
 
+	/*
+	 * Output corking state, protected by obuf_mtx: bytes currently
+	 * queued on obuf_fifo, when the oldest of them was queued, and when
+	 * the last flush happened and how many messages it carried.
+	 */
+	size_t obuf_bytes;
+	struct timeval obuf_first_queued;
+	struct timeval obuf_last_flush;
+	uint32_t obuf_last_flush_msgs;
+
 	/* Private I/O buffers */
 	struct stream *ibuf_work;
 	struct stream *obuf_work;
 
-	/* Buffer of data waiting to be written to client. */
-	struct buffer *wb;
+	/* Messages waiting to be written to client, queued by reference. */
+	struct segbuf *wb;
 
 	/* Threads for read/write. */
 	struct thread *t_read;
 	struct thread *t_write;
 
+	/* Cork timer, bounds how long small writes are held back */
+	struct thread *t_write_cork;
+
 	/* Event for message processing, for the main pthread */
 	struct thread *t_process;
 
@@ -226,6 +251,18 @@ struct zserv {
 	/* command code of last message written */
 	_Atomic uint32_t last_write_cmd;
 
+	/*
+	 * Output statistics, updated by the client pthread on every flush
+	 * of the output queue.
+	 */
+	_Atomic uint32_t write_flush_cnt;
+	_Atomic uint32_t write_msg_cnt;
+	_Atomic uint32_t write_max_depth;
+	/* log2 histogram of messages per flush */
+	_Atomic uint32_t write_depth_hist[ZSERV_WRITE_HIST_BUCKETS];
+	/* log2 histogram of queueing latency per flush, in usec */
+	_Atomic uint32_t write_lat_hist[ZSERV_WRITE_HIST_BUCKETS];
+
 	/*
 	 * Number of instances configured with
 	 * graceful restart